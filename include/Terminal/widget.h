@@ -0,0 +1,77 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef DESKTOP_TERMINAL_WIDGET_H
+# define DESKTOP_TERMINAL_WIDGET_H
+
+# include <gtk/gtk.h>
+
+
+/* TerminalWidget */
+/* public */
+/* types */
+typedef struct _TerminalWidget TerminalWidget;
+
+typedef struct _TerminalWidgetHelper
+{
+	void * data;
+	/* every member is optional */
+	char const * (*config_get)(void * data, char const * variable);
+	void (*set_title)(void * data, char const * title);
+	/* the terminal is usable */
+	void (*ready)(void * data);
+	/* the process is reaped by the widget if set, by the host otherwise */
+	void (*exited)(void * data, GPid pid, int status);
+} TerminalWidgetHelper;
+
+
+/* functions */
+/* essential */
+/* the default backend is used if NULL */
+TerminalWidget * terminalwidget_new(char const * backend,
+		TerminalWidgetHelper const * helper);
+void terminalwidget_delete(TerminalWidget * widget);
+
+
+/* accessors */
+char const * terminalwidget_get_backend(TerminalWidget * widget);
+char const * terminalwidget_get_label(TerminalWidget * widget);
+/* -1 until started, or once exited */
+GPid terminalwidget_get_pid(TerminalWidget * widget);
+GtkWidget * terminalwidget_get_widget(TerminalWidget * widget);
+
+int terminalwidget_can_attach(TerminalWidget * widget);
+
+
+/* useful */
+/* the widget must be added to a toplevel window before starting */
+int terminalwidget_start(TerminalWidget * widget, char const * directory,
+		char const * shell, unsigned int login);
+/* uses the master side of an existing pty instead */
+int terminalwidget_attach(TerminalWidget * widget, int fd);
+
+#endif /* !DESKTOP_TERMINAL_WIDGET_H */
@@ -0,0 +1,71 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_BACKEND_H
+# define TERMINAL_BACKEND_H
+
+
+/* TerminalBackend */
+/* public */
+/* types */
+typedef struct _TerminalBackend TerminalBackend;
+
+typedef struct _TerminalBackendHelper
+{
+	void * data;
+	char const * (*config_get)(void * data, char const * variable);
+	void (*set_title)(void * data, char const * title);
+	/* the terminal is usable */
+	void (*ready)(void * data);
+} TerminalBackendHelper;
+
+typedef struct _TerminalBackendDefinition
+{
+	char const * name;
+	char const * label;
+
+	/* the widget must be added to a toplevel window before starting */
+	TerminalBackend * (*init)(TerminalBackendHelper const * helper);
+	void (*destroy)(TerminalBackend * backend);
+	GtkWidget * (*get_widget)(TerminalBackend * backend);
+	int (*start)(TerminalBackend * backend, char const * directory,
+			char const * shell, unsigned int login, GPid * pid);
+	/* optional, uses the master side of an existing pty instead */
+	int (*attach)(TerminalBackend * backend, int fd, GPid * pid);
+} TerminalBackendDefinition;
+
+
+/* constants */
+extern TerminalBackendDefinition const backend_native;
+extern TerminalBackendDefinition const backend_xterm;
+
+
+/* functions */
+/* the default backend if NULL */
+TerminalBackendDefinition const * backend_lookup(char const * name);
+
+#endif /* !TERMINAL_BACKEND_H */
@@ -0,0 +1,868 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <libintl.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "control.h"
+#define _(string) gettext(string)
+
+/* constants */
+#define TERMINALCONTROL_MESSAGE_SIZE	65536
+#define TERMINALCONTROL_OUTPUT_SIZE	1048576
+#define TERMINALCONTROL_VALUES		32
+
+
+/* TerminalControl */
+/* private */
+/* types */
+typedef struct _TerminalControlValue
+{
+	char const * key;
+	char const * value;
+	gboolean string;
+} TerminalControlValue;
+
+struct _TerminalControlRequest
+{
+	TerminalControlValue values[TERMINALCONTROL_VALUES];
+	size_t values_cnt;
+};
+
+typedef struct _TerminalControlClient
+{
+	TerminalControl * control;
+	int fd;
+	guint source;
+	guint source_out;
+	gboolean closing;
+	gboolean subscribed;
+
+	/* one line at a time, the values unescaped separately */
+	char buf[TERMINALCONTROL_MESSAGE_SIZE];
+	size_t len;
+	char values[TERMINALCONTROL_MESSAGE_SIZE + 1];
+
+	/* not sent yet */
+	GString * out;
+} TerminalControlClient;
+
+struct _TerminalControl
+{
+	String * path;
+	int fd;
+	GIOChannel * channel;
+	guint source;
+	TerminalControlCallback callback;
+	void * data;
+
+	TerminalControlClient ** clients;
+	size_t clients_cnt;
+};
+
+
+/* prototypes */
+static int _terminalcontrol_set_cloexec(int fd);
+
+/* clients */
+static void _terminalcontrol_client_delete(TerminalControlClient * client);
+static int _terminalcontrol_client_process(TerminalControlClient * client,
+		char const * line);
+static void _terminalcontrol_client_remove(TerminalControlClient * client);
+static void _terminalcontrol_client_reply(TerminalControlClient * client,
+		TerminalControlRequest * request, GString * reply);
+static int _terminalcontrol_client_write(TerminalControlClient * client,
+		char const * buf, size_t len);
+
+/* parser */
+static int _terminalcontrol_parse_request(char const ** p, char ** w,
+		TerminalControlRequest * request);
+static int _terminalcontrol_parse_scalar(char const ** p, char ** w);
+static int _terminalcontrol_parse_string(char const ** p, char ** w);
+static void _terminalcontrol_parse_whitespace(char const ** p);
+
+/* callbacks */
+static gboolean _terminalcontrol_on_accept(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static gboolean _terminalcontrol_on_client(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static gboolean _terminalcontrol_on_output(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+
+
+/* public */
+/* functions */
+/* terminalcontrol_new */
+static int _new_bind(TerminalControl * control);
+
+TerminalControl * terminalcontrol_new(char const * path,
+		TerminalControlCallback callback, void * data)
+{
+	TerminalControl * control;
+
+	if(strlen(path) >= sizeof(((struct sockaddr_un *)NULL)->sun_path))
+	{
+		error_set_code(1, "%s: %s", path, strerror(ENAMETOOLONG));
+		return NULL;
+	}
+	if((control = object_new(sizeof(*control))) == NULL)
+		return NULL;
+	control->path = string_new(path);
+	control->fd = -1;
+	control->channel = NULL;
+	control->source = 0;
+	control->callback = callback;
+	control->data = data;
+	control->clients = NULL;
+	control->clients_cnt = 0;
+	if(control->path == NULL || _new_bind(control) != 0)
+	{
+		terminalcontrol_delete(control);
+		return NULL;
+	}
+	control->channel = g_io_channel_unix_new(control->fd);
+	control->source = g_io_add_watch(control->channel, G_IO_IN,
+			_terminalcontrol_on_accept, control);
+	return control;
+}
+
+static int _new_bind(TerminalControl * control)
+{
+	struct sockaddr_un sa;
+	int fd;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", control->path);
+	if((control->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -error_set_code(1, "%s: %s", "socket", strerror(errno));
+	if(_terminalcontrol_set_cloexec(control->fd) != 0)
+		return -1;
+	if(bind(control->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+	{
+		if(errno != EADDRINUSE)
+			return -error_set_code(1, "%s: %s", control->path,
+					strerror(errno));
+		/* check if the socket is stale */
+		if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+			return -error_set_code(1, "%s: %s", "socket",
+					strerror(errno));
+		if(connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0)
+		{
+			close(fd);
+			return -error_set_code(1, "%s: %s", control->path,
+					strerror(EADDRINUSE));
+		}
+		close(fd);
+		if(unlink(control->path) != 0
+				|| bind(control->fd, (struct sockaddr *)&sa,
+					sizeof(sa)) != 0)
+			return -error_set_code(1, "%s: %s", control->path,
+					strerror(errno));
+	}
+	/* the tabs can be driven by the user alone */
+	if(chmod(control->path, 0600) != 0 || listen(control->fd, 5) != 0)
+	{
+		error_set_code(1, "%s: %s", control->path, strerror(errno));
+		unlink(control->path);
+		return -1;
+	}
+	return 0;
+}
+
+
+/* terminalcontrol_delete */
+void terminalcontrol_delete(TerminalControl * control)
+{
+	while(control->clients_cnt > 0)
+		_terminalcontrol_client_remove(control->clients[0]);
+	free(control->clients);
+	if(control->source > 0)
+		g_source_remove(control->source);
+	if(control->channel != NULL)
+	{
+		g_io_channel_unref(control->channel);
+		/* only remove the socket if we were listening */
+		unlink(control->path);
+	}
+	if(control->fd >= 0)
+		close(control->fd);
+	string_delete(control->path);
+	object_delete(control);
+}
+
+
+/* accessors */
+/* terminalcontrol_get_path */
+char const * terminalcontrol_get_path(TerminalControl * control)
+{
+	return control->path;
+}
+
+
+/* terminalcontrol_request_get_boolean */
+static TerminalControlValue const * _request_get(
+		TerminalControlRequest const * request, char const * key);
+
+int terminalcontrol_request_get_boolean(TerminalControlRequest const * request,
+		char const * key, unsigned int * value)
+{
+	TerminalControlValue const * v;
+
+	if((v = _request_get(request, key)) == NULL)
+		return 0;
+	if(v->string == FALSE && strcmp(v->value, "true") == 0)
+		*value = 1;
+	else if(v->string == FALSE && strcmp(v->value, "false") == 0)
+		*value = 0;
+	else
+		return -error_set_code(1, "%s: %s", key, _("Invalid value"));
+	return 0;
+}
+
+static TerminalControlValue const * _request_get(
+		TerminalControlRequest const * request, char const * key)
+{
+	size_t i;
+
+	for(i = 0; i < request->values_cnt; i++)
+		if(strcmp(request->values[i].key, key) == 0)
+			return &request->values[i];
+	return NULL;
+}
+
+
+/* terminalcontrol_request_get_string */
+char const * terminalcontrol_request_get_string(
+		TerminalControlRequest const * request, char const * key)
+{
+	TerminalControlValue const * v;
+
+	if((v = _request_get(request, key)) == NULL || v->string == FALSE)
+		return NULL;
+	return v->value;
+}
+
+
+/* terminalcontrol_request_get_uint */
+int terminalcontrol_request_get_uint(TerminalControlRequest const * request,
+		char const * key, unsigned int * value)
+{
+	TerminalControlValue const * v;
+	char * p;
+	unsigned long u;
+
+	if((v = _request_get(request, key)) == NULL)
+		return 0;
+	errno = 0;
+	if(v->string || v->value[0] < '0' || v->value[0] > '9'
+			|| (u = strtoul(v->value, &p, 10)) > UINT_MAX
+			|| *p != '\0' || errno != 0)
+		return -error_set_code(1, "%s: %s", key, _("Invalid value"));
+	*value = u;
+	return 0;
+}
+
+
+/* useful */
+/* terminalcontrol_append_string */
+void terminalcontrol_append_string(GString * json, char const * string)
+{
+	unsigned char const * s;
+
+	g_string_append_c(json, '"');
+	for(s = (unsigned char const *)string; *s != '\0'; s++)
+		if(*s == '"' || *s == '\\')
+		{
+			g_string_append_c(json, '\\');
+			g_string_append_c(json, *s);
+		}
+		else if(*s == '\n')
+			g_string_append(json, "\\n");
+		else if(*s < 0x20 || *s == 0x7f)
+			g_string_append_printf(json, "\\u%04x", *s);
+		else
+			g_string_append_c(json, *s);
+	g_string_append_c(json, '"');
+}
+
+
+/* terminalcontrol_event */
+void terminalcontrol_event(TerminalControl * control, char const * event,
+		char const * members)
+{
+	GString * line = NULL;
+	TerminalControlClient * client;
+	size_t i;
+
+	for(i = 0; i < control->clients_cnt; i++)
+	{
+		if((client = control->clients[i])->subscribed == FALSE)
+			continue;
+		if(line == NULL)
+		{
+			line = g_string_new("{\"event\":");
+			terminalcontrol_append_string(line, event);
+			g_string_append(line, members);
+			g_string_append(line, "}\n");
+		}
+		/* the events are not queued forever */
+		if(client->out->len >= TERMINALCONTROL_OUTPUT_SIZE)
+		{
+			client->subscribed = FALSE;
+			_terminalcontrol_client_write(client,
+					"{\"event\":\"overflow\"}\n", 20);
+		}
+		else if(_terminalcontrol_client_write(client, line->str,
+					line->len) != 0)
+			client->subscribed = FALSE;
+	}
+	if(line != NULL)
+		g_string_free(line, TRUE);
+}
+
+
+/* private */
+/* functions */
+/* terminalcontrol_set_cloexec */
+static int _terminalcontrol_set_cloexec(int fd)
+{
+	int flags;
+
+	/* the children must not inherit our sockets */
+	if((flags = fcntl(fd, F_GETFD)) == -1
+			|| fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1)
+		return -error_set_code(1, "%s: %s", "fcntl", strerror(errno));
+	return 0;
+}
+
+
+/* clients */
+/* terminalcontrol_client_delete */
+static void _terminalcontrol_client_delete(TerminalControlClient * client)
+{
+	if(client->source > 0)
+		g_source_remove(client->source);
+	if(client->source_out > 0)
+		g_source_remove(client->source_out);
+	close(client->fd);
+	g_string_free(client->out, TRUE);
+	object_delete(client);
+}
+
+
+/* terminalcontrol_client_process */
+static int _process_parse(char const * line, char * w,
+		TerminalControlRequest ** requests, size_t * requests_cnt);
+
+static int _terminalcontrol_client_process(TerminalControlClient * client,
+		char const * line)
+{
+	TerminalControlRequest * requests = NULL;
+	size_t requests_cnt = 0;
+	int batch;
+	GString * reply;
+	size_t i;
+	int ret = 0;
+
+	reply = g_string_new(NULL);
+	/* nothing is done unless the whole line is valid */
+	if((batch = _process_parse(line, client->values, &requests,
+					&requests_cnt)) < 0)
+	{
+		g_string_append(reply, "{\"ok\":false,\"error\":");
+		terminalcontrol_append_string(reply, _("Invalid request"));
+		g_string_append_c(reply, '}');
+	}
+	else
+	{
+		/* the commands of a batch are replied to at once */
+		if(batch)
+			g_string_append_c(reply, '[');
+		for(i = 0; i < requests_cnt; i++)
+		{
+			if(i > 0)
+				g_string_append_c(reply, ',');
+			_terminalcontrol_client_reply(client, &requests[i],
+					reply);
+		}
+		if(batch)
+			g_string_append_c(reply, ']');
+	}
+	free(requests);
+	g_string_append_c(reply, '\n');
+	if(_terminalcontrol_client_write(client, reply->str, reply->len) != 0)
+		ret = -1;
+	g_string_free(reply, TRUE);
+	return ret;
+}
+
+static int _process_parse(char const * line, char * w,
+		TerminalControlRequest ** requests, size_t * requests_cnt)
+{
+	char const * p = line;
+	int batch;
+	TerminalControlRequest * q;
+
+	_terminalcontrol_parse_whitespace(&p);
+	if((batch = (*p == '[')))
+	{
+		p++;
+		_terminalcontrol_parse_whitespace(&p);
+	}
+	while(!batch || *p != ']')
+	{
+		if(batch && *requests_cnt > 0 && *(p++) != ',')
+			return -1;
+		if((q = realloc(*requests, sizeof(*q) * (*requests_cnt + 1)))
+				== NULL)
+			return -1;
+		*requests = q;
+		if(_terminalcontrol_parse_request(&p, &w,
+					&q[(*requests_cnt)++]) != 0)
+			return -1;
+		_terminalcontrol_parse_whitespace(&p);
+		if(!batch)
+			break;
+	}
+	if(batch)
+		p++;
+	_terminalcontrol_parse_whitespace(&p);
+	return (*p == '\0') ? batch : -1;
+}
+
+
+/* terminalcontrol_client_remove */
+static void _terminalcontrol_client_remove(TerminalControlClient * client)
+{
+	TerminalControl * control = client->control;
+	size_t i;
+
+	for(i = 0; i < control->clients_cnt; i++)
+		if(control->clients[i] == client)
+		{
+			memmove(&control->clients[i], &control->clients[i + 1],
+					(control->clients_cnt - (i + 1))
+					* sizeof(*control->clients));
+			control->clients_cnt--;
+			break;
+		}
+	_terminalcontrol_client_delete(client);
+}
+
+
+/* terminalcontrol_client_reply */
+static void _terminalcontrol_client_reply(TerminalControlClient * client,
+		TerminalControlRequest * request, GString * reply)
+{
+	TerminalControl * control = client->control;
+	TerminalControlValue const * id;
+	char const * command;
+	GString * members;
+	int res;
+
+	g_string_append_c(reply, '{');
+	/* the identifier of the command is returned as is */
+	if((id = _request_get(request, "id")) != NULL)
+	{
+		g_string_append(reply, "\"id\":");
+		if(id->string)
+			terminalcontrol_append_string(reply, id->value);
+		else
+			g_string_append(reply, id->value);
+		g_string_append_c(reply, ',');
+	}
+	members = g_string_new(NULL);
+	if((command = terminalcontrol_request_get_string(request, "command"))
+			== NULL)
+		res = -error_set_code(1, "%s", _("No command given"));
+	else if(strcmp(command, "subscribe") == 0)
+	{
+		client->subscribed = TRUE;
+		res = 0;
+	}
+	else if(strcmp(command, "unsubscribe") == 0)
+	{
+		client->subscribed = FALSE;
+		res = 0;
+	}
+	else
+		res = control->callback(control->data, command, request,
+				members);
+	if(res == 0)
+		g_string_append(reply, "\"ok\":true");
+	else
+	{
+		g_string_append(reply, "\"ok\":false,\"error\":");
+		terminalcontrol_append_string(reply, error_get(NULL));
+	}
+	g_string_append_len(reply, members->str, members->len);
+	g_string_append_c(reply, '}');
+	g_string_free(members, TRUE);
+}
+
+
+/* terminalcontrol_client_write */
+static int _terminalcontrol_client_write(TerminalControlClient * client,
+		char const * buf, size_t len)
+{
+	ssize_t s = 0;
+	GIOChannel * channel;
+
+	/* the messages are kept in order */
+	if(client->out->len == 0
+			&& (s = send(client->fd, buf, len, MSG_NOSIGNAL)) < 0)
+	{
+		if(errno != EAGAIN)
+			return -1;
+		s = 0;
+	}
+	if((size_t)s == len)
+		return 0;
+	g_string_append_len(client->out, &buf[s], len - s);
+	if(client->source_out == 0)
+	{
+		channel = g_io_channel_unix_new(client->fd);
+		client->source_out = g_io_add_watch(channel, G_IO_OUT,
+				_terminalcontrol_on_output, client);
+		g_io_channel_unref(channel);
+	}
+	return 0;
+}
+
+
+/* parser */
+/* terminalcontrol_parse_request */
+static int _terminalcontrol_parse_request(char const ** p, char ** w,
+		TerminalControlRequest * request)
+{
+	TerminalControlValue * v;
+
+	request->values_cnt = 0;
+	_terminalcontrol_parse_whitespace(p);
+	if(**p != '{')
+		return -1;
+	(*p)++;
+	_terminalcontrol_parse_whitespace(p);
+	if(**p == '}')
+	{
+		(*p)++;
+		return 0;
+	}
+	/* only flat objects are supported */
+	for(;;)
+	{
+		if(request->values_cnt == TERMINALCONTROL_VALUES)
+			return -1;
+		v = &request->values[request->values_cnt++];
+		v->key = *w;
+		if(_terminalcontrol_parse_string(p, w) != 0)
+			return -1;
+		_terminalcontrol_parse_whitespace(p);
+		if(*((*p)++) != ':')
+			return -1;
+		_terminalcontrol_parse_whitespace(p);
+		v->value = *w;
+		v->string = (**p == '"') ? TRUE : FALSE;
+		if((v->string ? _terminalcontrol_parse_string(p, w)
+					: _terminalcontrol_parse_scalar(p, w))
+				!= 0)
+			return -1;
+		_terminalcontrol_parse_whitespace(p);
+		if(**p == '}')
+			break;
+		if(*((*p)++) != ',')
+			return -1;
+		_terminalcontrol_parse_whitespace(p);
+	}
+	(*p)++;
+	return 0;
+}
+
+
+/* terminalcontrol_parse_scalar */
+static int _terminalcontrol_parse_scalar(char const ** p, char ** w)
+{
+	char const * s = *w;
+	char * q;
+
+	while((**p >= '0' && **p <= '9') || (**p >= 'a' && **p <= 'z')
+			|| **p == '-' || **p == '+' || **p == '.'
+			|| **p == 'E')
+		*((*w)++) = *((*p)++);
+	*((*w)++) = '\0';
+	if(strcmp(s, "true") == 0 || strcmp(s, "false") == 0
+			|| strcmp(s, "null") == 0)
+		return 0;
+	/* a number otherwise */
+	if(s[0] == '\0' || (strtod(s, &q), *q != '\0'))
+		return -1;
+	return 0;
+}
+
+
+/* terminalcontrol_parse_string */
+static int _parse_string_hex(char const ** p, unsigned long * c);
+
+static int _terminalcontrol_parse_string(char const ** p, char ** w)
+{
+	unsigned long c;
+	unsigned long d;
+
+	if(*((*p)++) != '"')
+		return -1;
+	while((c = (unsigned char)*((*p)++)) != '"')
+	{
+		if(c < 0x20)
+			return -1;
+		if(c != '\\')
+		{
+			*((*w)++) = c;
+			continue;
+		}
+		switch((c = *((*p)++)))
+		{
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			case 'b':
+				c = '\b';
+				break;
+			case 'f':
+				c = '\f';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			case 'u':
+				if(_parse_string_hex(p, &c) != 0 || c == 0)
+					return -1;
+				/* beyond the BMP as surrogate pairs */
+				if(c >= 0xd800 && c < 0xdc00 && (*p)[0] == '\\'
+						&& (*p)[1] == 'u')
+				{
+					*p += 2;
+					if(_parse_string_hex(p, &d) != 0
+							|| d < 0xdc00
+							|| d >= 0xe000)
+						return -1;
+					c = 0x10000 + ((c - 0xd800) << 10)
+						+ (d - 0xdc00);
+				}
+				else if(c >= 0xd800 && c < 0xe000)
+					return -1;
+				/* encoded in UTF-8 */
+				if(c < 0x80)
+					break;
+				if(c < 0x800)
+					*((*w)++) = 0xc0 | (c >> 6);
+				else
+				{
+					if(c < 0x10000)
+						*((*w)++) = 0xe0 | (c >> 12);
+					else
+					{
+						*((*w)++) = 0xf0 | (c >> 18);
+						*((*w)++) = 0x80
+							| ((c >> 12) & 0x3f);
+					}
+					*((*w)++) = 0x80 | ((c >> 6) & 0x3f);
+				}
+				c = 0x80 | (c & 0x3f);
+				break;
+			default:
+				return -1;
+		}
+		*((*w)++) = c;
+	}
+	*((*w)++) = '\0';
+	return 0;
+}
+
+static int _parse_string_hex(char const ** p, unsigned long * c)
+{
+	size_t i;
+
+	for(*c = 0, i = 0; i < 4; i++, (*p)++)
+		if(**p >= '0' && **p <= '9')
+			*c = (*c << 4) | (**p - '0');
+		else if(**p >= 'a' && **p <= 'f')
+			*c = (*c << 4) | (**p - 'a' + 10);
+		else if(**p >= 'A' && **p <= 'F')
+			*c = (*c << 4) | (**p - 'A' + 10);
+		else
+			return -1;
+	return 0;
+}
+
+
+/* terminalcontrol_parse_whitespace */
+static void _terminalcontrol_parse_whitespace(char const ** p)
+{
+	while(**p == ' ' || **p == '\t' || **p == '\r' || **p == '\n')
+		(*p)++;
+}
+
+
+/* callbacks */
+/* terminalcontrol_on_accept */
+static gboolean _terminalcontrol_on_accept(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalControl * control = data;
+	TerminalControlClient ** p;
+	TerminalControlClient * client;
+	GIOChannel * channel;
+	int fd;
+
+	if(condition != G_IO_IN)
+		return TRUE;
+	if((fd = accept(g_io_channel_unix_get_fd(source), NULL, NULL)) < 0)
+		return TRUE;
+	if(_terminalcontrol_set_cloexec(fd) != 0
+			|| fcntl(fd, F_SETFL, O_NONBLOCK) != 0
+			|| (p = realloc(control->clients, sizeof(*p)
+					* (control->clients_cnt + 1))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	control->clients = p;
+	if((client = object_new(sizeof(*client))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	control->clients[control->clients_cnt++] = client;
+	client->control = control;
+	client->fd = fd;
+	client->source_out = 0;
+	client->closing = FALSE;
+	client->subscribed = FALSE;
+	client->len = 0;
+	client->out = g_string_new(NULL);
+	channel = g_io_channel_unix_new(fd);
+	client->source = g_io_add_watch(channel, G_IO_IN | G_IO_HUP
+			| G_IO_ERR, _terminalcontrol_on_client, client);
+	g_io_channel_unref(channel);
+	return TRUE;
+}
+
+
+/* terminalcontrol_on_client */
+static gboolean _terminalcontrol_on_client(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalControlClient * client = data;
+	ssize_t s = -1;
+	char * p;
+	size_t i;
+	(void) source;
+
+	if((condition & (G_IO_IN | G_IO_HUP))
+			&& (s = read(client->fd, &client->buf[client->len],
+					sizeof(client->buf) - client->len))
+			< 0 && errno == EAGAIN)
+		return TRUE;
+	if(s > 0)
+	{
+		client->len += s;
+		/* every line is a command, or a batch of commands */
+		for(i = 0; (p = memchr(&client->buf[i], '\n', client->len - i))
+				!= NULL; i = p - client->buf + 1)
+		{
+			*p = '\0';
+			/* the clients not reading their replies are dropped */
+			if(client->out->len >= TERMINALCONTROL_OUTPUT_SIZE
+					|| _terminalcontrol_client_process(
+						client, &client->buf[i]) != 0)
+				break;
+		}
+		if(p == NULL && i < client->len)
+			memmove(client->buf, &client->buf[i], client->len - i);
+		client->len -= i;
+		if(p == NULL && client->len < sizeof(client->buf))
+			return TRUE;
+	}
+	/* the replies pending are sent first */
+	client->source = 0;
+	if(s == 0 && client->out->len > 0)
+		client->closing = TRUE;
+	else
+		_terminalcontrol_client_remove(client);
+	return FALSE;
+}
+
+
+/* terminalcontrol_on_output */
+static gboolean _terminalcontrol_on_output(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalControlClient * client = data;
+	ssize_t s;
+	(void) source;
+	(void) condition;
+
+	if((s = send(client->fd, client->out->str, client->out->len,
+					MSG_NOSIGNAL)) < 0)
+	{
+		if(errno == EAGAIN)
+			return TRUE;
+	}
+	else
+	{
+		g_string_erase(client->out, 0, s);
+		if(client->out->len > 0)
+			return TRUE;
+		if(client->closing == FALSE)
+		{
+			client->source_out = 0;
+			return FALSE;
+		}
+	}
+	client->source_out = 0;
+	_terminalcontrol_client_remove(client);
+	return FALSE;
+}
@@ -0,0 +1,74 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_CONTROL_H
+# define TERMINAL_CONTROL_H
+
+# include <gtk/gtk.h>
+
+
+/* Control */
+/* public */
+/* types */
+typedef struct _TerminalControl TerminalControl;
+
+/* the members of one command received */
+typedef struct _TerminalControlRequest TerminalControlRequest;
+
+/* appends the members of the reply, each preceded by a comma, and returns 0
+ * or -1 with the error set */
+typedef int (*TerminalControlCallback)(void * data, char const * command,
+		TerminalControlRequest const * request, GString * reply);
+
+
+/* functions */
+/* essential */
+TerminalControl * terminalcontrol_new(char const * path,
+		TerminalControlCallback callback, void * data);
+void terminalcontrol_delete(TerminalControl * control);
+
+
+/* accessors */
+char const * terminalcontrol_get_path(TerminalControl * control);
+
+/* returns 0 if the member is missing, -1 if it has the wrong type */
+int terminalcontrol_request_get_boolean(TerminalControlRequest const * request,
+		char const * key, unsigned int * value);
+char const * terminalcontrol_request_get_string(
+		TerminalControlRequest const * request, char const * key);
+int terminalcontrol_request_get_uint(TerminalControlRequest const * request,
+		char const * key, unsigned int * value);
+
+
+/* useful */
+void terminalcontrol_append_string(GString * json, char const * string);
+
+/* sent to the clients subscribed, the members preceded by a comma */
+void terminalcontrol_event(TerminalControl * control, char const * event,
+		char const * members);
+
+#endif /* !TERMINAL_CONTROL_H */
@@ -0,0 +1,699 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/mman.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include "history.h"
+
+/* constants */
+#define TERMINALHISTORY_BLOCK		65536
+/* the blocks end with a complete line once this close to full */
+#define TERMINALHISTORY_BLOCK_LINE	4096
+#define TERMINALHISTORY_BLOOM_BITS	15
+#define TERMINALHISTORY_BLOOM		(1 << TERMINALHISTORY_BLOOM_BITS)
+#define TERMINALHISTORY_FRAME_MAX	4096
+#define TERMINALHISTORY_MAGIC		0x31425448
+/* favor the speed over the size */
+#define TERMINALHISTORY_LEVEL		1
+#define TERMINALHISTORY_SIZE_MIN	65536
+
+
+/* History */
+/* private */
+/* types */
+typedef enum _TerminalHistoryState
+{
+	THS_TEXT = 0,
+	THS_ESCAPE,
+	THS_CHARSET,
+	THS_CSI,
+	THS_STRING,
+	THS_STRING_ESCAPE
+} TerminalHistoryState;
+
+/* precedes every block in the file, followed by the text compressed */
+typedef struct _TerminalHistoryHeader
+{
+	uint32_t magic;
+	uint32_t size;				/* of the text */
+	uint32_t compressed;
+	uint32_t reserved;
+	uint64_t offset;			/* of the text in the history */
+	/* trigrams found in the text */
+	unsigned char bloom[TERMINALHISTORY_BLOOM / 8];
+} TerminalHistoryHeader;
+
+struct _TerminalHistory
+{
+	int fd;
+	int error;
+
+	/* shared between the indexer and the searches */
+	pthread_mutex_t mutex;
+	off_t * blocks;				/* position in the file */
+	size_t blocks_cnt;
+	size_t blocks_alloc;
+	off_t stored;
+	uint64_t offset;			/* of the current block */
+	TerminalHistoryHeader header;		/* of the current block */
+	char text[TERMINALHISTORY_BLOCK];
+
+	/* ring buffer, with a single producer and a single consumer */
+	char * ring;
+	size_t size;				/* a power of two */
+	atomic_size_t head;			/* set by the producer */
+	atomic_size_t tail;			/* set by the consumer */
+	atomic_ulong dropped;			/* in bytes */
+
+	/* indexer */
+	pthread_t thread;
+	int pipe[2];
+	atomic_int sleeping;
+	atomic_int stopping;
+	TerminalHistoryState state;
+	uint32_t trigram;
+	char input[TERMINALHISTORY_FRAME_MAX];
+	unsigned char * output;
+	uLong output_size;
+};
+
+
+/* prototypes */
+static void _terminalhistory_copy_in(TerminalHistory * history,
+		size_t pos, void const * buf, size_t len);
+static void _terminalhistory_copy_out(TerminalHistory * history,
+		size_t pos, void * buf, size_t len);
+static void _terminalhistory_destroy(TerminalHistory * history);
+static unsigned char _terminalhistory_fold(unsigned char c);
+static uint32_t _terminalhistory_hash(uint32_t trigram);
+static int _terminalhistory_matches(unsigned char const * bloom,
+		uint32_t const * hashes, size_t hashes_cnt);
+static int _terminalhistory_search_text(char const * text, size_t size,
+		uint64_t offset, char const * string, size_t len,
+		TerminalHistoryCallback callback, void * data, int * count);
+static void _terminalhistory_wake(TerminalHistory * history);
+
+/* indexer */
+static void _terminalhistory_append(TerminalHistory * history,
+		char const * buf, size_t len);
+static void _terminalhistory_filter(TerminalHistory * history, size_t len);
+static void _terminalhistory_flush(TerminalHistory * history);
+static void * _terminalhistory_thread(void * data);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalhistory_new */
+TerminalHistory * terminalhistory_new(char const * directory, size_t size)
+{
+	TerminalHistory * history;
+	char * filename;
+	int i;
+	sigset_t set;
+	sigset_t oset;
+	int res;
+
+	if((history = malloc(sizeof(*history))) == NULL)
+		return NULL;
+	history->fd = -1;
+	history->error = 0;
+	pthread_mutex_init(&history->mutex, NULL);
+	history->blocks = NULL;
+	history->blocks_cnt = 0;
+	history->blocks_alloc = 0;
+	history->stored = 0;
+	history->offset = 0;
+	memset(&history->header, 0, sizeof(history->header));
+	for(history->size = TERMINALHISTORY_SIZE_MIN; history->size < size;
+			history->size <<= 1);
+	history->ring = malloc(history->size);
+	atomic_init(&history->head, 0);
+	atomic_init(&history->tail, 0);
+	atomic_init(&history->dropped, 0);
+	history->pipe[0] = -1;
+	history->pipe[1] = -1;
+	atomic_init(&history->sleeping, 0);
+	atomic_init(&history->stopping, 0);
+	history->state = THS_TEXT;
+	history->trigram = 0;
+	history->output_size = compressBound(TERMINALHISTORY_BLOCK);
+	history->output = malloc(history->output_size);
+	if(history->ring == NULL || history->output == NULL
+			|| (filename = malloc(strlen(directory)
+					+ sizeof("/history.XXXXXX"))) == NULL)
+	{
+		_terminalhistory_destroy(history);
+		errno = ENOMEM;
+		return NULL;
+	}
+	/* the file is private, and gone along with the history */
+	sprintf(filename, "%s/history.XXXXXX", directory);
+	if((history->fd = mkstemp(filename)) >= 0)
+	{
+		unlink(filename);
+		fcntl(history->fd, F_SETFD, FD_CLOEXEC);
+	}
+	free(filename);
+	if(history->fd < 0 || pipe(history->pipe) != 0)
+	{
+		res = errno;
+		_terminalhistory_destroy(history);
+		errno = res;
+		return NULL;
+	}
+	/* the producer must never block */
+	for(i = 0; i < 2; i++)
+	{
+		fcntl(history->pipe[i], F_SETFD, FD_CLOEXEC);
+		fcntl(history->pipe[i], F_SETFL, O_NONBLOCK);
+	}
+	/* the signals are left to the other threads */
+	sigfillset(&set);
+	pthread_sigmask(SIG_SETMASK, &set, &oset);
+	res = pthread_create(&history->thread, NULL, _terminalhistory_thread,
+			history);
+	pthread_sigmask(SIG_SETMASK, &oset, NULL);
+	if(res != 0)
+	{
+		_terminalhistory_destroy(history);
+		errno = res;
+		return NULL;
+	}
+	return history;
+}
+
+
+/* terminalhistory_delete */
+void terminalhistory_delete(TerminalHistory * history)
+{
+	atomic_store(&history->stopping, 1);
+	_terminalhistory_wake(history);
+	pthread_join(history->thread, NULL);
+	_terminalhistory_destroy(history);
+}
+
+
+/* accessors */
+/* terminalhistory_get_dropped */
+unsigned long terminalhistory_get_dropped(TerminalHistory * history)
+{
+	return atomic_load_explicit(&history->dropped, memory_order_relaxed);
+}
+
+
+/* terminalhistory_get_size */
+size_t terminalhistory_get_size(TerminalHistory * history,
+		size_t * stored)
+{
+	size_t ret;
+
+	pthread_mutex_lock(&history->mutex);
+	ret = history->offset + history->header.size;
+	if(stored != NULL)
+		*stored = history->stored;
+	pthread_mutex_unlock(&history->mutex);
+	return ret;
+}
+
+
+/* useful */
+/* terminalhistory_output */
+void terminalhistory_output(TerminalHistory * history, char const * buf,
+		size_t len)
+{
+	size_t head;
+	size_t tail;
+
+	head = atomic_load_explicit(&history->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&history->tail, memory_order_acquire);
+	if(len > history->size - (head - tail))
+	{
+		atomic_fetch_add_explicit(&history->dropped, len,
+				memory_order_relaxed);
+		return;
+	}
+	_terminalhistory_copy_in(history, head, buf, len);
+	/* ordered with the indexer going to sleep */
+	atomic_store(&history->head, head + len);
+	_terminalhistory_wake(history);
+}
+
+
+/* terminalhistory_search */
+int terminalhistory_search(TerminalHistory * history, char const * string,
+		TerminalHistoryCallback callback, void * data)
+{
+	int ret = 0;
+	size_t len;
+	uint32_t * hashes = NULL;
+	size_t hashes_cnt;
+	uint32_t trigram = 0;
+	off_t * blocks = NULL;
+	size_t blocks_cnt;
+	off_t stored;
+	unsigned char * map = MAP_FAILED;
+	TerminalHistoryHeader const * header;
+	char * text;
+	uLongf size;
+	uint64_t offset;
+	size_t i;
+	int res = 0;
+
+	if((len = strlen(string)) == 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	/* the trigrams of the string have to be found in the blocks */
+	hashes_cnt = (len >= 3) ? len - 2 : 0;
+	if((text = malloc(TERMINALHISTORY_BLOCK)) == NULL
+			|| (hashes_cnt > 0 && (hashes = malloc(sizeof(*hashes)
+						* hashes_cnt)) == NULL))
+	{
+		free(text);
+		return -1;
+	}
+	for(i = 0; i < len; i++)
+	{
+		trigram = ((trigram << 8) | _terminalhistory_fold(string[i]))
+			& 0xffffff;
+		if(i >= 2)
+			hashes[i - 2] = _terminalhistory_hash(trigram);
+	}
+	/* the blocks stored so far, without holding the indexer back */
+	pthread_mutex_lock(&history->mutex);
+	blocks_cnt = history->blocks_cnt;
+	stored = history->stored;
+	if(blocks_cnt > 0 && (blocks = malloc(sizeof(*blocks) * blocks_cnt))
+			!= NULL)
+		memcpy(blocks, history->blocks, sizeof(*blocks) * blocks_cnt);
+	pthread_mutex_unlock(&history->mutex);
+	if((blocks_cnt > 0 && blocks == NULL) || (stored > 0
+				&& (map = mmap(NULL, stored, PROT_READ,
+						MAP_SHARED, history->fd, 0))
+				== MAP_FAILED))
+	{
+		free(blocks);
+		free(hashes);
+		free(text);
+		return -1;
+	}
+	for(i = 0; res == 0 && i < blocks_cnt; i++)
+	{
+		header = (TerminalHistoryHeader const *)&map[blocks[i]];
+		if(!_terminalhistory_matches(header->bloom, hashes, hashes_cnt))
+			continue;
+		size = TERMINALHISTORY_BLOCK;
+		if(uncompress((Bytef *)text, &size, (Bytef const *)&header[1],
+					header->compressed) != Z_OK)
+			continue;
+		res = _terminalhistory_search_text(text, size, header->offset,
+				string, len, callback, data, &ret);
+	}
+	/* the current block last */
+	if(res == 0)
+	{
+		pthread_mutex_lock(&history->mutex);
+		size = 0;
+		offset = history->offset;
+		if(_terminalhistory_matches(history->header.bloom, hashes,
+					hashes_cnt))
+		{
+			size = history->header.size;
+			memcpy(text, history->text, size);
+		}
+		pthread_mutex_unlock(&history->mutex);
+		_terminalhistory_search_text(text, size, offset, string, len,
+				callback, data, &ret);
+	}
+	if(map != MAP_FAILED)
+		munmap(map, stored);
+	free(blocks);
+	free(hashes);
+	free(text);
+	return ret;
+}
+
+
+/* private */
+/* functions */
+/* terminalhistory_copy_in */
+static void _terminalhistory_copy_in(TerminalHistory * history,
+		size_t pos, void const * buf, size_t len)
+{
+	size_t offset = pos & (history->size - 1);
+	size_t n;
+
+	n = (len < history->size - offset) ? len : history->size - offset;
+	memcpy(&history->ring[offset], buf, n);
+	memcpy(history->ring, (char const *)buf + n, len - n);
+}
+
+
+/* terminalhistory_copy_out */
+static void _terminalhistory_copy_out(TerminalHistory * history,
+		size_t pos, void * buf, size_t len)
+{
+	size_t offset = pos & (history->size - 1);
+	size_t n;
+
+	n = (len < history->size - offset) ? len : history->size - offset;
+	memcpy(buf, &history->ring[offset], n);
+	memcpy((char *)buf + n, history->ring, len - n);
+}
+
+
+/* terminalhistory_destroy */
+static void _terminalhistory_destroy(TerminalHistory * history)
+{
+	int i;
+
+	if(history->fd >= 0)
+		close(history->fd);
+	for(i = 0; i < 2; i++)
+		if(history->pipe[i] >= 0)
+			close(history->pipe[i]);
+	pthread_mutex_destroy(&history->mutex);
+	free(history->blocks);
+	free(history->output);
+	free(history->ring);
+	free(history);
+}
+
+
+/* terminalhistory_fold */
+static unsigned char _terminalhistory_fold(unsigned char c)
+{
+	/* only ASCII, consistently with the searches */
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+/* terminalhistory_hash */
+static uint32_t _terminalhistory_hash(uint32_t trigram)
+{
+	/* multiplicative hashing */
+	return (trigram * UINT32_C(2654435761))
+		>> (32 - TERMINALHISTORY_BLOOM_BITS);
+}
+
+
+/* terminalhistory_matches */
+static int _terminalhistory_matches(unsigned char const * bloom,
+		uint32_t const * hashes, size_t hashes_cnt)
+{
+	size_t i;
+
+	/* may be a false positive */
+	for(i = 0; i < hashes_cnt; i++)
+		if((bloom[hashes[i] >> 3] & (1 << (hashes[i] & 7))) == 0)
+			return 0;
+	return 1;
+}
+
+
+/* terminalhistory_search_text */
+static int _terminalhistory_search_text(char const * text, size_t size,
+		uint64_t offset, char const * string, size_t len,
+		TerminalHistoryCallback callback, void * data, int * count)
+{
+	size_t i;
+	size_t j;
+	size_t start;
+	char const * p;
+	size_t end;
+	int res;
+
+	for(i = 0; i + len <= size; i++)
+	{
+		for(j = 0; j < len && _terminalhistory_fold(text[i + j])
+				== _terminalhistory_fold(string[j]); j++);
+		if(j != len)
+			continue;
+		/* the whole line is reported, once */
+		for(start = i; start > 0 && text[start - 1] != '\n'; start--);
+		end = ((p = memchr(&text[i], '\n', size - i)) != NULL)
+			? (size_t)(p - text) : size;
+		(*count)++;
+		if((res = callback(data, offset + start, &text[start],
+						end - start)) != 0)
+			return res;
+		i = end;
+	}
+	return 0;
+}
+
+
+/* terminalhistory_wake */
+static void _terminalhistory_wake(TerminalHistory * history)
+{
+	char c = '\0';
+
+	if(atomic_load(&history->sleeping)
+			&& atomic_exchange(&history->sleeping, 0)
+			&& write(history->pipe[1], &c, sizeof(c)) < 0)
+		/* the indexer has been woken up already */
+		return;
+}
+
+
+/* indexer */
+/* terminalhistory_append */
+static void _terminalhistory_append(TerminalHistory * history,
+		char const * buf, size_t len)
+{
+	TerminalHistoryHeader * header = &history->header;
+	size_t n;
+	size_t start;
+	char const * p;
+	size_t i;
+	uint32_t h;
+
+	for(; len > 0; buf += n, len -= n)
+	{
+		n = TERMINALHISTORY_BLOCK - header->size;
+		n = (len < n) ? len : n;
+		/* the lines are only split when very long */
+		start = (header->size < TERMINALHISTORY_BLOCK
+				- TERMINALHISTORY_BLOCK_LINE)
+			? TERMINALHISTORY_BLOCK - TERMINALHISTORY_BLOCK_LINE
+			- header->size : 0;
+		if(start < n && (p = memchr(&buf[start], '\n', n - start))
+				!= NULL)
+			n = p - buf + 1;
+		else
+			p = NULL;
+		pthread_mutex_lock(&history->mutex);
+		memcpy(&history->text[header->size], buf, n);
+		for(i = 0; i < n; i++)
+		{
+			history->trigram = ((history->trigram << 8)
+					| _terminalhistory_fold(buf[i]))
+				& 0xffffff;
+			/* the trigrams never span two blocks */
+			if(header->size + i < 2)
+				continue;
+			h = _terminalhistory_hash(history->trigram);
+			header->bloom[h >> 3] |= 1 << (h & 7);
+		}
+		header->size += n;
+		pthread_mutex_unlock(&history->mutex);
+		if(p != NULL || header->size == TERMINALHISTORY_BLOCK)
+			_terminalhistory_flush(history);
+	}
+}
+
+
+/* terminalhistory_filter */
+static void _terminalhistory_filter(TerminalHistory * history, size_t len)
+{
+	unsigned char * buf = (unsigned char *)history->input;
+	size_t i;
+	size_t j;
+	unsigned char c;
+
+	/* only the text is kept, without the escape sequences */
+	for(i = 0, j = 0; i < len; i++)
+	{
+		c = buf[i];
+		switch(history->state)
+		{
+			case THS_TEXT:
+				if(c == 0x1b)
+					history->state = THS_ESCAPE;
+				else if(c == '\n' || c == '\t'
+						|| (c >= 0x20 && c != 0x7f))
+					buf[j++] = c;
+				break;
+			case THS_ESCAPE:
+				if(c == '[')
+					history->state = THS_CSI;
+				else if(c == ']' || c == 'P' || c == '^'
+						|| c == '_' || c == 'X')
+					history->state = THS_STRING;
+				else if(c >= 0x20 && c <= 0x2f)
+					history->state = THS_CHARSET;
+				else
+					history->state = THS_TEXT;
+				break;
+			case THS_CHARSET:
+				history->state = THS_TEXT;
+				break;
+			case THS_CSI:
+				if(c >= 0x40 && c <= 0x7e)
+					history->state = THS_TEXT;
+				break;
+			case THS_STRING:
+				if(c == 0x07)
+					history->state = THS_TEXT;
+				else if(c == 0x1b)
+					history->state = THS_STRING_ESCAPE;
+				break;
+			case THS_STRING_ESCAPE:
+				history->state = (c == '\\') ? THS_TEXT
+					: THS_STRING;
+				break;
+		}
+	}
+	_terminalhistory_append(history, history->input, j);
+}
+
+
+/* terminalhistory_flush */
+static void _terminalhistory_flush(TerminalHistory * history)
+{
+	TerminalHistoryHeader * header = &history->header;
+	uLongf len = history->output_size;
+	off_t * p;
+
+	/* the text is only read by the searches meanwhile */
+	if(history->error == 0)
+	{
+		header->magic = TERMINALHISTORY_MAGIC;
+		header->offset = history->offset;
+		if(compress2(history->output, &len, (Bytef *)history->text,
+					header->size, TERMINALHISTORY_LEVEL)
+				!= Z_OK)
+			history->error = ENOMEM;
+		else
+		{
+			header->compressed = len;
+			if(pwrite(history->fd, header, sizeof(*header),
+						history->stored)
+					!= sizeof(*header)
+					|| pwrite(history->fd, history->output,
+						len, history->stored
+						+ sizeof(*header))
+					!= (ssize_t)len)
+				history->error = (errno != 0) ? errno : EIO;
+		}
+	}
+	pthread_mutex_lock(&history->mutex);
+	if(history->error == 0 && history->blocks_cnt
+			== history->blocks_alloc)
+	{
+		if((p = realloc(history->blocks, sizeof(*p)
+						* (history->blocks_alloc + 64)))
+				== NULL)
+			history->error = ENOMEM;
+		else
+		{
+			history->blocks = p;
+			history->blocks_alloc += 64;
+		}
+	}
+	/* the text is lost if it could not be stored */
+	if(history->error == 0)
+	{
+		history->blocks[history->blocks_cnt++] = history->stored;
+		history->stored += sizeof(*header) + len;
+	}
+	history->offset += header->size;
+	header->size = 0;
+	memset(header->bloom, 0, sizeof(header->bloom));
+	pthread_mutex_unlock(&history->mutex);
+}
+
+
+/* terminalhistory_thread */
+static void * _terminalhistory_thread(void * data)
+{
+	TerminalHistory * history = data;
+	size_t head;
+	size_t tail;
+	size_t n;
+	struct pollfd pfd;
+	char buf[64];
+
+	pfd.fd = history->pipe[0];
+	pfd.events = POLLIN;
+	tail = atomic_load_explicit(&history->tail, memory_order_relaxed);
+	for(;;)
+	{
+		head = atomic_load_explicit(&history->head,
+				memory_order_acquire);
+		for(; tail != head; tail += n)
+		{
+			n = (head - tail < TERMINALHISTORY_FRAME_MAX)
+				? head - tail : TERMINALHISTORY_FRAME_MAX;
+			_terminalhistory_copy_out(history, tail,
+					history->input, n);
+			atomic_store_explicit(&history->tail, tail + n,
+					memory_order_release);
+			_terminalhistory_filter(history, n);
+		}
+		if(atomic_load(&history->stopping))
+		{
+			/* the last output may have been pushed meanwhile */
+			if(atomic_load(&history->head) == tail)
+				break;
+			continue;
+		}
+		atomic_store(&history->sleeping, 1);
+		if(atomic_load(&history->head) != tail
+				|| atomic_load(&history->stopping))
+		{
+			atomic_store(&history->sleeping, 0);
+			continue;
+		}
+		while(poll(&pfd, 1, -1) < 0 && errno == EINTR);
+		while(read(history->pipe[0], buf, sizeof(buf)) > 0);
+	}
+	return NULL;
+}
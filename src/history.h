@@ -0,0 +1,69 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_HISTORY_H
+# define TERMINAL_HISTORY_H
+
+# include <sys/types.h>
+
+
+/* History */
+/* public */
+/* types */
+typedef struct _TerminalHistory TerminalHistory;
+
+/* returns non-zero to stop searching */
+typedef int (*TerminalHistoryCallback)(void * data, size_t offset,
+		char const * line, size_t len);
+
+
+/* functions */
+/* essential */
+/* keeps the text of the output in a file of this directory, removed once
+ * created, as compressed blocks indexed by trigram */
+TerminalHistory * terminalhistory_new(char const * directory, size_t size);
+void terminalhistory_delete(TerminalHistory * history);
+
+
+/* accessors */
+unsigned long terminalhistory_get_dropped(TerminalHistory * history);
+/* the text kept in bytes, and the size of the file */
+size_t terminalhistory_get_size(TerminalHistory * history,
+		size_t * stored);
+
+
+/* useful */
+/* never blocks, the output is dropped if not indexed fast enough */
+void terminalhistory_output(TerminalHistory * history, char const * buf,
+		size_t len);
+
+/* reports the lines containing the string regardless of the case, oldest
+ * first, returns how many or -1 */
+int terminalhistory_search(TerminalHistory * history, char const * string,
+		TerminalHistoryCallback callback, void * data);
+
+#endif /* !TERMINAL_HISTORY_H */
@@ -0,0 +1,549 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "journal.h"
+
+/* constants */
+/* the records appended before compacting the journal */
+#define TERMINALJOURNAL_RECORDS		256
+
+
+/* Journal */
+/* private */
+/* types */
+typedef struct _TerminalJournalEntry
+{
+	unsigned int id;
+	unsigned int window;
+	int position;
+	unsigned int login;
+	char * shell;
+	char * directory;
+	char * label;
+} TerminalJournalEntry;
+
+struct _TerminalJournal
+{
+	char * filename;
+	int fd;
+	TerminalJournalEntry * entries;
+	size_t entries_cnt;
+	size_t records;
+};
+
+
+/* prototypes */
+static int _terminaljournal_append(TerminalJournal * journal,
+		char const * record, size_t len);
+static int _terminaljournal_compact(TerminalJournal * journal);
+static int _terminaljournal_load(TerminalJournal * journal);
+static int _terminaljournal_parse(TerminalJournal * journal, char * line);
+static char * _terminaljournal_record(TerminalJournalEntry const * entry,
+		size_t * len);
+
+static int _terminaljournal_compare(void const * a, void const * b);
+
+/* entries */
+static void _terminaljournal_entry_destroy(TerminalJournalEntry * entry);
+static TerminalJournalEntry * _terminaljournal_entry_get(
+		TerminalJournal * journal, unsigned int id);
+static int _terminaljournal_entry_remove(TerminalJournal * journal,
+		unsigned int id);
+static int _terminaljournal_entry_set(TerminalJournal * journal,
+		TerminalJournalTab const * tab);
+
+/* strings */
+static char * _terminaljournal_string_escape(char * p, char const * string);
+static char * _terminaljournal_string_unescape(char * string);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminaljournal_new */
+TerminalJournal * terminaljournal_new(char const * filename, int load)
+{
+	TerminalJournal * journal;
+	char old[PATH_MAX];
+	struct stat st;
+	int res;
+
+	if((journal = malloc(sizeof(*journal))) == NULL)
+		return NULL;
+	journal->filename = strdup(filename);
+	journal->entries = NULL;
+	journal->entries_cnt = 0;
+	journal->records = 0;
+	/* only one process at a time */
+	if(journal->filename == NULL || (journal->fd = open(filename,
+					O_RDWR | O_CREAT, 0600)) < 0)
+	{
+		res = errno;
+		free(journal->filename);
+		free(journal);
+		errno = res;
+		return NULL;
+	}
+	if(fcntl(journal->fd, F_SETFD, FD_CLOEXEC) != 0
+			|| flock(journal->fd, LOCK_EX | LOCK_NB) != 0)
+		res = -1;
+	else if(load)
+		res = _terminaljournal_load(journal);
+	/* the previous session is kept aside otherwise */
+	else if(fstat(journal->fd, &st) == 0 && st.st_size > 0)
+	{
+		if((size_t)snprintf(old, sizeof(old), "%s.old", filename)
+				>= sizeof(old))
+		{
+			errno = ENAMETOOLONG;
+			res = -1;
+		}
+		else
+			res = rename(filename, old);
+	}
+	else
+		res = 0;
+	/* starting from a clean journal */
+	if(res != 0 || _terminaljournal_compact(journal) != 0)
+	{
+		res = errno;
+		terminaljournal_delete(journal);
+		errno = res;
+		return NULL;
+	}
+	return journal;
+}
+
+
+/* terminaljournal_delete */
+void terminaljournal_delete(TerminalJournal * journal)
+{
+	size_t i;
+
+	/* the tabs left are restored the next time */
+	if(journal->fd >= 0)
+		close(journal->fd);
+	for(i = 0; i < journal->entries_cnt; i++)
+		_terminaljournal_entry_destroy(&journal->entries[i]);
+	free(journal->entries);
+	free(journal->filename);
+	free(journal);
+}
+
+
+/* accessors */
+/* terminaljournal_set */
+int terminaljournal_set(TerminalJournal * journal,
+		TerminalJournalTab const * tab)
+{
+	TerminalJournalEntry * entry;
+	char * record;
+	size_t len;
+	int res;
+
+	if(_terminaljournal_entry_set(journal, tab) != 0
+			|| (entry = _terminaljournal_entry_get(journal,
+					tab->id)) == NULL
+			|| (record = _terminaljournal_record(entry, &len))
+			== NULL)
+		return -1;
+	res = _terminaljournal_append(journal, record, len);
+	free(record);
+	return res;
+}
+
+
+/* useful */
+/* terminaljournal_remove */
+int terminaljournal_remove(TerminalJournal * journal, unsigned int id)
+{
+	char record[32];
+	int len;
+
+	if(_terminaljournal_entry_remove(journal, id) != 0)
+		return 0;
+	len = snprintf(record, sizeof(record), "C\t%u\n", id);
+	return _terminaljournal_append(journal, record, len);
+}
+
+
+/* terminaljournal_restore */
+int terminaljournal_restore(TerminalJournal * journal,
+		TerminalJournalCallback callback, void * data)
+{
+	TerminalJournalEntry * entries = journal->entries;
+	size_t entries_cnt = journal->entries_cnt;
+	TerminalJournalTab tab;
+	size_t i;
+
+	/* the tabs restored are journaled again */
+	journal->entries = NULL;
+	journal->entries_cnt = 0;
+	if(entries_cnt > 0)
+		qsort(entries, entries_cnt, sizeof(*entries),
+				_terminaljournal_compare);
+	for(i = 0; i < entries_cnt; i++)
+	{
+		tab.id = entries[i].id;
+		tab.window = entries[i].window;
+		tab.position = entries[i].position;
+		tab.login = entries[i].login;
+		tab.shell = entries[i].shell;
+		tab.directory = entries[i].directory;
+		tab.label = entries[i].label;
+		callback(data, &tab);
+		_terminaljournal_entry_destroy(&entries[i]);
+	}
+	free(entries);
+	/* without the records of the previous session */
+	return _terminaljournal_compact(journal);
+}
+
+
+/* private */
+/* functions */
+/* terminaljournal_append */
+static int _terminaljournal_append(TerminalJournal * journal,
+		char const * record, size_t len)
+{
+	/* a single write, ignored when loading if interrupted */
+	if(write(journal->fd, record, len) != (ssize_t)len)
+		return -1;
+	if(++journal->records >= TERMINALJOURNAL_RECORDS
+			&& journal->records >= journal->entries_cnt * 2)
+		return _terminaljournal_compact(journal);
+	return 0;
+}
+
+
+/* terminaljournal_compact */
+static int _terminaljournal_compact(TerminalJournal * journal)
+{
+	char tmp[PATH_MAX];
+	int fd;
+	size_t i;
+	char * record;
+	size_t len;
+	int res = 0;
+
+	if((size_t)snprintf(tmp, sizeof(tmp), "%s.XXXXXX", journal->filename)
+			>= sizeof(tmp))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if((fd = mkstemp(tmp)) < 0)
+		return -1;
+	for(i = 0; res == 0 && i < journal->entries_cnt; i++)
+		if((record = _terminaljournal_record(&journal->entries[i],
+						&len)) == NULL)
+			res = -1;
+		else
+		{
+			if(write(fd, record, len) != (ssize_t)len)
+				res = -1;
+			free(record);
+		}
+	/* replaced at once, and only once written */
+	if(res != 0 || fcntl(fd, F_SETFD, FD_CLOEXEC) != 0
+			|| flock(fd, LOCK_EX | LOCK_NB) != 0
+			|| fsync(fd) != 0
+			|| rename(tmp, journal->filename) != 0)
+	{
+		res = errno;
+		close(fd);
+		unlink(tmp);
+		errno = res;
+		return -1;
+	}
+	close(journal->fd);
+	journal->fd = fd;
+	journal->records = 0;
+	return 0;
+}
+
+
+/* terminaljournal_load */
+static int _terminaljournal_load(TerminalJournal * journal)
+{
+	FILE * fp;
+	int fd;
+	char * line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int res = 0;
+
+	if((fd = dup(journal->fd)) < 0)
+		return -1;
+	if((fp = fdopen(fd, "r")) == NULL)
+	{
+		close(fd);
+		return -1;
+	}
+	while(res == 0 && (len = getline(&line, &size, fp)) > 0)
+	{
+		/* the last record may have been interrupted */
+		if(line[len - 1] != '\n')
+			break;
+		line[len - 1] = '\0';
+		res = _terminaljournal_parse(journal, line);
+	}
+	if(res == 0 && ferror(fp))
+		res = -1;
+	free(line);
+	fclose(fp);
+	return res;
+}
+
+
+/* terminaljournal_parse */
+static int _terminaljournal_parse(TerminalJournal * journal, char * line)
+{
+	TerminalJournalTab tab;
+	char * fields[8];
+	size_t i;
+	char * p;
+	unsigned long u;
+
+	/* the fields are separated with tabulations */
+	for(i = 0, fields[0] = line; i < sizeof(fields) / sizeof(*fields) - 1;
+			i++)
+	{
+		if((p = strchr(fields[i], '\t')) == NULL)
+			break;
+		*p = '\0';
+		fields[i + 1] = p + 1;
+	}
+	if(strcmp(fields[0], "C") == 0 && i == 1)
+	{
+		u = strtoul(fields[1], &p, 10);
+		if(*p == '\0')
+			_terminaljournal_entry_remove(journal, u);
+		return 0;
+	}
+	/* the unknown records are ignored */
+	if(strcmp(fields[0], "T") != 0 || i != 7)
+		return 0;
+	tab.id = strtoul(fields[1], NULL, 10);
+	tab.window = strtoul(fields[2], NULL, 10);
+	tab.position = strtol(fields[3], NULL, 10);
+	tab.login = strtoul(fields[4], NULL, 10);
+	tab.shell = _terminaljournal_string_unescape(fields[5]);
+	tab.directory = _terminaljournal_string_unescape(fields[6]);
+	tab.label = _terminaljournal_string_unescape(fields[7]);
+	return _terminaljournal_entry_set(journal, &tab);
+}
+
+
+/* terminaljournal_record */
+static char * _terminaljournal_record(TerminalJournalEntry const * entry,
+		size_t * len)
+{
+	char * ret;
+	char * p;
+	size_t size = 64;
+
+	/* every character escaped at worst */
+	if(entry->shell != NULL)
+		size += strlen(entry->shell) * 2;
+	if(entry->directory != NULL)
+		size += strlen(entry->directory) * 2;
+	if(entry->label != NULL)
+		size += strlen(entry->label) * 2;
+	if((ret = malloc(size)) == NULL)
+		return NULL;
+	p = ret + sprintf(ret, "T\t%u\t%u\t%d\t%u\t", entry->id,
+			entry->window, entry->position, entry->login);
+	p = _terminaljournal_string_escape(p, entry->shell);
+	*(p++) = '\t';
+	p = _terminaljournal_string_escape(p, entry->directory);
+	*(p++) = '\t';
+	p = _terminaljournal_string_escape(p, entry->label);
+	*(p++) = '\n';
+	*len = p - ret;
+	return ret;
+}
+
+
+/* terminaljournal_compare */
+static int _terminaljournal_compare(void const * a, void const * b)
+{
+	TerminalJournalEntry const * ea = a;
+	TerminalJournalEntry const * eb = b;
+
+	/* by window, then by position */
+	if(ea->window != eb->window)
+		return (ea->window < eb->window) ? -1 : 1;
+	if(ea->position != eb->position)
+		return (ea->position < eb->position) ? -1 : 1;
+	return (ea->id < eb->id) ? -1 : (ea->id > eb->id);
+}
+
+
+/* entries */
+/* terminaljournal_entry_destroy */
+static void _terminaljournal_entry_destroy(TerminalJournalEntry * entry)
+{
+	free(entry->shell);
+	free(entry->directory);
+	free(entry->label);
+}
+
+
+/* terminaljournal_entry_get */
+static TerminalJournalEntry * _terminaljournal_entry_get(
+		TerminalJournal * journal, unsigned int id)
+{
+	size_t i;
+
+	for(i = 0; i < journal->entries_cnt; i++)
+		if(journal->entries[i].id == id)
+			return &journal->entries[i];
+	return NULL;
+}
+
+
+/* terminaljournal_entry_remove */
+static int _terminaljournal_entry_remove(TerminalJournal * journal,
+		unsigned int id)
+{
+	TerminalJournalEntry * entry;
+
+	if((entry = _terminaljournal_entry_get(journal, id)) == NULL)
+		return -1;
+	_terminaljournal_entry_destroy(entry);
+	memmove(entry, entry + 1, (journal->entries_cnt-- - 1
+				- (entry - journal->entries))
+			* sizeof(*entry));
+	return 0;
+}
+
+
+/* terminaljournal_entry_set */
+static int _terminaljournal_entry_set(TerminalJournal * journal,
+		TerminalJournalTab const * tab)
+{
+	TerminalJournalEntry * entry;
+	TerminalJournalEntry e;
+
+	e.id = tab->id;
+	e.window = tab->window;
+	e.position = tab->position;
+	e.login = tab->login;
+	e.shell = (tab->shell != NULL) ? strdup(tab->shell) : NULL;
+	e.directory = (tab->directory != NULL) ? strdup(tab->directory)
+		: NULL;
+	e.label = (tab->label != NULL) ? strdup(tab->label) : NULL;
+	if((tab->shell != NULL && e.shell == NULL)
+			|| (tab->directory != NULL && e.directory == NULL)
+			|| (tab->label != NULL && e.label == NULL))
+	{
+		_terminaljournal_entry_destroy(&e);
+		return -1;
+	}
+	if((entry = _terminaljournal_entry_get(journal, tab->id)) != NULL)
+		_terminaljournal_entry_destroy(entry);
+	else if((entry = realloc(journal->entries, sizeof(*entry)
+					* (journal->entries_cnt + 1))) == NULL)
+	{
+		_terminaljournal_entry_destroy(&e);
+		return -1;
+	}
+	else
+	{
+		journal->entries = entry;
+		entry = &journal->entries[journal->entries_cnt++];
+	}
+	*entry = e;
+	return 0;
+}
+
+
+/* strings */
+/* terminaljournal_string_escape */
+static char * _terminaljournal_string_escape(char * p, char const * string)
+{
+	/* empty if not set */
+	for(; string != NULL && *string != '\0'; string++)
+		switch(*string)
+		{
+			case '\t':
+				*(p++) = '\\';
+				*(p++) = 't';
+				break;
+			case '\n':
+				*(p++) = '\\';
+				*(p++) = 'n';
+				break;
+			case '\\':
+				*(p++) = '\\';
+				*(p++) = '\\';
+				break;
+			default:
+				*(p++) = *string;
+				break;
+		}
+	return p;
+}
+
+
+/* terminaljournal_string_unescape */
+static char * _terminaljournal_string_unescape(char * string)
+{
+	char * p;
+	char * q;
+
+	if(string[0] == '\0')
+		return NULL;
+	for(p = string, q = string; *p != '\0'; p++)
+		if(*p != '\\' || p[1] == '\0')
+			*(q++) = *p;
+		else
+			switch(*(++p))
+			{
+				case 't':
+					*(q++) = '\t';
+					break;
+				case 'n':
+					*(q++) = '\n';
+					break;
+				default:
+					*(q++) = *p;
+					break;
+			}
+	*q = '\0';
+	return string;
+}
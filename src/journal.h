@@ -0,0 +1,73 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_JOURNAL_H
+# define TERMINAL_JOURNAL_H
+
+
+/* Journal */
+/* public */
+/* types */
+typedef struct _TerminalJournal TerminalJournal;
+
+typedef struct _TerminalJournalTab
+{
+	unsigned int id;
+	unsigned int window;
+	int position;
+	unsigned int login;
+	/* NULL if not set */
+	char const * shell;
+	char const * directory;
+	char const * label;
+} TerminalJournalTab;
+
+typedef void (*TerminalJournalCallback)(void * data,
+		TerminalJournalTab const * tab);
+
+
+/* functions */
+/* essential */
+/* locks the journal, loading the tabs it holds or keeping it aside */
+TerminalJournal * terminaljournal_new(char const * filename, int load);
+void terminaljournal_delete(TerminalJournal * journal);
+
+
+/* accessors */
+/* only appends a record, compacted from time to time */
+int terminaljournal_set(TerminalJournal * journal,
+		TerminalJournalTab const * tab);
+
+
+/* useful */
+int terminaljournal_remove(TerminalJournal * journal, unsigned int id);
+
+/* reports the tabs loaded in order, and forgets them */
+int terminaljournal_restore(TerminalJournal * journal,
+		TerminalJournalCallback callback, void * data);
+
+#endif /* !TERMINAL_JOURNAL_H */
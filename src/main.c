@@ -26,6 +26,7 @@
 
 
 #include <unistd.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <locale.h>
@@ -33,6 +34,9 @@
 #include <gtk/gtk.h>
 #include <System.h>
 #include "terminal.h"
+#include "server.h"
+#include "spawner.h"
+#include "trace.h"
 #include "../config.h"
 #define _(string) gettext(string)
 
@@ -53,7 +57,7 @@
 
 /* private */
 /* prototypes */
-static int _terminal(TerminalPrefs * prefs);
+static int _terminal(TerminalPrefs * prefs, int server);
 
 static int _error(char const * message, int ret);
 static int _usage(void);
@@ -61,22 +65,25 @@ static int _usage(void);
 
 /* functions */
 /* terminal */
-static int _terminal(TerminalPrefs * prefs)
+static int _terminal(TerminalPrefs * prefs, int server)
 {
-	Terminal * terminal;
+	TerminalServer * ts = NULL;
 
-	/* consistency check */
-	if(prefs != NULL)
+	/* let the next invocations open their windows in this process
+	 * (this is not fatal) */
+	if(server != 0)
+		ts = terminalserver_new();
+	if(terminal_new(prefs) == NULL)
 	{
-		if(prefs->shell != NULL)
-			prefs->login = 0;
-		else if(prefs->login != 0)
-			prefs->directory = NULL;
-	}
-	if((terminal = terminal_new(prefs)) == NULL)
+		if(ts != NULL)
+			terminalserver_delete(ts);
 		return error_print(PROGNAME_TERMINAL);
+	}
+	trace_instant("gtk_main");
+	/* returns once every window is closed */
 	gtk_main();
-	terminal_delete(terminal);
+	if(ts != NULL)
+		terminalserver_delete(ts);
 	return 0;
 }
 
@@ -93,8 +100,15 @@ static int _error(char const * message, int ret)
 /* usage */
 static int _usage(void)
 {
-	fprintf(stderr, _("Usage: %s [-d directory][shell]\n"),
-			PROGNAME_TERMINAL);
+	fprintf(stderr, _("Usage: %s [-d directory][-l][-n][-t filename]"
+				"[shell]\n"
+"       %s -r [-n][-t filename]\n"
+"  -d	Start in this directory\n"
+"  -l	Start a login shell\n"
+"  -n	Do not use or start a server\n"
+"  -r	Restore the tabs of the previous session\n"
+"  -t	Write a trace of the startup and tabs to this file\n"),
+			PROGNAME_TERMINAL, PROGNAME_TERMINAL);
 	return 1;
 }
 
@@ -106,14 +120,24 @@ int main(int argc, char * argv[])
 {
 	int o;
 	TerminalPrefs prefs;
+	int server = 1;
+	char const * trace;
+	gint64 times[3];
+	int ret;
 
+	/* the phases are traced once the options are known */
+	times[0] = g_get_monotonic_time();
 	if(setlocale(LC_ALL, "") == NULL)
 		_error("setlocale", 1);
 	bindtextdomain(PACKAGE, LOCALEDIR);
 	textdomain(PACKAGE);
 	memset(&prefs, 0, sizeof(prefs));
-	gtk_init(&argc, &argv);
-	while((o = getopt(argc, argv, "d:l")) != -1)
+	times[1] = g_get_monotonic_time();
+	/* does not connect to the display yet */
+	gtk_parse_args(&argc, &argv);
+	times[2] = g_get_monotonic_time();
+	trace = getenv("TERMINAL_TRACE");
+	while((o = getopt(argc, argv, "d:lnrt:")) != -1)
 		switch(o)
 		{
 			case 'd':
@@ -122,12 +146,59 @@ int main(int argc, char * argv[])
 			case 'l':
 				prefs.login = 1;
 				break;
+			case 'n':
+				server = 0;
+				break;
+			case 'r':
+				prefs.restore = 1;
+				break;
+			case 't':
+				trace = optarg;
+				break;
 			default:
 				return _usage();
 		}
+	/* the tabs restored keep their own settings */
+	if(prefs.restore != 0 && (prefs.directory != NULL || prefs.login != 0
+				|| optind != argc))
+		return _usage();
 	if(argc - optind == 1)
 		prefs.shell = argv[optind];
 	else if(optind != argc)
 		return _usage();
-	return (_terminal(&prefs) == 0) ? 0 : 2;
+	/* consistency check */
+	if(prefs.shell != NULL)
+		prefs.login = 0;
+	else if(prefs.login != 0)
+		prefs.directory = NULL;
+	if(trace != NULL && trace[0] != '\0')
+	{
+		if(trace_open(trace) != 0)
+			error_print(PROGNAME_TERMINAL);
+		trace_complete("setlocale", times[0], times[1]);
+		trace_complete("gtk_parse_args", times[1], times[2]);
+	}
+	/* hand the window over to a running server if possible, unless
+	 * restoring in this process */
+	trace_begin("server_request");
+	if(server != 0 && prefs.restore == 0
+			&& terminalserver_request(&prefs) == 0)
+	{
+		trace_end("server_request");
+		trace_close();
+		return 0;
+	}
+	trace_end("server_request");
+	/* spawn the shells from a process still small (this is not fatal) */
+	trace_begin("spawner");
+	if(spawner_start() != 0)
+		_error("spawner", 0);
+	trace_end("spawner");
+	trace_begin("gtk_init");
+	gtk_init(&argc, &argv);
+	trace_end("gtk_init");
+	ret = (_terminal(&prefs, server) == 0) ? 0 : 2;
+	spawner_stop();
+	trace_close();
+	return ret;
 }
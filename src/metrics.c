@@ -0,0 +1,522 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include "metrics.h"
+
+/* constants */
+#define TERMINALMETRICS_BUCKETS		12
+/* a power of two */
+#define TERMINALMETRICS_EVENTS		1024
+
+
+/* Metrics */
+/* private */
+/* types */
+typedef enum _TerminalMetricsHistogram
+{
+	TMH_SPAWN = 0,
+	TMH_CLOSE,
+	TMH_HANG
+} TerminalMetricsHistogram;
+#define TMH_LAST TMH_HANG
+#define TMH_COUNT (TMH_LAST + 1)
+
+typedef struct _TerminalMetricsEvent
+{
+	uint64_t time;				/* in microseconds */
+	uint32_t type;
+	uint32_t tab;
+	int32_t pid;
+	int64_t value;
+} TerminalMetricsEvent;
+
+typedef struct _TerminalMetricsWriter
+{
+	int fd;
+	int error;
+	size_t len;
+	char buf[4096];
+} TerminalMetricsWriter;
+
+struct _TerminalMetrics
+{
+	atomic_ulong counters[TMET_COUNT];
+	atomic_ulong exits_failed;
+	atomic_ulong gauges[TMG_COUNT];
+
+	/* not cumulated, the last bucket being infinite */
+	atomic_ulong buckets[TMH_COUNT][TERMINALMETRICS_BUCKETS + 1];
+	atomic_ulong sums[TMH_COUNT];		/* in microseconds */
+
+	/* the latest events, overwritten by the next ones */
+	TerminalMetricsEvent events[TERMINALMETRICS_EVENTS];
+	atomic_ulong head;
+
+	/* exporter */
+	char * path;
+	int fd;
+};
+
+
+/* constants */
+/* in microseconds */
+static const unsigned long _terminalmetrics_buckets[TERMINALMETRICS_BUCKETS] =
+{
+	1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000,
+	2500000, 5000000, 10000000
+};
+
+static char const * _terminalmetrics_events[TMET_COUNT] =
+{
+	"opened", "plugged", "spawn_failed", "exited", "signaled", "closed",
+	"reaped", "hung", "hang_ended"
+};
+
+static char const * _terminalmetrics_histograms[TMH_COUNT][2] =
+{
+	{ "terminal_spawn_seconds", "From starting a tab until usable" },
+	{ "terminal_close_seconds", "From closing a tab until reaped" },
+	{ "terminal_hang_seconds", "Terminal emulators not responding" }
+};
+
+
+/* prototypes */
+static void _terminalmetrics_observe(TerminalMetrics * metrics,
+		TerminalMetricsHistogram histogram, unsigned long value);
+
+/* writer */
+static int _terminalmetrics_writer_flush(TerminalMetricsWriter * writer);
+static void _terminalmetrics_writer_printf(TerminalMetricsWriter * writer,
+		char const * format, ...);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalmetrics_new */
+TerminalMetrics * terminalmetrics_new(void)
+{
+	TerminalMetrics * metrics;
+	size_t i;
+	size_t j;
+
+	if((metrics = malloc(sizeof(*metrics))) == NULL)
+		return NULL;
+	for(i = 0; i < TMET_COUNT; i++)
+		atomic_init(&metrics->counters[i], 0);
+	atomic_init(&metrics->exits_failed, 0);
+	for(i = 0; i < TMG_COUNT; i++)
+		atomic_init(&metrics->gauges[i], 0);
+	for(i = 0; i < TMH_COUNT; i++)
+	{
+		for(j = 0; j <= TERMINALMETRICS_BUCKETS; j++)
+			atomic_init(&metrics->buckets[i][j], 0);
+		atomic_init(&metrics->sums[i], 0);
+	}
+	memset(metrics->events, 0, sizeof(metrics->events));
+	atomic_init(&metrics->head, 0);
+	metrics->path = NULL;
+	metrics->fd = -1;
+	return metrics;
+}
+
+
+/* terminalmetrics_delete */
+void terminalmetrics_delete(TerminalMetrics * metrics)
+{
+	if(metrics->fd >= 0)
+	{
+		close(metrics->fd);
+		/* only remove the socket if we were listening */
+		unlink(metrics->path);
+	}
+	free(metrics->path);
+	free(metrics);
+}
+
+
+/* accessors */
+/* terminalmetrics_set_gauge */
+void terminalmetrics_set_gauge(TerminalMetrics * metrics,
+		TerminalMetricsGauge gauge, unsigned long value)
+{
+	atomic_store_explicit(&metrics->gauges[gauge], value,
+			memory_order_relaxed);
+}
+
+
+/* useful */
+/* terminalmetrics_event */
+void terminalmetrics_event(TerminalMetrics * metrics,
+		TerminalMetricsEventType type, unsigned int tab, pid_t pid,
+		long value)
+{
+	struct timespec ts;
+	unsigned long head;
+	TerminalMetricsEvent * event;
+
+	atomic_fetch_add_explicit(&metrics->counters[type], 1,
+			memory_order_relaxed);
+	if(type == TMET_EXITED && value != 0)
+		atomic_fetch_add_explicit(&metrics->exits_failed, 1,
+				memory_order_relaxed);
+	else if(type == TMET_PLUGGED)
+		_terminalmetrics_observe(metrics, TMH_SPAWN, value);
+	else if(type == TMET_REAPED)
+		_terminalmetrics_observe(metrics, TMH_CLOSE, value);
+	else if(type == TMET_HANG_ENDED)
+		_terminalmetrics_observe(metrics, TMH_HANG, value);
+	/* there is a single producer */
+	clock_gettime(CLOCK_REALTIME, &ts);
+	head = atomic_load_explicit(&metrics->head, memory_order_relaxed);
+	event = &metrics->events[head & (TERMINALMETRICS_EVENTS - 1)];
+	event->time = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	event->type = type;
+	event->tab = tab;
+	event->pid = pid;
+	event->value = value;
+	atomic_store_explicit(&metrics->head, head + 1, memory_order_release);
+}
+
+
+/* terminalmetrics_export */
+int terminalmetrics_export(TerminalMetrics * metrics, int fd)
+{
+	TerminalMetricsWriter writer;
+	struct
+	{
+		char const * name;
+		char const * help;
+		atomic_ulong * value;
+	} counters[] =
+	{
+		{ "terminal_tabs_opened_total", "Tabs opened",
+			&metrics->counters[TMET_OPENED] },
+		{ "terminal_tabs_closed_total", "Tabs closed",
+			&metrics->counters[TMET_CLOSED] },
+		{ "terminal_spawn_failures_total",
+			"Terminal emulators which could not be started",
+			&metrics->counters[TMET_SPAWN_FAILED] },
+		{ "terminal_exits_total", "Terminal emulators which exited",
+			&metrics->counters[TMET_EXITED] },
+		{ "terminal_exits_failed_total",
+			"Terminal emulators which exited with an error",
+			&metrics->exits_failed },
+		{ "terminal_exits_signaled_total",
+			"Terminal emulators killed by a signal",
+			&metrics->counters[TMET_SIGNALED] },
+		{ "terminal_hangs_total", "Terminal emulators found hung",
+			&metrics->counters[TMET_HUNG] }
+	};
+	size_t i;
+	size_t j;
+	unsigned long count;
+
+	writer.fd = fd;
+	writer.error = 0;
+	writer.len = 0;
+	for(i = 0; i < sizeof(counters) / sizeof(*counters); i++)
+		_terminalmetrics_writer_printf(&writer, "# HELP %s %s\n"
+				"# TYPE %s counter\n%s %lu\n",
+				counters[i].name, counters[i].help,
+				counters[i].name, counters[i].name,
+				atomic_load(counters[i].value));
+	_terminalmetrics_writer_printf(&writer, "# HELP terminal_tabs"
+			" Tabs currently open\n# TYPE terminal_tabs gauge\n"
+			"terminal_tabs %lu\n",
+			atomic_load(&metrics->gauges[TMG_TABS]));
+	_terminalmetrics_writer_printf(&writer, "# HELP terminal_processes"
+			" Child processes not reaped yet\n"
+			"# TYPE terminal_processes gauge\n"
+			"terminal_processes %lu\n",
+			atomic_load(&metrics->gauges[TMG_PROCESSES]));
+	for(i = 0; i < TMH_COUNT; i++)
+	{
+		_terminalmetrics_writer_printf(&writer, "# HELP %s %s\n"
+				"# TYPE %s histogram\n",
+				_terminalmetrics_histograms[i][0],
+				_terminalmetrics_histograms[i][1],
+				_terminalmetrics_histograms[i][0]);
+		for(j = 0, count = 0; j < TERMINALMETRICS_BUCKETS; j++)
+		{
+			count += atomic_load(&metrics->buckets[i][j]);
+			_terminalmetrics_writer_printf(&writer,
+					"%s_bucket{le=\"%lu.%06lu\"} %lu\n",
+					_terminalmetrics_histograms[i][0],
+					_terminalmetrics_buckets[j] / 1000000,
+					_terminalmetrics_buckets[j] % 1000000,
+					count);
+		}
+		count += atomic_load(&metrics->buckets[i][j]);
+		_terminalmetrics_writer_printf(&writer,
+				"%s_bucket{le=\"+Inf\"} %lu\n"
+				"%s_sum %lu.%06lu\n%s_count %lu\n",
+				_terminalmetrics_histograms[i][0], count,
+				_terminalmetrics_histograms[i][0],
+				atomic_load(&metrics->sums[i]) / 1000000,
+				atomic_load(&metrics->sums[i]) % 1000000,
+				_terminalmetrics_histograms[i][0], count);
+	}
+	return _terminalmetrics_writer_flush(&writer);
+}
+
+
+/* terminalmetrics_export_events */
+int terminalmetrics_export_events(TerminalMetrics * metrics, int fd)
+{
+	TerminalMetricsWriter writer;
+	unsigned long head;
+	unsigned long i;
+	TerminalMetricsEvent event;
+
+	writer.fd = fd;
+	writer.error = 0;
+	writer.len = 0;
+	head = atomic_load_explicit(&metrics->head, memory_order_acquire);
+	i = (head > TERMINALMETRICS_EVENTS) ? head - TERMINALMETRICS_EVENTS : 0;
+	for(; i < head; i++)
+	{
+		event = metrics->events[i & (TERMINALMETRICS_EVENTS - 1)];
+		/* skip the events overwritten meanwhile */
+		if(atomic_load_explicit(&metrics->head, memory_order_acquire)
+				- i > TERMINALMETRICS_EVENTS)
+			continue;
+		_terminalmetrics_writer_printf(&writer,
+				"{\"time\":%llu.%06llu,\"event\":\"%s\","
+				"\"tab\":%lu,\"pid\":%ld,\"value\":%lld}\n",
+				(unsigned long long)event.time / 1000000,
+				(unsigned long long)event.time % 1000000,
+				_terminalmetrics_events[event.type],
+				(unsigned long)event.tab, (long)event.pid,
+				(long long)event.value);
+	}
+	return _terminalmetrics_writer_flush(&writer);
+}
+
+
+/* terminalmetrics_listen */
+static int _listen_stale(int fd, struct sockaddr_un * sa);
+
+int terminalmetrics_listen(TerminalMetrics * metrics, char const * path)
+{
+	struct sockaddr_un sa;
+	int fd;
+
+	if(metrics->fd >= 0)
+	{
+		errno = EALREADY;
+		return -1;
+	}
+	if(strlen(path) >= sizeof(sa.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	free(metrics->path);
+	if((metrics->path = strdup(path)) == NULL)
+		return -1;
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	if(bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0
+			&& _listen_stale(fd, &sa) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	if(chmod(path, 0600) != 0 || listen(fd, 5) != 0)
+	{
+		unlink(path);
+		close(fd);
+		return -1;
+	}
+	metrics->fd = fd;
+	return fd;
+}
+
+
+static int _listen_stale(int fd, struct sockaddr_un * sa)
+{
+	int res;
+
+	if(errno != EADDRINUSE || (res = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+	/* only replace the socket if stale */
+	if(connect(res, (struct sockaddr *)sa, sizeof(*sa)) == 0)
+	{
+		close(res);
+		errno = EADDRINUSE;
+		return -1;
+	}
+	close(res);
+	if(unlink(sa->sun_path) != 0)
+		return -1;
+	return bind(fd, (struct sockaddr *)sa, sizeof(*sa));
+}
+
+
+/* terminalmetrics_serve */
+int terminalmetrics_serve(TerminalMetrics * metrics)
+{
+	int fd;
+	int ret;
+
+	if((fd = accept(metrics->fd, NULL, NULL)) < 0)
+		return -1;
+	/* the clients not reading fast enough miss the end */
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	ret = terminalmetrics_export(metrics, fd);
+	close(fd);
+	return ret;
+}
+
+
+/* terminalmetrics_write */
+int terminalmetrics_write(TerminalMetrics * metrics, char const * filename,
+		int events)
+{
+	char tmp[PATH_MAX];
+	int fd;
+	int res;
+
+	if((size_t)snprintf(tmp, sizeof(tmp), "%s.XXXXXX", filename)
+			>= sizeof(tmp))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if((fd = mkstemp(tmp)) < 0)
+		return -1;
+	if((events ? terminalmetrics_export_events(metrics, fd)
+				: terminalmetrics_export(metrics, fd)) != 0
+			|| fchmod(fd, 0644) != 0
+			|| close(fd) != 0)
+	{
+		res = errno;
+		close(fd);
+		unlink(tmp);
+		errno = res;
+		return -1;
+	}
+	if(rename(tmp, filename) != 0)
+	{
+		res = errno;
+		unlink(tmp);
+		errno = res;
+		return -1;
+	}
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* terminalmetrics_observe */
+static void _terminalmetrics_observe(TerminalMetrics * metrics,
+		TerminalMetricsHistogram histogram, unsigned long value)
+{
+	size_t i;
+
+	for(i = 0; i < TERMINALMETRICS_BUCKETS; i++)
+		if(value <= _terminalmetrics_buckets[i])
+			break;
+	atomic_fetch_add_explicit(&metrics->buckets[histogram][i], 1,
+			memory_order_relaxed);
+	atomic_fetch_add_explicit(&metrics->sums[histogram], value,
+			memory_order_relaxed);
+}
+
+
+/* writer */
+/* terminalmetrics_writer_flush */
+static int _terminalmetrics_writer_flush(TerminalMetricsWriter * writer)
+{
+	size_t i;
+	ssize_t res;
+
+	for(i = 0; writer->error == 0 && i < writer->len; i += res)
+		if((res = write(writer->fd, &writer->buf[i], writer->len - i))
+				< 0)
+		{
+			if(errno != EINTR)
+				writer->error = errno;
+			res = 0;
+		}
+	writer->len = 0;
+	if(writer->error == 0)
+		return 0;
+	errno = writer->error;
+	return -1;
+}
+
+
+/* terminalmetrics_writer_printf */
+static void _terminalmetrics_writer_printf(TerminalMetricsWriter * writer,
+		char const * format, ...)
+{
+	va_list ap;
+	int res;
+	size_t i;
+
+	for(i = 0; i < 2 && writer->error == 0; i++)
+	{
+		va_start(ap, format);
+		res = vsnprintf(&writer->buf[writer->len],
+				sizeof(writer->buf) - writer->len, format, ap);
+		va_end(ap);
+		if(res < 0)
+			writer->error = EINVAL;
+		else if((size_t)res < sizeof(writer->buf) - writer->len)
+		{
+			writer->len += res;
+			return;
+		}
+		/* flush and try again, with the whole buffer */
+		else if(writer->len == 0)
+			writer->error = ENOBUFS;
+		else
+			_terminalmetrics_writer_flush(writer);
+	}
+}
@@ -0,0 +1,95 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_METRICS_H
+# define TERMINAL_METRICS_H
+
+# include <sys/types.h>
+
+
+/* Metrics */
+/* public */
+/* types */
+typedef struct _TerminalMetrics TerminalMetrics;
+
+typedef enum _TerminalMetricsEventType
+{
+	TMET_OPENED = 0,
+	TMET_PLUGGED,				/* value: in microseconds */
+	TMET_SPAWN_FAILED,
+	TMET_EXITED,				/* value: exit status */
+	TMET_SIGNALED,				/* value: signal number */
+	TMET_CLOSED,
+	TMET_REAPED,				/* value: in microseconds */
+	TMET_HUNG,
+	TMET_HANG_ENDED				/* value: in microseconds */
+} TerminalMetricsEventType;
+# define TMET_LAST TMET_HANG_ENDED
+# define TMET_COUNT (TMET_LAST + 1)
+
+typedef enum _TerminalMetricsGauge
+{
+	TMG_TABS = 0,
+	TMG_PROCESSES
+} TerminalMetricsGauge;
+# define TMG_LAST TMG_PROCESSES
+# define TMG_COUNT (TMG_LAST + 1)
+
+
+/* functions */
+/* essential */
+TerminalMetrics * terminalmetrics_new(void);
+void terminalmetrics_delete(TerminalMetrics * metrics);
+
+
+/* accessors */
+void terminalmetrics_set_gauge(TerminalMetrics * metrics,
+		TerminalMetricsGauge gauge, unsigned long value);
+
+
+/* useful */
+/* counts the event and keeps it along with the latest ones, without
+ * allocating or locking */
+void terminalmetrics_event(TerminalMetrics * metrics,
+		TerminalMetricsEventType type, unsigned int tab, pid_t pid,
+		long value);
+
+/* in the text format of Prometheus */
+int terminalmetrics_export(TerminalMetrics * metrics, int fd);
+/* the latest events, as JSON objects on their own line */
+int terminalmetrics_export_events(TerminalMetrics * metrics, int fd);
+
+/* returns the socket to watch for the connections to serve */
+int terminalmetrics_listen(TerminalMetrics * metrics, char const * path);
+/* exports to the next connection, without ever blocking */
+int terminalmetrics_serve(TerminalMetrics * metrics);
+
+/* replaces the file given once complete */
+int terminalmetrics_write(TerminalMetrics * metrics, char const * filename,
+		int events);
+
+#endif /* !TERMINAL_METRICS_H */
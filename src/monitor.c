@@ -0,0 +1,541 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include "monitor.h"
+
+/* constants */
+#define TERMINALMONITOR_PROC	"/proc"
+
+
+/* Monitor */
+/* private */
+/* types */
+typedef struct _TerminalMonitorEntry
+{
+	pid_t pid;
+	size_t index;
+} TerminalMonitorEntry;
+
+typedef struct _TerminalMonitorProcess
+{
+	pid_t pid;
+	/* the parent is always found before its children */
+	size_t parent;
+	unsigned int depth;
+	int valid;
+	/* 0 until sampled once */
+	unsigned long long start;
+	/* unchanged as long as the process does not run */
+	unsigned long faults;
+	unsigned long ticks;
+	/* in kilobytes */
+	unsigned long pss;
+	unsigned long rss;
+} TerminalMonitorProcess;
+
+typedef struct _TerminalMonitorStat
+{
+	pid_t ppid;
+	unsigned long faults;
+	unsigned long ticks;
+	unsigned long children;
+	long threads;
+	unsigned long long start;
+	unsigned long rss;
+} TerminalMonitorStat;
+
+struct _TerminalMonitor
+{
+	/* the kernel lists the children of every thread */
+	int children;
+	/* in kilobytes */
+	unsigned long page;
+	/* clock ticks per second */
+	unsigned long hz;
+
+	char buf[4096];
+};
+
+struct _TerminalMonitorTree
+{
+	TerminalMonitorProcess * processes;
+	size_t processes_cnt;
+	size_t processes_size;
+
+	/* sorted by pid, as of the previous sample */
+	TerminalMonitorEntry * entries;
+	size_t entries_cnt;
+
+	/* the processes given to the current sample */
+	pid_t const * pids;
+	size_t pids_cnt;
+
+	/* previous sample, in milliseconds and microseconds */
+	unsigned long cpu;
+	long long time;
+};
+
+
+/* prototypes */
+static int _terminalmonitor_children(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, size_t parent, long threads);
+static int _terminalmonitor_children_read(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, char const * path, size_t parent);
+static int _terminalmonitor_memory(TerminalMonitor * monitor, pid_t pid,
+		unsigned long * pss, unsigned long * rss);
+static int _terminalmonitor_stat(TerminalMonitor * monitor, pid_t pid,
+		TerminalMonitorStat * st);
+
+static int _terminalmonitor_tree_append(TerminalMonitorTree * tree,
+		pid_t pid, size_t parent, unsigned int depth);
+static void _terminalmonitor_tree_compact(TerminalMonitorTree * tree);
+static int _terminalmonitor_tree_given(TerminalMonitorTree * tree,
+		pid_t pid);
+static TerminalMonitorProcess * _terminalmonitor_tree_lookup(
+		TerminalMonitorTree * tree, pid_t pid);
+
+static int _terminalmonitor_compare(void const * a, void const * b);
+static long long _terminalmonitor_now(void);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalmonitor_new */
+TerminalMonitor * terminalmonitor_new(void)
+{
+	TerminalMonitor * monitor;
+	long l;
+
+	if((monitor = malloc(sizeof(*monitor))) == NULL)
+		return NULL;
+	snprintf(monitor->buf, sizeof(monitor->buf), "%s/%ld/task/%ld/children",
+			TERMINALMONITOR_PROC, (long)getpid(), (long)getpid());
+	monitor->children = (access(monitor->buf, R_OK) == 0) ? 1 : 0;
+	monitor->page = ((l = sysconf(_SC_PAGESIZE)) > 0)
+		? (unsigned long)l / 1024 : 4;
+	monitor->hz = ((l = sysconf(_SC_CLK_TCK)) > 0) ? (unsigned long)l
+		: 100;
+	return monitor;
+}
+
+
+/* terminalmonitor_delete */
+void terminalmonitor_delete(TerminalMonitor * monitor)
+{
+	free(monitor);
+}
+
+
+/* terminalmonitor_tree_new */
+TerminalMonitorTree * terminalmonitor_tree_new(void)
+{
+	TerminalMonitorTree * tree;
+
+	if((tree = malloc(sizeof(*tree))) == NULL)
+		return NULL;
+	tree->processes = NULL;
+	tree->processes_cnt = 0;
+	tree->processes_size = 0;
+	tree->entries = NULL;
+	tree->entries_cnt = 0;
+	tree->pids = NULL;
+	tree->pids_cnt = 0;
+	tree->cpu = 0;
+	tree->time = 0;
+	return tree;
+}
+
+
+/* terminalmonitor_tree_delete */
+void terminalmonitor_tree_delete(TerminalMonitorTree * tree)
+{
+	free(tree->entries);
+	free(tree->processes);
+	free(tree);
+}
+
+
+/* useful */
+/* terminalmonitor_sample */
+int terminalmonitor_sample(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, pid_t const * pids,
+		size_t pids_cnt, unsigned int depth, int memory,
+		TerminalMonitorUsage * usage)
+{
+	TerminalMonitorProcess * p;
+	TerminalMonitorStat st;
+	size_t i;
+	size_t j;
+	int changed;
+	unsigned long cpu = 0;
+	unsigned long largest = 0;
+	long long now;
+
+	memset(usage, 0, sizeof(*usage));
+	usage->largest = -1;
+	tree->pids = pids;
+	tree->pids_cnt = pids_cnt;
+	for(i = 0; i < pids_cnt; i++)
+	{
+		for(j = 0; j < i && pids[j] != pids[i]; j++);
+		if(j < i || pids[i] <= 0)
+			continue;
+		if((p = _terminalmonitor_tree_lookup(tree, pids[i])) != NULL)
+			p->depth = 0;
+		else if(_terminalmonitor_tree_append(tree, pids[i], 0, 0) != 0)
+			return -1;
+	}
+	/* the descendants found are appended along the way */
+	for(i = 0; i < tree->processes_cnt; i++)
+	{
+		p = &tree->processes[i];
+		p->valid = (p->depth == 0)
+			? _terminalmonitor_tree_given(tree, p->pid)
+			: tree->processes[p->parent].valid;
+		/* the process may have exited, or been reparented */
+		if(!p->valid || _terminalmonitor_stat(monitor, p->pid, &st) != 0
+				|| (p->start != 0 && st.start != p->start)
+				|| (p->depth > 0 && st.ppid
+					!= tree->processes[p->parent].pid))
+		{
+			p->valid = 0;
+			continue;
+		}
+		changed = (p->start == 0 || memory || st.faults != p->faults
+				|| st.ticks != p->ticks);
+		p->start = st.start;
+		p->faults = st.faults;
+		p->ticks = st.ticks;
+		p->rss = st.rss;
+		if(memory)
+		{
+			if(_terminalmonitor_memory(monitor, p->pid, &p->pss,
+						&p->rss) != 0)
+				p->pss = p->rss;
+		}
+		else if(p->pss == 0)
+			p->pss = p->rss;
+		cpu += st.ticks + st.children;
+		usage->pss += p->pss;
+		usage->rss += p->rss;
+		usage->processes++;
+		if(p->depth >= depth)
+			usage->jobs++;
+		if(p->depth > 0 && p->pss > largest)
+		{
+			largest = p->pss;
+			usage->largest = p->pid;
+		}
+		if(changed && monitor->children && _terminalmonitor_children(
+					monitor, tree, i, st.threads) != 0)
+			return -1;
+	}
+	_terminalmonitor_tree_compact(tree);
+	tree->pids = NULL;
+	tree->pids_cnt = 0;
+	now = _terminalmonitor_now();
+	usage->cpu = cpu * 1000 / monitor->hz;
+	if(tree->time != 0 && now > tree->time && usage->cpu >= tree->cpu)
+		usage->load = (usage->cpu - tree->cpu) * 100000
+			/ (now - tree->time);
+	tree->cpu = usage->cpu;
+	tree->time = now;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* terminalmonitor_children */
+static int _terminalmonitor_children(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, size_t parent, long threads)
+{
+	pid_t pid = tree->processes[parent].pid;
+	char path[64];
+	DIR * dir;
+	struct dirent * de;
+	int res = 0;
+
+	/* the children are listed by the thread that started them */
+	if(threads <= 1)
+	{
+		snprintf(path, sizeof(path), "%s/%ld/task/%ld/children",
+				TERMINALMONITOR_PROC, (long)pid, (long)pid);
+		return _terminalmonitor_children_read(monitor, tree, path,
+				parent);
+	}
+	snprintf(path, sizeof(path), "%s/%ld/task", TERMINALMONITOR_PROC,
+			(long)pid);
+	if((dir = opendir(path)) == NULL)
+		return 0;
+	while(res == 0 && (de = readdir(dir)) != NULL)
+	{
+		if(de->d_name[0] < '1' || de->d_name[0] > '9')
+			continue;
+		snprintf(path, sizeof(path), "%s/%ld/task/%ld/children",
+				TERMINALMONITOR_PROC, (long)pid,
+				strtol(de->d_name, NULL, 10));
+		res = _terminalmonitor_children_read(monitor, tree, path,
+				parent);
+	}
+	closedir(dir);
+	return res;
+}
+
+
+/* terminalmonitor_children_read */
+static int _terminalmonitor_children_read(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, char const * path, size_t parent)
+{
+	int fd;
+	ssize_t len;
+	ssize_t i;
+	pid_t pid = 0;
+	unsigned int depth = tree->processes[parent].depth + 1;
+
+	if((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return 0;
+	/* the list may be longer than the buffer */
+	while((len = read(fd, monitor->buf, sizeof(monitor->buf))) > 0)
+		for(i = 0; i < len; i++)
+		{
+			if(monitor->buf[i] >= '0' && monitor->buf[i] <= '9')
+			{
+				pid = pid * 10 + monitor->buf[i] - '0';
+				continue;
+			}
+			/* the processes known already are checked anyway */
+			if(pid > 0 && !_terminalmonitor_tree_given(tree, pid)
+					&& _terminalmonitor_tree_lookup(tree,
+						pid) == NULL
+					&& _terminalmonitor_tree_append(tree,
+						pid, parent, depth) != 0)
+			{
+				close(fd);
+				return -1;
+			}
+			pid = 0;
+		}
+	close(fd);
+	return 0;
+}
+
+
+/* terminalmonitor_memory */
+static int _terminalmonitor_memory(TerminalMonitor * monitor, pid_t pid,
+		unsigned long * pss, unsigned long * rss)
+{
+	char path[64];
+	int fd;
+	ssize_t len;
+	char const * p;
+
+	/* only readable for the processes owned */
+	snprintf(path, sizeof(path), "%s/%ld/smaps_rollup",
+			TERMINALMONITOR_PROC, (long)pid);
+	if((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	len = read(fd, monitor->buf, sizeof(monitor->buf) - 1);
+	close(fd);
+	if(len <= 0)
+		return -1;
+	monitor->buf[len] = '\0';
+	if((p = strstr(monitor->buf, "\nRss:")) == NULL)
+		return -1;
+	*rss = strtoul(p + 5, NULL, 10);
+	if((p = strstr(monitor->buf, "\nPss:")) == NULL)
+		return -1;
+	*pss = strtoul(p + 5, NULL, 10);
+	return 0;
+}
+
+
+/* terminalmonitor_stat */
+static int _terminalmonitor_stat(TerminalMonitor * monitor, pid_t pid,
+		TerminalMonitorStat * st)
+{
+	char path[64];
+	int fd;
+	ssize_t len;
+	char const * p;
+	char state;
+	int ppid;
+	unsigned long minflt;
+	unsigned long majflt;
+	unsigned long utime;
+	unsigned long stime;
+	long cutime;
+	long cstime;
+	long pages;
+
+	snprintf(path, sizeof(path), "%s/%ld/stat", TERMINALMONITOR_PROC,
+			(long)pid);
+	if((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	len = read(fd, monitor->buf, sizeof(monitor->buf) - 1);
+	close(fd);
+	if(len <= 0)
+		return -1;
+	monitor->buf[len] = '\0';
+	/* the name of the process may contain anything */
+	if((p = strrchr(monitor->buf, ')')) == NULL
+			|| sscanf(p + 1, " %c %d %*d %*d %*d %*d %*u %lu %*u"
+				" %lu %*u %lu %lu %ld %ld %*d %*d %ld %*d %llu"
+				" %*u %ld", &state, &ppid, &minflt, &majflt,
+				&utime, &stime, &cutime, &cstime,
+				&st->threads, &st->start, &pages) != 11
+			|| state == 'Z' || state == 'X')
+		return -1;
+	st->ppid = ppid;
+	st->faults = minflt + majflt;
+	st->ticks = utime + stime;
+	st->children = (cutime > 0 ? cutime : 0) + (cstime > 0 ? cstime : 0);
+	st->rss = (pages > 0) ? (unsigned long)pages * monitor->page : 0;
+	return 0;
+}
+
+
+/* terminalmonitor_tree_append */
+static int _terminalmonitor_tree_append(TerminalMonitorTree * tree,
+		pid_t pid, size_t parent, unsigned int depth)
+{
+	TerminalMonitorProcess * p;
+	TerminalMonitorEntry * e;
+	size_t size;
+
+	if(tree->processes_cnt == tree->processes_size)
+	{
+		size = (tree->processes_size > 0) ? tree->processes_size * 2
+			: 16;
+		if((p = realloc(tree->processes, sizeof(*p) * size)) == NULL)
+			return -1;
+		tree->processes = p;
+		if((e = realloc(tree->entries, sizeof(*e) * size)) == NULL)
+			return -1;
+		tree->entries = e;
+		tree->processes_size = size;
+	}
+	p = &tree->processes[tree->processes_cnt];
+	memset(p, 0, sizeof(*p));
+	p->pid = pid;
+	p->parent = (depth > 0) ? parent : tree->processes_cnt;
+	p->depth = depth;
+	tree->processes_cnt++;
+	return 0;
+}
+
+
+/* terminalmonitor_tree_compact */
+static void _terminalmonitor_tree_compact(TerminalMonitorTree * tree)
+{
+	TerminalMonitorProcess * p;
+	size_t i;
+	size_t cnt = 0;
+
+	/* the parents move before their children */
+	for(i = 0; i < tree->processes_cnt; i++)
+	{
+		p = &tree->processes[i];
+		if(!p->valid)
+			continue;
+		tree->entries[i].index = cnt;
+		p->parent = (p->depth > 0) ? tree->entries[p->parent].index
+			: cnt;
+		tree->processes[cnt++] = *p;
+	}
+	tree->processes_cnt = cnt;
+	for(i = 0; i < cnt; i++)
+	{
+		tree->entries[i].pid = tree->processes[i].pid;
+		tree->entries[i].index = i;
+	}
+	qsort(tree->entries, cnt, sizeof(*tree->entries),
+			_terminalmonitor_compare);
+	tree->entries_cnt = cnt;
+}
+
+
+/* terminalmonitor_tree_given */
+static int _terminalmonitor_tree_given(TerminalMonitorTree * tree,
+		pid_t pid)
+{
+	size_t i;
+
+	for(i = 0; i < tree->pids_cnt; i++)
+		if(tree->pids[i] == pid)
+			return 1;
+	return 0;
+}
+
+
+/* terminalmonitor_tree_lookup */
+static TerminalMonitorProcess * _terminalmonitor_tree_lookup(
+		TerminalMonitorTree * tree, pid_t pid)
+{
+	TerminalMonitorEntry key;
+	TerminalMonitorEntry * e;
+
+	key.pid = pid;
+	if(tree->entries_cnt == 0 || (e = bsearch(&key, tree->entries,
+					tree->entries_cnt,
+					sizeof(*tree->entries),
+					_terminalmonitor_compare)) == NULL)
+		return NULL;
+	return &tree->processes[e->index];
+}
+
+
+/* terminalmonitor_compare */
+static int _terminalmonitor_compare(void const * a, void const * b)
+{
+	TerminalMonitorEntry const * ea = a;
+	TerminalMonitorEntry const * eb = b;
+
+	return (ea->pid < eb->pid) ? -1 : ((ea->pid > eb->pid) ? 1 : 0);
+}
+
+
+/* terminalmonitor_now */
+static long long _terminalmonitor_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
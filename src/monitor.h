@@ -0,0 +1,78 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_MONITOR_H
+# define TERMINAL_MONITOR_H
+
+# include <sys/types.h>
+
+
+/* Monitor */
+/* public */
+/* types */
+typedef struct _TerminalMonitor TerminalMonitor;
+
+/* processes followed from one sample to the next */
+typedef struct _TerminalMonitorTree TerminalMonitorTree;
+
+typedef struct _TerminalMonitorUsage
+{
+	/* in kilobytes, as of the last sample of the memory */
+	unsigned long pss;
+	unsigned long rss;
+	/* in milliseconds, including the processes waited for */
+	unsigned long cpu;
+	/* since the previous sample, in percent of one processor */
+	unsigned int load;
+	size_t processes;
+	/* the processes below the depth given */
+	size_t jobs;
+	/* the descendant using the most memory, -1 if none */
+	pid_t largest;
+} TerminalMonitorUsage;
+
+
+/* functions */
+/* essential */
+TerminalMonitor * terminalmonitor_new(void);
+void terminalmonitor_delete(TerminalMonitor * monitor);
+
+TerminalMonitorTree * terminalmonitor_tree_new(void);
+void terminalmonitor_tree_delete(TerminalMonitorTree * tree);
+
+
+/* useful */
+/* follows the processes given and their descendants, or the processes given
+ * alone if the kernel does not list the children; only the processes which
+ * ran since the previous sample have their children listed again, unless
+ * the memory is sampled as well */
+int terminalmonitor_sample(TerminalMonitor * monitor,
+		TerminalMonitorTree * tree, pid_t const * pids,
+		size_t pids_cnt, unsigned int depth, int memory,
+		TerminalMonitorUsage * usage);
+
+#endif /* !TERMINAL_MONITOR_H */
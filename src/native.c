@@ -0,0 +1,912 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <libintl.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkkeysyms.h>
+#include <System.h>
+#include "backend.h"
+#include "pty.h"
+#include "vt.h"
+#define N_(string) (string)
+
+/* constants */
+#define NATIVE_COLUMNS		80
+#define NATIVE_ROWS		24
+#define NATIVE_FONT		"Monospace 9"
+#define NATIVE_HISTORY		1000
+#define NATIVE_READ_SIZE	4096
+/* limit the time spent reading before the screen is updated */
+#define NATIVE_READ_BUDGET	65536
+#define NATIVE_SHELL		"/bin/sh"
+
+
+/* Native */
+/* private */
+/* types */
+struct _TerminalBackend
+{
+	TerminalBackendHelper helper;
+	TerminalVT * vt;
+	GtkWidget * widget;
+	int scroll;
+	gboolean ready;
+
+	/* pseudo-terminal */
+	int fd;
+	GIOChannel * channel;
+	guint rd_source;
+	guint wr_source;
+	char * wr_buf;
+	size_t wr_buf_cnt;
+};
+
+/* the glyphs are rendered once and shared by every tab */
+typedef struct _NativeGlyphs
+{
+	GHashTable * glyphs;
+	PangoFontDescription * font;
+	PangoFontDescription * bold;
+	int width;
+	int height;
+} NativeGlyphs;
+
+typedef struct _NativeKey
+{
+	guint keyval;
+	char const * normal;
+	char const * application;
+} NativeKey;
+
+
+/* constants */
+static const NativeKey _native_keys[] =
+{
+	{ GDK_KEY_Up,		"\033[A",	"\033OA"	},
+	{ GDK_KEY_Down,		"\033[B",	"\033OB"	},
+	{ GDK_KEY_Right,	"\033[C",	"\033OC"	},
+	{ GDK_KEY_Left,		"\033[D",	"\033OD"	},
+	{ GDK_KEY_Home,		"\033[H",	"\033OH"	},
+	{ GDK_KEY_End,		"\033[F",	"\033OF"	},
+	{ GDK_KEY_Insert,	"\033[2~",	NULL		},
+	{ GDK_KEY_Delete,	"\033[3~",	NULL		},
+	{ GDK_KEY_Page_Up,	"\033[5~",	NULL		},
+	{ GDK_KEY_Page_Down,	"\033[6~",	NULL		},
+	{ GDK_KEY_F1,		"\033OP",	NULL		},
+	{ GDK_KEY_F2,		"\033OQ",	NULL		},
+	{ GDK_KEY_F3,		"\033OR",	NULL		},
+	{ GDK_KEY_F4,		"\033OS",	NULL		},
+	{ GDK_KEY_F5,		"\033[15~",	NULL		},
+	{ GDK_KEY_F6,		"\033[17~",	NULL		},
+	{ GDK_KEY_F7,		"\033[18~",	NULL		},
+	{ GDK_KEY_F8,		"\033[19~",	NULL		},
+	{ GDK_KEY_F9,		"\033[20~",	NULL		},
+	{ GDK_KEY_F10,		"\033[21~",	NULL		},
+	{ GDK_KEY_F11,		"\033[23~",	NULL		},
+	{ GDK_KEY_F12,		"\033[24~",	NULL		},
+	{ GDK_KEY_BackSpace,	"\177",		NULL		},
+	{ GDK_KEY_Tab,		"\t",		NULL		},
+	{ GDK_KEY_ISO_Left_Tab,	"\033[Z",	NULL		},
+	{ GDK_KEY_Return,	"\r",		NULL		},
+	{ GDK_KEY_KP_Enter,	"\r",		NULL		},
+	{ GDK_KEY_Escape,	"\033",		NULL		}
+};
+
+
+/* variables */
+static NativeGlyphs _native_glyphs = { NULL, NULL, NULL, 0, 0 };
+
+
+/* prototypes */
+static TerminalBackend * _native_init(TerminalBackendHelper const * helper);
+static void _native_destroy(TerminalBackend * native);
+
+static GtkWidget * _native_get_widget(TerminalBackend * native);
+
+static int _native_start(TerminalBackend * native, char const * directory,
+		char const * shell, unsigned int login, GPid * pid);
+
+static void _native_color(cairo_t * cr, unsigned int color);
+static void _native_draw(TerminalBackend * native, cairo_t * cr);
+static cairo_surface_t * _native_glyph(uint32_t c, unsigned int bold);
+static int _native_glyphs_init(TerminalBackend * native);
+static void _native_redraw(TerminalBackend * native);
+static void _native_resize(TerminalBackend * native, int width, int height);
+static void _native_scroll(TerminalBackend * native, int lines);
+static void _native_write(TerminalBackend * native, char const * buf,
+		size_t len);
+
+/* callbacks */
+static gboolean _native_on_button_press(GtkWidget * widget,
+		GdkEventButton * event, gpointer data);
+#if GTK_CHECK_VERSION(3, 0, 0)
+static gboolean _native_on_draw(GtkWidget * widget, cairo_t * cr,
+		gpointer data);
+#else
+static gboolean _native_on_expose(GtkWidget * widget, GdkEventExpose * event,
+		gpointer data);
+#endif
+static gboolean _native_on_key_press(GtkWidget * widget, GdkEventKey * event,
+		gpointer data);
+static void _native_on_map(GtkWidget * widget, gpointer data);
+static void _native_on_paste(GtkClipboard * clipboard, gchar const * text,
+		gpointer data);
+static gboolean _native_on_read(GIOChannel * source, GIOCondition condition,
+		gpointer data);
+static void _native_on_reply(void * data, char const * buf, size_t len);
+static gboolean _native_on_scroll(GtkWidget * widget, GdkEventScroll * event,
+		gpointer data);
+static void _native_on_size_allocate(GtkWidget * widget,
+		GtkAllocation * allocation, gpointer data);
+static void _native_on_title(void * data, char const * title);
+static gboolean _native_on_write(GIOChannel * source, GIOCondition condition,
+		gpointer data);
+
+
+/* public */
+/* constants */
+TerminalBackendDefinition const backend_native =
+{
+	"native",
+	N_("Terminal"),
+	_native_init,
+	_native_destroy,
+	_native_get_widget,
+	_native_start,
+	NULL
+};
+
+
+/* private */
+/* functions */
+/* native_init */
+static TerminalBackend * _native_init(TerminalBackendHelper const * helper)
+{
+	TerminalBackend * native;
+	TerminalVTHelper vthelper;
+
+	if((native = object_new(sizeof(*native))) == NULL)
+		return NULL;
+	native->helper = *helper;
+	native->scroll = 0;
+	native->ready = FALSE;
+	native->fd = -1;
+	native->channel = NULL;
+	native->rd_source = 0;
+	native->wr_source = 0;
+	native->wr_buf = NULL;
+	native->wr_buf_cnt = 0;
+	vthelper.data = native;
+	vthelper.reply = _native_on_reply;
+	vthelper.set_title = _native_on_title;
+	if((native->vt = terminalvt_new(&vthelper, NATIVE_COLUMNS,
+					NATIVE_ROWS, NATIVE_HISTORY)) == NULL)
+	{
+		error_set_code(1, "%s", strerror(ENOMEM));
+		object_delete(native);
+		return NULL;
+	}
+	native->widget = gtk_drawing_area_new();
+	g_object_ref_sink(native->widget);
+	if(_native_glyphs_init(native) != 0)
+	{
+		g_object_unref(native->widget);
+		terminalvt_delete(native->vt);
+		object_delete(native);
+		return NULL;
+	}
+	/* the widget may outlive the backend while pasting */
+	g_object_set_data(G_OBJECT(native->widget), "backend", native);
+	gtk_widget_set_size_request(native->widget, _native_glyphs.width * 2,
+			_native_glyphs.height);
+	gtk_widget_set_can_focus(native->widget, TRUE);
+	gtk_widget_add_events(native->widget, GDK_KEY_PRESS_MASK
+			| GDK_BUTTON_PRESS_MASK | GDK_SCROLL_MASK);
+	g_signal_connect(native->widget, "button-press-event", G_CALLBACK(
+				_native_on_button_press), native);
+#if GTK_CHECK_VERSION(3, 0, 0)
+	g_signal_connect(native->widget, "draw", G_CALLBACK(_native_on_draw),
+			native);
+#else
+	g_signal_connect(native->widget, "expose-event", G_CALLBACK(
+				_native_on_expose), native);
+#endif
+	g_signal_connect(native->widget, "key-press-event", G_CALLBACK(
+				_native_on_key_press), native);
+	g_signal_connect(native->widget, "map", G_CALLBACK(_native_on_map),
+			native);
+	g_signal_connect(native->widget, "scroll-event", G_CALLBACK(
+				_native_on_scroll), native);
+	g_signal_connect(native->widget, "size-allocate", G_CALLBACK(
+				_native_on_size_allocate), native);
+	return native;
+}
+
+
+/* native_destroy */
+static void _native_destroy(TerminalBackend * native)
+{
+	if(native->wr_source > 0)
+		g_source_remove(native->wr_source);
+	if(native->rd_source > 0)
+		g_source_remove(native->rd_source);
+	if(native->channel != NULL)
+		g_io_channel_unref(native->channel);
+	/* the shell gets a hangup */
+	if(native->fd >= 0)
+		close(native->fd);
+	free(native->wr_buf);
+	g_signal_handlers_disconnect_by_data(native->widget, native);
+	g_object_set_data(G_OBJECT(native->widget), "backend", NULL);
+	g_object_unref(native->widget);
+	terminalvt_delete(native->vt);
+	object_delete(native);
+}
+
+
+/* accessors */
+/* native_get_widget */
+static GtkWidget * _native_get_widget(TerminalBackend * native)
+{
+	return native->widget;
+}
+
+
+/* useful */
+/* native_start */
+static int _native_start(TerminalBackend * native, char const * directory,
+		char const * shell, unsigned int login, GPid * pid)
+{
+	char * argv[] = { NULL, NULL, NULL };
+	char * argv0 = NULL;
+	char const * p;
+	int res;
+
+	if(shell == NULL && ((shell = getenv("SHELL")) == NULL
+				|| shell[0] == '\0'))
+		shell = NATIVE_SHELL;
+	argv[0] = (char *)shell;
+	argv[1] = (char *)shell;
+	/* login shells have their name prefixed with a dash */
+	if(login)
+	{
+		p = strrchr(shell, '/');
+		if((argv0 = string_new_append("-", (p != NULL) ? p + 1 : shell,
+						NULL)) == NULL)
+			return -1;
+		argv[1] = argv0;
+	}
+	if((native->fd = pty_new()) < 0)
+	{
+		string_delete(argv0);
+		return -1;
+	}
+	pty_set_size(native->fd, terminalvt_get_columns(native->vt),
+			terminalvt_get_rows(native->vt),
+			terminalvt_get_columns(native->vt)
+			* _native_glyphs.width,
+			terminalvt_get_rows(native->vt)
+			* _native_glyphs.height);
+	res = pty_spawn(native->fd, directory, argv, pid);
+	string_delete(argv0);
+	if(res != 0)
+		return -1;
+	native->channel = g_io_channel_unix_new(native->fd);
+	g_io_channel_set_encoding(native->channel, NULL, NULL);
+	g_io_channel_set_buffered(native->channel, FALSE);
+	/* keep the user interface responsive while reading */
+	native->rd_source = g_io_add_watch_full(native->channel,
+			G_PRIORITY_DEFAULT_IDLE, G_IO_IN | G_IO_ERR | G_IO_HUP,
+			_native_on_read, native, NULL);
+	return 0;
+}
+
+
+/* native_color */
+static void _native_color(cairo_t * cr, unsigned int color)
+{
+	static const unsigned char base[16][3] =
+	{
+		{ 0x00, 0x00, 0x00 }, { 0xcd, 0x00, 0x00 },
+		{ 0x00, 0xcd, 0x00 }, { 0xcd, 0xcd, 0x00 },
+		{ 0x00, 0x00, 0xee }, { 0xcd, 0x00, 0xcd },
+		{ 0x00, 0xcd, 0xcd }, { 0xe5, 0xe5, 0xe5 },
+		{ 0x7f, 0x7f, 0x7f }, { 0xff, 0x00, 0x00 },
+		{ 0x00, 0xff, 0x00 }, { 0xff, 0xff, 0x00 },
+		{ 0x5c, 0x5c, 0xff }, { 0xff, 0x00, 0xff },
+		{ 0x00, 0xff, 0xff }, { 0xff, 0xff, 0xff }
+	};
+	static const unsigned char cube[6] =
+	{ 0x00, 0x5f, 0x87, 0xaf, 0xd7, 0xff };
+	unsigned int r;
+	unsigned int g;
+	unsigned int b;
+
+	if(color < 16)
+	{
+		r = base[color][0];
+		g = base[color][1];
+		b = base[color][2];
+	}
+	else if(color < 232)
+	{
+		color -= 16;
+		r = cube[color / 36];
+		g = cube[(color / 6) % 6];
+		b = cube[color % 6];
+	}
+	else
+		r = g = b = 8 + (color - 232) * 10;
+	cairo_set_source_rgb(cr, r / 255.0, g / 255.0, b / 255.0);
+}
+
+
+/* native_draw */
+static void _native_draw(TerminalBackend * native, cairo_t * cr)
+{
+	const unsigned int fg_default = 0;
+	const unsigned int bg_default = 15;
+	const int width = _native_glyphs.width;
+	const int height = _native_glyphs.height;
+	TerminalVTCell const * line;
+	TerminalVTCell const * cell;
+	unsigned int columns;
+	unsigned int rows;
+	unsigned int x;
+	unsigned int y;
+	unsigned int cx;
+	unsigned int cy;
+	unsigned int fg;
+	unsigned int bg;
+	unsigned int tmp;
+	gboolean outline;
+	double x1;
+	double y1;
+	double x2;
+	double y2;
+	cairo_surface_t * glyph;
+
+	columns = terminalvt_get_columns(native->vt);
+	rows = terminalvt_get_rows(native->vt);
+	terminalvt_get_cursor(native->vt, &cx, &cy);
+	/* only draw the lines exposed */
+	cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+	_native_color(cr, bg_default);
+	cairo_paint(cr);
+	for(y = (y1 > 0) ? y1 / height : 0; y < rows && y * height < y2; y++)
+	{
+		if((line = terminalvt_get_line(native->vt, (int)y
+						- native->scroll)) == NULL)
+			continue;
+		for(x = 0; x < columns; x++)
+		{
+			cell = &line[x];
+			fg = (cell->attributes & TVA_DEFAULT_FG) ? fg_default
+				: cell->fg;
+			bg = (cell->attributes & TVA_DEFAULT_BG) ? bg_default
+				: cell->bg;
+			if(cell->attributes & TVA_REVERSE)
+			{
+				tmp = fg;
+				fg = bg;
+				bg = tmp;
+			}
+			/* the cursor */
+			outline = FALSE;
+			if(native->scroll == 0 && x == cx && y == cy
+					&& (terminalvt_get_modes(native->vt)
+						& TVM_CURSOR_VISIBLE))
+			{
+				if(!gtk_widget_has_focus(native->widget))
+					outline = TRUE;
+				else
+				{
+					tmp = fg;
+					fg = bg;
+					bg = tmp;
+				}
+			}
+			if(bg != bg_default)
+			{
+				_native_color(cr, bg);
+				cairo_rectangle(cr, x * width, y * height,
+						width, height);
+				cairo_fill(cr);
+			}
+			if(cell->c == ' ' && !outline && !(cell->attributes
+						& TVA_UNDERLINE))
+				continue;
+			_native_color(cr, fg);
+			if(outline)
+			{
+				cairo_rectangle(cr, x * width + 0.5,
+						y * height + 0.5, width - 1,
+						height - 1);
+				cairo_set_line_width(cr, 1.0);
+				cairo_stroke(cr);
+			}
+			if(cell->c != ' ' && (glyph = _native_glyph(cell->c,
+						cell->attributes & TVA_BOLD))
+					!= NULL)
+				cairo_mask_surface(cr, glyph, x * width,
+						y * height);
+			if(cell->attributes & TVA_UNDERLINE)
+			{
+				cairo_rectangle(cr, x * width,
+						(y + 1) * height - 1, width, 1);
+				cairo_fill(cr);
+			}
+		}
+	}
+}
+
+
+/* native_glyph */
+static cairo_surface_t * _native_glyph(uint32_t c, unsigned int bold)
+{
+	gpointer key = GUINT_TO_POINTER(bold ? (c | 0x80000000) : c);
+	cairo_surface_t * glyph;
+	cairo_t * cr;
+	PangoLayout * layout;
+	char buf[8];
+	int len;
+
+	if((glyph = g_hash_table_lookup(_native_glyphs.glyphs, key)) != NULL)
+		return glyph;
+	/* render the glyph as an alpha mask */
+	glyph = cairo_image_surface_create(CAIRO_FORMAT_A8,
+			_native_glyphs.width, _native_glyphs.height);
+	if(cairo_surface_status(glyph) != CAIRO_STATUS_SUCCESS)
+	{
+		cairo_surface_destroy(glyph);
+		return NULL;
+	}
+	cr = cairo_create(glyph);
+	layout = pango_cairo_create_layout(cr);
+	pango_layout_set_font_description(layout, bold ? _native_glyphs.bold
+			: _native_glyphs.font);
+	len = g_unichar_to_utf8(c, buf);
+	pango_layout_set_text(layout, buf, len);
+	cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+	pango_cairo_show_layout(cr, layout);
+	g_object_unref(layout);
+	cairo_destroy(cr);
+	g_hash_table_insert(_native_glyphs.glyphs, key, glyph);
+	return glyph;
+}
+
+
+/* native_glyphs_init */
+static int _native_glyphs_init(TerminalBackend * native)
+{
+	char const * font = NULL;
+	PangoLayout * layout;
+
+	if(_native_glyphs.glyphs != NULL)
+		return 0;
+	if(native->helper.config_get != NULL)
+		font = native->helper.config_get(native->helper.data, "font");
+	if((_native_glyphs.font = pango_font_description_from_string(
+					(font != NULL) ? font : NATIVE_FONT))
+			== NULL)
+		return -error_set_code(1, "%s", "Could not load the font");
+	_native_glyphs.bold = pango_font_description_copy(_native_glyphs.font);
+	pango_font_description_set_weight(_native_glyphs.bold,
+			PANGO_WEIGHT_BOLD);
+	/* obtain the size of the cells */
+	layout = gtk_widget_create_pango_layout(native->widget, "M");
+	pango_layout_set_font_description(layout, _native_glyphs.font);
+	pango_layout_get_pixel_size(layout, &_native_glyphs.width,
+			&_native_glyphs.height);
+	g_object_unref(layout);
+	if(_native_glyphs.width <= 0 || _native_glyphs.height <= 0)
+	{
+		pango_font_description_free(_native_glyphs.bold);
+		pango_font_description_free(_native_glyphs.font);
+		return -error_set_code(1, "%s", "Could not load the font");
+	}
+	_native_glyphs.glyphs = g_hash_table_new_full(g_direct_hash,
+			g_direct_equal, NULL, (GDestroyNotify)
+			cairo_surface_destroy);
+	return 0;
+}
+
+
+/* native_redraw */
+static void _native_redraw(TerminalBackend * native)
+{
+	unsigned int first;
+	unsigned int last;
+
+	if(terminalvt_get_dirty(native->vt, &first, &last) == 0)
+		return;
+	if(native->scroll != 0)
+	{
+		/* new output scrolls back to the bottom */
+		native->scroll = 0;
+		gtk_widget_queue_draw(native->widget);
+		return;
+	}
+	gtk_widget_queue_draw_area(native->widget, 0,
+			first * _native_glyphs.height,
+			terminalvt_get_columns(native->vt)
+			* _native_glyphs.width,
+			(last - first + 1) * _native_glyphs.height);
+}
+
+
+/* native_resize */
+static void _native_resize(TerminalBackend * native, int width, int height)
+{
+	unsigned int columns;
+	unsigned int rows;
+
+	columns = (width > _native_glyphs.width)
+		? width / _native_glyphs.width : 1;
+	rows = (height > _native_glyphs.height)
+		? height / _native_glyphs.height : 1;
+	if(columns == terminalvt_get_columns(native->vt)
+			&& rows == terminalvt_get_rows(native->vt))
+		return;
+	if(terminalvt_set_size(native->vt, columns, rows) != 0)
+		return;
+	native->scroll = 0;
+	if(native->fd >= 0)
+		pty_set_size(native->fd, columns, rows, width, height);
+	gtk_widget_queue_draw(native->widget);
+}
+
+
+/* native_scroll */
+static void _native_scroll(TerminalBackend * native, int lines)
+{
+	int scroll = native->scroll + lines;
+	int history = terminalvt_get_history(native->vt);
+
+	if(scroll < 0)
+		scroll = 0;
+	else if(scroll > history)
+		scroll = history;
+	if(scroll == native->scroll)
+		return;
+	native->scroll = scroll;
+	gtk_widget_queue_draw(native->widget);
+}
+
+
+/* native_write */
+static void _native_write(TerminalBackend * native, char const * buf,
+		size_t len)
+{
+	ssize_t res = 0;
+	char * p;
+
+	if(native->fd < 0 || len == 0)
+		return;
+	/* preserve the order of the input */
+	if(native->wr_buf_cnt == 0
+			&& (res = write(native->fd, buf, len)) == (ssize_t)len)
+		return;
+	if(res < 0)
+	{
+		if(errno != EAGAIN)
+			return;
+		res = 0;
+	}
+	buf += res;
+	len -= res;
+	if((p = realloc(native->wr_buf, native->wr_buf_cnt + len)) == NULL)
+		return;
+	native->wr_buf = p;
+	memcpy(&native->wr_buf[native->wr_buf_cnt], buf, len);
+	native->wr_buf_cnt += len;
+	if(native->wr_source == 0)
+		native->wr_source = g_io_add_watch(native->channel, G_IO_OUT,
+				_native_on_write, native);
+}
+
+
+/* callbacks */
+/* native_on_button_press */
+static gboolean _native_on_button_press(GtkWidget * widget,
+		GdkEventButton * event, gpointer data)
+{
+	TerminalBackend * native = data;
+	GtkClipboard * clipboard;
+
+	gtk_widget_grab_focus(widget);
+	if(event->type != GDK_BUTTON_PRESS || event->button != 2
+			|| native->fd < 0)
+		return FALSE;
+	/* paste the primary selection */
+	clipboard = gtk_widget_get_clipboard(widget, GDK_SELECTION_PRIMARY);
+	gtk_clipboard_request_text(clipboard, _native_on_paste,
+			g_object_ref(widget));
+	return TRUE;
+}
+
+
+#if GTK_CHECK_VERSION(3, 0, 0)
+/* native_on_draw */
+static gboolean _native_on_draw(GtkWidget * widget, cairo_t * cr,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	(void) widget;
+
+	_native_draw(native, cr);
+	return TRUE;
+}
+#else
+/* native_on_expose */
+static gboolean _native_on_expose(GtkWidget * widget, GdkEventExpose * event,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	cairo_t * cr;
+
+	cr = gdk_cairo_create(gtk_widget_get_window(widget));
+	gdk_cairo_region(cr, event->region);
+	cairo_clip(cr);
+	_native_draw(native, cr);
+	cairo_destroy(cr);
+	return TRUE;
+}
+#endif
+
+
+/* native_on_key_press */
+static gboolean _native_on_key_press(GtkWidget * widget, GdkEventKey * event,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	const guint modifiers = GDK_SHIFT_MASK | GDK_CONTROL_MASK
+		| GDK_MOD1_MASK;
+	guint state = event->state & modifiers;
+	unsigned int application;
+	size_t i;
+	char const * p;
+	char buf[16];
+	gunichar c;
+	int len;
+	(void) widget;
+
+	/* scroll the history */
+	if(state == GDK_SHIFT_MASK && (event->keyval == GDK_KEY_Page_Up
+				|| event->keyval == GDK_KEY_Page_Down))
+	{
+		i = terminalvt_get_rows(native->vt) / 2;
+		_native_scroll(native, (event->keyval == GDK_KEY_Page_Up)
+				? (int)i : -(int)i);
+		return TRUE;
+	}
+	application = terminalvt_get_modes(native->vt) & TVM_CURSOR_KEYS;
+	for(i = 0; i < sizeof(_native_keys) / sizeof(*_native_keys); i++)
+	{
+		if(_native_keys[i].keyval != event->keyval)
+			continue;
+		p = (application && _native_keys[i].application != NULL)
+			? _native_keys[i].application : _native_keys[i].normal;
+		/* report the modifiers for the cursor keys */
+		if(state != 0 && i < 6)
+		{
+			len = snprintf(buf, sizeof(buf), "\033[1;%u%c",
+					1 + ((state & GDK_SHIFT_MASK) ? 1 : 0)
+					+ ((state & GDK_MOD1_MASK) ? 2 : 0)
+					+ ((state & GDK_CONTROL_MASK) ? 4 : 0),
+					p[2]);
+			_native_write(native, buf, len);
+		}
+		else
+			_native_write(native, p, strlen(p));
+		native->scroll = 0;
+		return TRUE;
+	}
+	if((c = gdk_keyval_to_unicode(event->keyval)) == 0)
+		return FALSE;
+	len = 0;
+	if(state & GDK_MOD1_MASK)
+		buf[len++] = '\033';
+	if((state & GDK_CONTROL_MASK) && c < 0x80)
+	{
+		if(c == ' ' || c == '2' || c == '@')
+			c = 0x00;
+		else if((c >= 'a' && c <= 'z') || (c >= '[' && c <= '_'))
+			c &= 0x1f;
+		else if(c >= 'A' && c <= 'Z')
+			c &= 0x1f;
+		else if(c == '/')
+			c = 0x1f;
+		else if(c == '8' || c == '?')
+			c = 0x7f;
+	}
+	if(c < 0x80)
+		buf[len++] = c;
+	else
+		len += g_unichar_to_utf8(c, &buf[len]);
+	_native_write(native, buf, len);
+	if(native->scroll != 0)
+	{
+		native->scroll = 0;
+		gtk_widget_queue_draw(native->widget);
+	}
+	return TRUE;
+}
+
+
+/* native_on_map */
+static void _native_on_map(GtkWidget * widget, gpointer data)
+{
+	(void) data;
+
+	/* the visible tab gets the keyboard */
+	gtk_widget_grab_focus(widget);
+}
+
+
+/* native_on_paste */
+static void _native_on_paste(GtkClipboard * clipboard, gchar const * text,
+		gpointer data)
+{
+	GtkWidget * widget = data;
+	TerminalBackend * native;
+	(void) clipboard;
+
+	if(text != NULL && (native = g_object_get_data(G_OBJECT(widget),
+					"backend")) != NULL)
+	{
+		if(terminalvt_get_modes(native->vt) & TVM_BRACKETED_PASTE)
+		{
+			_native_write(native, "\033[200~", 6);
+			_native_write(native, text, strlen(text));
+			_native_write(native, "\033[201~", 6);
+		}
+		else
+			_native_write(native, text, strlen(text));
+	}
+	g_object_unref(widget);
+}
+
+
+/* native_on_read */
+static gboolean _native_on_read(GIOChannel * source, GIOCondition condition,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	char buf[NATIVE_READ_SIZE];
+	ssize_t res;
+	size_t total = 0;
+	(void) source;
+	(void) condition;
+
+	while(total < NATIVE_READ_BUDGET)
+	{
+		if((res = read(native->fd, buf, sizeof(buf))) > 0)
+		{
+			terminalvt_write(native->vt, buf, res);
+			total += res;
+			/* the shell has started */
+			if(native->ready == FALSE)
+			{
+				native->ready = TRUE;
+				if(native->helper.ready != NULL)
+					native->helper.ready(
+							native->helper.data);
+			}
+			continue;
+		}
+		if(res < 0 && (errno == EAGAIN || errno == EINTR))
+			break;
+		/* the shell is gone (EIO on some systems) */
+		_native_redraw(native);
+		native->rd_source = 0;
+		return FALSE;
+	}
+	_native_redraw(native);
+	return TRUE;
+}
+
+
+/* native_on_reply */
+static void _native_on_reply(void * data, char const * buf, size_t len)
+{
+	TerminalBackend * native = data;
+
+	_native_write(native, buf, len);
+}
+
+
+/* native_on_scroll */
+static gboolean _native_on_scroll(GtkWidget * widget, GdkEventScroll * event,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	(void) widget;
+
+	if(event->direction == GDK_SCROLL_UP)
+		_native_scroll(native, 3);
+	else if(event->direction == GDK_SCROLL_DOWN)
+		_native_scroll(native, -3);
+	else
+		return FALSE;
+	return TRUE;
+}
+
+
+/* native_on_size_allocate */
+static void _native_on_size_allocate(GtkWidget * widget,
+		GtkAllocation * allocation, gpointer data)
+{
+	TerminalBackend * native = data;
+	(void) widget;
+
+	_native_resize(native, allocation->width, allocation->height);
+}
+
+
+/* native_on_title */
+static void _native_on_title(void * data, char const * title)
+{
+	TerminalBackend * native = data;
+
+	if(native->helper.set_title != NULL)
+		native->helper.set_title(native->helper.data, title);
+}
+
+
+/* native_on_write */
+static gboolean _native_on_write(GIOChannel * source, GIOCondition condition,
+		gpointer data)
+{
+	TerminalBackend * native = data;
+	ssize_t res;
+	(void) source;
+
+	if(condition != G_IO_OUT
+			|| ((res = write(native->fd, native->wr_buf,
+						native->wr_buf_cnt)) < 0
+				&& errno != EAGAIN))
+	{
+		/* give up */
+		native->wr_buf_cnt = 0;
+		native->wr_source = 0;
+		return FALSE;
+	}
+	if(res < 0)
+		return TRUE;
+	memmove(native->wr_buf, &native->wr_buf[res], native->wr_buf_cnt
+			- res);
+	if((native->wr_buf_cnt -= res) > 0)
+		return TRUE;
+	native->wr_source = 0;
+	return FALSE;
+}
@@ -0,0 +1,554 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "priority.h"
+
+/* constants */
+#define TERMINALPRIORITY_BACKGROUND	"background"
+#define TERMINALPRIORITY_CGROUP		"/sys/fs/cgroup"
+#define TERMINALPRIORITY_FOREGROUND	"foreground"
+#define TERMINALPRIORITY_IO_IDLE	(3 << 13)
+#define TERMINALPRIORITY_IO_PROCESS	1
+
+
+/* Priority */
+/* private */
+/* types */
+struct _TerminalPriority
+{
+	int idle;
+	int io;
+	/* niceness in the background, 0 if unchanged */
+	int nice;
+	int nice_base;
+
+	/* cgroup of the current process, if delegated */
+	char * cgroup;
+	char * path;
+};
+
+
+/* prototypes */
+static int _terminalpriority_cgroup_move(TerminalPriority * priority,
+		pid_t pid, char const * from, char const * to);
+static int _terminalpriority_cgroup_self(char ** cgroup);
+static int _terminalpriority_cgroup_setup(char const * path,
+		unsigned int weight);
+
+static int _terminalpriority_can_restore(TerminalPriority * priority);
+static void _terminalpriority_error(int * error);
+
+static int _terminalpriority_ioprio_get(pid_t pid);
+static int _terminalpriority_ioprio_set(pid_t pid, int ioprio);
+
+static int _terminalpriority_read(char const * path, char * buf,
+		size_t size);
+static int _terminalpriority_write(char const * path, char const * buf);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalpriority_new */
+TerminalPriority * terminalpriority_new(void)
+{
+	TerminalPriority * priority;
+
+	if((priority = malloc(sizeof(*priority))) == NULL)
+		return NULL;
+	priority->idle = 0;
+	priority->io = 0;
+	priority->nice = 0;
+	errno = 0;
+	if((priority->nice_base = getpriority(PRIO_PROCESS, 0)) == -1
+			&& errno != 0)
+		priority->nice_base = 0;
+	priority->cgroup = NULL;
+	priority->path = NULL;
+	return priority;
+}
+
+
+/* terminalpriority_delete */
+void terminalpriority_delete(TerminalPriority * priority)
+{
+	char path[PATH_MAX];
+
+	/* the processes left behind keep it */
+	if(priority->path != NULL && (size_t)snprintf(path, sizeof(path),
+				"%s/%s", priority->path,
+				TERMINALPRIORITY_BACKGROUND) < sizeof(path))
+		rmdir(path);
+	free(priority->path);
+	free(priority->cgroup);
+	free(priority);
+}
+
+
+/* accessors */
+/* terminalpriority_set_idle */
+int terminalpriority_set_idle(TerminalPriority * priority, int idle)
+{
+#ifdef SCHED_IDLE
+	if(idle && _terminalpriority_can_restore(priority) != 0)
+		return -1;
+	priority->idle = idle ? 1 : 0;
+	return 0;
+#else
+	if(idle)
+	{
+		errno = ENOSYS;
+		return -1;
+	}
+	return 0;
+#endif
+}
+
+
+/* terminalpriority_set_io */
+int terminalpriority_set_io(TerminalPriority * priority, int idle)
+{
+#ifndef SYS_ioprio_set
+	if(idle)
+	{
+		errno = ENOSYS;
+		return -1;
+	}
+#endif
+	priority->io = idle ? 1 : 0;
+	return 0;
+}
+
+
+/* terminalpriority_set_nice */
+int terminalpriority_set_nice(TerminalPriority * priority, int nice)
+{
+	if(nice < 0 || nice > 19)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	if(nice > priority->nice_base
+			&& _terminalpriority_can_restore(priority) != 0)
+		return -1;
+	priority->nice = (nice > priority->nice_base) ? nice : 0;
+	return 0;
+}
+
+
+/* terminalpriority_set_weight */
+int terminalpriority_set_weight(TerminalPriority * priority,
+		unsigned int weight)
+{
+	char * cgroup;
+	char * path;
+
+	if(weight > 10000)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	if(weight == 0)
+	{
+		free(priority->path);
+		free(priority->cgroup);
+		priority->path = NULL;
+		priority->cgroup = NULL;
+		return 0;
+	}
+	if(_terminalpriority_cgroup_self(&cgroup) != 0)
+		return -1;
+	if((path = malloc(sizeof(TERMINALPRIORITY_CGROUP) + strlen(cgroup)))
+			== NULL)
+	{
+		free(cgroup);
+		return -1;
+	}
+	sprintf(path, "%s%s", TERMINALPRIORITY_CGROUP, cgroup);
+	if(_terminalpriority_cgroup_setup(path, weight) != 0)
+	{
+		free(path);
+		free(cgroup);
+		return -1;
+	}
+	free(priority->path);
+	free(priority->cgroup);
+	priority->cgroup = cgroup;
+	priority->path = path;
+	return 0;
+}
+
+
+/* useful */
+/* terminalpriority_background */
+int terminalpriority_background(TerminalPriority * priority,
+		pid_t const * pids, size_t pids_cnt)
+{
+	int error = 0;
+	size_t i;
+	int nice;
+#ifdef SCHED_IDLE
+	int policy;
+	struct sched_param param;
+
+	memset(&param, 0, sizeof(param));
+#endif
+	for(i = 0; i < pids_cnt; i++)
+	{
+		if(priority->nice > 0)
+		{
+			errno = 0;
+			nice = getpriority(PRIO_PROCESS, pids[i]);
+			if(errno != 0 || (nice < priority->nice
+						&& setpriority(PRIO_PROCESS,
+							pids[i],
+							priority->nice) != 0))
+				_terminalpriority_error(&error);
+		}
+#ifdef SCHED_IDLE
+		if(priority->idle && (((policy = sched_getscheduler(pids[i]))
+						< 0) || (policy == SCHED_OTHER
+						&& sched_setscheduler(pids[i],
+							SCHED_IDLE, &param)
+						!= 0)))
+			_terminalpriority_error(&error);
+#endif
+		if(priority->io && _terminalpriority_ioprio_set(pids[i],
+					TERMINALPRIORITY_IO_IDLE) != 0)
+			_terminalpriority_error(&error);
+		if(priority->path != NULL && _terminalpriority_cgroup_move(
+					priority, pids[i],
+					TERMINALPRIORITY_FOREGROUND,
+					TERMINALPRIORITY_BACKGROUND) != 0)
+			_terminalpriority_error(&error);
+	}
+	errno = error;
+	return (error != 0) ? -1 : 0;
+}
+
+
+/* terminalpriority_foreground */
+int terminalpriority_foreground(TerminalPriority * priority,
+		pid_t const * pids, size_t pids_cnt)
+{
+	int error = 0;
+	size_t i;
+	int nice;
+	int ioprio;
+#ifdef SCHED_IDLE
+	int policy;
+	struct sched_param param;
+
+	memset(&param, 0, sizeof(param));
+#endif
+	for(i = 0; i < pids_cnt; i++)
+	{
+		/* only what was changed in the background */
+		if(priority->nice > 0)
+		{
+			errno = 0;
+			nice = getpriority(PRIO_PROCESS, pids[i]);
+			if(errno != 0 || (nice == priority->nice
+						&& setpriority(PRIO_PROCESS,
+							pids[i],
+							priority->nice_base)
+						!= 0))
+				_terminalpriority_error(&error);
+		}
+#ifdef SCHED_IDLE
+		if(priority->idle && (((policy = sched_getscheduler(pids[i]))
+						< 0) || (policy == SCHED_IDLE
+						&& sched_setscheduler(pids[i],
+							SCHED_OTHER, &param)
+						!= 0)))
+			_terminalpriority_error(&error);
+#endif
+		if(priority->io)
+		{
+			ioprio = _terminalpriority_ioprio_get(pids[i]);
+			/* the I/O priority follows the niceness again */
+			if(ioprio < 0 || (ioprio == TERMINALPRIORITY_IO_IDLE
+						&& _terminalpriority_ioprio_set(
+							pids[i], 0) != 0))
+				_terminalpriority_error(&error);
+		}
+		if(priority->path != NULL && _terminalpriority_cgroup_move(
+					priority, pids[i],
+					TERMINALPRIORITY_BACKGROUND,
+					TERMINALPRIORITY_FOREGROUND) != 0)
+			_terminalpriority_error(&error);
+	}
+	errno = error;
+	return (error != 0) ? -1 : 0;
+}
+
+
+/* private */
+/* functions */
+/* terminalpriority_cgroup_move */
+static int _terminalpriority_cgroup_move(TerminalPriority * priority,
+		pid_t pid, char const * from, char const * to)
+{
+	char path[PATH_MAX];
+	char buf[PATH_MAX + 16];
+	char expected[PATH_MAX + 16];
+	char * p;
+
+	/* the processes moved elsewhere meanwhile are left alone */
+	snprintf(path, sizeof(path), "/proc/%ld/cgroup", (long)pid);
+	if(_terminalpriority_read(path, buf, sizeof(buf)) != 0)
+	{
+		if(errno == ENOENT)
+			errno = ESRCH;
+		return -1;
+	}
+	if((p = strstr(buf, "0::")) == NULL
+			|| (p != buf && p[-1] != '\n'))
+		return 0;
+	snprintf(expected, sizeof(expected), "0::%s/%s\n", priority->cgroup,
+			from);
+	if(strncmp(p, expected, strlen(expected)) != 0)
+		return 0;
+	if((size_t)snprintf(path, sizeof(path), "%s/%s/cgroup.procs",
+				priority->path, to) >= sizeof(path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	snprintf(buf, sizeof(buf), "%ld", (long)pid);
+	return _terminalpriority_write(path, buf);
+}
+
+
+/* terminalpriority_cgroup_self */
+static int _terminalpriority_cgroup_self(char ** cgroup)
+{
+	char buf[PATH_MAX + 16];
+	char * p;
+	char * q;
+
+	if(_terminalpriority_read("/proc/self/cgroup", buf, sizeof(buf)) != 0)
+		return -1;
+	/* only the unified hierarchy (v2) is supported */
+	for(p = buf; strncmp(p, "0::", 3) != 0; p = q + 1)
+		if((q = strchr(p, '\n')) == NULL)
+		{
+			errno = ENOTSUP;
+			return -1;
+		}
+	p += 3;
+	if((q = strchr(p, '\n')) != NULL)
+		*q = '\0';
+	/* the root cgroup is never delegated */
+	if(strcmp(p, "/") == 0)
+	{
+		errno = EPERM;
+		return -1;
+	}
+	return ((*cgroup = strdup(p)) != NULL) ? 0 : -1;
+}
+
+
+/* terminalpriority_cgroup_setup */
+static int _terminalpriority_cgroup_setup(char const * path,
+		unsigned int weight)
+{
+	char buf[PATH_MAX];
+	char procs[4096];
+	char * p;
+	char * q;
+	size_t i;
+	char const * children[] = { TERMINALPRIORITY_FOREGROUND,
+		TERMINALPRIORITY_BACKGROUND };
+
+	/* the CPU controller has to be available */
+	snprintf(buf, sizeof(buf), "%s/cgroup.controllers", path);
+	if(_terminalpriority_read(buf, procs, sizeof(procs)) != 0)
+		return -1;
+	for(p = procs; (p = strstr(p, "cpu")) != NULL; p += 3)
+		if((p == procs || p[-1] == ' ')
+				&& (p[3] == ' ' || p[3] == '\n'
+					|| p[3] == '\0'))
+			break;
+	if(p == NULL)
+	{
+		errno = ENOTSUP;
+		return -1;
+	}
+	for(i = 0; i < sizeof(children) / sizeof(*children); i++)
+	{
+		if((size_t)snprintf(buf, sizeof(buf), "%s/%s", path,
+					children[i]) >= sizeof(buf))
+		{
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+		if(mkdir(buf, 0755) != 0 && errno != EEXIST)
+			return -1;
+	}
+	/* the processes have to leave before enabling the controller */
+	snprintf(buf, sizeof(buf), "%s/cgroup.procs", path);
+	if(_terminalpriority_read(buf, procs, sizeof(procs)) != 0)
+		return -1;
+	snprintf(buf, sizeof(buf), "%s/%s/cgroup.procs", path,
+			TERMINALPRIORITY_FOREGROUND);
+	for(p = procs; *p != '\0'; p = q)
+	{
+		if((q = strchr(p, '\n')) != NULL)
+			*(q++) = '\0';
+		else
+			q = &p[strlen(p)];
+		if(*p != '\0' && _terminalpriority_write(buf, p) != 0
+				&& errno != ESRCH)
+			return -1;
+	}
+	snprintf(buf, sizeof(buf), "%s/cgroup.subtree_control", path);
+	if(_terminalpriority_write(buf, "+cpu") != 0)
+		return -1;
+	snprintf(buf, sizeof(buf), "%s/%s/cpu.weight", path,
+			TERMINALPRIORITY_BACKGROUND);
+	snprintf(procs, sizeof(procs), "%u", weight);
+	return _terminalpriority_write(buf, procs);
+}
+
+
+/* terminalpriority_can_restore */
+static int _terminalpriority_can_restore(TerminalPriority * priority)
+{
+#ifdef RLIMIT_NICE
+	struct rlimit rl;
+#endif
+
+	/* lowering the niceness again may not be allowed */
+	if(geteuid() == 0)
+		return 0;
+#ifdef RLIMIT_NICE
+	if(getrlimit(RLIMIT_NICE, &rl) != 0)
+		return -1;
+	if(rl.rlim_cur == RLIM_INFINITY
+			|| 20 - (long)rl.rlim_cur <= priority->nice_base)
+		return 0;
+#endif
+	errno = EPERM;
+	return -1;
+}
+
+
+/* terminalpriority_error */
+static void _terminalpriority_error(int * error)
+{
+	/* the process may have exited in the meantime, or belong to another
+	 * user (set-user-ID) */
+	if(*error == 0 && errno != ESRCH && errno != EPERM)
+		*error = (errno != 0) ? errno : EIO;
+}
+
+
+/* terminalpriority_ioprio_get */
+static int _terminalpriority_ioprio_get(pid_t pid)
+{
+#ifdef SYS_ioprio_get
+	return syscall(SYS_ioprio_get, TERMINALPRIORITY_IO_PROCESS, pid);
+#else
+	(void) pid;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+
+/* terminalpriority_ioprio_set */
+static int _terminalpriority_ioprio_set(pid_t pid, int ioprio)
+{
+#ifdef SYS_ioprio_set
+	return syscall(SYS_ioprio_set, TERMINALPRIORITY_IO_PROCESS, pid,
+			ioprio);
+#else
+	(void) pid;
+	(void) ioprio;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+
+/* terminalpriority_read */
+static int _terminalpriority_read(char const * path, char * buf,
+		size_t size)
+{
+	int fd;
+	ssize_t len;
+
+	if((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	len = read(fd, buf, size - 1);
+	close(fd);
+	if(len < 0)
+		return -1;
+	buf[len] = '\0';
+	return 0;
+}
+
+
+/* terminalpriority_write */
+static int _terminalpriority_write(char const * path, char const * buf)
+{
+	int fd;
+	ssize_t len;
+	int res;
+
+	if((fd = open(path, O_WRONLY | O_CLOEXEC)) < 0)
+		return -1;
+	len = write(fd, buf, strlen(buf));
+	res = errno;
+	close(fd);
+	if(len < 0)
+	{
+		errno = res;
+		return -1;
+	}
+	return 0;
+}
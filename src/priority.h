@@ -0,0 +1,69 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_PRIORITY_H
+# define TERMINAL_PRIORITY_H
+
+# include <sys/types.h>
+
+
+/* Priority */
+/* public */
+/* types */
+typedef struct _TerminalPriority TerminalPriority;
+
+
+/* functions */
+/* essential */
+/* nothing is changed until configured */
+TerminalPriority * terminalpriority_new(void);
+/* removes the cgroup of the background processes, once empty */
+void terminalpriority_delete(TerminalPriority * priority);
+
+
+/* accessors */
+/* uses the idle scheduling policy in the background, fails if the
+ * priority could not be restored afterwards */
+int terminalpriority_set_idle(TerminalPriority * priority, int idle);
+/* uses the idle I/O class in the background */
+int terminalpriority_set_io(TerminalPriority * priority, int idle);
+/* same as the idle scheduling policy */
+int terminalpriority_set_nice(TerminalPriority * priority, int nice);
+/* moves the background processes to a cgroup (v2) with this CPU weight,
+ * within the cgroup of the current process (delegated) */
+int terminalpriority_set_weight(TerminalPriority * priority,
+		unsigned int weight);
+
+
+/* useful */
+/* the processes gone or not owned are ignored */
+int terminalpriority_background(TerminalPriority * priority,
+		pid_t const * pids, size_t pids_cnt);
+int terminalpriority_foreground(TerminalPriority * priority,
+		pid_t const * pids, size_t pids_cnt);
+
+#endif /* !TERMINAL_PRIORITY_H */
@@ -0,0 +1,318 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/types.h>
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+#include <dirent.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "proc.h"
+
+/* constants */
+#define PROC_PATH	"/proc"
+
+
+/* proc */
+/* private */
+/* prototypes */
+static int _proc_get_entries(ProcEntry ** entries, size_t * entries_cnt);
+static int _proc_get_entry(char const * pid, ProcEntry * entry);
+
+static int _proc_compare(void const * a, void const * b);
+
+
+/* public */
+/* functions */
+/* accessors */
+/* proc_get_cwd */
+int proc_get_cwd(GPid pid, char * buf, size_t size)
+{
+	char path[32];
+	ssize_t len;
+
+	snprintf(path, sizeof(path), "%s/%ld/cwd", PROC_PATH, (long)pid);
+	if(size == 0 || (len = readlink(path, buf, size)) < 0)
+		return -error_set_code(1, "%s: %s", path, strerror(errno));
+	if((size_t)len == size)
+		return -error_set_code(1, "%s: %s", path,
+				strerror(ENAMETOOLONG));
+	buf[len] = '\0';
+	return 0;
+}
+
+
+/* proc_get_descendants */
+int proc_get_descendants(GPid const * pids, size_t pids_cnt,
+		ProcEntry ** descendants, size_t * descendants_cnt)
+{
+	ProcEntry * entries;
+	size_t entries_cnt;
+	ProcEntry key;
+	ProcEntry * parent;
+	size_t * parents;
+	char * marks;
+	size_t i;
+	size_t j;
+	size_t cnt = 0;
+	int changed;
+
+	if(_proc_get_entries(&entries, &entries_cnt) != 0)
+		return -1;
+	marks = calloc(entries_cnt + 1, sizeof(*marks));
+	parents = malloc(sizeof(*parents) * (entries_cnt + 1));
+	if(marks == NULL || parents == NULL)
+	{
+		free(parents);
+		free(marks);
+		free(entries);
+		return -error_set_code(1, "%s", strerror(errno));
+	}
+	/* look the parents up once and for all */
+	qsort(entries, entries_cnt, sizeof(*entries), _proc_compare);
+	for(i = 0; i < entries_cnt; i++)
+	{
+		for(j = 0; j < pids_cnt; j++)
+			if(entries[i].ppid == pids[j])
+				marks[i] = 1;
+		key.pid = entries[i].ppid;
+		parent = bsearch(&key, entries, entries_cnt, sizeof(*entries),
+				_proc_compare);
+		parents[i] = (parent != NULL) ? (size_t)(parent - entries)
+			: entries_cnt;
+	}
+	/* mark the processes until the tree is complete */
+	do
+		for(i = 0, changed = 0; i < entries_cnt; i++)
+			if(!marks[i] && marks[parents[i]])
+				marks[i] = changed = 1;
+	while(changed);
+	/* keep only the processes marked */
+	for(i = 0; i < entries_cnt; i++)
+		if(marks[i])
+			entries[cnt++] = entries[i];
+	free(parents);
+	free(marks);
+	*descendants = entries;
+	*descendants_cnt = cnt;
+	return 0;
+}
+
+
+/* proc_get_foreground */
+int proc_get_foreground(GPid pid, GPid * foreground)
+{
+	char path[32];
+	char buf[512];
+	FILE * fp;
+	char const * p;
+	long tpgid;
+
+	snprintf(path, sizeof(path), "%s/%ld/stat", PROC_PATH, (long)pid);
+	if((fp = fopen(path, "r")) == NULL)
+		return -error_set_code(1, "%s: %s", path, strerror(errno));
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	/* the name of the process may contain anything */
+	if(p == NULL || (p = strrchr(buf, ')')) == NULL
+			|| sscanf(p + 1, " %*c %*d %*d %*d %*d %ld", &tpgid)
+			!= 1)
+		return -error_set_code(1, "%s: %s", path, strerror(EINVAL));
+	/* without a controlling terminal */
+	if(tpgid <= 0)
+		return -error_set_code(1, "%s: %s", path, strerror(ENOTTY));
+	*foreground = tpgid;
+	return 0;
+}
+
+
+/* proc_get_name */
+int proc_get_name(GPid pid, char * buf, size_t size)
+{
+	char path[32];
+	FILE * fp;
+	size_t len;
+
+	snprintf(path, sizeof(path), "%s/%ld/comm", PROC_PATH, (long)pid);
+	if(size == 0 || (fp = fopen(path, "r")) == NULL)
+		return -error_set_code(1, "%s: %s", path, strerror(errno));
+	if(fgets(buf, size, fp) == NULL)
+		buf[0] = '\0';
+	fclose(fp);
+	if((len = strlen(buf)) > 0 && buf[len - 1] == '\n')
+		buf[len - 1] = '\0';
+	return 0;
+}
+
+
+/* proc_get_state */
+int proc_get_state(GPid pid, char * state, unsigned long * cpu)
+{
+	char path[32];
+	char buf[512];
+	FILE * fp;
+	char const * p;
+	unsigned long utime;
+	unsigned long stime;
+	long hz;
+
+	snprintf(path, sizeof(path), "%s/%ld/stat", PROC_PATH, (long)pid);
+	if((fp = fopen(path, "r")) == NULL)
+		return -error_set_code(1, "%s: %s", path, strerror(errno));
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	/* the name of the process may contain anything */
+	if(p == NULL || (p = strrchr(buf, ')')) == NULL
+			|| sscanf(p + 1, " %c %*d %*d %*d %*d %*d %*u %*u %*u"
+				" %*u %*u %lu %lu", state, &utime, &stime)
+			!= 3)
+		return -error_set_code(1, "%s: %s", path, strerror(EINVAL));
+	if((hz = sysconf(_SC_CLK_TCK)) <= 0)
+		hz = 100;
+	*cpu = (utime + stime) * 1000 / hz;
+	return 0;
+}
+
+
+/* proc_get_subreaper */
+int proc_get_subreaper(void)
+{
+#if defined(__linux__) && defined(PR_GET_CHILD_SUBREAPER)
+	int subreaper = 0;
+
+	if(prctl(PR_GET_CHILD_SUBREAPER, &subreaper, 0, 0, 0) != 0)
+		return 0;
+	return (subreaper != 0) ? 1 : 0;
+#else
+	return 0;
+#endif
+}
+
+
+/* proc_set_subreaper */
+int proc_set_subreaper(int subreaper)
+{
+#if defined(__linux__) && defined(PR_SET_CHILD_SUBREAPER)
+	if(prctl(PR_SET_CHILD_SUBREAPER, subreaper ? 1 : 0, 0, 0, 0) != 0)
+		return -error_set_code(1, "%s: %s", "prctl", strerror(errno));
+	return 0;
+#else
+	(void) subreaper;
+
+	return -error_set_code(1, "%s", strerror(ENOSYS));
+#endif
+}
+
+
+/* private */
+/* functions */
+/* proc_get_entries */
+static int _proc_get_entries(ProcEntry ** entries, size_t * entries_cnt)
+{
+	DIR * dir;
+	struct dirent * de;
+	ProcEntry * e = NULL;
+	ProcEntry * p;
+	size_t cnt = 0;
+	size_t size = 0;
+
+	if((dir = opendir(PROC_PATH)) == NULL)
+		return -error_set_code(1, "%s: %s", PROC_PATH,
+				strerror(errno));
+	while((de = readdir(dir)) != NULL)
+	{
+		if(de->d_name[0] < '1' || de->d_name[0] > '9')
+			continue;
+		if(cnt == size)
+		{
+			if((p = realloc(e, sizeof(*e) * (size + 256))) == NULL)
+			{
+				closedir(dir);
+				free(e);
+				return -error_set_code(1, "%s",
+						strerror(errno));
+			}
+			e = p;
+			size += 256;
+		}
+		/* the process may have exited in the meantime */
+		if(_proc_get_entry(de->d_name, &e[cnt]) == 0)
+			cnt++;
+	}
+	closedir(dir);
+	*entries = e;
+	*entries_cnt = cnt;
+	return 0;
+}
+
+
+/* proc_get_entry */
+static int _proc_get_entry(char const * pid, ProcEntry * entry)
+{
+	char path[32];
+	char buf[512];
+	FILE * fp;
+	size_t len;
+	char const * p;
+	char state;
+	long ppid;
+	long pgid;
+	long sid;
+
+	snprintf(path, sizeof(path), "%s/%s/stat", PROC_PATH, pid);
+	if((fp = fopen(path, "r")) == NULL)
+		return -1;
+	len = fread(buf, sizeof(*buf), sizeof(buf) - 1, fp);
+	fclose(fp);
+	buf[len] = '\0';
+	/* the name of the process may contain anything */
+	if((p = strrchr(buf, ')')) == NULL
+			|| sscanf(p + 1, " %c %ld %ld %ld", &state, &ppid, &pgid,
+				&sid) != 4)
+		return -1;
+	entry->pid = strtol(pid, NULL, 10);
+	entry->ppid = ppid;
+	entry->pgid = pgid;
+	entry->sid = sid;
+	return 0;
+}
+
+
+/* proc_compare */
+static int _proc_compare(void const * a, void const * b)
+{
+	ProcEntry const * pa = a;
+	ProcEntry const * pb = b;
+
+	return (pa->pid < pb->pid) ? -1 : ((pa->pid > pb->pid) ? 1 : 0);
+}
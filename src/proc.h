@@ -0,0 +1,58 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_PROC_H
+# define TERMINAL_PROC_H
+
+
+/* proc */
+/* public */
+/* types */
+typedef struct _ProcEntry
+{
+	GPid pid;
+	GPid ppid;
+	GPid pgid;
+	GPid sid;
+} ProcEntry;
+
+
+/* functions */
+/* accessors */
+int proc_get_cwd(GPid pid, char * buf, size_t size);
+int proc_get_descendants(GPid const * pids, size_t pids_cnt,
+		ProcEntry ** descendants, size_t * descendants_cnt);
+/* the process group in the foreground of its controlling terminal */
+int proc_get_foreground(GPid pid, GPid * foreground);
+int proc_get_name(GPid pid, char * buf, size_t size);
+/* the cpu time is in milliseconds */
+int proc_get_state(GPid pid, char * state, unsigned long * cpu);
+
+int proc_get_subreaper(void);
+int proc_set_subreaper(int subreaper);
+
+#endif /* !TERMINAL_PROC_H */
@@ -0,0 +1,224 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _XOPEN_SOURCE
+# define _XOPEN_SOURCE	600
+#endif
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "spawner.h"
+#include "pty.h"
+
+/* constants */
+#ifndef PROGNAME_TERMINAL
+# define PROGNAME_TERMINAL	"terminal"
+#endif
+
+
+/* pty */
+/* private */
+/* prototypes */
+static void _pty_on_child_setup(gpointer data);
+
+
+/* public */
+/* functions */
+/* pty_new */
+int pty_new(void)
+{
+	int fd;
+
+	if((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+		return -error_set_code(1, "%s: %s", "posix_openpt",
+				strerror(errno));
+	if(grantpt(fd) != 0 || unlockpt(fd) != 0
+			|| fcntl(fd, F_SETFD, FD_CLOEXEC) != 0
+			|| fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK)
+			!= 0)
+	{
+		error_set_code(1, "%s: %s", "pty", strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+/* accessors */
+/* pty_get_name */
+char * pty_get_name(int fd)
+{
+	char const * name;
+	char * ret;
+
+	if((name = ptsname(fd)) == NULL)
+	{
+		error_set_code(1, "%s: %s", "ptsname", strerror(errno));
+		return NULL;
+	}
+	/* ptsname() may use static storage */
+	if((ret = strdup(name)) == NULL)
+		error_set_code(1, "%s", strerror(errno));
+	return ret;
+}
+
+
+/* pty_get_size */
+int pty_get_size(int fd, unsigned int * columns, unsigned int * rows,
+		unsigned int * width, unsigned int * height)
+{
+	struct winsize ws;
+
+	if(ioctl(fd, TIOCGWINSZ, &ws) != 0)
+		return -error_set_code(1, "%s: %s", "TIOCGWINSZ",
+				strerror(errno));
+	*columns = ws.ws_col;
+	*rows = ws.ws_row;
+	*width = ws.ws_xpixel;
+	*height = ws.ws_ypixel;
+	return 0;
+}
+
+
+/* pty_set_size */
+int pty_set_size(int fd, unsigned int columns, unsigned int rows,
+		unsigned int width, unsigned int height)
+{
+	struct winsize ws;
+
+	memset(&ws, 0, sizeof(ws));
+	ws.ws_col = columns;
+	ws.ws_row = rows;
+	ws.ws_xpixel = width;
+	ws.ws_ypixel = height;
+	if(ioctl(fd, TIOCSWINSZ, &ws) != 0)
+		return -error_set_code(1, "%s: %s", "TIOCSWINSZ",
+				strerror(errno));
+	return 0;
+}
+
+
+/* useful */
+/* pty_open_slave */
+int pty_open_slave(int fd)
+{
+	char * name;
+	int ret;
+	struct termios t;
+
+	if((name = pty_get_name(fd)) == NULL)
+		return -1;
+	ret = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	free(name);
+	if(ret < 0)
+		return -error_set_code(1, "%s: %s", "pty", strerror(errno));
+	/* the data goes through unmodified */
+	if(fcntl(ret, F_SETFD, FD_CLOEXEC) != 0 || tcgetattr(ret, &t) != 0)
+	{
+		error_set_code(1, "%s: %s", "pty", strerror(errno));
+		close(ret);
+		return -1;
+	}
+	t.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR
+			| ICRNL | IXON);
+	t.c_oflag &= ~OPOST;
+	t.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	t.c_cflag &= ~(CSIZE | PARENB);
+	t.c_cflag |= CS8;
+	t.c_cc[VMIN] = 1;
+	t.c_cc[VTIME] = 0;
+	if(tcsetattr(ret, TCSANOW, &t) != 0)
+	{
+		error_set_code(1, "%s: %s", "pty", strerror(errno));
+		close(ret);
+		return -1;
+	}
+	return ret;
+}
+
+
+/* pty_spawn */
+int pty_spawn(int fd, char const * directory, char ** argv, GPid * pid)
+{
+	int ret = 0;
+	int res;
+	char * slave;
+	gchar ** envp;
+	GSpawnFlags flags = G_SPAWN_FILE_AND_ARGV_ZERO | G_SPAWN_SEARCH_PATH
+		| G_SPAWN_DO_NOT_REAP_CHILD;
+	GError * error = NULL;
+
+	if((slave = pty_get_name(fd)) == NULL)
+		return -1;
+	envp = g_get_environ();
+	envp = g_environ_setenv(envp, "TERM", "xterm", TRUE);
+	envp = g_environ_unsetenv(envp, "WINDOWID");
+	/* avoid forking the whole process if possible */
+	if((res = spawner_spawn(argv[0], &argv[1], envp, directory, slave, -1,
+					SPAWNER_FLAG_SEARCH_PATH
+					| SPAWNER_FLAG_SETSID, pid)) < 0)
+		ret = -error_set_code(1, "%s: %s", argv[0], strerror(errno));
+	else if(res > 0 && g_spawn_async(directory, argv, envp, flags,
+				_pty_on_child_setup, slave, pid, &error)
+			== FALSE)
+	{
+		ret = -error_set_code(1, "%s: %s", argv[0], error->message);
+		g_error_free(error);
+	}
+	g_strfreev(envp);
+	free(slave);
+	return ret;
+}
+
+
+/* private */
+/* callbacks */
+/* pty_on_child_setup */
+static void _pty_on_child_setup(gpointer data)
+{
+	char const * slave = data;
+	int fd;
+
+	/* from here on, only async-signal-safe functions may be used */
+	setsid();
+	if((fd = open(slave, O_RDWR)) < 0)
+		_exit(127);
+#ifdef TIOCSCTTY
+	ioctl(fd, TIOCSCTTY, 0);
+#endif
+	if(dup2(fd, 0) < 0 || dup2(fd, 1) < 0 || dup2(fd, 2) < 0)
+		_exit(127);
+	if(fd > 2)
+		close(fd);
+}
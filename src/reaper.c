@@ -0,0 +1,988 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+# include <sys/epoll.h>
+# include <sys/syscall.h>
+#endif
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "proc.h"
+#include "spawner.h"
+#include "store.h"
+#include "reaper.h"
+
+/* constants */
+#define TERMINALREAPER_EVENTS	64
+#define TERMINALREAPER_ORPHANS_INTERVAL	1000
+
+#if defined(SYS_pidfd_open) && defined(SYS_pidfd_send_signal)
+# define TERMINALREAPER_PIDFD
+#endif
+
+
+/* TerminalReaper */
+/* private */
+/* types */
+typedef enum _TerminalReaperIndex
+{
+	TRI_PID = 0
+} TerminalReaperIndex;
+#define TRI_LAST TRI_PID
+#define TRI_COUNT (TRI_LAST + 1)
+
+typedef enum _TerminalReaperFlag
+{
+	/* reported to the callback, and signalled with its process group */
+	TRF_REPORT = 0x1,
+	/* has to be reaped */
+	TRF_CHILD = 0x2,
+	/* reaped and signalled by the spawner */
+	TRF_REMOTE = 0x4
+} TerminalReaperFlag;
+
+typedef struct _TerminalReaperChild
+{
+	GPid pid;
+	TerminalStoreHandle handle;
+	unsigned int flags;
+	/* either a pidfd or a child watch */
+	int fd;
+	guint source;
+} TerminalReaperChild;
+
+typedef struct _TerminalReaperSource
+{
+	GSource source;
+	TerminalReaper * reaper;
+} TerminalReaperSource;
+
+typedef struct _TerminalReaperExit
+{
+	GPid pid;
+	int status;
+} TerminalReaperExit;
+
+struct _TerminalReaper
+{
+	TerminalReaperCallback callback;
+	void * data;
+	TerminalStore * children;
+
+	/* every pidfd is watched by a single source */
+	int epoll;
+	GSource * source;
+
+	/* shutdown */
+	TerminalReaperShutdownCallback shutdown;
+	void * shutdown_data;
+	gint64 shutdown_time;
+	guint shutdown_source;
+	int shutdown_tree;
+	size_t shutdown_terminated;
+
+	TerminalReaper * next;
+};
+
+
+/* prototypes */
+static int _terminalreaper_add(TerminalReaper * reaper, GPid pid,
+		unsigned int flags);
+static void _terminalreaper_adopt(TerminalReaper * reaper, int sig);
+static void _terminalreaper_child_delete(TerminalReaper * reaper,
+		TerminalReaperChild * child);
+static int _terminalreaper_child_watch(TerminalReaper * reaper,
+		TerminalReaperChild * child);
+static int _terminalreaper_is_tracked(GPid pid);
+static void _terminalreaper_orphan(GPid pid);
+static int _terminalreaper_pidfd_init(TerminalReaper * reaper);
+static int _terminalreaper_pidfd_open(GPid pid);
+static void _terminalreaper_shutdown_check(TerminalReaper * reaper);
+static void _terminalreaper_shutdown_done(TerminalReaper * reaper,
+		TerminalReaperProcess const * killed, size_t killed_cnt);
+static int _terminalreaper_signal(TerminalReaperChild * child, int sig);
+static void _terminalreaper_spawner_dispatch(void);
+static void _terminalreaper_spawner_watch(void);
+
+/* callbacks */
+static void _terminalreaper_on_child_watch(GPid pid, gint status,
+		gpointer data);
+static void _terminalreaper_on_orphan(GPid pid, gint status, gpointer data);
+static gboolean _terminalreaper_on_orphans(gpointer data);
+static gboolean _terminalreaper_on_pidfd(GSource * source,
+		GSourceFunc callback, gpointer data);
+static gboolean _terminalreaper_on_shutdown_done(gpointer data);
+static gboolean _terminalreaper_on_shutdown_timeout(gpointer data);
+static gboolean _terminalreaper_on_spawner(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static void _terminalreaper_on_spawner_exit(void * data, GPid pid,
+		int status);
+static gboolean _terminalreaper_on_spawner_idle(gpointer data);
+
+
+/* variables */
+static GSourceFuncs _terminalreaper_funcs =
+{
+	NULL, NULL, _terminalreaper_on_pidfd, NULL, NULL, NULL
+};
+
+/* the processes of every reaper are known to each other */
+static TerminalReaper * _terminalreaper_reapers = NULL;
+
+/* the processes of the spawner are reported through its connection */
+static GIOChannel * _terminalreaper_spawner_channel = NULL;
+static guint _terminalreaper_spawner_source = 0;
+static guint _terminalreaper_spawner_idle = 0;
+
+/* the processes reaped by a child watch alone */
+static GPid * _terminalreaper_orphans = NULL;
+static size_t _terminalreaper_orphans_cnt = 0;
+
+/* the processes reparented while we are a subreaper */
+static guint _terminalreaper_orphans_source = 0;
+
+
+/* public */
+/* functions */
+/* terminalreaper_new */
+TerminalReaper * terminalreaper_new(TerminalReaperCallback callback,
+		void * data)
+{
+	TerminalReaper * reaper;
+
+	if((reaper = object_new(sizeof(*reaper))) == NULL)
+		return NULL;
+	reaper->callback = callback;
+	reaper->data = data;
+	reaper->children = terminalstore_new(sizeof(TerminalReaperChild),
+			TRI_COUNT);
+	reaper->epoll = -1;
+	reaper->source = NULL;
+	reaper->shutdown = NULL;
+	reaper->shutdown_data = NULL;
+	reaper->shutdown_time = 0;
+	reaper->shutdown_source = 0;
+	reaper->shutdown_tree = 0;
+	reaper->shutdown_terminated = 0;
+	reaper->next = _terminalreaper_reapers;
+	_terminalreaper_reapers = reaper;
+	if(reaper->children == NULL)
+	{
+		terminalreaper_delete(reaper);
+		return NULL;
+	}
+	/* fallback to a child watch per process if necessary */
+	_terminalreaper_pidfd_init(reaper);
+	return reaper;
+}
+
+
+/* terminalreaper_delete */
+void terminalreaper_delete(TerminalReaper * reaper)
+{
+	TerminalReaper ** r;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalReaperChild * child;
+
+	for(r = &_terminalreaper_reapers; *r != NULL; r = &(*r)->next)
+		if(*r == reaper)
+		{
+			*r = reaper->next;
+			break;
+		}
+	if(reaper->shutdown_source > 0)
+		g_source_remove(reaper->shutdown_source);
+	/* the remaining processes still have to be reaped eventually */
+	while(reaper->children != NULL && (child = terminalstore_get_next(
+					reaper->children, &handle)) != NULL)
+	{
+		if(child->source > 0)
+			g_source_remove(child->source);
+		if(child->fd >= 0)
+			close(child->fd);
+		if(child->flags & TRF_CHILD)
+			_terminalreaper_orphan(child->pid);
+	}
+	if(reaper->source != NULL)
+	{
+		g_source_destroy(reaper->source);
+		g_source_unref(reaper->source);
+	}
+	if(reaper->epoll >= 0)
+		close(reaper->epoll);
+	if(reaper->children != NULL)
+		terminalstore_delete(reaper->children);
+	object_delete(reaper);
+	if(_terminalreaper_reapers != NULL)
+		return;
+	if(_terminalreaper_orphans_source > 0)
+		g_source_remove(_terminalreaper_orphans_source);
+	_terminalreaper_orphans_source = 0;
+	if(_terminalreaper_spawner_idle > 0)
+		g_source_remove(_terminalreaper_spawner_idle);
+	_terminalreaper_spawner_idle = 0;
+	if(_terminalreaper_spawner_source > 0)
+		g_source_remove(_terminalreaper_spawner_source);
+	_terminalreaper_spawner_source = 0;
+	if(_terminalreaper_spawner_channel != NULL)
+		g_io_channel_unref(_terminalreaper_spawner_channel);
+	_terminalreaper_spawner_channel = NULL;
+}
+
+
+/* accessors */
+/* terminalreaper_get_count */
+size_t terminalreaper_get_count(TerminalReaper * reaper)
+{
+	return terminalstore_get_count(reaper->children);
+}
+
+
+/* terminalreaper_set_subreaper */
+int terminalreaper_set_subreaper(int subreaper)
+{
+	if(proc_set_subreaper(subreaper) != 0)
+		return -1;
+	if(subreaper && _terminalreaper_orphans_source == 0)
+		_terminalreaper_orphans_source = g_timeout_add(
+				TERMINALREAPER_ORPHANS_INTERVAL,
+				_terminalreaper_on_orphans, NULL);
+	else if(!subreaper && _terminalreaper_orphans_source > 0)
+	{
+		g_source_remove(_terminalreaper_orphans_source);
+		_terminalreaper_orphans_source = 0;
+	}
+	return 0;
+}
+
+
+/* useful */
+/* terminalreaper_abandon */
+void terminalreaper_abandon(GPid pid, int sig)
+{
+	/* the processes of the spawner are reaped by the spawner */
+	if(spawner_has_child(pid))
+	{
+		spawner_kill(pid, sig, 0);
+		return;
+	}
+	kill(pid, sig);
+	_terminalreaper_orphan(pid);
+}
+
+
+/* terminalreaper_add */
+int terminalreaper_add(TerminalReaper * reaper, GPid pid)
+{
+	if(pid <= 0)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	return _terminalreaper_add(reaper, pid, TRF_REPORT | TRF_CHILD);
+}
+
+
+/* terminalreaper_kill */
+int terminalreaper_kill(TerminalReaper * reaper, GPid pid, int sig)
+{
+	TerminalReaperChild * child;
+
+	/* never signal a process which may have been reaped already */
+	if((child = terminalstore_lookup(reaper->children, TRI_PID, pid,
+					NULL)) == NULL)
+		return -error_set_code(1, "%s", strerror(ESRCH));
+	return _terminalreaper_signal(child, sig);
+}
+
+
+/* terminalreaper_kill_all */
+int terminalreaper_kill_all(TerminalReaper * reaper, int sig)
+{
+	int ret = 0;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalReaperChild * child;
+
+	while((child = terminalstore_get_next(reaper->children, &handle))
+			!= NULL)
+		if(_terminalreaper_signal(child, sig) != 0)
+			ret = -1;
+	return ret;
+}
+
+
+/* terminalreaper_shutdown */
+int terminalreaper_shutdown(TerminalReaper * reaper, unsigned int timeout,
+		int tree, TerminalReaperShutdownCallback callback,
+		void * data)
+{
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalReaperChild * child;
+
+	if(reaper->shutdown != NULL)
+		return -error_set_code(1, "%s", strerror(EALREADY));
+	reaper->shutdown = callback;
+	reaper->shutdown_data = data;
+	reaper->shutdown_time = g_get_monotonic_time();
+	reaper->shutdown_tree = tree;
+	reaper->shutdown_terminated = 0;
+	/* every process is signalled at once */
+	if(tree)
+		_terminalreaper_adopt(reaper, SIGTERM);
+	while((child = terminalstore_get_next(reaper->children, &handle))
+			!= NULL)
+		if(_terminalreaper_signal(child, SIGTERM) == 0)
+			reaper->shutdown_terminated++;
+	/* the exits are then waited for asynchronously */
+	if(terminalstore_get_count(reaper->children) == 0)
+		reaper->shutdown_source = g_idle_add(
+				_terminalreaper_on_shutdown_done, reaper);
+	else
+		reaper->shutdown_source = g_timeout_add(timeout,
+				_terminalreaper_on_shutdown_timeout, reaper);
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* terminalreaper_add */
+static int _terminalreaper_add(TerminalReaper * reaper, GPid pid,
+		unsigned int flags)
+{
+	TerminalReaperChild * child;
+	TerminalStoreHandle handle;
+
+	if((child = terminalstore_alloc(reaper->children, &handle)) == NULL)
+		return -error_set_code(1, "%s", strerror(ENOMEM));
+	/* the processes of the spawner are not ours to reap */
+	if(spawner_has_child(pid))
+		flags = (flags & ~TRF_CHILD) | TRF_REMOTE;
+	child->pid = pid;
+	child->handle = handle;
+	child->flags = flags;
+	child->fd = -1;
+	child->source = 0;
+	if(terminalstore_set_key(reaper->children, handle, TRI_PID, pid) != 0)
+	{
+		terminalstore_free(reaper->children, handle);
+		return -error_set_code(1, "%s", strerror(EEXIST));
+	}
+	if(flags & TRF_REMOTE)
+	{
+		_terminalreaper_spawner_watch();
+		return 0;
+	}
+	if(_terminalreaper_child_watch(reaper, child) == 0)
+		return 0;
+	terminalstore_free(reaper->children, handle);
+	return -error_set_code(1, "%s", strerror(ENOTSUP));
+}
+
+
+/* terminalreaper_adopt */
+static GPid * _adopt_roots(TerminalReaper * reaper, size_t * roots_cnt);
+static GPid * _adopt_sessions(GPid const * roots, size_t roots_cnt,
+		size_t * sessions_cnt);
+
+static void _terminalreaper_adopt(TerminalReaper * reaper, int sig)
+{
+	GPid self = getpid();
+	GPid * roots;
+	size_t roots_cnt;
+	GPid * sessions = NULL;
+	size_t sessions_cnt = 0;
+	ProcEntry * entries;
+	size_t entries_cnt;
+	size_t i;
+	size_t j;
+
+	if((roots = _adopt_roots(reaper, &roots_cnt)) == NULL)
+		return;
+	/* processes orphaned while we are a subreaper are ours as well, if
+	 * they come from the same sessions */
+	if(proc_get_subreaper() && (sessions = _adopt_sessions(roots,
+					roots_cnt, &sessions_cnt)) != NULL
+			&& proc_get_descendants(&self, 1, &entries,
+				&entries_cnt) == 0)
+	{
+		for(i = 0; i < entries_cnt; i++)
+		{
+			if(entries[i].ppid != self
+					|| entries[i].pid == spawner_get_pid()
+					|| _terminalreaper_is_tracked(
+						entries[i].pid))
+				continue;
+			for(j = 0; j < sessions_cnt; j++)
+				if(entries[i].sid == sessions[j]
+						|| entries[i].pgid
+						== sessions[j])
+					break;
+			if(j < sessions_cnt)
+				_terminalreaper_add(reaper, entries[i].pid,
+						TRF_CHILD);
+		}
+		free(entries);
+		free(roots);
+		if((roots = _adopt_roots(reaper, &roots_cnt)) == NULL)
+		{
+			free(sessions);
+			return;
+		}
+	}
+	free(sessions);
+	/* the processes which cannot be watched are only signalled */
+	if(proc_get_descendants(roots, roots_cnt, &entries, &entries_cnt)
+			== 0)
+	{
+		for(i = 0; i < entries_cnt; i++)
+			if(!_terminalreaper_is_tracked(entries[i].pid)
+					&& _terminalreaper_add(reaper,
+						entries[i].pid,
+						(entries[i].ppid == self)
+						? TRF_CHILD : 0) != 0
+					&& kill(entries[i].pid, sig) == 0)
+				reaper->shutdown_terminated++;
+		free(entries);
+	}
+	free(roots);
+}
+
+static GPid * _adopt_roots(TerminalReaper * reaper, size_t * roots_cnt)
+{
+	GPid * roots;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalReaperChild * child;
+
+	if((roots = malloc(sizeof(*roots) * (terminalstore_get_count(
+							reaper->children)
+						+ 1))) == NULL)
+		return NULL;
+	*roots_cnt = 0;
+	while((child = terminalstore_get_next(reaper->children, &handle))
+			!= NULL)
+		roots[(*roots_cnt)++] = child->pid;
+	return roots;
+}
+
+static GPid * _adopt_sessions(GPid const * roots, size_t roots_cnt,
+		size_t * sessions_cnt)
+{
+	GPid * sessions;
+	GPid own = getsid(0);
+	ProcEntry * entries;
+	size_t entries_cnt;
+	size_t i;
+
+	if(proc_get_descendants(roots, roots_cnt, &entries, &entries_cnt)
+			!= 0)
+		return NULL;
+	if((sessions = malloc(sizeof(*sessions) * (roots_cnt + entries_cnt
+						+ 1))) == NULL)
+	{
+		free(entries);
+		return NULL;
+	}
+	/* the processes are leaders of their own process group */
+	memcpy(sessions, roots, sizeof(*roots) * roots_cnt);
+	*sessions_cnt = roots_cnt;
+	/* like the shells, unless in the session of Terminal itself */
+	for(i = 0; i < entries_cnt; i++)
+		if(entries[i].sid > 0 && entries[i].sid != own)
+			sessions[(*sessions_cnt)++] = entries[i].sid;
+	free(entries);
+	return sessions;
+}
+
+
+/* terminalreaper_child_delete */
+static void _terminalreaper_child_delete(TerminalReaper * reaper,
+		TerminalReaperChild * child)
+{
+	/* closing the pidfd also removes it from epoll */
+	if(child->fd >= 0)
+		close(child->fd);
+	terminalstore_free(reaper->children, child->handle);
+}
+
+
+/* terminalreaper_child_watch */
+static int _terminalreaper_child_watch(TerminalReaper * reaper,
+		TerminalReaperChild * child)
+{
+#ifdef TERMINALREAPER_PIDFD
+	struct epoll_event event;
+
+	if(reaper->epoll >= 0 && (child->fd = _terminalreaper_pidfd_open(
+					child->pid)) >= 0)
+	{
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.u32 = child->handle;
+		if(epoll_ctl(reaper->epoll, EPOLL_CTL_ADD, child->fd, &event)
+				== 0)
+			return 0;
+		close(child->fd);
+		child->fd = -1;
+	}
+#endif
+	/* only the children of the current process can be watched */
+	if(child->flags & TRF_CHILD)
+	{
+		child->source = g_child_watch_add(child->pid,
+				_terminalreaper_on_child_watch, reaper);
+		return 0;
+	}
+	return -1;
+}
+
+
+/* terminalreaper_is_tracked */
+static int _terminalreaper_is_tracked(GPid pid)
+{
+	TerminalReaper * r;
+	size_t i;
+
+	for(r = _terminalreaper_reapers; r != NULL; r = r->next)
+		if(terminalstore_lookup(r->children, TRI_PID, pid, NULL)
+				!= NULL)
+			return 1;
+	for(i = 0; i < _terminalreaper_orphans_cnt; i++)
+		if(_terminalreaper_orphans[i] == pid)
+			return 1;
+	return 0;
+}
+
+
+/* terminalreaper_orphan */
+static void _terminalreaper_orphan(GPid pid)
+{
+	GPid * p;
+
+	/* known to be reaped already, if possible */
+	if((p = realloc(_terminalreaper_orphans, sizeof(*p)
+					* (_terminalreaper_orphans_cnt + 1)))
+			!= NULL)
+	{
+		_terminalreaper_orphans = p;
+		_terminalreaper_orphans[_terminalreaper_orphans_cnt++] = pid;
+	}
+	g_child_watch_add(pid, _terminalreaper_on_orphan, NULL);
+}
+
+
+/* terminalreaper_pidfd_init */
+static int _terminalreaper_pidfd_init(TerminalReaper * reaper)
+{
+#ifdef TERMINALREAPER_PIDFD
+	int fd;
+
+	/* check if pidfd is supported by the kernel */
+	if((fd = _terminalreaper_pidfd_open(getpid())) < 0)
+		return -1;
+	close(fd);
+	if((reaper->epoll = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		return -1;
+	reaper->source = g_source_new(&_terminalreaper_funcs,
+			sizeof(TerminalReaperSource));
+	((TerminalReaperSource *)reaper->source)->reaper = reaper;
+	g_source_add_unix_fd(reaper->source, reaper->epoll, G_IO_IN);
+	g_source_attach(reaper->source, NULL);
+	return 0;
+#else
+	(void) reaper;
+
+	return -1;
+#endif
+}
+
+
+/* terminalreaper_pidfd_open */
+static int _terminalreaper_pidfd_open(GPid pid)
+{
+#ifdef TERMINALREAPER_PIDFD
+	int fd;
+
+	if((fd = syscall(SYS_pidfd_open, pid, 0)) < 0)
+		return -1;
+	/* pidfds are close-on-exec already */
+	return fd;
+#else
+	(void) pid;
+
+	return -1;
+#endif
+}
+
+
+/* terminalreaper_shutdown_check */
+static void _terminalreaper_shutdown_check(TerminalReaper * reaper)
+{
+	if(reaper->shutdown == NULL
+			|| terminalstore_get_count(reaper->children) > 0)
+		return;
+	g_source_remove(reaper->shutdown_source);
+	reaper->shutdown_source = 0;
+	_terminalreaper_shutdown_done(reaper, NULL, 0);
+}
+
+
+/* terminalreaper_shutdown_done */
+static void _terminalreaper_shutdown_done(TerminalReaper * reaper,
+		TerminalReaperProcess const * killed, size_t killed_cnt)
+{
+	TerminalReaperShutdownCallback callback = reaper->shutdown;
+	TerminalReaperReport report;
+
+	report.duration = (g_get_monotonic_time() - reaper->shutdown_time)
+		/ 1000;
+	report.terminated = reaper->shutdown_terminated;
+	report.killed = killed;
+	report.killed_cnt = killed_cnt;
+	reaper->shutdown = NULL;
+	callback(reaper->shutdown_data, &report);
+}
+
+
+/* terminalreaper_signal */
+static int _terminalreaper_signal(TerminalReaperChild * child, int sig)
+{
+	if(child->flags & TRF_REMOTE)
+	{
+		if(spawner_kill(child->pid, sig, child->flags & TRF_REPORT)
+				!= 0 && errno != ESRCH)
+			return -error_set_code(1, "%s", strerror(errno));
+		return 0;
+	}
+	/* the process group cannot be reused while its leader is known */
+	if(child->flags & TRF_REPORT)
+		kill(-child->pid, sig);
+#ifdef TERMINALREAPER_PIDFD
+	if(child->fd >= 0)
+	{
+		if(syscall(SYS_pidfd_send_signal, child->fd, sig, NULL, 0)
+				!= 0 && errno != ESRCH)
+			return -error_set_code(1, "%s", strerror(errno));
+		return 0;
+	}
+#endif
+	if(kill(child->pid, sig) != 0 && errno != ESRCH)
+		return -error_set_code(1, "%s", strerror(errno));
+	return 0;
+}
+
+
+/* terminalreaper_spawner_dispatch */
+static void _terminalreaper_spawner_dispatch(void)
+{
+	TerminalReaper * reaper;
+	TerminalStoreHandle handle;
+	TerminalReaperChild * child;
+	GPid * lost;
+	size_t lost_cnt = 0;
+	size_t i;
+
+	if(spawner_dispatch() == 0)
+		return;
+	/* the helper process is gone, along with the exit statuses */
+	if(_terminalreaper_spawner_source > 0)
+		g_source_remove(_terminalreaper_spawner_source);
+	_terminalreaper_spawner_source = 0;
+	g_io_channel_unref(_terminalreaper_spawner_channel);
+	_terminalreaper_spawner_channel = NULL;
+	spawner_stop();
+	for(reaper = _terminalreaper_reapers, i = 0; reaper != NULL;
+			reaper = reaper->next)
+		i += terminalstore_get_count(reaper->children);
+	lost = malloc(sizeof(*lost) * (i + 1));
+	for(reaper = _terminalreaper_reapers; reaper != NULL;
+			reaper = reaper->next)
+		for(handle = TERMINALSTORE_HANDLE_NONE; (child
+					= terminalstore_get_next(
+						reaper->children, &handle))
+				!= NULL;)
+		{
+			if(!(child->flags & TRF_REMOTE))
+				continue;
+			/* the processes left can still be watched directly */
+			child->flags &= ~TRF_REMOTE;
+			if(_terminalreaper_child_watch(reaper, child) != 0
+					&& lost != NULL)
+				lost[lost_cnt++] = child->pid;
+		}
+	/* the others are considered gone */
+	for(i = 0; i < lost_cnt; i++)
+		_terminalreaper_on_spawner_exit(NULL, lost[i], 0);
+	free(lost);
+}
+
+
+/* terminalreaper_spawner_watch */
+static void _terminalreaper_spawner_watch(void)
+{
+	if(_terminalreaper_spawner_source == 0)
+	{
+		spawner_set_callback(_terminalreaper_on_spawner_exit, NULL);
+		_terminalreaper_spawner_channel = g_io_channel_unix_new(
+				spawner_get_fd());
+		_terminalreaper_spawner_source = g_io_add_watch(
+				_terminalreaper_spawner_channel,
+				G_IO_IN | G_IO_ERR | G_IO_HUP,
+				_terminalreaper_on_spawner, NULL);
+	}
+	/* the exits read while spawning are not signalled by the connection */
+	if(spawner_get_pending() > 0 && _terminalreaper_spawner_idle == 0)
+		_terminalreaper_spawner_idle = g_idle_add(
+				_terminalreaper_on_spawner_idle, NULL);
+}
+
+
+/* callbacks */
+/* terminalreaper_on_child_watch */
+static void _terminalreaper_on_child_watch(GPid pid, gint status,
+		gpointer data)
+{
+	TerminalReaper * reaper = data;
+	TerminalReaperChild * child;
+	unsigned int flags = 0;
+
+	if((child = terminalstore_lookup(reaper->children, TRI_PID, pid,
+					NULL)) != NULL)
+	{
+		flags = child->flags;
+		_terminalreaper_child_delete(reaper, child);
+	}
+	g_spawn_close_pid(pid);
+	if(flags & TRF_REPORT)
+		reaper->callback(reaper->data, pid, status);
+	_terminalreaper_shutdown_check(reaper);
+}
+
+
+/* terminalreaper_on_orphan */
+static void _terminalreaper_on_orphan(GPid pid, gint status, gpointer data)
+{
+	size_t i;
+	(void) status;
+	(void) data;
+
+	for(i = 0; i < _terminalreaper_orphans_cnt; i++)
+		if(_terminalreaper_orphans[i] == pid)
+		{
+			_terminalreaper_orphans[i] = _terminalreaper_orphans[
+				--_terminalreaper_orphans_cnt];
+			break;
+		}
+	if(_terminalreaper_orphans_cnt == 0)
+	{
+		free(_terminalreaper_orphans);
+		_terminalreaper_orphans = NULL;
+	}
+	g_spawn_close_pid(pid);
+}
+
+
+/* terminalreaper_on_orphans */
+static gboolean _terminalreaper_on_orphans(gpointer data)
+{
+	siginfo_t si;
+	(void) data;
+
+	/* the processes exited are looked at before being reaped */
+	for(;;)
+	{
+		memset(&si, 0, sizeof(si));
+		if(waitid(P_ALL, 0, &si, WEXITED | WNOHANG | WNOWAIT) != 0
+				|| si.si_pid <= 0)
+			break;
+		/* left to its watch, reaping it shortly */
+		if(si.si_pid == spawner_get_pid()
+				|| _terminalreaper_is_tracked(si.si_pid))
+			break;
+		if(waitpid(si.si_pid, NULL, WNOHANG) <= 0)
+			break;
+	}
+	return TRUE;
+}
+
+
+/* terminalreaper_on_pidfd */
+static gboolean _terminalreaper_on_pidfd(GSource * source,
+		GSourceFunc callback, gpointer data)
+{
+#ifdef TERMINALREAPER_PIDFD
+	TerminalReaper * reaper = ((TerminalReaperSource *)source)->reaper;
+	struct epoll_event events[TERMINALREAPER_EVENTS];
+	TerminalReaperExit exits[TERMINALREAPER_EVENTS];
+	TerminalReaperChild * child;
+	int cnt;
+	int i;
+	size_t exits_cnt;
+	int status;
+	int res;
+	(void) callback;
+	(void) data;
+
+	do
+	{
+		/* collect every process exited so far at once */
+		if((cnt = epoll_wait(reaper->epoll, events,
+						TERMINALREAPER_EVENTS, 0)) < 0)
+			break;
+		for(i = 0, exits_cnt = 0; i < cnt; i++)
+		{
+			if((child = terminalstore_get(reaper->children,
+							events[i].data.u32))
+					== NULL)
+				continue;
+			/* the other processes are not ours to reap */
+			if((res = waitpid(child->pid, &status, WNOHANG)) == 0
+					|| (res < 0 && (child->flags
+							& TRF_CHILD)))
+				continue;
+			if(res < 0)
+				status = 0;
+			if(child->flags & TRF_REPORT)
+			{
+				exits[exits_cnt].pid = child->pid;
+				exits[exits_cnt++].status = status;
+			}
+			_terminalreaper_child_delete(reaper, child);
+		}
+		/* the callback may add or signal processes */
+		for(i = 0; (size_t)i < exits_cnt; i++)
+			reaper->callback(reaper->data, exits[i].pid,
+					exits[i].status);
+	}
+	while(cnt == TERMINALREAPER_EVENTS);
+	_terminalreaper_shutdown_check(reaper);
+#else
+	(void) source;
+	(void) callback;
+	(void) data;
+#endif
+	return TRUE;
+}
+
+
+/* terminalreaper_on_shutdown_done */
+static gboolean _terminalreaper_on_shutdown_done(gpointer data)
+{
+	TerminalReaper * reaper = data;
+
+	reaper->shutdown_source = 0;
+	_terminalreaper_shutdown_done(reaper, NULL, 0);
+	return FALSE;
+}
+
+
+/* terminalreaper_on_shutdown_timeout */
+static gboolean _terminalreaper_on_shutdown_timeout(gpointer data)
+{
+	TerminalReaper * reaper = data;
+	TerminalReaperProcess * killed;
+	size_t killed_cnt = 0;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalReaperChild * child;
+
+	reaper->shutdown_source = 0;
+	/* the processes spawned since are not spared either */
+	if(reaper->shutdown_tree)
+		_terminalreaper_adopt(reaper, SIGKILL);
+	killed = malloc(sizeof(*killed) * terminalstore_get_count(
+				reaper->children));
+	while((child = terminalstore_get_next(reaper->children, &handle))
+			!= NULL)
+	{
+		if(killed != NULL)
+		{
+			killed[killed_cnt].pid = child->pid;
+			if(proc_get_name(child->pid, killed[killed_cnt].name,
+						sizeof(killed->name)) != 0)
+				killed[killed_cnt].name[0] = '\0';
+		}
+		if(_terminalreaper_signal(child, SIGKILL) == 0
+				&& killed != NULL)
+			killed_cnt++;
+	}
+	/* the processes killed are still reaped as they exit */
+	_terminalreaper_shutdown_done(reaper, killed, killed_cnt);
+	free(killed);
+	return FALSE;
+}
+
+
+/* terminalreaper_on_spawner */
+static gboolean _terminalreaper_on_spawner(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	(void) source;
+	(void) condition;
+	(void) data;
+
+	_terminalreaper_spawner_dispatch();
+	return TRUE;
+}
+
+
+/* terminalreaper_on_spawner_exit */
+static void _terminalreaper_on_spawner_exit(void * data, GPid pid,
+		int status)
+{
+	TerminalReaper * reaper;
+	TerminalReaperChild * child = NULL;
+	unsigned int flags;
+	(void) data;
+
+	for(reaper = _terminalreaper_reapers; reaper != NULL;
+			reaper = reaper->next)
+		if((child = terminalstore_lookup(reaper->children, TRI_PID,
+						pid, NULL)) != NULL)
+			break;
+	if(child == NULL)
+		return;
+	flags = child->flags;
+	_terminalreaper_child_delete(reaper, child);
+	if(flags & TRF_REPORT)
+		reaper->callback(reaper->data, pid, status);
+	_terminalreaper_shutdown_check(reaper);
+}
+
+
+/* terminalreaper_on_spawner_idle */
+static gboolean _terminalreaper_on_spawner_idle(gpointer data)
+{
+	(void) data;
+
+	_terminalreaper_spawner_idle = 0;
+	_terminalreaper_spawner_dispatch();
+	return FALSE;
+}
@@ -0,0 +1,86 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_REAPER_H
+# define TERMINAL_REAPER_H
+
+
+/* TerminalReaper */
+/* public */
+/* types */
+typedef struct _TerminalReaper TerminalReaper;
+
+typedef void (*TerminalReaperCallback)(void * data, GPid pid, int status);
+
+typedef struct _TerminalReaperProcess
+{
+	GPid pid;
+	char name[16];
+} TerminalReaperProcess;
+
+typedef struct _TerminalReaperReport
+{
+	unsigned long duration;			/* in milliseconds */
+	size_t terminated;
+	TerminalReaperProcess const * killed;
+	size_t killed_cnt;
+} TerminalReaperReport;
+
+typedef void (*TerminalReaperShutdownCallback)(void * data,
+		TerminalReaperReport const * report);
+
+
+/* functions */
+/* essential */
+TerminalReaper * terminalreaper_new(TerminalReaperCallback callback,
+		void * data);
+void terminalreaper_delete(TerminalReaper * reaper);
+
+
+/* accessors */
+/* the processes not reaped yet */
+size_t terminalreaper_get_count(TerminalReaper * reaper);
+
+/* also reaps the processes orphaned meanwhile */
+int terminalreaper_set_subreaper(int subreaper);
+
+
+/* useful */
+/* signals a process which could not be added, and still reaps it */
+void terminalreaper_abandon(GPid pid, int sig);
+
+int terminalreaper_add(TerminalReaper * reaper, GPid pid);
+
+/* only signals processes which were not reaped yet */
+int terminalreaper_kill(TerminalReaper * reaper, GPid pid, int sig);
+int terminalreaper_kill_all(TerminalReaper * reaper, int sig);
+
+int terminalreaper_shutdown(TerminalReaper * reaper, unsigned int timeout,
+		int tree, TerminalReaperShutdownCallback callback,
+		void * data);
+
+#endif /* !TERMINAL_REAPER_H */
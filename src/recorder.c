@@ -0,0 +1,550 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/stat.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <zlib.h>
+#include "recorder.h"
+
+/* constants */
+#define TERMINALRECORDER_FRAME_MAX	4096
+/* favor the speed over the size */
+#define TERMINALRECORDER_MODE		"wb1"
+#define TERMINALRECORDER_SIZE_MIN	65536
+
+
+/* Recorder */
+/* private */
+/* types */
+typedef enum _TerminalRecorderEvent
+{
+	TRE_OUTPUT = 0,
+	TRE_RESIZE
+} TerminalRecorderEvent;
+
+typedef struct _TerminalRecorderFrame
+{
+	uint64_t time;				/* in microseconds */
+	uint32_t type;
+	uint32_t len;
+} TerminalRecorderFrame;
+
+struct _TerminalRecorder
+{
+	struct timespec start;
+	gzFile file;
+	int error;
+
+	/* ring buffer, with a single producer and a single consumer */
+	char * ring;
+	size_t size;				/* a power of two */
+	atomic_size_t head;			/* set by the producer */
+	atomic_size_t tail;			/* set by the consumer */
+	atomic_ulong dropped;
+
+	/* writer */
+	pthread_t thread;
+	int pipe[2];
+	atomic_int sleeping;
+	atomic_int stopping;
+	unsigned long dropped_reported;
+
+	/* incomplete UTF-8 sequence at the end of the last frame */
+	unsigned char input[3 + TERMINALRECORDER_FRAME_MAX];
+	size_t input_cnt;
+	char output[64 + 6 * (3 + TERMINALRECORDER_FRAME_MAX)];
+};
+
+
+/* prototypes */
+static void _terminalrecorder_copy_in(TerminalRecorder * recorder,
+		size_t pos, void const * buf, size_t len);
+static void _terminalrecorder_copy_out(TerminalRecorder * recorder,
+		size_t pos, void * buf, size_t len);
+static uint64_t _terminalrecorder_now(TerminalRecorder * recorder);
+static void _terminalrecorder_push(TerminalRecorder * recorder,
+		TerminalRecorderEvent type, void const * buf, size_t len);
+static void _terminalrecorder_wake(TerminalRecorder * recorder);
+
+/* writer */
+static void * _terminalrecorder_thread(void * data);
+static void _terminalrecorder_write(TerminalRecorder * recorder,
+		size_t pos, TerminalRecorderFrame const * frame);
+static void _terminalrecorder_write_marker(TerminalRecorder * recorder,
+		uint64_t time, unsigned long dropped);
+static size_t _terminalrecorder_write_utf8(unsigned char const * buf,
+		size_t len, char * output, size_t * output_len);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalrecorder_new */
+TerminalRecorder * terminalrecorder_new(char const * filename,
+		unsigned int columns, unsigned int rows, size_t size)
+{
+	TerminalRecorder * recorder;
+	int fd;
+	int i;
+	sigset_t set;
+	sigset_t oset;
+	int res;
+
+	if((recorder = malloc(sizeof(*recorder))) == NULL)
+		return NULL;
+	clock_gettime(CLOCK_MONOTONIC, &recorder->start);
+	recorder->file = NULL;
+	recorder->error = 0;
+	for(recorder->size = TERMINALRECORDER_SIZE_MIN; recorder->size < size;
+			recorder->size <<= 1);
+	recorder->ring = malloc(recorder->size);
+	atomic_init(&recorder->head, 0);
+	atomic_init(&recorder->tail, 0);
+	atomic_init(&recorder->dropped, 0);
+	atomic_init(&recorder->sleeping, 0);
+	atomic_init(&recorder->stopping, 0);
+	recorder->dropped_reported = 0;
+	recorder->input_cnt = 0;
+	recorder->pipe[0] = -1;
+	recorder->pipe[1] = -1;
+	/* the recordings are private */
+	if(recorder->ring == NULL || (fd = open(filename, O_WRONLY | O_CREAT
+					| O_EXCL | O_CLOEXEC, 0600)) < 0)
+	{
+		free(recorder->ring);
+		free(recorder);
+		return NULL;
+	}
+	if((recorder->file = gzdopen(fd, TERMINALRECORDER_MODE)) == NULL)
+	{
+		close(fd);
+		errno = ENOMEM;
+	}
+	else if(pipe(recorder->pipe) == 0)
+		/* the producer must never block */
+		for(i = 0; i < 2; i++)
+		{
+			fcntl(recorder->pipe[i], F_SETFD, FD_CLOEXEC);
+			fcntl(recorder->pipe[i], F_SETFL, O_NONBLOCK);
+		}
+	if(recorder->file == NULL || recorder->pipe[0] < 0
+			|| gzprintf(recorder->file, "{\"version\": 2,"
+				" \"width\": %u, \"height\": %u,"
+				" \"timestamp\": %lld,"
+				" \"env\": {\"TERM\": \"xterm\"}}\n",
+				columns, rows, (long long)time(NULL)) <= 0)
+	{
+		res = errno;
+		if(recorder->file != NULL)
+			gzclose(recorder->file);
+		unlink(filename);
+		for(i = 0; i < 2; i++)
+			if(recorder->pipe[i] >= 0)
+				close(recorder->pipe[i]);
+		free(recorder->ring);
+		free(recorder);
+		errno = (res != 0) ? res : EIO;
+		return NULL;
+	}
+	/* the signals are left to the other threads */
+	sigfillset(&set);
+	pthread_sigmask(SIG_SETMASK, &set, &oset);
+	res = pthread_create(&recorder->thread, NULL, _terminalrecorder_thread,
+			recorder);
+	pthread_sigmask(SIG_SETMASK, &oset, NULL);
+	if(res != 0)
+	{
+		gzclose(recorder->file);
+		unlink(filename);
+		close(recorder->pipe[0]);
+		close(recorder->pipe[1]);
+		free(recorder->ring);
+		free(recorder);
+		errno = res;
+		return NULL;
+	}
+	return recorder;
+}
+
+
+/* terminalrecorder_delete */
+int terminalrecorder_delete(TerminalRecorder * recorder)
+{
+	int ret;
+
+	atomic_store(&recorder->stopping, 1);
+	_terminalrecorder_wake(recorder);
+	pthread_join(recorder->thread, NULL);
+	ret = (recorder->error == 0 && gzclose(recorder->file) == Z_OK)
+		? 0 : -1;
+	close(recorder->pipe[0]);
+	close(recorder->pipe[1]);
+	free(recorder->ring);
+	free(recorder);
+	return ret;
+}
+
+
+/* accessors */
+/* terminalrecorder_get_dropped */
+unsigned long terminalrecorder_get_dropped(TerminalRecorder * recorder)
+{
+	return atomic_load_explicit(&recorder->dropped, memory_order_relaxed);
+}
+
+
+/* useful */
+/* terminalrecorder_output */
+void terminalrecorder_output(TerminalRecorder * recorder, char const * buf,
+		size_t len)
+{
+	size_t n;
+
+	for(; len > 0; buf += n, len -= n)
+	{
+		n = (len < TERMINALRECORDER_FRAME_MAX)
+			? len : TERMINALRECORDER_FRAME_MAX;
+		_terminalrecorder_push(recorder, TRE_OUTPUT, buf, n);
+	}
+}
+
+
+/* terminalrecorder_resize */
+void terminalrecorder_resize(TerminalRecorder * recorder,
+		unsigned int columns, unsigned int rows)
+{
+	uint32_t size[2];
+
+	size[0] = columns;
+	size[1] = rows;
+	_terminalrecorder_push(recorder, TRE_RESIZE, size, sizeof(size));
+}
+
+
+/* private */
+/* functions */
+/* terminalrecorder_copy_in */
+static void _terminalrecorder_copy_in(TerminalRecorder * recorder,
+		size_t pos, void const * buf, size_t len)
+{
+	size_t offset = pos & (recorder->size - 1);
+	size_t n;
+
+	n = (len < recorder->size - offset) ? len : recorder->size - offset;
+	memcpy(&recorder->ring[offset], buf, n);
+	memcpy(recorder->ring, (char const *)buf + n, len - n);
+}
+
+
+/* terminalrecorder_copy_out */
+static void _terminalrecorder_copy_out(TerminalRecorder * recorder,
+		size_t pos, void * buf, size_t len)
+{
+	size_t offset = pos & (recorder->size - 1);
+	size_t n;
+
+	n = (len < recorder->size - offset) ? len : recorder->size - offset;
+	memcpy(buf, &recorder->ring[offset], n);
+	memcpy((char *)buf + n, recorder->ring, len - n);
+}
+
+
+/* terminalrecorder_now */
+static uint64_t _terminalrecorder_now(TerminalRecorder * recorder)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)(ts.tv_sec - recorder->start.tv_sec) * 1000000
+		+ (ts.tv_nsec - recorder->start.tv_nsec) / 1000;
+}
+
+
+/* terminalrecorder_push */
+static void _terminalrecorder_push(TerminalRecorder * recorder,
+		TerminalRecorderEvent type, void const * buf, size_t len)
+{
+	TerminalRecorderFrame frame;
+	size_t head;
+	size_t tail;
+
+	head = atomic_load_explicit(&recorder->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&recorder->tail, memory_order_acquire);
+	if(sizeof(frame) + len > recorder->size - (head - tail))
+	{
+		atomic_fetch_add_explicit(&recorder->dropped, 1,
+				memory_order_relaxed);
+		return;
+	}
+	frame.time = _terminalrecorder_now(recorder);
+	frame.type = type;
+	frame.len = len;
+	_terminalrecorder_copy_in(recorder, head, &frame, sizeof(frame));
+	_terminalrecorder_copy_in(recorder, head + sizeof(frame), buf, len);
+	/* ordered with the writer going to sleep */
+	atomic_store(&recorder->head, head + sizeof(frame) + len);
+	_terminalrecorder_wake(recorder);
+}
+
+
+/* terminalrecorder_wake */
+static void _terminalrecorder_wake(TerminalRecorder * recorder)
+{
+	char c = '\0';
+
+	if(atomic_load(&recorder->sleeping)
+			&& atomic_exchange(&recorder->sleeping, 0)
+			&& write(recorder->pipe[1], &c, sizeof(c)) < 0)
+		/* the writer has been woken up already */
+		return;
+}
+
+
+/* writer */
+/* terminalrecorder_thread */
+static void * _terminalrecorder_thread(void * data)
+{
+	TerminalRecorder * recorder = data;
+	TerminalRecorderFrame frame;
+	size_t head;
+	size_t tail;
+	unsigned long dropped;
+	struct pollfd pfd;
+	char buf[64];
+
+	pfd.fd = recorder->pipe[0];
+	pfd.events = POLLIN;
+	tail = atomic_load_explicit(&recorder->tail, memory_order_relaxed);
+	for(;;)
+	{
+		head = atomic_load_explicit(&recorder->head,
+				memory_order_acquire);
+		for(; tail != head; tail += sizeof(frame) + frame.len)
+		{
+			_terminalrecorder_copy_out(recorder, tail, &frame,
+					sizeof(frame));
+			_terminalrecorder_write(recorder,
+					tail + sizeof(frame), &frame);
+			atomic_store_explicit(&recorder->tail,
+					tail + sizeof(frame) + frame.len,
+					memory_order_release);
+		}
+		/* the gaps are marked in the recording */
+		if((dropped = terminalrecorder_get_dropped(recorder))
+				!= recorder->dropped_reported)
+		{
+			_terminalrecorder_write_marker(recorder,
+					_terminalrecorder_now(recorder),
+					dropped - recorder->dropped_reported);
+			recorder->dropped_reported = dropped;
+		}
+		if(atomic_load(&recorder->stopping))
+		{
+			/* the last frames may have been pushed meanwhile */
+			if(atomic_load(&recorder->head) == tail)
+				break;
+			continue;
+		}
+		atomic_store(&recorder->sleeping, 1);
+		if(atomic_load(&recorder->head) != tail
+				|| atomic_load(&recorder->stopping))
+		{
+			atomic_store(&recorder->sleeping, 0);
+			continue;
+		}
+		while(poll(&pfd, 1, -1) < 0 && errno == EINTR);
+		while(read(recorder->pipe[0], buf, sizeof(buf)) > 0);
+	}
+	return NULL;
+}
+
+
+/* terminalrecorder_write */
+static void _terminalrecorder_write(TerminalRecorder * recorder,
+		size_t pos, TerminalRecorderFrame const * frame)
+{
+	char * output = recorder->output;
+	size_t len;
+	size_t cnt;
+	size_t i;
+	size_t n;
+	uint32_t size[2];
+
+	len = snprintf(output, sizeof(recorder->output), "[%lu.%06lu, ",
+			(unsigned long)(frame->time / 1000000),
+			(unsigned long)(frame->time % 1000000));
+	if(frame->type == TRE_RESIZE && frame->len == sizeof(size))
+	{
+		_terminalrecorder_copy_out(recorder, pos, size, sizeof(size));
+		len += snprintf(&output[len], sizeof(recorder->output) - len,
+				"\"r\", \"%ux%u\"]\n", size[0], size[1]);
+	}
+	else if(frame->type == TRE_OUTPUT)
+	{
+		_terminalrecorder_copy_out(recorder, pos,
+				&recorder->input[recorder->input_cnt],
+				frame->len);
+		cnt = recorder->input_cnt + frame->len;
+		memcpy(&output[len], "\"o\", \"", 6);
+		len += 6;
+		i = _terminalrecorder_write_utf8(recorder->input, cnt,
+				&output[len], &n);
+		len += n;
+		/* the end of the sequence should come with the next frame */
+		recorder->input_cnt = cnt - i;
+		memmove(recorder->input, &recorder->input[i],
+				recorder->input_cnt);
+		memcpy(&output[len], "\"]\n", 3);
+		len += 3;
+	}
+	else
+		return;
+	if(recorder->error == 0 && gzwrite(recorder->file, output, len) <= 0)
+		recorder->error = 1;
+}
+
+
+/* terminalrecorder_write_marker */
+static void _terminalrecorder_write_marker(TerminalRecorder * recorder,
+		uint64_t time, unsigned long dropped)
+{
+	if(recorder->error == 0 && gzprintf(recorder->file, "[%lu.%06lu, \"m\","
+				" \"%lu frame(s) dropped\"]\n",
+				(unsigned long)(time / 1000000),
+				(unsigned long)(time % 1000000), dropped) <= 0)
+		recorder->error = 1;
+}
+
+
+/* terminalrecorder_write_utf8 */
+static size_t _terminalrecorder_write_utf8(unsigned char const * buf,
+		size_t len, char * output, size_t * output_len)
+{
+	static char const hex[] = "0123456789abcdef";
+	char * p = output;
+	size_t i;
+	size_t j;
+	size_t n;
+	unsigned char c;
+	unsigned char min;
+	unsigned char max;
+
+	for(i = 0; i < len; i += n)
+	{
+		/* most of the output is printable ASCII */
+		for(n = 0; i + n < len && buf[i + n] >= 0x20
+				&& buf[i + n] < 0x7f && buf[i + n] != '"'
+				&& buf[i + n] != '\\'; n++);
+		if(n > 0)
+		{
+			memcpy(output, &buf[i], n);
+			output += n;
+			continue;
+		}
+		c = buf[i];
+		min = 0x80;
+		max = 0xbf;
+		if(c < 0x80)
+			n = 1;
+		else if(c >= 0xc2 && c <= 0xdf)
+			n = 2;
+		else if(c >= 0xe0 && c <= 0xef)
+		{
+			n = 3;
+			/* neither overlong nor a surrogate */
+			min = (c == 0xe0) ? 0xa0 : 0x80;
+			max = (c == 0xed) ? 0x9f : 0xbf;
+		}
+		else if(c >= 0xf0 && c <= 0xf4)
+		{
+			n = 4;
+			min = (c == 0xf0) ? 0x90 : 0x80;
+			max = (c == 0xf4) ? 0x8f : 0xbf;
+		}
+		else
+			n = 0;
+		for(j = 1; j < n && i + j < len; j++)
+			if(buf[i + j] < ((j == 1) ? min : 0x80)
+					|| buf[i + j] > ((j == 1) ? max : 0xbf))
+			{
+				n = 0;
+				break;
+			}
+		/* incomplete */
+		if(n > 1 && i + j == len && j < n)
+			break;
+		if(n == 0)
+		{
+			/* replaced with U+FFFD */
+			memcpy(output, "\\ufffd", 6);
+			output += 6;
+			n = 1;
+		}
+		else if(n > 1)
+		{
+			memcpy(output, &buf[i], n);
+			output += n;
+		}
+		else if(c == '"' || c == '\\')
+		{
+			*(output++) = '\\';
+			*(output++) = c;
+		}
+		else if(c == '\n')
+		{
+			memcpy(output, "\\n", 2);
+			output += 2;
+		}
+		else if(c == '\r')
+		{
+			memcpy(output, "\\r", 2);
+			output += 2;
+		}
+		else if(c < 0x20)
+		{
+			memcpy(output, "\\u00", 4);
+			output[4] = hex[c >> 4];
+			output[5] = hex[c & 0xf];
+			output += 6;
+		}
+		else
+			*(output++) = c;
+	}
+	*output_len = output - p;
+	return i;
+}
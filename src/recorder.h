@@ -0,0 +1,60 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_RECORDER_H
+# define TERMINAL_RECORDER_H
+
+# include <sys/types.h>
+
+
+/* Recorder */
+/* public */
+/* types */
+typedef struct _TerminalRecorder TerminalRecorder;
+
+
+/* functions */
+/* essential */
+/* records to a gzip-compressed asciicast (v2) file, created exclusively */
+TerminalRecorder * terminalrecorder_new(char const * filename,
+		unsigned int columns, unsigned int rows, size_t size);
+/* writes what is left, returns -1 if the file could not be written */
+int terminalrecorder_delete(TerminalRecorder * recorder);
+
+
+/* accessors */
+unsigned long terminalrecorder_get_dropped(TerminalRecorder * recorder);
+
+
+/* useful */
+/* never blocks, frames are dropped if the file is not written fast enough */
+void terminalrecorder_output(TerminalRecorder * recorder, char const * buf,
+		size_t len);
+void terminalrecorder_resize(TerminalRecorder * recorder,
+		unsigned int columns, unsigned int rows);
+
+#endif /* !TERMINAL_RECORDER_H */
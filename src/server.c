@@ -0,0 +1,505 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <libintl.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "server.h"
+#include "../config.h"
+#define _(string) gettext(string)
+
+/* constants */
+#ifndef PROGNAME_TERMINAL
+# define PROGNAME_TERMINAL	"terminal"
+#endif
+
+#define TERMINALSERVER_MESSAGE_SIZE	8192
+#define TERMINALSERVER_TIMEOUT		5
+
+
+/* TerminalServer */
+/* private */
+/* types */
+typedef struct _TerminalServerClient
+{
+	TerminalServer * server;
+	int fd;
+	guint source;
+	char buf[TERMINALSERVER_MESSAGE_SIZE];
+	size_t len;
+} TerminalServerClient;
+
+struct _TerminalServer
+{
+	String * path;
+	int fd;
+	GIOChannel * channel;
+	guint source;
+
+	TerminalServerClient ** clients;
+	size_t clients_cnt;
+};
+
+
+/* prototypes */
+static String * _terminalserver_get_path(void);
+static int _terminalserver_get_peer(int fd, uid_t * uid);
+static int _terminalserver_set_cloexec(int fd);
+
+static void _terminalserver_client_delete(TerminalServerClient * client);
+static int _terminalserver_client_process(TerminalServerClient * client);
+
+/* callbacks */
+static gboolean _terminalserver_on_accept(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static gboolean _terminalserver_on_client(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+
+
+/* public */
+/* functions */
+/* terminalserver_new */
+static int _new_bind(TerminalServer * server);
+
+TerminalServer * terminalserver_new(void)
+{
+	TerminalServer * server;
+
+	if((server = object_new(sizeof(*server))) == NULL)
+		return NULL;
+	server->path = _terminalserver_get_path();
+	server->fd = -1;
+	server->channel = NULL;
+	server->source = 0;
+	server->clients = NULL;
+	server->clients_cnt = 0;
+	if(server->path == NULL || _new_bind(server) != 0)
+	{
+		terminalserver_delete(server);
+		return NULL;
+	}
+	server->channel = g_io_channel_unix_new(server->fd);
+	server->source = g_io_add_watch(server->channel, G_IO_IN,
+			_terminalserver_on_accept, server);
+	return server;
+}
+
+static int _new_bind(TerminalServer * server)
+{
+	struct sockaddr_un sa;
+	int fd;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", server->path);
+	if((server->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -error_set_code(1, "%s: %s", "socket", strerror(errno));
+	if(_terminalserver_set_cloexec(server->fd) != 0)
+		return -1;
+	if(bind(server->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+	{
+		if(errno != EADDRINUSE)
+			return -error_set_code(1, "%s: %s", server->path,
+					strerror(errno));
+		/* check if the socket is stale */
+		if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+			return -error_set_code(1, "%s: %s", "socket",
+					strerror(errno));
+		if(connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0)
+		{
+			/* another server is already running */
+			close(fd);
+			return -error_set_code(1, "%s: %s", server->path,
+					strerror(EADDRINUSE));
+		}
+		close(fd);
+		if(unlink(server->path) != 0
+				|| bind(server->fd, (struct sockaddr *)&sa,
+					sizeof(sa)) != 0)
+			return -error_set_code(1, "%s: %s", server->path,
+					strerror(errno));
+	}
+	/* the shells can be started by the user alone */
+	if(chmod(server->path, 0600) != 0 || listen(server->fd, 5) != 0)
+	{
+		error_set_code(1, "%s: %s", server->path, strerror(errno));
+		unlink(server->path);
+		return -1;
+	}
+	return 0;
+}
+
+
+/* terminalserver_delete */
+void terminalserver_delete(TerminalServer * server)
+{
+	size_t i;
+
+	for(i = 0; i < server->clients_cnt; i++)
+		_terminalserver_client_delete(server->clients[i]);
+	free(server->clients);
+	if(server->source > 0)
+		g_source_remove(server->source);
+	if(server->channel != NULL)
+	{
+		g_io_channel_unref(server->channel);
+		/* only remove the socket if we were listening */
+		unlink(server->path);
+	}
+	if(server->fd >= 0)
+		close(server->fd);
+	string_delete(server->path);
+	object_delete(server);
+}
+
+
+/* useful */
+/* terminalserver_request */
+static String * _request_message(TerminalPrefs const * prefs, size_t * len);
+
+int terminalserver_request(TerminalPrefs const * prefs)
+{
+	int ret = -1;
+	String * path;
+	struct sockaddr_un sa;
+	struct timeval tv;
+	int fd;
+	String * message;
+	size_t len;
+	ssize_t s;
+	size_t i;
+	char c;
+
+	if((path = _terminalserver_get_path()) == NULL)
+		return -1;
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+	string_delete(path);
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -error_set_code(1, "%s: %s", "socket", strerror(errno));
+	if(connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+	{
+		/* no server is running */
+		close(fd);
+		return -error_set_code(1, "%s: %s", sa.sun_path,
+				strerror(errno));
+	}
+	/* do not wait forever for a busy server */
+	tv.tv_sec = TERMINALSERVER_TIMEOUT;
+	tv.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	if((message = _request_message(prefs, &len)) == NULL)
+	{
+		close(fd);
+		return -1;
+	}
+	for(i = 0; i < len; i += s)
+		if((s = write(fd, &message[i], len - i)) <= 0)
+			break;
+	free(message);
+	/* the reply is a single character */
+	if(i == len && shutdown(fd, SHUT_WR) == 0
+			&& read(fd, &c, sizeof(c)) == sizeof(c) && c == '0')
+		ret = 0;
+	else
+		error_set_code(1, "%s: %s", sa.sun_path,
+				_("Could not open a new window"));
+	close(fd);
+	return ret;
+}
+
+static String * _request_message(TerminalPrefs const * prefs, size_t * len)
+{
+	String * message;
+	String * p = NULL;
+	gchar * cwd;
+	char const * directory = NULL;
+	char const * shell = NULL;
+	unsigned int login = 0;
+	size_t dlen;
+	size_t slen;
+
+	if(prefs != NULL)
+	{
+		directory = prefs->directory;
+		shell = prefs->shell;
+		login = prefs->login;
+	}
+	/* the server runs in a different directory */
+	if(directory == NULL || directory[0] != '/')
+	{
+		if((cwd = g_get_current_dir()) == NULL)
+			return NULL;
+		p = (directory != NULL)
+			? string_new_append(cwd, "/", directory, NULL)
+			: string_new(cwd);
+		g_free(cwd);
+		if((directory = p) == NULL)
+			return NULL;
+	}
+	/* fields are separated by NUL characters */
+	dlen = strlen(directory);
+	slen = (shell != NULL) ? strlen(shell) : 0;
+	*len = (login ? 2 : 0) + dlen + 2 + ((shell != NULL) ? slen + 2 : 0);
+	if((message = malloc(*len)) == NULL)
+	{
+		string_delete(p);
+		return NULL;
+	}
+	*len = 0;
+	if(login)
+	{
+		memcpy(message, "l", 2);
+		*len += 2;
+	}
+	message[(*len)++] = 'd';
+	memcpy(&message[*len], directory, dlen + 1);
+	*len += dlen + 1;
+	if(shell != NULL)
+	{
+		message[(*len)++] = 's';
+		memcpy(&message[*len], shell, slen + 1);
+		*len += slen + 1;
+	}
+	string_delete(p);
+	return message;
+}
+
+
+/* private */
+/* functions */
+/* terminalserver_get_path */
+static String * _terminalserver_get_path(void)
+{
+	String * path;
+	char const * display;
+	String * p;
+
+	/* one server per user and per display */
+	if((display = g_getenv("DISPLAY")) == NULL || display[0] == '\0')
+		return NULL;
+	if((path = string_new_append(g_get_user_runtime_dir(), "/",
+					PROGNAME_TERMINAL, "-", display,
+					NULL)) == NULL)
+		return NULL;
+	for(p = &path[strlen(g_get_user_runtime_dir()) + 1]; *p != '\0'; p++)
+		if(*p == '/')
+			*p = '_';
+	if(strlen(path) >= sizeof(((struct sockaddr_un *)NULL)->sun_path))
+	{
+		error_set_code(1, "%s: %s", path, strerror(ENAMETOOLONG));
+		string_delete(path);
+		return NULL;
+	}
+	return path;
+}
+
+
+/* terminalserver_get_peer */
+static int _terminalserver_get_peer(int fd, uid_t * uid)
+{
+#ifdef SO_PEERCRED
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+
+	if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+		return -1;
+	*uid = cred.uid;
+	return 0;
+#else
+	gid_t gid;
+
+	return getpeereid(fd, uid, &gid);
+#endif
+}
+
+
+/* terminalserver_set_cloexec */
+static int _terminalserver_set_cloexec(int fd)
+{
+	int flags;
+
+	/* the children must not inherit our sockets */
+	if((flags = fcntl(fd, F_GETFD)) == -1
+			|| fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1)
+		return -error_set_code(1, "%s: %s", "fcntl", strerror(errno));
+	return 0;
+}
+
+
+/* clients */
+/* terminalserver_client_delete */
+static void _terminalserver_client_delete(TerminalServerClient * client)
+{
+	if(client->source > 0)
+		g_source_remove(client->source);
+	close(client->fd);
+	object_delete(client);
+}
+
+
+/* terminalserver_client_process */
+static int _terminalserver_client_process(TerminalServerClient * client)
+{
+	TerminalPrefs prefs;
+	size_t i;
+	char * p;
+
+	memset(&prefs, 0, sizeof(prefs));
+	if(client->len == 0 || client->buf[client->len - 1] != '\0')
+		return -1;
+	for(i = 0; i < client->len; i += strlen(p) + 1)
+	{
+		p = &client->buf[i];
+		switch(*(p++))
+		{
+			case 'd':
+				prefs.directory = p;
+				break;
+			case 'l':
+				prefs.login = 1;
+				break;
+			case 's':
+				prefs.shell = p;
+				break;
+			default:
+				return -1;
+		}
+	}
+	return (terminal_new(&prefs) != NULL) ? 0 : -1;
+}
+
+
+/* callbacks */
+/* terminalserver_on_accept */
+static gboolean _terminalserver_on_accept(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalServer * server = data;
+	TerminalServerClient ** p;
+	TerminalServerClient * client;
+	GIOChannel * channel;
+	int fd;
+	uid_t uid;
+
+	if(condition != G_IO_IN)
+		return TRUE;
+	if((fd = accept(g_io_channel_unix_get_fd(source), NULL, NULL)) < 0)
+		return TRUE;
+	/* the clients may start any shell */
+	if(_terminalserver_get_peer(fd, &uid) != 0 || uid != getuid()
+			|| _terminalserver_set_cloexec(fd) != 0
+			|| fcntl(fd, F_SETFL, O_NONBLOCK) != 0
+			|| (p = realloc(server->clients, sizeof(*p)
+					* (server->clients_cnt + 1))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	server->clients = p;
+	if((client = object_new(sizeof(*client))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	server->clients[server->clients_cnt++] = client;
+	client->server = server;
+	client->fd = fd;
+	client->len = 0;
+	channel = g_io_channel_unix_new(fd);
+	client->source = g_io_add_watch(channel, G_IO_IN | G_IO_HUP
+			| G_IO_ERR, _terminalserver_on_client, client);
+	g_io_channel_unref(channel);
+	return TRUE;
+}
+
+
+/* terminalserver_on_client */
+static gboolean _terminalserver_on_client(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalServerClient * client = data;
+	TerminalServer * server = client->server;
+	ssize_t s;
+	char c;
+	size_t i;
+	(void) source;
+
+	if(condition & (G_IO_IN | G_IO_HUP))
+	{
+		if((s = read(client->fd, &client->buf[client->len],
+						sizeof(client->buf)
+						- client->len)) > 0)
+		{
+			client->len += s;
+			if(client->len < sizeof(client->buf))
+				return TRUE;
+			/* the message is too long */
+			s = -1;
+		}
+		else if(s < 0 && errno == EAGAIN)
+			return TRUE;
+		/* reply once the request is complete */
+		if(s == 0)
+		{
+			c = (_terminalserver_client_process(client) == 0)
+				? '0' : '1';
+			if(write(client->fd, &c, sizeof(c)) != sizeof(c))
+				error_set_code(1, "%s: %s", "write",
+						strerror(errno));
+		}
+	}
+	for(i = 0; i < server->clients_cnt; i++)
+		if(server->clients[i] == client)
+			break;
+	if(i < server->clients_cnt)
+	{
+		memmove(&server->clients[i], &server->clients[i + 1],
+				(server->clients_cnt - (i + 1))
+				* sizeof(*server->clients));
+		server->clients_cnt--;
+	}
+	client->source = 0;
+	_terminalserver_client_delete(client);
+	return FALSE;
+}
@@ -0,0 +1,829 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <termios.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "history.h"
+#include "pty.h"
+#include "reaper.h"
+#include "recorder.h"
+#include "session.h"
+#include "vt.h"
+
+/* constants */
+#define TERMINALSESSION_COLUMNS		80
+#define TERMINALSESSION_FLOOD_PERIOD	100
+#define TERMINALSESSION_INPUT_SIZE	4096
+#define TERMINALSESSION_READ_BUDGET	65536
+#define TERMINALSESSION_READ_SIZE	4096
+#define TERMINALSESSION_REPLAY_MIN	TERMINALSESSION_READ_SIZE
+#define TERMINALSESSION_ROWS		24
+#define TERMINALSESSION_SHELL		"/bin/sh"
+
+
+/* TerminalSession */
+/* private */
+/* types */
+struct _TerminalSession
+{
+	GPid pid;
+	String * title;
+	gboolean detached;
+
+	TerminalSessionCallback callback;
+	void * data;
+
+	/* the pty of the shell */
+	int fd;
+	GIOChannel * channel;
+	guint rd_source;
+	guint wr_source;
+
+	/* the latest output, in a ring buffer */
+	char * replay;
+	size_t replay_size;
+	guint64 replay_pos;
+
+	/* the output recorded, if enabled */
+	TerminalRecorder * recorder;
+
+	/* the text of the output, if kept */
+	TerminalHistory * history;
+
+	/* flood control, if enabled */
+	TerminalVT * vt;
+	size_t flood_rate;			/* in bytes per second */
+	size_t flood_cnt;
+	gint64 flood_time;
+	guint flood_source;
+	/* sent instead of the output skipped */
+	char * screen;
+	size_t screen_len;
+	size_t screen_pos;
+	gboolean screen_again;
+
+	/* the terminal emulator, if attached */
+	int client;
+	GIOChannel * client_channel;
+	guint client_rd_source;
+	guint client_wr_source;
+	guint64 client_pos;
+	/* the emulator writes its window ID first */
+	gboolean client_id;
+	char input[TERMINALSESSION_INPUT_SIZE];
+	size_t input_cnt;
+
+	TerminalSession * next;
+};
+
+
+/* prototypes */
+static void _terminalsession_client_close(TerminalSession * session);
+static void _terminalsession_flood(TerminalSession * session);
+static void _terminalsession_flush(TerminalSession * session);
+static void _terminalsession_input(TerminalSession * session);
+static void _terminalsession_redraw(TerminalSession * session);
+
+/* callbacks */
+static gboolean _terminalsession_on_client_read(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static gboolean _terminalsession_on_client_write(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static void _terminalsession_on_exit(void * data, GPid pid, int status);
+static gboolean _terminalsession_on_flood(gpointer data);
+static gboolean _terminalsession_on_read(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+static gboolean _terminalsession_on_write(GIOChannel * source,
+		GIOCondition condition, gpointer data);
+
+
+/* variables */
+/* every session, attached or not */
+static TerminalSession * _terminalsession_sessions = NULL;
+
+/* kept until exiting, sessions may be deleted from its callback */
+static TerminalReaper * _terminalsession_reaper = NULL;
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalsession_new */
+TerminalSession * terminalsession_new(char const * directory,
+		char const * shell, unsigned int login, size_t replay)
+{
+	TerminalSession * session;
+	char * argv[] = { NULL, NULL, NULL };
+	char * argv0 = NULL;
+	char const * p;
+
+	if(_terminalsession_reaper == NULL
+			&& (_terminalsession_reaper = terminalreaper_new(
+					_terminalsession_on_exit, NULL))
+			== NULL)
+		return NULL;
+	if((session = object_new(sizeof(*session))) == NULL)
+		return NULL;
+	session->pid = -1;
+	session->title = NULL;
+	session->detached = FALSE;
+	session->callback = NULL;
+	session->data = NULL;
+	session->channel = NULL;
+	session->rd_source = 0;
+	session->wr_source = 0;
+	session->replay_size = (replay > TERMINALSESSION_REPLAY_MIN)
+		? replay : TERMINALSESSION_REPLAY_MIN;
+	session->replay = malloc(session->replay_size);
+	session->replay_pos = 0;
+	session->recorder = NULL;
+	session->history = NULL;
+	session->vt = NULL;
+	session->flood_rate = 0;
+	session->flood_cnt = 0;
+	session->flood_time = 0;
+	session->flood_source = 0;
+	session->screen = NULL;
+	session->screen_len = 0;
+	session->screen_pos = 0;
+	session->screen_again = FALSE;
+	session->client = -1;
+	session->client_channel = NULL;
+	session->client_rd_source = 0;
+	session->client_wr_source = 0;
+	session->client_pos = 0;
+	session->client_id = FALSE;
+	session->input_cnt = 0;
+	session->next = _terminalsession_sessions;
+	_terminalsession_sessions = session;
+	if(shell == NULL && ((shell = getenv("SHELL")) == NULL
+				|| shell[0] == '\0'))
+		shell = TERMINALSESSION_SHELL;
+	argv[0] = (char *)shell;
+	argv[1] = (char *)shell;
+	/* login shells have their name prefixed with a dash */
+	if(login)
+	{
+		p = strrchr(shell, '/');
+		argv[1] = argv0 = string_new_append("-",
+				(p != NULL) ? p + 1 : shell, NULL);
+	}
+	if(session->replay == NULL || argv[1] == NULL
+			|| (session->fd = pty_new()) < 0)
+	{
+		session->fd = -1;
+		string_delete(argv0);
+		terminalsession_delete(session);
+		return NULL;
+	}
+	pty_set_size(session->fd, TERMINALSESSION_COLUMNS,
+			TERMINALSESSION_ROWS, 0, 0);
+	if(pty_spawn(session->fd, directory, argv, &session->pid) != 0
+			|| terminalreaper_add(_terminalsession_reaper,
+				session->pid) != 0)
+	{
+		if(session->pid > 0)
+			terminalreaper_abandon(session->pid, SIGKILL);
+		session->pid = -1;
+		string_delete(argv0);
+		terminalsession_delete(session);
+		return NULL;
+	}
+	string_delete(argv0);
+	session->channel = g_io_channel_unix_new(session->fd);
+	g_io_channel_set_encoding(session->channel, NULL, NULL);
+	g_io_channel_set_buffered(session->channel, FALSE);
+	session->rd_source = g_io_add_watch(session->channel,
+			G_IO_IN | G_IO_ERR | G_IO_HUP,
+			_terminalsession_on_read, session);
+	return session;
+}
+
+
+/* terminalsession_delete */
+void terminalsession_delete(TerminalSession * session)
+{
+	TerminalSession ** s;
+
+	for(s = &_terminalsession_sessions; *s != NULL; s = &(*s)->next)
+		if(*s == session)
+		{
+			*s = session->next;
+			break;
+		}
+	_terminalsession_client_close(session);
+	if(session->rd_source > 0)
+		g_source_remove(session->rd_source);
+	if(session->wr_source > 0)
+		g_source_remove(session->wr_source);
+	if(session->channel != NULL)
+		g_io_channel_unref(session->channel);
+	/* closing the pty hangs the shell up */
+	if(session->fd >= 0)
+		close(session->fd);
+	if(session->pid > 0)
+		terminalreaper_kill(_terminalsession_reaper, session->pid,
+				SIGHUP);
+	/* the recording is complete once the shell is gone */
+	if(session->recorder != NULL)
+		terminalrecorder_delete(session->recorder);
+	if(session->history != NULL)
+		terminalhistory_delete(session->history);
+	if(session->flood_source > 0)
+		g_source_remove(session->flood_source);
+	if(session->vt != NULL)
+		terminalvt_delete(session->vt);
+	free(session->replay);
+	string_delete(session->title);
+	object_delete(session);
+}
+
+
+/* accessors */
+/* terminalsession_get_detached */
+TerminalSession * terminalsession_get_detached(TerminalSession * session)
+{
+	session = (session != NULL) ? session->next
+		: _terminalsession_sessions;
+	for(; session != NULL; session = session->next)
+		if(session->detached)
+			return session;
+	return NULL;
+}
+
+
+/* terminalsession_get_history */
+TerminalHistory * terminalsession_get_history(TerminalSession * session)
+{
+	return session->history;
+}
+
+
+/* terminalsession_get_pid */
+GPid terminalsession_get_pid(TerminalSession * session)
+{
+	return session->pid;
+}
+
+
+/* terminalsession_get_title */
+char const * terminalsession_get_title(TerminalSession * session)
+{
+	return session->title;
+}
+
+
+/* terminalsession_set_flood */
+int terminalsession_set_flood(TerminalSession * session, size_t rate)
+{
+	unsigned int columns;
+	unsigned int rows;
+	unsigned int width;
+	unsigned int height;
+
+	if(rate == 0)
+	{
+		if(session->vt == NULL)
+			return 0;
+		/* the output skipped was not displayed */
+		if(session->flood_source > 0)
+		{
+			g_source_remove(session->flood_source);
+			session->flood_source = 0;
+			_terminalsession_redraw(session);
+		}
+		terminalvt_delete(session->vt);
+		session->vt = NULL;
+	}
+	else if(session->vt == NULL)
+	{
+		if(pty_get_size(session->fd, &columns, &rows, &width, &height)
+				!= 0)
+			return -1;
+		/* the screen is followed but never displayed */
+		if((session->vt = terminalvt_new(NULL, columns, rows, 0))
+				== NULL)
+			return -error_set_code(1, "%s", strerror(ENOMEM));
+	}
+	session->flood_rate = rate;
+	session->flood_cnt = 0;
+	session->flood_time = g_get_monotonic_time();
+	return 0;
+}
+
+
+/* terminalsession_set_history */
+int terminalsession_set_history(TerminalSession * session,
+		char const * directory, size_t size)
+{
+	if(session->history != NULL)
+		return 0;
+	if((session->history = terminalhistory_new(directory, size)) == NULL)
+		return -error_set_code(1, "%s: %s", directory,
+				strerror(errno));
+	return 0;
+}
+
+
+/* useful */
+/* terminalsession_attach */
+int terminalsession_attach(TerminalSession * session,
+		TerminalSessionCallback callback, void * data)
+{
+	int fd;
+
+	_terminalsession_client_close(session);
+	if((fd = pty_new()) < 0)
+		return -1;
+	if((session->client = pty_open_slave(fd)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	session->callback = callback;
+	session->data = data;
+	session->detached = FALSE;
+	session->client_channel = g_io_channel_unix_new(session->client);
+	g_io_channel_set_encoding(session->client_channel, NULL, NULL);
+	g_io_channel_set_buffered(session->client_channel, FALSE);
+	/* the input always comes first */
+	session->client_rd_source = g_io_add_watch_full(
+			session->client_channel, G_PRIORITY_HIGH,
+			G_IO_IN | G_IO_ERR | G_IO_HUP,
+			_terminalsession_on_client_read, session, NULL);
+	session->client_id = TRUE;
+	session->input_cnt = 0;
+	/* the latest output is replayed */
+	session->client_pos = (session->replay_pos > session->replay_size)
+		? session->replay_pos - session->replay_size : 0;
+	_terminalsession_flush(session);
+	return fd;
+}
+
+
+/* terminalsession_detach */
+void terminalsession_detach(TerminalSession * session, char const * title)
+{
+	String * p;
+
+	_terminalsession_client_close(session);
+	session->callback = NULL;
+	session->data = NULL;
+	session->detached = TRUE;
+	if(title != NULL && (p = string_new(title)) != NULL)
+	{
+		string_delete(session->title);
+		session->title = p;
+	}
+	/* the output keeps being read while detached */
+	_terminalsession_flush(session);
+}
+
+
+/* terminalsession_record */
+int terminalsession_record(TerminalSession * session, char const * filename,
+		size_t size)
+{
+	unsigned int columns;
+	unsigned int rows;
+	unsigned int width;
+	unsigned int height;
+
+	if(session->recorder != NULL)
+		return -error_set_code(1, "%s: %s", filename,
+				"Already recording");
+	if(pty_get_size(session->fd, &columns, &rows, &width, &height) != 0)
+		return -1;
+	if((session->recorder = terminalrecorder_new(filename, columns, rows,
+					size)) == NULL)
+		return -error_set_code(1, "%s: %s", filename,
+				strerror(errno));
+	return 0;
+}
+
+
+/* terminalsession_resize */
+int terminalsession_resize(TerminalSession * session)
+{
+	unsigned int size[4];
+	unsigned int current[4];
+
+	if(session->client < 0 || session->fd < 0
+			|| pty_get_size(session->client, &size[0], &size[1],
+				&size[2], &size[3]) != 0
+			|| size[0] == 0 || size[1] == 0
+			|| pty_get_size(session->fd, &current[0], &current[1],
+				&current[2], &current[3]) != 0
+			|| memcmp(size, current, sizeof(size)) == 0)
+		return 0;
+	/* the shell is then notified */
+	if(pty_set_size(session->fd, size[0], size[1], size[2], size[3]) != 0)
+		return -1;
+	if(session->recorder != NULL)
+		terminalrecorder_resize(session->recorder, size[0], size[1]);
+	if(session->vt != NULL)
+		terminalvt_set_size(session->vt, size[0], size[1]);
+	return 1;
+}
+
+
+/* private */
+/* functions */
+/* terminalsession_client_close */
+static void _terminalsession_client_close(TerminalSession * session)
+{
+	if(session->client_rd_source > 0)
+		g_source_remove(session->client_rd_source);
+	session->client_rd_source = 0;
+	if(session->client_wr_source > 0)
+		g_source_remove(session->client_wr_source);
+	session->client_wr_source = 0;
+	if(session->client_channel != NULL)
+		g_io_channel_unref(session->client_channel);
+	session->client_channel = NULL;
+	if(session->client >= 0)
+		close(session->client);
+	session->client = -1;
+	free(session->screen);
+	session->screen = NULL;
+	session->screen_again = FALSE;
+	/* the input pending is lost with the terminal emulator */
+	if(session->wr_source > 0)
+		g_source_remove(session->wr_source);
+	session->wr_source = 0;
+	session->input_cnt = 0;
+}
+
+
+/* terminalsession_flood */
+static void _terminalsession_flood(TerminalSession * session)
+{
+	gint64 now;
+
+	/* the timer takes over while flooding */
+	if(session->vt == NULL || session->flood_source > 0)
+		return;
+	if(session->flood_cnt > session->flood_rate
+			* TERMINALSESSION_FLOOD_PERIOD / 1000)
+	{
+		session->flood_cnt = 0;
+		session->flood_time = g_get_monotonic_time();
+		session->flood_source = g_timeout_add(
+				TERMINALSESSION_FLOOD_PERIOD,
+				_terminalsession_on_flood, session);
+		_terminalsession_redraw(session);
+		return;
+	}
+	now = g_get_monotonic_time();
+	if(now - session->flood_time >= TERMINALSESSION_FLOOD_PERIOD * 1000)
+	{
+		session->flood_cnt = 0;
+		session->flood_time = now;
+	}
+}
+
+
+/* terminalsession_flush */
+static void _terminalsession_flush(TerminalSession * session)
+{
+	size_t offset;
+	size_t len;
+	ssize_t res;
+	char const * buf;
+
+	/* the output is skipped while flooding */
+	if(session->flood_source > 0)
+		session->client_pos = session->replay_pos;
+	while(session->client >= 0 && (session->screen != NULL
+				|| session->client_pos < session->replay_pos))
+	{
+		if(session->screen != NULL)
+		{
+			buf = &session->screen[session->screen_pos];
+			len = session->screen_len - session->screen_pos;
+		}
+		else
+		{
+			offset = session->client_pos % session->replay_size;
+			buf = &session->replay[offset];
+			len = MIN(session->replay_pos - session->client_pos,
+					session->replay_size - offset);
+		}
+		if((res = write(session->client, buf, len)) > 0)
+		{
+			if(session->screen == NULL)
+				session->client_pos += res;
+			else if((session->screen_pos += res)
+					== session->screen_len)
+			{
+				free(session->screen);
+				session->screen = NULL;
+				/* the screen has changed meanwhile */
+				if(session->screen_again)
+					_terminalsession_redraw(session);
+			}
+			continue;
+		}
+		if(res < 0 && errno == EINTR)
+			continue;
+		if(res < 0 && errno == EAGAIN)
+		{
+			/* wait for the terminal emulator */
+			if(session->client_wr_source == 0)
+				session->client_wr_source = g_io_add_watch(
+					session->client_channel, G_IO_OUT,
+					_terminalsession_on_client_write,
+					session);
+			break;
+		}
+		_terminalsession_client_close(session);
+	}
+	/* the shell is only waited for by the terminal emulator */
+	if(session->rd_source == 0 && session->channel != NULL
+			&& (session->client < 0
+				|| session->replay_pos - session->client_pos
+				+ TERMINALSESSION_READ_SIZE
+				<= session->replay_size))
+		session->rd_source = g_io_add_watch(session->channel,
+				G_IO_IN | G_IO_ERR | G_IO_HUP,
+				_terminalsession_on_read, session);
+}
+
+
+/* terminalsession_input */
+static void _terminalsession_input(TerminalSession * session)
+{
+	ssize_t res;
+
+	while(session->input_cnt > 0)
+	{
+		if((res = write(session->fd, session->input,
+						session->input_cnt)) > 0)
+		{
+			memmove(session->input, &session->input[res],
+					session->input_cnt - res);
+			session->input_cnt -= res;
+			continue;
+		}
+		if(res < 0 && errno == EINTR)
+			continue;
+		if(res < 0 && errno == EAGAIN)
+		{
+			/* wait for the shell */
+			if(session->wr_source == 0)
+				session->wr_source = g_io_add_watch(
+						session->channel, G_IO_OUT,
+						_terminalsession_on_write,
+						session);
+			return;
+		}
+		/* the shell is gone */
+		session->input_cnt = 0;
+	}
+	/* the terminal emulator is only read from once done */
+	if(session->client_rd_source == 0 && session->client_channel != NULL)
+		session->client_rd_source = g_io_add_watch_full(
+				session->client_channel, G_PRIORITY_HIGH,
+				G_IO_IN | G_IO_ERR | G_IO_HUP,
+				_terminalsession_on_client_read, session,
+				NULL);
+}
+
+
+/* terminalsession_redraw */
+static void _terminalsession_redraw(TerminalSession * session)
+{
+	/* a screen is never interrupted */
+	if(session->screen != NULL && session->screen_pos > 0)
+	{
+		session->screen_again = TRUE;
+		return;
+	}
+	free(session->screen);
+	session->screen_again = FALSE;
+	/* the output not sent yet is replaced */
+	if(session->client < 0 || (session->screen = terminalvt_dump(
+					session->vt, &session->screen_len))
+			== NULL)
+		return;
+	session->screen_pos = 0;
+	session->client_pos = session->replay_pos;
+}
+
+
+/* callbacks */
+/* terminalsession_on_client_read */
+static gboolean _terminalsession_on_client_read(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalSession * session = data;
+	ssize_t res;
+	char * p;
+	struct termios term;
+	(void) source;
+	(void) condition;
+
+	if((res = read(session->client, session->input,
+					sizeof(session->input))) < 0
+			&& (errno == EAGAIN || errno == EINTR))
+		return TRUE;
+	if(res <= 0)
+	{
+		/* the terminal emulator is gone (EIO on some systems) */
+		session->client_rd_source = 0;
+		_terminalsession_client_close(session);
+		_terminalsession_flush(session);
+		return FALSE;
+	}
+	session->input_cnt = res;
+	/* the window ID is not meant for the shell */
+	if(session->client_id)
+	{
+		if((p = memchr(session->input, '\n', res)) != NULL)
+		{
+			session->client_id = FALSE;
+			session->input_cnt = &session->input[res] - (p + 1);
+			memmove(session->input, p + 1, session->input_cnt);
+		}
+		else
+			session->input_cnt = 0;
+	}
+	/* interrupting displays the current screen right away */
+	if(session->vt != NULL && session->client_pos < session->replay_pos
+			&& tcgetattr(session->fd, &term) == 0
+			&& (term.c_lflag & ISIG)
+			&& memchr(session->input, term.c_cc[VINTR],
+				session->input_cnt) != NULL)
+	{
+		_terminalsession_redraw(session);
+		_terminalsession_flush(session);
+	}
+	/* stop reading until the shell has read it all */
+	session->client_rd_source = 0;
+	_terminalsession_input(session);
+	return FALSE;
+}
+
+
+/* terminalsession_on_client_write */
+static gboolean _terminalsession_on_client_write(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalSession * session = data;
+	(void) source;
+	(void) condition;
+
+	session->client_wr_source = 0;
+	_terminalsession_flush(session);
+	return FALSE;
+}
+
+
+/* terminalsession_on_exit */
+static void _terminalsession_on_exit(void * data, GPid pid, int status)
+{
+	TerminalSession * session;
+	(void) data;
+
+	for(session = _terminalsession_sessions; session != NULL;
+			session = session->next)
+		if(session->pid == pid)
+			break;
+	if(session == NULL)
+		return;
+	session->pid = -1;
+	/* the sessions detached are not needed anymore */
+	if(session->callback != NULL)
+		session->callback(session->data, session, status);
+	else
+		terminalsession_delete(session);
+}
+
+
+/* terminalsession_on_flood */
+static gboolean _terminalsession_on_flood(gpointer data)
+{
+	TerminalSession * session = data;
+	gboolean ret = TRUE;
+
+	/* the last screen is displayed in any case */
+	if(session->flood_cnt <= session->flood_rate
+			* TERMINALSESSION_FLOOD_PERIOD / 1000)
+	{
+		session->flood_source = 0;
+		ret = FALSE;
+	}
+	session->flood_cnt = 0;
+	session->flood_time = g_get_monotonic_time();
+	_terminalsession_redraw(session);
+	_terminalsession_flush(session);
+	return ret;
+}
+
+
+/* terminalsession_on_read */
+static gboolean _terminalsession_on_read(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalSession * session = data;
+	size_t offset;
+	size_t len;
+	ssize_t res;
+	size_t total = 0;
+	(void) source;
+	(void) condition;
+
+	while(total < TERMINALSESSION_READ_BUDGET)
+	{
+		/* the terminal emulator is not overrun while attached */
+		if(session->client >= 0 && session->flood_source == 0
+				&& session->replay_pos
+				- session->client_pos
+				+ TERMINALSESSION_READ_SIZE
+				> session->replay_size)
+		{
+			session->rd_source = 0;
+			_terminalsession_flood(session);
+			_terminalsession_flush(session);
+			return FALSE;
+		}
+		offset = session->replay_pos % session->replay_size;
+		len = MIN(TERMINALSESSION_READ_SIZE,
+				session->replay_size - offset);
+		if((res = read(session->fd, &session->replay[offset], len))
+				> 0)
+		{
+			/* this never blocks */
+			if(session->recorder != NULL)
+				terminalrecorder_output(session->recorder,
+						&session->replay[offset], res);
+			if(session->history != NULL)
+				terminalhistory_output(session->history,
+						&session->replay[offset], res);
+			if(session->vt != NULL)
+			{
+				terminalvt_write(session->vt,
+						&session->replay[offset], res);
+				session->flood_cnt += res;
+			}
+			session->replay_pos += res;
+			total += res;
+			continue;
+		}
+		if(res < 0 && (errno == EAGAIN || errno == EINTR))
+			break;
+		/* the shell is gone (EIO on some systems) */
+		_terminalsession_flush(session);
+		session->rd_source = 0;
+		g_io_channel_unref(session->channel);
+		session->channel = NULL;
+		return FALSE;
+	}
+	_terminalsession_flood(session);
+	_terminalsession_flush(session);
+	return TRUE;
+}
+
+
+/* terminalsession_on_write */
+static gboolean _terminalsession_on_write(GIOChannel * source,
+		GIOCondition condition, gpointer data)
+{
+	TerminalSession * session = data;
+	(void) source;
+	(void) condition;
+
+	session->wr_source = 0;
+	_terminalsession_input(session);
+	return FALSE;
+}
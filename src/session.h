@@ -0,0 +1,79 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_SESSION_H
+# define TERMINAL_SESSION_H
+
+# include "history.h"
+
+
+/* TerminalSession */
+/* public */
+/* types */
+typedef struct _TerminalSession TerminalSession;
+
+/* the shell has exited */
+typedef void (*TerminalSessionCallback)(void * data,
+		TerminalSession * session, int status);
+
+
+/* functions */
+/* essential */
+TerminalSession * terminalsession_new(char const * directory,
+		char const * shell, unsigned int login, size_t replay);
+/* hangs the shell up */
+void terminalsession_delete(TerminalSession * session);
+
+
+/* accessors */
+/* iterates over the sessions detached */
+TerminalSession * terminalsession_get_detached(TerminalSession * session);
+TerminalHistory * terminalsession_get_history(TerminalSession * session);
+GPid terminalsession_get_pid(TerminalSession * session);
+char const * terminalsession_get_title(TerminalSession * session);
+
+/* skips the output above this rate in bytes per second, 0 to disable */
+int terminalsession_set_flood(TerminalSession * session, size_t rate);
+/* keeps the text of the output from now on */
+int terminalsession_set_history(TerminalSession * session,
+		char const * directory, size_t size);
+
+
+/* useful */
+/* returns the master side of a pty for a terminal emulator */
+int terminalsession_attach(TerminalSession * session,
+		TerminalSessionCallback callback, void * data);
+void terminalsession_detach(TerminalSession * session, char const * title);
+
+/* records the output from now on */
+int terminalsession_record(TerminalSession * session, char const * filename,
+		size_t size);
+
+/* returns 1 if the size of the terminal emulator has changed */
+int terminalsession_resize(TerminalSession * session);
+
+#endif /* !TERMINAL_SESSION_H */
@@ -0,0 +1,972 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "store.h"
+#include "spawner.h"
+
+/* constants */
+#define SPAWNER_FDS_MAX		1024
+#define SPAWNER_PENDING_MAX	64
+#define SPAWNER_STRINGS_MAX	1048576
+
+/* the features of posix_spawn() required by the terminals */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 \
+		|| (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+# define SPAWNER_ADDCHDIR
+#endif
+/* the controlling terminal is only acquired implicitly on Linux */
+#if defined(POSIX_SPAWN_SETSID) && defined(__linux__)
+# define SPAWNER_SETSID
+#endif
+#if !defined(SPAWNER_ADDCHDIR) || !defined(SPAWNER_SETSID)
+# define SPAWNER_FORK
+#endif
+
+
+/* Spawner */
+/* private */
+/* types */
+typedef enum _SpawnerMessageType
+{
+	SMT_SPAWN = 0,
+	SMT_KILL,
+	SMT_SPAWNED,
+	SMT_EXITED
+} SpawnerMessageType;
+
+/* followed by the file, directory, terminal, arguments and environment */
+typedef struct _SpawnerMessage
+{
+	uint32_t type;
+	uint32_t flags;
+	int32_t pid;
+	/* the signal, the exit status, the error or if a file is passed */
+	int32_t value;
+	uint32_t argc;
+	uint32_t envc;
+	uint32_t size;
+} SpawnerMessage;
+
+typedef struct _SpawnerChild
+{
+	pid_t pid;
+} SpawnerChild;
+
+typedef struct _Spawner
+{
+	int fd;
+	pid_t pid;
+
+	SpawnerCallback callback;
+	void * data;
+
+	/* the processes spawned and not reported yet */
+	TerminalStore * children;
+
+	/* the exits read while waiting for a process to be spawned */
+	SpawnerMessage pending[SPAWNER_PENDING_MAX];
+	size_t pending_cnt;
+
+	/* the messages are received in full */
+	SpawnerMessage in;
+	size_t in_cnt;
+} Spawner;
+
+
+/* prototypes */
+static int _spawner_kill(Spawner * spawner, pid_t pid, int sig, int group);
+static int _spawner_read(Spawner * spawner, SpawnerMessage * message);
+static int _spawner_wait(Spawner * spawner, SpawnerMessage * message);
+static int _spawner_send(int fd, void const * buf, size_t size, int passed);
+static int _spawner_write(int fd, void const * buf, size_t size);
+
+static void _spawner_exited(Spawner * spawner, pid_t pid, int status);
+
+/* helper */
+static void _spawner_helper(int fd);
+static int _spawner_helper_kill(SpawnerMessage const * message);
+static void _spawner_helper_reap(int fd);
+static int _spawner_helper_receive(int fd);
+static pid_t _spawner_helper_spawn(SpawnerMessage const * message,
+		char * strings, int passed, int * error);
+static int _spawner_helper_actions(posix_spawn_file_actions_t * actions,
+		char const * directory, char const * tty, int passed);
+#ifdef SPAWNER_FORK
+static pid_t _spawner_helper_spawn_fork(char const * file, char ** argv,
+		char ** envp, char const * directory, char const * tty,
+		int passed, unsigned int flags, int * error);
+#endif
+static int _spawner_helper_read(int fd, void * buf, size_t size);
+static int _spawner_helper_recv(int fd, void * buf, size_t size,
+		int * passed);
+
+static void _spawner_helper_on_child(int signum);
+
+
+/* variables */
+extern char ** environ;
+
+static Spawner _spawner = { -1, -1, NULL, NULL, NULL, { { 0 } }, 0,
+	{ 0 }, 0 };
+
+static int _spawner_helper_pipe[2] = { -1, -1 };
+
+
+/* public */
+/* functions */
+/* essential */
+/* spawner_start */
+int spawner_start(void)
+{
+	int fds[2];
+	pid_t pid;
+
+	if(_spawner.fd >= 0)
+		return 0;
+	if((_spawner.children = terminalstore_new(sizeof(SpawnerChild), 1))
+			== NULL)
+		return -1;
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		terminalstore_delete(_spawner.children);
+		_spawner.children = NULL;
+		return -1;
+	}
+	if((pid = fork()) < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		terminalstore_delete(_spawner.children);
+		_spawner.children = NULL;
+		return -1;
+	}
+	else if(pid == 0)
+	{
+		close(fds[0]);
+		_spawner_helper(fds[1]);
+	}
+	close(fds[1]);
+	if(fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0
+			|| fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL)
+				| O_NONBLOCK) != 0)
+	{
+		close(fds[0]);
+		waitpid(pid, NULL, 0);
+		terminalstore_delete(_spawner.children);
+		_spawner.children = NULL;
+		return -1;
+	}
+	_spawner.fd = fds[0];
+	_spawner.pid = pid;
+	return 0;
+}
+
+
+/* spawner_stop */
+void spawner_stop(void)
+{
+	if(_spawner.fd < 0)
+		return;
+	/* the helper exits once the connection is closed */
+	close(_spawner.fd);
+	_spawner.fd = -1;
+	while(waitpid(_spawner.pid, NULL, 0) < 0 && errno == EINTR);
+	_spawner.pid = -1;
+	terminalstore_delete(_spawner.children);
+	_spawner.children = NULL;
+	_spawner.pending_cnt = 0;
+	_spawner.in_cnt = 0;
+}
+
+
+/* accessors */
+/* spawner_get_fd */
+int spawner_get_fd(void)
+{
+	return _spawner.fd;
+}
+
+
+/* spawner_get_pending */
+size_t spawner_get_pending(void)
+{
+	return _spawner.pending_cnt;
+}
+
+
+/* spawner_get_pid */
+pid_t spawner_get_pid(void)
+{
+	return _spawner.pid;
+}
+
+
+/* spawner_has_child */
+int spawner_has_child(pid_t pid)
+{
+	if(_spawner.children == NULL || pid <= 0)
+		return 0;
+	return (terminalstore_lookup(_spawner.children, 0, pid, NULL) != NULL)
+		? 1 : 0;
+}
+
+
+/* spawner_set_callback */
+void spawner_set_callback(SpawnerCallback callback, void * data)
+{
+	_spawner.callback = callback;
+	_spawner.data = data;
+}
+
+
+/* useful */
+/* spawner_dispatch */
+int spawner_dispatch(void)
+{
+	Spawner * spawner = &_spawner;
+	SpawnerMessage message;
+	int res;
+
+	if(spawner->fd < 0)
+		return -1;
+	/* the callbacks may spawn and queue further exits */
+	while(spawner->pending_cnt > 0)
+	{
+		message = spawner->pending[0];
+		memmove(&spawner->pending[0], &spawner->pending[1],
+				sizeof(message) * --spawner->pending_cnt);
+		_spawner_exited(spawner, message.pid, message.value);
+	}
+	while((res = _spawner_read(spawner, &message)) > 0)
+		if(message.type == SMT_EXITED)
+			_spawner_exited(spawner, message.pid, message.value);
+	return (res < 0) ? -1 : 0;
+}
+
+
+/* spawner_kill */
+int spawner_kill(pid_t pid, int sig, int group)
+{
+	if(_spawner.fd < 0 || !spawner_has_child(pid))
+	{
+		errno = ESRCH;
+		return -1;
+	}
+	return _spawner_kill(&_spawner, pid, sig, group);
+}
+
+
+/* spawner_spawn */
+int spawner_spawn(char const * file, char * const * argv,
+		char * const * envp, char const * directory,
+		char const * tty, int fd, unsigned int flags, pid_t * pid)
+{
+	Spawner * spawner = &_spawner;
+	SpawnerMessage message;
+	char const * fields[3];
+	char * strings;
+	char * p;
+	size_t i;
+	size_t len;
+	SpawnerChild * child;
+	TerminalStoreHandle handle;
+
+	if(spawner->fd < 0)
+		return 1;
+	memset(&message, 0, sizeof(message));
+	message.type = SMT_SPAWN;
+	message.flags = flags;
+	message.value = (fd >= 0) ? 1 : 0;
+	fields[0] = file;
+	fields[1] = (directory != NULL) ? directory : "";
+	fields[2] = (tty != NULL) ? tty : "";
+	for(i = 0; i < sizeof(fields) / sizeof(*fields); i++)
+		message.size += strlen(fields[i]) + 1;
+	for(; argv[message.argc] != NULL; message.argc++)
+		message.size += strlen(argv[message.argc]) + 1;
+	for(; envp != NULL && envp[message.envc] != NULL; message.envc++)
+		message.size += strlen(envp[message.envc]) + 1;
+	if(message.size > SPAWNER_STRINGS_MAX)
+	{
+		errno = E2BIG;
+		return -1;
+	}
+	if((strings = malloc(sizeof(message) + message.size)) == NULL)
+		return -1;
+	memcpy(strings, &message, sizeof(message));
+	p = &strings[sizeof(message)];
+	for(i = 0; i < sizeof(fields) / sizeof(*fields); i++, p += len)
+		memcpy(p, fields[i], len = strlen(fields[i]) + 1);
+	for(i = 0; i < message.argc; i++, p += len)
+		memcpy(p, argv[i], len = strlen(argv[i]) + 1);
+	for(i = 0; i < message.envc; i++, p += len)
+		memcpy(p, envp[i], len = strlen(envp[i]) + 1);
+	if(_spawner_send(spawner->fd, strings, sizeof(message) + message.size,
+				fd) != 0
+			|| _spawner_wait(spawner, &message) != 0)
+	{
+		/* the connection is closed by the next dispatch */
+		free(strings);
+		return 1;
+	}
+	free(strings);
+	if(message.pid <= 0)
+	{
+		errno = message.value;
+		return -1;
+	}
+	if((child = terminalstore_alloc(spawner->children, &handle)) == NULL
+			|| terminalstore_set_key(spawner->children, handle, 0,
+				message.pid) != 0)
+	{
+		if(child != NULL)
+			terminalstore_free(spawner->children, handle);
+		/* the process cannot be tracked */
+		_spawner_kill(spawner, message.pid, SIGKILL, 0);
+		errno = ENOMEM;
+		return -1;
+	}
+	child->pid = message.pid;
+	*pid = message.pid;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* spawner_kill */
+static int _spawner_kill(Spawner * spawner, pid_t pid, int sig, int group)
+{
+	SpawnerMessage message;
+
+	memset(&message, 0, sizeof(message));
+	message.type = SMT_KILL;
+	message.flags = group ? 1 : 0;
+	message.pid = pid;
+	message.value = sig;
+	return _spawner_write(spawner->fd, &message, sizeof(message));
+}
+
+
+/* spawner_read */
+static int _spawner_read(Spawner * spawner, SpawnerMessage * message)
+{
+	ssize_t res;
+
+	while(spawner->in_cnt < sizeof(spawner->in))
+	{
+		if((res = read(spawner->fd, (char *)&spawner->in
+						+ spawner->in_cnt,
+						sizeof(spawner->in)
+						- spawner->in_cnt)) > 0)
+			spawner->in_cnt += res;
+		else if(res == 0)
+		{
+			errno = EPIPE;
+			return -1;
+		}
+		else if(errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0;
+		else if(errno != EINTR)
+			return -1;
+	}
+	*message = spawner->in;
+	spawner->in_cnt = 0;
+	return 1;
+}
+
+
+/* spawner_wait */
+static int _spawner_wait(Spawner * spawner, SpawnerMessage * message)
+{
+	struct pollfd pfd;
+	int res;
+
+	pfd.fd = spawner->fd;
+	pfd.events = POLLIN;
+	for(;;)
+	{
+		if((res = _spawner_read(spawner, message)) < 0)
+			return -1;
+		else if(res == 0)
+		{
+			if(poll(&pfd, 1, -1) < 0 && errno != EINTR)
+				return -1;
+			continue;
+		}
+		if(message->type == SMT_SPAWNED)
+			return 0;
+		if(message->type != SMT_EXITED)
+			continue;
+		/* the exits are reported later on */
+		if(spawner->pending_cnt < SPAWNER_PENDING_MAX)
+			spawner->pending[spawner->pending_cnt++] = *message;
+		else
+			_spawner_exited(spawner, message->pid, message->value);
+	}
+}
+
+
+/* spawner_send */
+static int _spawner_send(int fd, void const * buf, size_t size, int passed)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	union
+	{
+		struct cmsghdr cmsg;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct cmsghdr * cmsg;
+	struct pollfd pfd;
+	ssize_t res;
+
+	if(passed < 0)
+		return _spawner_write(fd, buf, size);
+	/* the file descriptor is passed along with the first byte */
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = (void *)buf;
+	iov.iov_len = size;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	memset(&control, 0, sizeof(control));
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &passed, sizeof(int));
+	pfd.fd = fd;
+	pfd.events = POLLOUT;
+	while((res = sendmsg(fd, &msg, 0)) < 0)
+		if(errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			if(poll(&pfd, 1, -1) < 0 && errno != EINTR)
+				return -1;
+		}
+		else if(errno != EINTR)
+			return -1;
+	return _spawner_write(fd, (char const *)buf + res, size - res);
+}
+
+
+/* spawner_write */
+static int _spawner_write(int fd, void const * buf, size_t size)
+{
+	char const * p = buf;
+	struct pollfd pfd;
+	ssize_t res;
+
+	pfd.fd = fd;
+	pfd.events = POLLOUT;
+	while(size > 0)
+		if((res = write(fd, p, size)) >= 0)
+		{
+			p += res;
+			size -= res;
+		}
+		else if(errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			if(poll(&pfd, 1, -1) < 0 && errno != EINTR)
+				return -1;
+		}
+		else if(errno != EINTR)
+			return -1;
+	return 0;
+}
+
+
+/* spawner_exited */
+static void _spawner_exited(Spawner * spawner, pid_t pid, int status)
+{
+	TerminalStoreHandle handle;
+
+	if(terminalstore_lookup(spawner->children, 0, pid, &handle) == NULL)
+		return;
+	terminalstore_free(spawner->children, handle);
+	if(spawner->callback != NULL)
+		spawner->callback(spawner->data, pid, status);
+}
+
+
+/* helper */
+/* spawner_helper */
+static void _spawner_helper(int fd)
+{
+	struct sigaction sa;
+	struct pollfd pfds[2];
+	long max;
+	int i;
+	char buf[64];
+
+	/* keep the file descriptors of the terminal out of the processes */
+	if((max = sysconf(_SC_OPEN_MAX)) < 0 || max > SPAWNER_FDS_MAX)
+		max = SPAWNER_FDS_MAX;
+	for(i = 3; i < max; i++)
+		if(i != fd)
+			close(i);
+	if(fcntl(fd, F_SETFD, FD_CLOEXEC) != 0
+			|| pipe(_spawner_helper_pipe) != 0)
+		_exit(2);
+	for(i = 0; i < 2; i++)
+		if(fcntl(_spawner_helper_pipe[i], F_SETFD, FD_CLOEXEC) != 0
+				|| fcntl(_spawner_helper_pipe[i], F_SETFL,
+					O_NONBLOCK) != 0)
+			_exit(2);
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &sa, NULL);
+	sa.sa_handler = _spawner_helper_on_child;
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &sa, NULL);
+	pfds[0].fd = fd;
+	pfds[0].events = POLLIN;
+	pfds[1].fd = _spawner_helper_pipe[0];
+	pfds[1].events = POLLIN;
+	for(;;)
+	{
+		if(poll(pfds, 2, -1) < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		if(pfds[1].revents & POLLIN)
+		{
+			while(read(pfds[1].fd, buf, sizeof(buf)) > 0);
+			_spawner_helper_reap(fd);
+		}
+		if((pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+				&& _spawner_helper_receive(fd) != 0)
+			break;
+	}
+	/* the processes left are reparented */
+	_exit(0);
+}
+
+
+/* spawner_helper_kill */
+static int _spawner_helper_kill(SpawnerMessage const * message)
+{
+	siginfo_t si;
+
+	/* the process identifier is only valid until the child is reaped */
+	memset(&si, 0, sizeof(si));
+	if(waitid(P_PID, message->pid, &si, WEXITED | WNOHANG | WNOWAIT)
+			!= 0)
+		return -1;
+	if(message->flags)
+		kill(-message->pid, message->value);
+	return kill(message->pid, message->value);
+}
+
+
+/* spawner_helper_reap */
+static void _spawner_helper_reap(int fd)
+{
+	SpawnerMessage message;
+	pid_t pid;
+	int status;
+
+	memset(&message, 0, sizeof(message));
+	message.type = SMT_EXITED;
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		message.pid = pid;
+		message.value = status;
+		if(_spawner_write(fd, &message, sizeof(message)) != 0)
+			_exit(2);
+	}
+}
+
+
+/* spawner_helper_receive */
+static int _spawner_helper_receive(int fd)
+{
+	SpawnerMessage message;
+	char * strings;
+	int passed = -1;
+	int error = 0;
+	pid_t pid = -1;
+
+	if(_spawner_helper_recv(fd, &message, sizeof(message), &passed) != 0)
+		return -1;
+	if(message.type == SMT_KILL)
+	{
+		if(passed >= 0)
+			close(passed);
+		_spawner_helper_kill(&message);
+		return 0;
+	}
+	else if(message.type != SMT_SPAWN || message.size > SPAWNER_STRINGS_MAX
+			|| (strings = malloc(message.size + 1)) == NULL)
+	{
+		if(passed >= 0)
+			close(passed);
+		return -1;
+	}
+	if(_spawner_helper_read(fd, strings, message.size) != 0)
+	{
+		if(passed >= 0)
+			close(passed);
+		free(strings);
+		return -1;
+	}
+	strings[message.size] = '\0';
+	if(message.value && passed < 0)
+		error = EBADF;
+	else
+		pid = _spawner_helper_spawn(&message, strings, passed, &error);
+	if(passed >= 0)
+		close(passed);
+	free(strings);
+	memset(&message, 0, sizeof(message));
+	message.type = SMT_SPAWNED;
+	message.pid = pid;
+	message.value = error;
+	return _spawner_write(fd, &message, sizeof(message));
+}
+
+
+/* spawner_helper_spawn */
+static pid_t _spawner_helper_spawn(SpawnerMessage const * message,
+		char * strings, int passed, int * error)
+{
+	pid_t ret = -1;
+	char * fields[3];
+	char ** argv;
+	char ** envp;
+	char * p = strings;
+	char * end = &strings[message->size];
+	size_t i;
+	posix_spawnattr_t attr;
+	posix_spawn_file_actions_t actions;
+	sigset_t set;
+	short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+
+	if(message->argc == 0 || message->argc > message->size
+			|| message->envc > message->size
+			|| (argv = malloc(sizeof(*argv) * (message->argc
+						+ message->envc + 2))) == NULL)
+	{
+		*error = EINVAL;
+		return -1;
+	}
+	envp = &argv[message->argc + 1];
+	for(i = 0; i < 3 + message->argc + message->envc; i++)
+	{
+		if(p >= end)
+		{
+			free(argv);
+			*error = EINVAL;
+			return -1;
+		}
+		if(i < 3)
+			fields[i] = p;
+		else if(i < 3 + message->argc)
+			argv[i - 3] = p;
+		else
+			envp[i - 3 - message->argc] = p;
+		p += strlen(p) + 1;
+	}
+	argv[message->argc] = NULL;
+	envp[message->envc] = NULL;
+	if(message->envc == 0)
+		envp = environ;
+#ifndef SPAWNER_ADDCHDIR
+	if(fields[1][0] != '\0')
+		ret = _spawner_helper_spawn_fork(fields[0], argv, envp,
+				fields[1], fields[2], passed, message->flags,
+				error);
+	else
+#endif
+#ifndef SPAWNER_SETSID
+	if(message->flags & SPAWNER_FLAG_SETSID)
+		ret = _spawner_helper_spawn_fork(fields[0], argv, envp,
+				fields[1], fields[2], passed, message->flags,
+				error);
+	else
+#endif
+	if((*error = posix_spawnattr_init(&attr)) == 0)
+	{
+		sigemptyset(&set);
+		posix_spawnattr_setsigmask(&attr, &set);
+		sigfillset(&set);
+		posix_spawnattr_setsigdefault(&attr, &set);
+#ifdef SPAWNER_SETSID
+		if(message->flags & SPAWNER_FLAG_SETSID)
+			flags |= POSIX_SPAWN_SETSID;
+		else
+#endif
+		if(message->flags & SPAWNER_FLAG_SETPGID)
+		{
+			posix_spawnattr_setpgroup(&attr, 0);
+			flags |= POSIX_SPAWN_SETPGROUP;
+		}
+		posix_spawnattr_setflags(&attr, flags);
+		if((*error = posix_spawn_file_actions_init(&actions)) == 0)
+		{
+			*error = _spawner_helper_actions(&actions, fields[1],
+					fields[2], passed);
+			if(*error == 0)
+				*error = (message->flags
+						& SPAWNER_FLAG_SEARCH_PATH)
+					? posix_spawnp(&ret, fields[0],
+							&actions, &attr, argv,
+							envp)
+					: posix_spawn(&ret, fields[0],
+							&actions, &attr, argv,
+							envp);
+			if(*error != 0)
+				ret = -1;
+			posix_spawn_file_actions_destroy(&actions);
+		}
+		posix_spawnattr_destroy(&attr);
+	}
+	free(argv);
+	return ret;
+}
+
+
+/* spawner_helper_actions */
+static int _spawner_helper_actions(posix_spawn_file_actions_t * actions,
+		char const * directory, char const * tty, int passed)
+{
+	int res;
+
+	/* duplicating clears the close-on-exec flag */
+	if(passed >= 0 && (res = posix_spawn_file_actions_adddup2(actions,
+					passed, SPAWNER_FD)) != 0)
+		return res;
+#ifdef SPAWNER_ADDCHDIR
+	if(directory[0] != '\0' && (res
+				= posix_spawn_file_actions_addchdir_np(actions,
+					directory)) != 0)
+		return res;
+#else
+	(void) directory;
+#endif
+	if(tty[0] == '\0')
+		return 0;
+	/* opened after setsid() as the controlling terminal */
+	if((res = posix_spawn_file_actions_addopen(actions, 0, tty, O_RDWR, 0))
+			!= 0 || (res = posix_spawn_file_actions_adddup2(
+					actions, 0, 1)) != 0)
+		return res;
+	return posix_spawn_file_actions_adddup2(actions, 0, 2);
+}
+
+
+#ifdef SPAWNER_FORK
+/* spawner_helper_spawn_fork */
+static pid_t _spawner_helper_spawn_fork(char const * file, char ** argv,
+		char ** envp, char const * directory, char const * tty,
+		int passed, unsigned int flags, int * error)
+{
+	pid_t pid;
+	int fds[2];
+	int fd;
+	sigset_t set;
+	ssize_t res;
+
+	/* report the errors of the child through a pipe closed on exec() */
+	if(pipe(fds) != 0)
+	{
+		*error = errno;
+		return -1;
+	}
+	if(fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0
+			|| fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0
+			|| (pid = fork()) < 0)
+	{
+		*error = errno;
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	else if(pid == 0)
+	{
+		close(fds[0]);
+		signal(SIGCHLD, SIG_DFL);
+		signal(SIGPIPE, SIG_DFL);
+		sigemptyset(&set);
+		sigprocmask(SIG_SETMASK, &set, NULL);
+		if(flags & SPAWNER_FLAG_SETSID)
+			setsid();
+		else if(flags & SPAWNER_FLAG_SETPGID)
+			setpgid(0, 0);
+		if((passed >= 0 && dup2(passed, SPAWNER_FD) < 0)
+				|| (directory[0] != '\0'
+					&& chdir(directory) != 0))
+			fd = -1;
+		else if(tty[0] == '\0')
+			fd = 0;
+		else if((fd = open(tty, O_RDWR)) >= 0)
+		{
+#ifdef TIOCSCTTY
+			if(flags & SPAWNER_FLAG_SETSID)
+				ioctl(fd, TIOCSCTTY, 0);
+#endif
+			if(dup2(fd, 0) < 0 || dup2(fd, 1) < 0
+					|| dup2(fd, 2) < 0)
+				fd = -1;
+			else if(fd > 2)
+				close(fd);
+		}
+		if(fd >= 0)
+		{
+			environ = envp;
+			if(flags & SPAWNER_FLAG_SEARCH_PATH)
+				execvp(file, argv);
+			else
+				execv(file, argv);
+		}
+		fd = errno;
+		write(fds[1], &fd, sizeof(fd));
+		_exit(127);
+	}
+	close(fds[1]);
+	while((res = read(fds[0], error, sizeof(*error))) < 0
+			&& errno == EINTR);
+	close(fds[0]);
+	if(res <= 0)
+	{
+		*error = 0;
+		return pid;
+	}
+	/* the child failed and has to be reaped here */
+	while(waitpid(pid, NULL, 0) < 0 && errno == EINTR);
+	return -1;
+}
+#endif
+
+
+/* spawner_helper_read */
+static int _spawner_helper_read(int fd, void * buf, size_t size)
+{
+	char * p = buf;
+	ssize_t res;
+
+	while(size > 0)
+		if((res = read(fd, p, size)) > 0)
+		{
+			p += res;
+			size -= res;
+		}
+		else if(res == 0 || errno != EINTR)
+			return -1;
+	return 0;
+}
+
+
+/* spawner_helper_recv */
+static int _spawner_helper_recv(int fd, void * buf, size_t size,
+		int * passed)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	union
+	{
+		struct cmsghdr cmsg;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct cmsghdr * cmsg;
+	ssize_t res;
+	int flags = 0;
+	int f;
+
+#ifdef MSG_CMSG_CLOEXEC
+	flags = MSG_CMSG_CLOEXEC;
+#endif
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = buf;
+	iov.iov_len = size;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	while((res = recvmsg(fd, &msg, flags)) < 0)
+		if(errno != EINTR)
+			return -1;
+	if(res == 0)
+		return -1;
+	for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+			cmsg = CMSG_NXTHDR(&msg, cmsg))
+		if(cmsg->cmsg_level == SOL_SOCKET
+				&& cmsg->cmsg_type == SCM_RIGHTS
+				&& cmsg->cmsg_len == CMSG_LEN(sizeof(int))
+				&& *passed < 0)
+			memcpy(passed, CMSG_DATA(cmsg), sizeof(int));
+	if(*passed >= 0)
+	{
+		fcntl(*passed, F_SETFD, FD_CLOEXEC);
+		/* it has to be duplicated to its final place */
+		if(*passed == SPAWNER_FD)
+		{
+			f = fcntl(*passed, F_DUPFD, SPAWNER_FD + 1);
+			close(*passed);
+			if((*passed = f) >= 0)
+				fcntl(*passed, F_SETFD, FD_CLOEXEC);
+		}
+	}
+	return _spawner_helper_read(fd, (char *)buf + res, size - res);
+}
+
+
+/* callbacks */
+/* spawner_helper_on_child */
+static void _spawner_helper_on_child(int signum)
+{
+	int error = errno;
+	char c = 0;
+
+	(void) signum;
+	/* only async-signal-safe functions may be used */
+	if(write(_spawner_helper_pipe[1], &c, sizeof(c)) < 0)
+	{
+		/* the helper has been woken up already */
+	}
+	errno = error;
+}
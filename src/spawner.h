@@ -0,0 +1,82 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_SPAWNER_H
+# define TERMINAL_SPAWNER_H
+
+# include <sys/types.h>
+
+
+/* Spawner */
+/* public */
+/* constants */
+/* the file descriptor passed to the processes spawned, if any */
+# define SPAWNER_FD	3
+
+
+/* types */
+typedef enum _SpawnerFlag
+{
+	SPAWNER_FLAG_SEARCH_PATH = 0x1,
+	SPAWNER_FLAG_SETPGID = 0x2,
+	/* the terminal then becomes the controlling terminal */
+	SPAWNER_FLAG_SETSID = 0x4
+} SpawnerFlag;
+
+typedef void (*SpawnerCallback)(void * data, pid_t pid, int status);
+
+
+/* functions */
+/* essential */
+/* the helper process has to be started while the process is still small */
+int spawner_start(void);
+void spawner_stop(void);
+
+
+/* accessors */
+int spawner_get_fd(void);
+size_t spawner_get_pending(void);
+pid_t spawner_get_pid(void);
+
+int spawner_has_child(pid_t pid);
+
+void spawner_set_callback(SpawnerCallback callback, void * data);
+
+
+/* useful */
+/* the exits are reported to the callback */
+int spawner_dispatch(void);
+
+/* only signals processes which were not reaped yet */
+int spawner_kill(pid_t pid, int sig, int group);
+
+/* returns 1 if the helper process is not available */
+int spawner_spawn(char const * file, char * const * argv,
+		char * const * envp, char const * directory,
+		char const * tty, int fd, unsigned int flags, pid_t * pid);
+
+#endif /* !TERMINAL_SPAWNER_H */
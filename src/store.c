@@ -0,0 +1,438 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "store.h"
+
+/* constants */
+#define TERMINALSTORE_ALIGN		16
+#define TERMINALSTORE_BLOCK_SIZE	256
+#define TERMINALSTORE_HASH_SIZE		64
+/* handles are made of a generation and the position of the slot */
+#define TERMINALSTORE_GENERATION_SHIFT	24
+#define TERMINALSTORE_SLOT_MASK		0x00ffffff
+#define TERMINALSTORE_SLOTS_MAX		TERMINALSTORE_SLOT_MASK
+#define TERMINALSTORE_TOMBSTONE		0xffffffff
+
+
+/* TerminalStore */
+/* private */
+/* types */
+typedef struct _TerminalStoreSlot
+{
+	uint32_t generation;
+	uint32_t next;
+	int used;
+	uintptr_t keys[];
+} TerminalStoreSlot;
+
+typedef struct _TerminalStoreEntry
+{
+	uintptr_t key;
+	TerminalStoreHandle handle;
+} TerminalStoreEntry;
+
+typedef struct _TerminalStoreHash
+{
+	TerminalStoreEntry * entries;
+	size_t size;
+	size_t count;
+	size_t used;
+} TerminalStoreHash;
+
+struct _TerminalStore
+{
+	size_t size;
+	size_t stride;
+	size_t offset;
+	unsigned int indexes;
+
+	/* records are allocated by blocks and never move */
+	char ** blocks;
+	size_t blocks_cnt;
+	uint32_t slots_cnt;
+	uint32_t free;
+	size_t count;
+
+	TerminalStoreHash * hashes;
+};
+
+
+/* prototypes */
+static int _terminalstore_grow(TerminalStore * store);
+static TerminalStoreSlot * _terminalstore_slot(TerminalStore * store,
+		uint32_t i);
+static TerminalStoreSlot * _terminalstore_slot_handle(TerminalStore * store,
+		TerminalStoreHandle handle);
+
+static size_t _terminalstore_hash(TerminalStoreHash * hash, uintptr_t key);
+static TerminalStoreEntry * _terminalstore_hash_find(TerminalStoreHash * hash,
+		uintptr_t key);
+static int _terminalstore_hash_grow(TerminalStoreHash * hash);
+static int _terminalstore_hash_insert(TerminalStoreHash * hash,
+		uintptr_t key, TerminalStoreHandle handle);
+static void _terminalstore_hash_remove(TerminalStoreHash * hash,
+		uintptr_t key);
+
+
+/* public */
+/* functions */
+/* terminalstore_new */
+TerminalStore * terminalstore_new(size_t size, unsigned int indexes)
+{
+	TerminalStore * store;
+	const size_t align = TERMINALSTORE_ALIGN - 1;
+
+	if((store = malloc(sizeof(*store))) == NULL)
+		return NULL;
+	memset(store, 0, sizeof(*store));
+	store->size = size;
+	store->indexes = indexes;
+	/* each slot holds its header, its keys, and then the record */
+	store->offset = (offsetof(TerminalStoreSlot, keys)
+			+ sizeof(uintptr_t) * indexes + align) & ~align;
+	store->stride = (store->offset + size + align) & ~align;
+	store->free = TERMINALSTORE_SLOTS_MAX;
+	if(indexes > 0 && (store->hashes = calloc(indexes,
+					sizeof(*store->hashes))) == NULL)
+	{
+		free(store);
+		return NULL;
+	}
+	return store;
+}
+
+
+/* terminalstore_delete */
+void terminalstore_delete(TerminalStore * store)
+{
+	size_t i;
+
+	for(i = 0; i < store->indexes; i++)
+		free(store->hashes[i].entries);
+	free(store->hashes);
+	for(i = 0; i < store->blocks_cnt; i++)
+		free(store->blocks[i]);
+	free(store->blocks);
+	free(store);
+}
+
+
+/* accessors */
+/* terminalstore_get_count */
+size_t terminalstore_get_count(TerminalStore * store)
+{
+	return store->count;
+}
+
+
+/* terminalstore_get */
+void * terminalstore_get(TerminalStore * store, TerminalStoreHandle handle)
+{
+	TerminalStoreSlot * slot;
+
+	if((slot = _terminalstore_slot_handle(store, handle)) == NULL)
+		return NULL;
+	return (char *)slot + store->offset;
+}
+
+
+/* terminalstore_get_next */
+void * terminalstore_get_next(TerminalStore * store,
+		TerminalStoreHandle * handle)
+{
+	TerminalStoreSlot * slot;
+	uint32_t i;
+
+	/* start after the current handle, if any */
+	i = (*handle != TERMINALSTORE_HANDLE_NONE)
+		? (*handle & TERMINALSTORE_SLOT_MASK) : 0;
+	for(; i < store->slots_cnt; i++)
+	{
+		slot = _terminalstore_slot(store, i);
+		if(!slot->used)
+			continue;
+		*handle = (slot->generation << TERMINALSTORE_GENERATION_SHIFT)
+			| (i + 1);
+		return (char *)slot + store->offset;
+	}
+	*handle = TERMINALSTORE_HANDLE_NONE;
+	return NULL;
+}
+
+
+/* terminalstore_set_key */
+int terminalstore_set_key(TerminalStore * store, TerminalStoreHandle handle,
+		unsigned int index, uintptr_t key)
+{
+	TerminalStoreSlot * slot;
+
+	if(index >= store->indexes
+			|| (slot = _terminalstore_slot_handle(store, handle))
+			== NULL)
+		return -1;
+	if(slot->keys[index] == key)
+		return 0;
+	/* keys must be unique */
+	if(key != 0 && _terminalstore_hash_find(&store->hashes[index], key)
+			!= NULL)
+		return -1;
+	if(slot->keys[index] != 0)
+		_terminalstore_hash_remove(&store->hashes[index],
+				slot->keys[index]);
+	slot->keys[index] = 0;
+	if(key != 0 && _terminalstore_hash_insert(&store->hashes[index], key,
+				handle) != 0)
+		return -1;
+	slot->keys[index] = key;
+	return 0;
+}
+
+
+/* useful */
+/* terminalstore_alloc */
+void * terminalstore_alloc(TerminalStore * store,
+		TerminalStoreHandle * handle)
+{
+	TerminalStoreSlot * slot;
+	uint32_t i;
+
+	if(store->free != TERMINALSTORE_SLOTS_MAX)
+	{
+		/* re-use the slot released last */
+		i = store->free;
+		slot = _terminalstore_slot(store, i);
+		store->free = slot->next;
+	}
+	else
+	{
+		if(store->slots_cnt >= TERMINALSTORE_SLOTS_MAX)
+			return NULL;
+		if(store->slots_cnt == store->blocks_cnt
+				* TERMINALSTORE_BLOCK_SIZE
+				&& _terminalstore_grow(store) != 0)
+			return NULL;
+		i = store->slots_cnt++;
+		slot = _terminalstore_slot(store, i);
+		slot->generation = 0;
+	}
+	slot->next = TERMINALSTORE_SLOTS_MAX;
+	slot->used = 1;
+	memset(slot->keys, 0, sizeof(*slot->keys) * store->indexes);
+	memset((char *)slot + store->offset, 0, store->size);
+	store->count++;
+	if(handle != NULL)
+		*handle = (slot->generation << TERMINALSTORE_GENERATION_SHIFT)
+			| (i + 1);
+	return (char *)slot + store->offset;
+}
+
+
+/* terminalstore_free */
+void terminalstore_free(TerminalStore * store, TerminalStoreHandle handle)
+{
+	TerminalStoreSlot * slot;
+	unsigned int i;
+
+	if((slot = _terminalstore_slot_handle(store, handle)) == NULL)
+		return;
+	for(i = 0; i < store->indexes; i++)
+		if(slot->keys[i] != 0)
+			_terminalstore_hash_remove(&store->hashes[i],
+					slot->keys[i]);
+	/* invalidate the handles to this slot */
+	slot->generation = (slot->generation + 1)
+		& (0xffffffff >> TERMINALSTORE_GENERATION_SHIFT);
+	slot->used = 0;
+	slot->next = store->free;
+	store->free = (handle & TERMINALSTORE_SLOT_MASK) - 1;
+	store->count--;
+}
+
+
+/* terminalstore_lookup */
+void * terminalstore_lookup(TerminalStore * store, unsigned int index,
+		uintptr_t key, TerminalStoreHandle * handle)
+{
+	TerminalStoreEntry * entry;
+
+	if(index >= store->indexes || key == 0
+			|| (entry = _terminalstore_hash_find(
+					&store->hashes[index], key)) == NULL)
+		return NULL;
+	if(handle != NULL)
+		*handle = entry->handle;
+	return terminalstore_get(store, entry->handle);
+}
+
+
+/* private */
+/* functions */
+/* terminalstore_grow */
+static int _terminalstore_grow(TerminalStore * store)
+{
+	char ** p;
+
+	if((p = realloc(store->blocks, sizeof(*p) * (store->blocks_cnt + 1)))
+			== NULL)
+		return -1;
+	store->blocks = p;
+	if((p[store->blocks_cnt] = malloc(store->stride
+					* TERMINALSTORE_BLOCK_SIZE)) == NULL)
+		return -1;
+	store->blocks_cnt++;
+	return 0;
+}
+
+
+/* terminalstore_slot */
+static TerminalStoreSlot * _terminalstore_slot(TerminalStore * store,
+		uint32_t i)
+{
+	return (TerminalStoreSlot *)(store->blocks[i
+			/ TERMINALSTORE_BLOCK_SIZE] + store->stride
+			* (i % TERMINALSTORE_BLOCK_SIZE));
+}
+
+
+/* terminalstore_slot_handle */
+static TerminalStoreSlot * _terminalstore_slot_handle(TerminalStore * store,
+		TerminalStoreHandle handle)
+{
+	TerminalStoreSlot * slot;
+	uint32_t i = handle & TERMINALSTORE_SLOT_MASK;
+
+	if(i == 0 || i > store->slots_cnt)
+		return NULL;
+	slot = _terminalstore_slot(store, i - 1);
+	if(!slot->used || slot->generation
+			!= (handle >> TERMINALSTORE_GENERATION_SHIFT))
+		return NULL;
+	return slot;
+}
+
+
+/* hashes */
+/* terminalstore_hash */
+static size_t _terminalstore_hash(TerminalStoreHash * hash, uintptr_t key)
+{
+	uint64_t h = key;
+
+	/* Fibonacci hashing spreads pointers and sequential values */
+	h *= 0x9e3779b97f4a7c15ULL;
+	return (size_t)(h >> 32) & (hash->size - 1);
+}
+
+
+/* terminalstore_hash_find */
+static TerminalStoreEntry * _terminalstore_hash_find(TerminalStoreHash * hash,
+		uintptr_t key)
+{
+	TerminalStoreEntry * entry;
+	size_t i;
+
+	if(hash->count == 0)
+		return NULL;
+	for(i = _terminalstore_hash(hash, key);; i = (i + 1) & (hash->size - 1))
+	{
+		entry = &hash->entries[i];
+		if(entry->handle == TERMINALSTORE_HANDLE_NONE)
+			return NULL;
+		if(entry->handle != TERMINALSTORE_TOMBSTONE
+				&& entry->key == key)
+			return entry;
+	}
+}
+
+
+/* terminalstore_hash_grow */
+static int _terminalstore_hash_grow(TerminalStoreHash * hash)
+{
+	TerminalStoreHash h;
+	size_t i;
+
+	/* only grow if the tombstones are not the issue */
+	h.size = (hash->size == 0) ? TERMINALSTORE_HASH_SIZE
+		: ((hash->count * 2 >= hash->size / 2) ? hash->size * 2
+				: hash->size);
+	if((h.entries = calloc(h.size, sizeof(*h.entries))) == NULL)
+		return -1;
+	h.count = 0;
+	h.used = 0;
+	for(i = 0; i < hash->size; i++)
+		if(hash->entries[i].handle != TERMINALSTORE_HANDLE_NONE
+				&& hash->entries[i].handle
+				!= TERMINALSTORE_TOMBSTONE)
+			_terminalstore_hash_insert(&h, hash->entries[i].key,
+					hash->entries[i].handle);
+	free(hash->entries);
+	*hash = h;
+	return 0;
+}
+
+
+/* terminalstore_hash_insert */
+static int _terminalstore_hash_insert(TerminalStoreHash * hash,
+		uintptr_t key, TerminalStoreHandle handle)
+{
+	TerminalStoreEntry * entry;
+	size_t i;
+
+	/* keep the load factor below one half */
+	if((hash->used + 1) * 2 > hash->size
+			&& _terminalstore_hash_grow(hash) != 0)
+		return -1;
+	for(i = _terminalstore_hash(hash, key);; i = (i + 1) & (hash->size - 1))
+	{
+		entry = &hash->entries[i];
+		if(entry->handle == TERMINALSTORE_HANDLE_NONE)
+		{
+			hash->used++;
+			break;
+		}
+		if(entry->handle == TERMINALSTORE_TOMBSTONE)
+			break;
+	}
+	entry->key = key;
+	entry->handle = handle;
+	hash->count++;
+	return 0;
+}
+
+
+/* terminalstore_hash_remove */
+static void _terminalstore_hash_remove(TerminalStoreHash * hash,
+		uintptr_t key)
+{
+	TerminalStoreEntry * entry;
+
+	if((entry = _terminalstore_hash_find(hash, key)) == NULL)
+		return;
+	entry->handle = TERMINALSTORE_TOMBSTONE;
+	hash->count--;
+}
@@ -0,0 +1,70 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_STORE_H
+# define TERMINAL_STORE_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+
+/* TerminalStore */
+/* public */
+/* types */
+typedef struct _TerminalStore TerminalStore;
+
+/* handles remain valid until the record is released */
+typedef uint32_t TerminalStoreHandle;
+
+# define TERMINALSTORE_HANDLE_NONE	0
+
+
+/* functions */
+/* essential */
+TerminalStore * terminalstore_new(size_t size, unsigned int indexes);
+void terminalstore_delete(TerminalStore * store);
+
+
+/* accessors */
+size_t terminalstore_get_count(TerminalStore * store);
+void * terminalstore_get(TerminalStore * store, TerminalStoreHandle handle);
+void * terminalstore_get_next(TerminalStore * store,
+		TerminalStoreHandle * handle);
+
+int terminalstore_set_key(TerminalStore * store, TerminalStoreHandle handle,
+		unsigned int index, uintptr_t key);
+
+
+/* useful */
+void * terminalstore_alloc(TerminalStore * store,
+		TerminalStoreHandle * handle);
+void terminalstore_free(TerminalStore * store, TerminalStoreHandle handle);
+
+void * terminalstore_lookup(TerminalStore * store, unsigned int index,
+		uintptr_t key, TerminalStoreHandle * handle);
+
+#endif /* !TERMINAL_STORE_H */
@@ -29,21 +29,36 @@ static char const _license[] =
 
 
 
+#include <sys/stat.h>
 #include <sys/wait.h>
+#include <unistd.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <signal.h>
+#include <time.h>
 #include <errno.h>
 #include <libintl.h>
+#include <glib-unix.h>
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
-#if GTK_CHECK_VERSION(3, 0, 0)
-# include <gtk/gtkx.h>
-#endif
 #include <System.h>
 #include <Desktop.h>
+#include "Terminal/widget.h"
+#include "backend.h"
+#include "control.h"
+#include "history.h"
+#include "journal.h"
+#include "metrics.h"
+#include "monitor.h"
+#include "priority.h"
+#include "proc.h"
+#include "reaper.h"
+#include "session.h"
+#include "store.h"
 #include "terminal.h"
+#include "trace.h"
 #include "../config.h"
 #define _(string) gettext(string)
 #define N_(string) (string)
@@ -52,12 +67,26 @@ static char const _license[] =
 #ifndef PROGNAME_TERMINAL
 # define PROGNAME_TERMINAL	"terminal"
 #endif
-#ifndef PREFIX
-# define PREFIX			"/usr/local"
-#endif
-#ifndef BINDIR
-# define BINDIR			PREFIX "/bin"
-#endif
+#define TERMINAL_CONFIG_FILE	".terminal"
+#define TERMINAL_CONTROL_COUNT	256
+#define TERMINAL_HISTORY_DIRECTORY	".terminal-history"
+/* the rest of the scrollback is kept in the history */
+#define TERMINAL_HISTORY_SAVELINES	"100"
+#define TERMINAL_JOURNAL_FILE	".terminal-journal"
+#define TERMINAL_JOURNAL_INTERVAL	5000
+#define TERMINAL_JOURNAL_STAGGER	250
+#define TERMINAL_METRICS_REAPING	16
+#define TERMINAL_MONITOR_INTERVAL	1000
+#define TERMINAL_MONITOR_MEMORY	5000
+#define TERMINAL_RECORDING_DIRECTORY	".terminal-recordings"
+#define TERMINAL_RESIZE_COUNT	10
+#define TERMINAL_RESIZE_DELAY	100
+#define TERMINAL_RESIZE_INTERVAL	50
+#define TERMINAL_SEARCH_COUNT	100
+#define TERMINAL_SEARCH_LINE	256
+#define TERMINAL_SESSION_DELAY	1000000
+#define TERMINAL_WATCHDOG_INTERVAL	2000
+#define TERMINAL_WATCHDOG_TIMEOUT	5000
 
 
 /* Terminal */
@@ -65,6 +94,49 @@ static char const _license[] =
 /* types */
 typedef struct _TerminalTab TerminalTab;
 
+typedef enum _TerminalTabIndex
+{
+	TTI_PID = 0,
+	TTI_PAGE
+} TerminalTabIndex;
+#define TTI_LAST TTI_PAGE
+#define TTI_COUNT (TTI_LAST + 1)
+
+typedef struct _TerminalReaping
+{
+	GPid pid;
+	unsigned int id;
+	gint64 closed;
+} TerminalReaping;
+
+typedef struct _TerminalJournalRestore
+{
+	Terminal * terminal;
+	unsigned int window;
+} TerminalJournalRestore;
+
+typedef struct _TerminalSearch
+{
+	GString * reply;
+	TerminalTab * tab;
+	unsigned int count;
+	unsigned int cnt;
+} TerminalSearch;
+
+#ifndef EMBEDDED
+typedef enum _TerminalActivityColumn
+{
+	TAC_HANDLE = 0,
+	TAC_LABEL,
+	TAC_LOAD,
+	TAC_MEMORY,
+	TAC_PROCESSES,
+	TAC_STATE
+} TerminalActivityColumn;
+# define TAC_LAST TAC_STATE
+# define TAC_COUNT (TAC_LAST + 1)
+#endif
+
 struct _Terminal
 {
 	char * shell;
@@ -72,30 +144,185 @@ struct _Terminal
 	unsigned int login;
 
 	/* internal */
-	TerminalTab ** tabs;
+	unsigned int id;
+	Config * config;
+	TerminalBackendDefinition const * backend;
+	TerminalStore * tabs;
 	size_t tabs_cnt;
+	TerminalReaper * reaper;
+	guint source;
+
+	/* tabs closed while their process was running */
+	TerminalReaping reaping[TERMINAL_METRICS_REAPING];
+	size_t reaping_pos;
+
+	/* shutdown */
+	gboolean closing;
+	unsigned int shutdown_timeout;
+	unsigned int shutdown_tree;
+
+	/* pool of xterms started in advance */
+	TerminalTab ** pool;
+	size_t pool_cnt;
+	size_t pool_size;
+	guint pool_source;
+	unsigned long pool_hits;
+	unsigned long pool_misses;
+
+	/* shells kept running in sessions */
+	unsigned int sessions;
+	unsigned int sessions_replay;
+
+	/* output of the sessions recorded */
+	unsigned int recording;
+	unsigned int recording_size;
+
+	/* text of the output of the sessions kept */
+	unsigned int history;
+	unsigned int history_size;
+
+	/* output of the sessions skipped when flooding */
+	unsigned int flood;
+	unsigned int flood_rate;
+
+	/* tabs in the background */
+	unsigned int priority;
+	unsigned int freeze;
+	TerminalTab * foreground;
+	gulong switch_handler;
+
+	/* journal, with the tabs restored spawned once shown or in turn */
+	gulong reorder_handler;
+	guint journal_source;
+
+	/* activity of the tabs, memory in kilobytes */
+	unsigned int monitor;
+	unsigned int monitor_interval;
+	unsigned int monitor_memory;
+	unsigned int monitor_tab;
+	unsigned int monitor_window;
+	unsigned int monitor_background;
+	unsigned int monitor_signal;
+	guint monitor_source;
+	guint monitor_period;
+	gint64 monitor_sampled;
+
+	/* terminal emulators not responding, in milliseconds */
+	unsigned int watchdog_interval;
+	unsigned int watchdog_timeout;
+	guint watchdog_source;
 
 	/* widgets */
 	GtkWidget * window;
+	GtkAccelGroup * group;
 	gboolean fullscreen;
+	GtkWidget * vbox;
+	guint vbox_source;
 #ifndef EMBEDDED
+	GtkAccelGroup * accel;
 	GtkWidget * menubar;
 #endif
 	GtkToolItem * tb_fullscreen;
 	GtkWidget * notebook;
+#ifndef EMBEDDED
+	GtkWidget * activity;
+	GtkListStore * activity_store;
+#endif
 };
 
 struct _TerminalTab
 {
 	Terminal * terminal;
+	TerminalStoreHandle handle;
+	unsigned int id;
+	gboolean pooled;
 	GtkWidget * widget;
 	GtkWidget * label;
-	GtkWidget * socket;
+	gboolean renamed;
+	GtkWidget * warning;
+	GtkWidget * activity;
+	GtkWidget * page;
+	GtkWidget * view;
 	GPid pid;
-	guint source;
+	gboolean ready;
+	gboolean opening;
+	gint64 spawned;
+
+	/* backend */
+	TerminalBackendDefinition const * definition;
+	TerminalWidget * backend;
+	TerminalWidgetHelper helper;
+
+	/* settings at the time the tab was started */
+	char * shell;
+	char * directory;
+	unsigned int login;
+
+	/* session, if the shell is not started by the backend */
+	TerminalSession * session;
+	gint64 attached;
+	gulong resize_handler;
+	guint resize_source;
+	unsigned int resize_cnt;
+
+	/* size of the page, applied to the view lazily */
+	gint width;
+	gint height;
+	gboolean size_pending;
+	gint64 sized;
+	guint size_source;
+
+	/* scheduling */
+	gboolean background;
+	gboolean frozen;
+
+	/* activity */
+	TerminalMonitorTree * tree;
+	TerminalMonitorUsage usage;
+	gboolean exceeded;
+	gboolean finished;
+	gboolean listed;
+
+	/* watchdog */
+	GtkWidget * kill;
+	gint64 watched;
+	unsigned long cpu;			/* in milliseconds */
+	gint64 suspected;
+	gint64 hung;
+
+	/* journal */
+	gboolean deferred;
+	gboolean crashed;
+	GPid journal_pid;
+	char * journaled;
 };
 
 
+/* variables */
+static Terminal ** _terminal_windows = NULL;
+static size_t _terminal_windows_cnt = 0;
+
+/* identifiers of the windows and tabs opened, never reused */
+static unsigned int _terminal_windows_id = 0;
+static unsigned int _terminal_tabs_id = 0;
+
+/* shared by every window, configured along with the first one */
+static TerminalControl * _terminal_control = NULL;
+static TerminalPriority * _terminal_priority = NULL;
+static TerminalMonitor * _terminal_monitor = NULL;
+static TerminalMetrics * _terminal_metrics = NULL;
+static GIOChannel * _terminal_metrics_channel = NULL;
+static guint _terminal_metrics_source = 0;
+static guint _terminal_metrics_signal = 0;
+static String * _terminal_metrics_file = NULL;
+static String * _terminal_metrics_events = NULL;
+static TerminalJournal * _terminal_journal = NULL;
+static unsigned int _terminal_journal_lazy = 0;
+static unsigned int _terminal_journal_stagger = 0;
+static guint _terminal_journal_source = 0;
+static gboolean _terminal_journal_restoring = FALSE;
+
+
 /* constants */
 #ifndef EMBEDDED
 static char const * _authors[] =
@@ -107,27 +334,146 @@ static char const * _authors[] =
 
 
 /* prototypes */
+/* accessors */
+static TerminalBackendDefinition const * _terminal_get_config_backend(
+		Terminal * terminal);
+static unsigned int _terminal_get_config_uint(Terminal * terminal,
+		char const * section, char const * variable,
+		unsigned int fallback);
+
 /* useful */
-static int _terminal_open_tab(Terminal * terminal);
+static int _terminal_config_load(Terminal * terminal);
+static void _terminal_config_control(Terminal * terminal);
+static void _terminal_config_journal(Terminal * terminal,
+		unsigned int restore);
+static void _terminal_config_metrics(Terminal * terminal);
+static void _terminal_config_monitor(Terminal * terminal);
+static void _terminal_config_priority(Terminal * terminal);
+static void _terminal_config_watchdog(Terminal * terminal);
+
+static TerminalTab * _terminal_open_tab(Terminal * terminal,
+		TerminalBackendDefinition const * definition,
+		TerminalPrefs const * prefs, TerminalSession * session);
 static int _terminal_open_window(Terminal * terminal);
-static void _terminal_close_tab(Terminal * terminal, unsigned int i);
+static void _terminal_close(Terminal * terminal);
+static void _terminal_close_tab(Terminal * terminal, TerminalTab * tab);
 static void _terminal_close_all(Terminal * terminal);
 
+static TerminalTab * _terminal_pool_get(Terminal * terminal);
+static void _terminal_pool_refill(Terminal * terminal);
+static void _terminal_pool_remove(Terminal * terminal, size_t i);
+
+#ifndef EMBEDDED
+/* activity */
+static void _terminal_activity_update(Terminal * terminal);
+
+#endif
+/* control */
+static void _terminal_control_append_tab(GString * reply, TerminalTab * tab);
+static void _terminal_control_event(TerminalTab * tab, char const * event,
+		char const * members);
+static void _terminal_control_exited(TerminalTab * tab, char const * process,
+		GPid pid, int status);
+static TerminalTab * _terminal_control_get_tab(
+		TerminalControlRequest const * request);
+static Terminal * _terminal_control_get_window(
+		TerminalControlRequest const * request);
+
+/* journal */
+static void _terminal_journal_remove(Terminal * terminal, TerminalTab * tab);
+static int _terminal_journal_restore(Terminal * terminal);
+static void _terminal_journal_tab(TerminalTab * tab);
+
+/* metrics */
+static void _terminal_metrics_event(TerminalTab * tab,
+		TerminalMetricsEventType type, GPid pid, long value);
+static void _terminal_metrics_exited(TerminalTab * tab, GPid pid,
+		int status);
+static int _terminal_metrics_export(char const * filename, int events);
+static void _terminal_metrics_reaped(Terminal * terminal, GPid pid);
+
+/* tabs */
+static TerminalTab * _terminal_tab_new(Terminal * terminal,
+		TerminalBackendDefinition const * definition,
+		TerminalPrefs const * prefs, TerminalSession * session);
+static void _terminal_tab_delete(Terminal * terminal, TerminalTab * tab);
+static int _terminal_tab_attach(Terminal * terminal, TerminalTab * tab);
+static void _terminal_tab_detach(Terminal * terminal, TerminalTab * tab);
+static int _terminal_tab_get_directory(TerminalTab * tab, char * buf,
+		size_t size);
+static int _terminal_tab_history(Terminal * terminal, TerminalTab * tab);
+static gboolean _terminal_tab_matches(Terminal * terminal, TerminalTab * tab);
+static void _terminal_tab_monitor(Terminal * terminal, TerminalTab * tab,
+		int memory);
+static int _terminal_tab_record(Terminal * terminal, TerminalTab * tab);
+static void _terminal_tab_resize(TerminalTab * tab);
+static void _terminal_tab_set_background(Terminal * terminal,
+		TerminalTab * tab, gboolean background);
+static void _terminal_tab_set_budget(Terminal * terminal, TerminalTab * tab,
+		gboolean exceeded);
+static void _terminal_tab_set_finished(TerminalTab * tab, gboolean finished);
+static void _terminal_tab_set_hung(TerminalTab * tab, gboolean hung,
+		gint64 now);
+static void _terminal_tab_set_label(TerminalTab * tab, char const * label);
+static void _terminal_tab_set_size(TerminalTab * tab);
+static int _terminal_tab_spawn(Terminal * terminal, TerminalTab * tab);
+static void _terminal_tab_thaw(TerminalTab * tab);
+static void _terminal_tab_watch(Terminal * terminal, TerminalTab * tab,
+		gint64 now);
+
 /* callbacks */
-static void _terminal_on_child_watch(GPid pid, gint status, gpointer data);
+static void _terminal_on_child_watch(void * data, GPid pid, int status);
 static void _terminal_on_close(gpointer data);
 static gboolean _terminal_on_closex(gpointer data);
+static int _terminal_on_control(void * data, char const * command,
+		TerminalControlRequest const * request, GString * reply);
+static gboolean _terminal_on_delete(gpointer data);
 static void _terminal_on_fullscreen(gpointer data);
+static gboolean _terminal_on_journal(gpointer data);
+static gboolean _terminal_on_journal_spawn(gpointer data);
+static gboolean _terminal_on_metrics(GIOChannel * channel,
+		GIOCondition condition, gpointer data);
+static gboolean _terminal_on_metrics_signal(gpointer data);
+static gboolean _terminal_on_monitor(gpointer data);
 static void _terminal_on_new_tab(gpointer data);
 static void _terminal_on_new_window(gpointer data);
+static void _terminal_on_page_reordered(GtkWidget * widget, GtkWidget * page,
+		guint num, gpointer data);
+static gboolean _terminal_on_pool_fill(gpointer data);
+static void _terminal_on_shutdown(void * data,
+		TerminalReaperReport const * report);
+static void _terminal_on_switch_page(GtkWidget * widget, gpointer page,
+		guint num, gpointer data);
 static void _terminal_on_tab_close(gpointer data);
+static void _terminal_on_tab_kill(gpointer data);
+static char const * _terminal_on_tab_config_get(void * data,
+		char const * variable);
+static void _terminal_on_tab_page_allocate(GtkWidget * widget,
+		GtkAllocation * allocation, gpointer data);
+static void _terminal_on_tab_ready(void * data);
 static void _terminal_on_tab_rename(gpointer data);
+static gboolean _terminal_on_tab_resize(gpointer data);
+static void _terminal_on_tab_session(void * data, TerminalSession * session,
+		int status);
+static gboolean _terminal_on_tab_size(gpointer data);
+static void _terminal_on_tab_size_allocate(gpointer data);
+static void _terminal_on_tab_title(void * data, char const * title);
+static gboolean _terminal_on_vbox(gpointer data);
+static gboolean _terminal_on_watchdog(gpointer data);
 
 #ifndef EMBEDDED
+static void _terminal_on_activity_activated(GtkTreeView * view,
+		GtkTreePath * path, GtkTreeViewColumn * column, gpointer data);
+static gboolean _terminal_on_activity_closex(gpointer data);
 static void _terminal_on_file_close(gpointer data);
 static void _terminal_on_file_close_all(gpointer data);
+static void _terminal_on_file_detach(gpointer data);
 static void _terminal_on_file_new_tab(gpointer data);
+static void _terminal_on_file_new_tab_native(gpointer data);
+static void _terminal_on_file_new_tab_xterm(gpointer data);
 static void _terminal_on_file_new_window(gpointer data);
+static void _terminal_on_file_reattach(gpointer data);
+static void _terminal_on_view_activity(gpointer data);
 static void _terminal_on_view_fullscreen(gpointer data);
 static void _terminal_on_help_about(gpointer data);
 static void _terminal_on_help_contents(gpointer data);
@@ -141,9 +487,18 @@ static const DesktopMenu _terminal_file_menu[] =
 {
 	{ N_("New _tab"), G_CALLBACK(_terminal_on_file_new_tab), "tab-new",
 		GDK_CONTROL_MASK, GDK_KEY_T },
+	{ N_("New _xterm tab"), G_CALLBACK(_terminal_on_file_new_tab_xterm),
+		NULL, 0, 0 },
+	{ N_("New n_ative tab"), G_CALLBACK(_terminal_on_file_new_tab_native),
+		NULL, 0, 0 },
 	{ N_("_New window"), G_CALLBACK(_terminal_on_file_new_window),
 		"window-new", GDK_CONTROL_MASK, GDK_KEY_N },
 	{ "", NULL, NULL, 0, 0 },
+	{ N_("_Detach tab"), G_CALLBACK(_terminal_on_file_detach), NULL, 0,
+		0 },
+	{ N_("_Reattach session..."), G_CALLBACK(_terminal_on_file_reattach),
+		NULL, 0, 0 },
+	{ "", NULL, NULL, 0, 0 },
 	{ N_("_Close"), G_CALLBACK(_terminal_on_file_close), GTK_STOCK_CLOSE,
 		GDK_CONTROL_MASK, GDK_KEY_W },
 	{ N_("Close all tabs"), G_CALLBACK(_terminal_on_file_close_all), NULL,
@@ -153,6 +508,8 @@ static const DesktopMenu _terminal_file_menu[] =
 
 static const DesktopMenu _terminal_view_menu[] =
 {
+	{ N_("_Activity"), G_CALLBACK(_terminal_on_view_activity), NULL, 0,
+		0 },
 	{ N_("_Fullscreen"), G_CALLBACK(_terminal_on_view_fullscreen),
 # if GTK_CHECK_VERSION(2, 8, 0)
 		GTK_STOCK_FULLSCREEN,
@@ -183,6 +540,20 @@ static const DesktopMenubar _terminal_menubar[] =
 	{ N_("_Help"), _terminal_help_menu },
 	{ NULL, NULL }
 };
+
+/* accelerators until the menubar is created */
+static const DesktopAccel _terminal_accel[] =
+{
+	{ G_CALLBACK(_terminal_on_file_new_tab), GDK_CONTROL_MASK, GDK_KEY_T },
+	{ G_CALLBACK(_terminal_on_file_new_window), GDK_CONTROL_MASK,
+		GDK_KEY_N },
+	{ G_CALLBACK(_terminal_on_file_close), GDK_CONTROL_MASK, GDK_KEY_W },
+	{ G_CALLBACK(_terminal_on_file_close_all),
+		GDK_SHIFT_MASK | GDK_CONTROL_MASK, GDK_KEY_W },
+	{ G_CALLBACK(_terminal_on_view_fullscreen), 0, GDK_KEY_F11 },
+	{ G_CALLBACK(_terminal_on_help_contents), 0, GDK_KEY_F1 },
+	{ NULL, 0, 0 }
+};
 #endif
 
 static DesktopToolbar _terminal_toolbar[] =
@@ -202,35 +573,163 @@ static DesktopToolbar _terminal_toolbar[] =
 Terminal * terminal_new(TerminalPrefs * prefs)
 {
 	Terminal * terminal;
-	GtkAccelGroup * group;
-	GtkWidget * vbox;
-	GtkWidget * widget;
-	GtkToolItem * toolitem;
+	Terminal ** p;
+	int res;
 
+	trace_begin("terminal_new");
 	if((terminal = object_new(sizeof(*terminal))) == NULL)
+	{
+		trace_end("terminal_new");
+		return NULL;
+	}
+	if((p = realloc(_terminal_windows, sizeof(*p)
+					* (_terminal_windows_cnt + 1))) == NULL)
+	{
+		object_delete(terminal);
+		trace_end("terminal_new");
 		return NULL;
+	}
+	_terminal_windows = p;
+	_terminal_windows[_terminal_windows_cnt++] = terminal;
+	terminal->id = ++_terminal_windows_id;
 	terminal->shell = (prefs != NULL && prefs->shell != NULL)
 		? string_new(prefs->shell) : NULL;
 	terminal->directory = (prefs != NULL && prefs->directory != NULL)
 		? string_new(prefs->directory) : NULL;
 	terminal->login = (prefs != NULL) ? prefs->login : 0;
-	terminal->tabs = NULL;
+	terminal->config = config_new();
+	terminal->backend = &backend_xterm;
+	terminal->tabs = terminalstore_new(sizeof(TerminalTab), TTI_COUNT);
 	terminal->tabs_cnt = 0;
+	terminal->reaper = terminalreaper_new(_terminal_on_child_watch,
+			terminal);
+	terminal->source = 0;
+	memset(terminal->reaping, 0, sizeof(terminal->reaping));
+	terminal->reaping_pos = 0;
+	terminal->closing = FALSE;
+	terminal->shutdown_timeout = 0;
+	terminal->shutdown_tree = 0;
+	terminal->pool = NULL;
+	terminal->pool_cnt = 0;
+	terminal->pool_size = 0;
+	terminal->pool_source = 0;
+	terminal->pool_hits = 0;
+	terminal->pool_misses = 0;
+	terminal->sessions = 0;
+	terminal->sessions_replay = 0;
+	terminal->recording = 0;
+	terminal->recording_size = 0;
+	terminal->history = 0;
+	terminal->history_size = 0;
+	terminal->flood = 0;
+	terminal->flood_rate = 0;
+	terminal->priority = 0;
+	terminal->freeze = 0;
+	terminal->foreground = NULL;
+	terminal->switch_handler = 0;
+	terminal->reorder_handler = 0;
+	terminal->journal_source = 0;
+	terminal->monitor = 0;
+	terminal->monitor_interval = 0;
+	terminal->monitor_memory = 0;
+	terminal->monitor_tab = 0;
+	terminal->monitor_window = 0;
+	terminal->monitor_background = 0;
+	terminal->monitor_signal = 0;
+	terminal->monitor_source = 0;
+	terminal->monitor_period = 0;
+	terminal->monitor_sampled = 0;
+	terminal->watchdog_interval = 0;
+	terminal->watchdog_timeout = 0;
+	terminal->watchdog_source = 0;
 	terminal->window = NULL;
 	terminal->fullscreen = FALSE;
+	terminal->vbox_source = 0;
+#ifndef EMBEDDED
+	terminal->menubar = NULL;
+#endif
+	terminal->tb_fullscreen = NULL;
+#ifndef EMBEDDED
+	terminal->activity = NULL;
+	terminal->activity_store = NULL;
+#endif
 	/* check for errors */
 	if((prefs != NULL && prefs->shell != NULL && terminal->shell == NULL)
 			|| (prefs != NULL && prefs->directory != NULL
-				&& terminal->directory == NULL))
+				&& terminal->directory == NULL)
+			|| terminal->config == NULL || terminal->tabs == NULL
+			|| terminal->reaper == NULL)
 	{
 		terminal_delete(terminal);
+		trace_end("terminal_new");
 		return NULL;
 	}
+	trace_begin("config");
+	_terminal_config_load(terminal);
+	terminal->backend = _terminal_get_config_backend(terminal);
+	/* shutdown */
+	terminal->shutdown_timeout = _terminal_get_config_uint(terminal,
+			"shutdown", "timeout", 3000);
+	terminal->shutdown_tree = _terminal_get_config_uint(terminal,
+			"shutdown", "tree", 0);
+	if(_terminal_get_config_uint(terminal, "shutdown", "subreaper", 0)
+			&& terminalreaper_set_subreaper(1) != 0)
+		error_print(PROGNAME_TERMINAL);
+	/* pool */
+	terminal->pool_size = _terminal_get_config_uint(terminal, "pool",
+			"size", 0);
+	if(terminal->pool_size > 0 && (terminal->pool = malloc(
+					sizeof(*terminal->pool)
+					* terminal->pool_size)) == NULL)
+		terminal->pool_size = 0;
+	/* sessions */
+	terminal->sessions = _terminal_get_config_uint(terminal, "sessions",
+			"enabled", 0);
+	terminal->sessions_replay = _terminal_get_config_uint(terminal,
+			"sessions", "replay", 65536);
+	/* recording */
+	terminal->recording = _terminal_get_config_uint(terminal,
+			"recording", "enabled", 0);
+	terminal->recording_size = _terminal_get_config_uint(terminal,
+			"recording", "buffer", 4194304);
+	/* history */
+	terminal->history = _terminal_get_config_uint(terminal, "history",
+			"enabled", 0);
+	terminal->history_size = _terminal_get_config_uint(terminal,
+			"history", "buffer", 262144);
+	/* flood control */
+	terminal->flood = _terminal_get_config_uint(terminal, "flood",
+			"enabled", 0);
+	terminal->flood_rate = _terminal_get_config_uint(terminal, "flood",
+			"rate", 1048576);
+	/* priority */
+	_terminal_config_priority(terminal);
+	/* memory */
+	_terminal_config_monitor(terminal);
+	/* watchdog */
+	_terminal_config_watchdog(terminal);
+	/* control */
+	_terminal_config_control(terminal);
+	/* metrics */
+	_terminal_config_metrics(terminal);
+	/* journal */
+	_terminal_config_journal(terminal, (prefs != NULL) ? prefs->restore
+			: 0);
+	trace_end("config");
 	/* widgets */
-	group = gtk_accel_group_new();
+	trace_begin("window");
+	terminal->group = gtk_accel_group_new();
 	terminal->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
-	gtk_window_add_accel_group(GTK_WINDOW(terminal->window), group);
-	g_object_unref(group);
+	gtk_window_add_accel_group(GTK_WINDOW(terminal->window),
+			terminal->group);
+	g_object_unref(terminal->group);
+#ifndef EMBEDDED
+	terminal->accel = gtk_accel_group_new();
+	desktop_accel_create(_terminal_accel, terminal, terminal->accel);
+	gtk_window_add_accel_group(GTK_WINDOW(terminal->window),
+			terminal->accel);
+	g_object_unref(terminal->accel);
+#endif
 	gtk_window_set_default_size(GTK_WINDOW(terminal->window), 600, 400);
 #if GTK_CHECK_VERSION(2, 6, 0)
 	gtk_window_set_icon_name(GTK_WINDOW(terminal->window), "terminal");
@@ -238,37 +737,45 @@ Terminal * terminal_new(TerminalPrefs * prefs)
 	gtk_window_set_title(GTK_WINDOW(terminal->window), _("Terminal"));
 	g_signal_connect_swapped(terminal->window, "delete-event", G_CALLBACK(
 				_terminal_on_closex), terminal);
-	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-#ifndef EMBEDDED
-	/* menubar */
-	terminal->menubar = desktop_menubar_create(_terminal_menubar, terminal,
-			group);
-	gtk_box_pack_start(GTK_BOX(vbox), terminal->menubar, FALSE, TRUE, 0);
-#endif
-	/* toolbar */
-	widget = desktop_toolbar_create(_terminal_toolbar, terminal, group);
-#if GTK_CHECK_VERSION(2, 8, 0)
-	toolitem = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_FULLSCREEN);
-#else
-	toolitem = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_ZOOM_FIT);
-#endif
-	terminal->tb_fullscreen = toolitem;
-	g_signal_connect_swapped(G_OBJECT(toolitem), "toggled", G_CALLBACK(
-				_terminal_on_fullscreen), terminal);
-	gtk_toolbar_insert(GTK_TOOLBAR(widget), toolitem, -1);
-	gtk_box_pack_start(GTK_BOX(vbox), widget, FALSE, TRUE, 0);
+	terminal->vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	trace_end("window");
 	/* view */
+	trace_begin("notebook");
 	terminal->notebook = gtk_notebook_new();
 	gtk_notebook_set_scrollable(GTK_NOTEBOOK(terminal->notebook), TRUE);
-	gtk_box_pack_start(GTK_BOX(vbox), terminal->notebook, TRUE, TRUE, 0);
-	gtk_container_add(GTK_CONTAINER(terminal->window), vbox);
-	gtk_widget_show_all(vbox);
-	if(_terminal_open_tab(terminal) != 0)
+	terminal->switch_handler = g_signal_connect(terminal->notebook,
+			"switch-page", G_CALLBACK(_terminal_on_switch_page),
+			terminal);
+#if GTK_CHECK_VERSION(2, 10, 0)
+	terminal->reorder_handler = g_signal_connect(terminal->notebook,
+			"page-reordered", G_CALLBACK(
+				_terminal_on_page_reordered), terminal);
+#endif
+	gtk_box_pack_start(GTK_BOX(terminal->vbox), terminal->notebook, TRUE,
+			TRUE, 0);
+	gtk_container_add(GTK_CONTAINER(terminal->window), terminal->vbox);
+	gtk_widget_show_all(terminal->vbox);
+	trace_end("notebook");
+	/* the first tab starts along with the rest of the window */
+	terminal->vbox_source = g_idle_add(_terminal_on_vbox, terminal);
+	if(_terminal_journal_restoring)
+		/* the tabs are restored into this window */
+		res = 0;
+	else if(prefs != NULL && prefs->restore && _terminal_journal != NULL)
+		res = _terminal_journal_restore(terminal);
+	else
+		res = (_terminal_open_tab(terminal, terminal->backend, NULL,
+					NULL) != NULL) ? 0 : -1;
+	if(res != 0)
 	{
 		terminal_delete(terminal);
+		trace_end("terminal_new");
 		return NULL;
 	}
+	trace_begin("show");
 	gtk_widget_show(terminal->window);
+	trace_end("show");
+	trace_end("terminal_new");
 	return terminal;
 }
 
@@ -276,23 +783,136 @@ Terminal * terminal_new(TerminalPrefs * prefs)
 /* terminal_delete */
 void terminal_delete(Terminal * terminal)
 {
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
 	size_t i;
 
-	for(i = 0; i < terminal->tabs_cnt; i++)
+	if(terminal->source > 0)
+		g_source_remove(terminal->source);
+	if(terminal->vbox_source > 0)
+		g_source_remove(terminal->vbox_source);
+	if(terminal->monitor_source > 0)
+		g_source_remove(terminal->monitor_source);
+	if(terminal->watchdog_source > 0)
+		g_source_remove(terminal->watchdog_source);
+	if(terminal->journal_source > 0)
+		g_source_remove(terminal->journal_source);
+#ifndef EMBEDDED
+	if(terminal->activity != NULL)
+		gtk_widget_destroy(terminal->activity);
+#endif
+	/* the pages are removed along with the tabs */
+	if(terminal->switch_handler > 0)
+		g_signal_handler_disconnect(terminal->notebook,
+				terminal->switch_handler);
+	/* the xterms in the pool were never visible */
+	if(terminal->pool_source > 0)
+		g_source_remove(terminal->pool_source);
+	while(terminal->pool_cnt > 0)
+		_terminal_pool_remove(terminal, terminal->pool_cnt - 1);
+	if(terminal->pool_size > 0)
+		fprintf(stderr, _("%s: Pool: %lu hit(s), %lu miss(es)\n"),
+				PROGNAME_TERMINAL, terminal->pool_hits,
+				terminal->pool_misses);
+	while(terminal->tabs != NULL && (tab = terminalstore_get_next(
+					terminal->tabs, &handle)) != NULL)
 	{
-		if(terminal->tabs[i]->source > 0)
-			g_source_remove(terminal->tabs[i]->source);
-		if(terminal->tabs[i]->pid > 0)
-			g_spawn_close_pid(terminal->tabs[i]->pid);
-		free(terminal->tabs[i]);
+		if(tab->resize_source > 0)
+			g_source_remove(tab->resize_source);
+		if(tab->resize_handler > 0)
+			g_signal_handler_disconnect(tab->view,
+					tab->resize_handler);
+		if(tab->size_source > 0)
+			g_source_remove(tab->size_source);
+		_terminal_tab_thaw(tab);
+		_terminal_control_event(tab, "closed", "");
+		if(tab->id != 0)
+			_terminal_metrics_event(tab, TMET_CLOSED, tab->pid, 0);
+		if(tab->tree != NULL)
+			terminalmonitor_tree_delete(tab->tree);
+		if(tab->session != NULL)
+			terminalsession_delete(tab->session);
+		_terminal_journal_remove(terminal, tab);
+		terminalwidget_delete(tab->backend);
+		string_delete(tab->journaled);
+		string_delete(tab->directory);
+		string_delete(tab->shell);
 	}
-	/* FIXME also take care of the sub-processes */
+	/* the processes not terminated yet will not be waited for */
+	if(terminal->reaper != NULL)
+		terminalreaper_kill_all(terminal->reaper, SIGTERM);
 	if(terminal->window != NULL)
 		gtk_widget_destroy(terminal->window);
-	free(terminal->tabs);
+	free(terminal->pool);
+	/* the processes left are still reaped */
+	if(terminal->reaper != NULL)
+		terminalreaper_delete(terminal->reaper);
+	if(terminal->tabs != NULL)
+		terminalstore_delete(terminal->tabs);
+	if(terminal->config != NULL)
+		config_delete(terminal->config);
 	string_delete(terminal->directory);
 	string_delete(terminal->shell);
+	for(i = 0; i < _terminal_windows_cnt; i++)
+		if(_terminal_windows[i] == terminal)
+		{
+			memmove(&_terminal_windows[i],
+					&_terminal_windows[i + 1],
+					(_terminal_windows_cnt - (i + 1))
+					* sizeof(*_terminal_windows));
+			_terminal_windows_cnt--;
+			break;
+		}
 	object_delete(terminal);
+	if(_terminal_windows_cnt > 0)
+		return;
+	free(_terminal_windows);
+	_terminal_windows = NULL;
+	if(_terminal_control != NULL)
+	{
+		terminalcontrol_delete(_terminal_control);
+		_terminal_control = NULL;
+		g_unsetenv("TERMINAL_CONTROL");
+	}
+	if(_terminal_priority != NULL)
+	{
+		terminalpriority_delete(_terminal_priority);
+		_terminal_priority = NULL;
+	}
+	if(_terminal_monitor != NULL)
+	{
+		terminalmonitor_delete(_terminal_monitor);
+		_terminal_monitor = NULL;
+	}
+	if(_terminal_metrics_signal > 0)
+		g_source_remove(_terminal_metrics_signal);
+	_terminal_metrics_signal = 0;
+	if(_terminal_metrics_source > 0)
+		g_source_remove(_terminal_metrics_source);
+	_terminal_metrics_source = 0;
+	if(_terminal_metrics_channel != NULL)
+		g_io_channel_unref(_terminal_metrics_channel);
+	_terminal_metrics_channel = NULL;
+	string_delete(_terminal_metrics_events);
+	_terminal_metrics_events = NULL;
+	string_delete(_terminal_metrics_file);
+	_terminal_metrics_file = NULL;
+	if(_terminal_metrics != NULL)
+	{
+		terminalmetrics_delete(_terminal_metrics);
+		_terminal_metrics = NULL;
+	}
+	if(_terminal_journal_source > 0)
+		g_source_remove(_terminal_journal_source);
+	_terminal_journal_source = 0;
+	if(_terminal_journal != NULL)
+	{
+		terminaljournal_delete(_terminal_journal);
+		_terminal_journal = NULL;
+	}
+	/* quit once the last window is gone */
+	if(gtk_main_level() > 0)
+		gtk_main_quit();
 }
 
 
@@ -300,22 +920,31 @@ void terminal_delete(Terminal * terminal)
 /* terminal_set_fullscreen */
 void terminal_set_fullscreen(Terminal * terminal, gboolean fullscreen)
 {
+	/* the menubar and toolbar may not be created yet */
 	if(fullscreen)
 	{
 #ifndef EMBEDDED
-		gtk_widget_hide(terminal->menubar);
+		if(terminal->menubar != NULL)
+			gtk_widget_hide(terminal->menubar);
 #endif
-		gtk_toggle_tool_button_set_active(GTK_TOGGLE_TOOL_BUTTON(
-					terminal->tb_fullscreen), TRUE);
+		if(terminal->tb_fullscreen != NULL)
+			gtk_toggle_tool_button_set_active(
+					GTK_TOGGLE_TOOL_BUTTON(
+						terminal->tb_fullscreen),
+					TRUE);
 		gtk_window_fullscreen(GTK_WINDOW(terminal->window));
 	}
 	else
 	{
-		gtk_toggle_tool_button_set_active(GTK_TOGGLE_TOOL_BUTTON(
-					terminal->tb_fullscreen), FALSE);
+		if(terminal->tb_fullscreen != NULL)
+			gtk_toggle_tool_button_set_active(
+					GTK_TOGGLE_TOOL_BUTTON(
+						terminal->tb_fullscreen),
+					FALSE);
 		gtk_window_unfullscreen(GTK_WINDOW(terminal->window));
 #ifndef EMBEDDED
-		gtk_widget_show(terminal->menubar);
+		if(terminal->menubar != NULL)
+			gtk_widget_show(terminal->menubar);
 #endif
 	}
 	terminal->fullscreen = fullscreen;
@@ -324,288 +953,2437 @@ void terminal_set_fullscreen(Terminal * terminal, gboolean fullscreen)
 
 /* private */
 /* functions */
-/* useful */
-/* terminal_open_tab */
-static int _terminal_open_tab(Terminal * terminal)
+/* accessors */
+/* terminal_get_config_backend */
+static TerminalBackendDefinition const * _terminal_get_config_backend(
+		Terminal * terminal)
 {
-	TerminalTab ** p;
-	TerminalTab * tab;
-	GtkWidget * widget;
-	char * argv[] = { BINDIR "/xterm", "xterm", "-into", NULL,
-		"-class", "Terminal", NULL, NULL, NULL };
-	char buf[32];
-	GSpawnFlags flags = G_SPAWN_FILE_AND_ARGV_ZERO
-		| G_SPAWN_DO_NOT_REAP_CHILD;
-	GError * error = NULL;
-
-	if((p = realloc(terminal->tabs, sizeof(*p) * (terminal->tabs_cnt + 1)))
-			== NULL)
-		return -1;
-	terminal->tabs = p;
-	if((tab = malloc(sizeof(*tab))) == NULL)
-		return -1;
-	terminal->tabs[terminal->tabs_cnt++] = tab;
-	/* create the tab */
-	tab->terminal = terminal;
-	tab->socket = gtk_socket_new();
-	tab->widget = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-	tab->label = gtk_label_new(_("xterm"));
-	gtk_box_pack_start(GTK_BOX(tab->widget), tab->label, TRUE, TRUE, 0);
-	widget = gtk_button_new();
-	g_signal_connect_swapped(widget, "clicked", G_CALLBACK(
-				_terminal_on_tab_rename), tab);
-	gtk_container_add(GTK_CONTAINER(widget), gtk_image_new_from_icon_name(
-				"gtk-edit", GTK_ICON_SIZE_MENU));
-	gtk_button_set_relief(GTK_BUTTON(widget), GTK_RELIEF_NONE);
-	gtk_box_pack_start(GTK_BOX(tab->widget), widget, FALSE, TRUE, 0);
-	widget = gtk_button_new();
-	g_signal_connect_swapped(widget, "clicked", G_CALLBACK(
-				_terminal_on_tab_close), tab);
-	gtk_container_add(GTK_CONTAINER(widget), gtk_image_new_from_icon_name(
-				"gtk-close", GTK_ICON_SIZE_MENU));
-	gtk_button_set_relief(GTK_BUTTON(widget), GTK_RELIEF_NONE);
-	gtk_box_pack_start(GTK_BOX(tab->widget), widget, FALSE, TRUE, 0);
-	gtk_widget_show_all(tab->widget);
-	gtk_notebook_append_page(GTK_NOTEBOOK(terminal->notebook), tab->socket,
-			tab->widget);
-#if GTK_CHECK_VERSION(2, 10, 0)
-	gtk_notebook_set_tab_reorderable(GTK_NOTEBOOK(terminal->notebook),
-			tab->socket, TRUE);
-#endif
-	/* launch xterm */
-	snprintf(buf, sizeof(buf), "%lu", gtk_socket_get_id(
-				GTK_SOCKET(tab->socket)));
-	argv[3] = buf;
-	if(terminal->login)
-	{
-		argv[6] = "-ls";
-		argv[7] = terminal->shell;
-	}
-	else
-		argv[6] = terminal->shell;
-	if(g_spawn_async(terminal->directory, argv, NULL, flags, NULL, NULL,
-				&tab->pid, &error) == FALSE)
-	{
-		fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL, argv[1],
-				error->message);
-		g_error_free(error);
-		return -1;
-	}
-	tab->source = g_child_watch_add(tab->pid, _terminal_on_child_watch,
-			terminal);
-	gtk_widget_show(tab->socket);
-	return 0;
+	char const * p;
+	TerminalBackendDefinition const * definition;
+
+	if((p = config_get(terminal->config, NULL, "backend")) == NULL)
+		return &backend_xterm;
+	if((definition = backend_lookup(p)) != NULL)
+		return definition;
+	fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL, p,
+			_("Unknown backend"));
+	return &backend_xterm;
 }
 
 
-/* terminal_open_window */
-static int _terminal_open_window(Terminal * terminal)
+/* terminal_get_config_uint */
+static unsigned int _terminal_get_config_uint(Terminal * terminal,
+		char const * section, char const * variable,
+		unsigned int fallback)
 {
-	char * argv[] = { BINDIR "/" PROGNAME_TERMINAL, PROGNAME_TERMINAL,
-		NULL };
-	GSpawnFlags flags = G_SPAWN_FILE_AND_ARGV_ZERO;
-	GError * error = NULL;
-	(void) terminal;
+	char const * p;
+	char * q;
+	unsigned long u;
+
+	if((p = config_get(terminal->config, section, variable)) == NULL
+			|| p[0] == '\0')
+		return fallback;
+	u = strtoul(p, &q, 10);
+	if(*q != '\0' || u > UINT_MAX)
+		return fallback;
+	return u;
+}
 
-	if(g_spawn_async(NULL, argv, NULL, flags, NULL, NULL, NULL, &error)
-			== FALSE)
-	{
-		fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL, argv[0],
-				error->message);
-		g_error_free(error);
+
+/* useful */
+/* terminal_config_load */
+static int _terminal_config_load(Terminal * terminal)
+{
+	char const * homedir;
+	String * filename;
+	int ret;
+
+	if((homedir = getenv("HOME")) == NULL)
+		homedir = g_get_home_dir();
+	if((filename = string_new_append(homedir, "/", TERMINAL_CONFIG_FILE,
+					NULL)) == NULL)
 		return -1;
-	}
-	return 0;
+	/* the configuration file is optional */
+	ret = config_load(terminal->config, filename);
+	string_delete(filename);
+	return ret;
 }
 
 
-/* terminal_close_all */
-static void _terminal_close_all(Terminal * terminal)
+/* terminal_config_control */
+static void _terminal_config_control(Terminal * terminal)
 {
-	GPid * pid;
-	size_t i;
-	size_t cnt;
+	char const * path;
+	String * p = NULL;
+	char buf[16];
 
-#ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s()\n", __func__);
-#endif
-	gtk_widget_hide(terminal->window);
-	/* work on a copy */
-	if((pid = malloc(sizeof(*pid) * terminal->tabs_cnt)) == NULL)
-	{
-		gtk_main_quit();
+	/* the first window decides for the whole process */
+	if(_terminal_control != NULL || !_terminal_get_config_uint(terminal,
+				"control", "enabled", 0))
 		return;
-	}
-	cnt = terminal->tabs_cnt;
-	for(i = 0; i < cnt; i++)
+	if((path = config_get(terminal->config, "control", "path")) == NULL
+			|| path[0] == '\0')
 	{
-		pid[i] = terminal->tabs[i]->pid;
-		g_spawn_close_pid(terminal->tabs[i]->pid);
-		terminal->tabs[i]->pid = -1;
+		snprintf(buf, sizeof(buf), "%ld", (long)getpid());
+		if((p = string_new_append(g_get_user_runtime_dir(), "/",
+						PROGNAME_TERMINAL, "-control.",
+						buf, NULL)) == NULL)
+		{
+			error_print(PROGNAME_TERMINAL);
+			return;
+		}
+		path = p;
 	}
-	/* kill the remaining tabs */
-	for(i = 0; i < cnt; i++)
-		if(kill(pid[i], SIGTERM) != 0)
-			fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL,
-					"kill", strerror(errno));
-	free(pid);
-	gtk_main_quit();
+	if((_terminal_control = terminalcontrol_new(path, _terminal_on_control,
+					NULL)) == NULL)
+		error_print(PROGNAME_TERMINAL);
+	else
+		/* for the shells started from now on */
+		g_setenv("TERMINAL_CONTROL", path, TRUE);
+	string_delete(p);
 }
 
 
-/* terminal_close_tab */
-static void _terminal_close_tab(Terminal * terminal, unsigned int i)
+/* terminal_config_journal */
+static void _terminal_config_journal(Terminal * terminal,
+		unsigned int restore)
 {
-#ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(%u)\n", __func__, i);
-#endif
-	if(terminal->tabs[i]->source > 0)
-		g_source_remove(terminal->tabs[i]->source);
-	if(terminal->tabs[i]->pid >= 0)
-	{
-		g_spawn_close_pid(terminal->tabs[i]->pid);
-		if(kill(terminal->tabs[i]->pid, SIGTERM) != 0)
-			fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL,
-					"kill", strerror(errno));
-	}
-	free(terminal->tabs[i]);
-	gtk_notebook_remove_page(GTK_NOTEBOOK(terminal->notebook), i);
-	memmove(&terminal->tabs[i], &terminal->tabs[i + 1],
-			(terminal->tabs_cnt - (i + 1))
-			* sizeof(*terminal->tabs));
-	if(--terminal->tabs_cnt == 0)
-		gtk_main_quit();
+	char const * p;
+	char const * homedir;
+	String * filename = NULL;
+	unsigned int interval;
+
+	/* the first window decides for the whole process */
+	if(_terminal_journal != NULL || (!restore && !_terminal_get_config_uint(
+					terminal, "journal", "enabled", 0)))
+		return;
+	if((p = config_get(terminal->config, "journal", "file")) == NULL
+			|| p[0] == '\0')
+	{
+		if((homedir = getenv("HOME")) == NULL)
+			homedir = g_get_home_dir();
+		if((filename = string_new_append(homedir, "/",
+						TERMINAL_JOURNAL_FILE, NULL))
+				== NULL)
+		{
+			error_print(PROGNAME_TERMINAL);
+			return;
+		}
+		p = filename;
+	}
+	/* locked by a single process at a time */
+	if((_terminal_journal = terminaljournal_new(p, restore)) == NULL)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", p,
+				strerror(errno));
+	string_delete(filename);
+	if(_terminal_journal == NULL)
+		return;
+	_terminal_journal_lazy = _terminal_get_config_uint(terminal, "journal",
+			"lazy", 1);
+	_terminal_journal_stagger = _terminal_get_config_uint(terminal,
+			"journal", "stagger", TERMINAL_JOURNAL_STAGGER);
+	/* the directories are polled unless disabled */
+	if((interval = _terminal_get_config_uint(terminal, "journal",
+					"interval", TERMINAL_JOURNAL_INTERVAL))
+			> 0)
+		_terminal_journal_source = g_timeout_add(interval,
+				_terminal_on_journal, NULL);
 }
 
 
-/* callbacks */
-/* terminal_on_child_watch */
-static void _terminal_on_child_watch(GPid pid, gint status, gpointer data)
+/* terminal_config_metrics */
+static void _terminal_config_metrics(Terminal * terminal)
 {
-	Terminal * terminal = data;
-	size_t i;
+	char const * p;
+	int fd;
 
-#ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(%d, %d)\n", __func__, pid, status);
-#endif
-	for(i = 0; i < terminal->tabs_cnt; i++)
-		if(terminal->tabs[i]->pid == pid)
-			break;
-	if(i >= terminal->tabs_cnt)
+	/* the first window decides for the whole process */
+	if(_terminal_metrics != NULL || !_terminal_get_config_uint(terminal,
+				"metrics", "enabled", 0))
 		return;
-	if(WIFEXITED(status))
+	if((_terminal_metrics = terminalmetrics_new()) == NULL)
 	{
-		if(WEXITSTATUS(status) != 0)
-			fprintf(stderr, "%s: %s%u\n", PROGNAME_TERMINAL,
-					_("xterm exited with status "),
-					WEXITSTATUS(status));
-		g_spawn_close_pid(terminal->tabs[i]->pid);
-		terminal->tabs[i]->pid = -1;
-		_terminal_close_tab(terminal, i);
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+		return;
 	}
-	else if(WIFSIGNALED(status))
+	if((p = config_get(terminal->config, "metrics", "socket")) != NULL
+			&& p[0] != '\0')
 	{
-		fprintf(stderr, "%s: %s%u\n", PROGNAME_TERMINAL,
-				_("xterm exited with signal "),
-				WTERMSIG(status));
-		g_spawn_close_pid(terminal->tabs[i]->pid);
-		terminal->tabs[i]->pid = -1;
-		_terminal_close_tab(terminal, i);
+		if((fd = terminalmetrics_listen(_terminal_metrics, p)) < 0)
+			error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", p,
+					strerror(errno));
+		else
+		{
+			_terminal_metrics_channel = g_io_channel_unix_new(fd);
+			_terminal_metrics_source = g_io_add_watch(
+					_terminal_metrics_channel, G_IO_IN,
+					_terminal_on_metrics, NULL);
+		}
 	}
+	/* written upon SIGUSR1 */
+	if((p = config_get(terminal->config, "metrics", "file")) != NULL
+			&& p[0] != '\0')
+		_terminal_metrics_file = string_new(p);
+	if((p = config_get(terminal->config, "metrics", "events")) != NULL
+			&& p[0] != '\0')
+		_terminal_metrics_events = string_new(p);
+	if(_terminal_metrics_file != NULL || _terminal_metrics_events != NULL)
+		_terminal_metrics_signal = g_unix_signal_add(SIGUSR1,
+				_terminal_on_metrics_signal, NULL);
 }
 
 
-/* terminal_on_close */
-static void _terminal_on_close(gpointer data)
+/* terminal_config_monitor */
+static void _terminal_config_monitor(Terminal * terminal)
 {
-	Terminal * terminal = data;
-	int i;
-
-	i = gtk_notebook_get_current_page(GTK_NOTEBOOK(terminal->notebook));
-	if(i < 0)
+	terminal->monitor_interval = _terminal_get_config_uint(terminal,
+			"monitor", "interval", TERMINAL_MONITOR_INTERVAL);
+	if(terminal->monitor_interval == 0)
+		terminal->monitor_interval = TERMINAL_MONITOR_INTERVAL;
+	terminal->monitor_memory = _terminal_get_config_uint(terminal,
+			"monitor", "memory", TERMINAL_MONITOR_MEMORY);
+	if(!_terminal_get_config_uint(terminal, "monitor", "enabled", 0))
+		return;
+	terminal->monitor = 1;
+	terminal->monitor_tab = _terminal_get_config_uint(terminal, "monitor",
+			"tab", 0);
+	terminal->monitor_window = _terminal_get_config_uint(terminal,
+			"monitor", "window", 0);
+	terminal->monitor_background = _terminal_get_config_uint(terminal,
+			"monitor", "background", 0);
+	terminal->monitor_signal = _terminal_get_config_uint(terminal,
+			"monitor", "signal", 0);
+	/* shared by every window */
+	if(_terminal_monitor == NULL
+			&& (_terminal_monitor = terminalmonitor_new()) == NULL)
+	{
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
 		return;
-	_terminal_close_tab(terminal, i);
+	}
+	terminal->monitor_period = terminal->monitor_interval;
+	terminal->monitor_source = g_timeout_add(terminal->monitor_period,
+			_terminal_on_monitor, terminal);
 }
 
 
-/* terminal_on_closex */
-static gboolean _on_closex_confirm(Terminal * terminal);
-
-static gboolean _terminal_on_closex(gpointer data)
+/* terminal_config_priority */
+static void _terminal_config_priority(Terminal * terminal)
 {
-	Terminal * terminal = data;
+	TerminalPriority * priority;
+	unsigned int u;
 
-	if(terminal->tabs_cnt > 1 && _on_closex_confirm(terminal) != TRUE)
-		return TRUE;
-	_terminal_close_all(terminal);
-	return TRUE;
+	terminal->freeze = _terminal_get_config_uint(terminal, "priority",
+			"freeze", 0);
+	if(!_terminal_get_config_uint(terminal, "priority", "enabled", 0))
+		return;
+	terminal->priority = 1;
+	/* the first window decides for the whole process */
+	if(_terminal_priority != NULL)
+		return;
+	if((priority = terminalpriority_new()) == NULL)
+	{
+		terminal->priority = 0;
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+		return;
+	}
+	/* the other settings remain if one cannot be used */
+	u = _terminal_get_config_uint(terminal, "priority", "nice", 10);
+	if(terminalpriority_set_nice(priority, u) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", "nice",
+				strerror(errno));
+	u = _terminal_get_config_uint(terminal, "priority", "idle", 1);
+	if(terminalpriority_set_idle(priority, u) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", "idle",
+				strerror(errno));
+	u = _terminal_get_config_uint(terminal, "priority", "io", 1);
+	if(terminalpriority_set_io(priority, u) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", "io",
+				strerror(errno));
+	u = _terminal_get_config_uint(terminal, "priority", "weight", 0);
+	if(terminalpriority_set_weight(priority, u) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", "weight",
+				strerror(errno));
+	_terminal_priority = priority;
 }
 
-static gboolean _on_closex_confirm(Terminal * terminal)
-{
-	GtkWidget * dialog;
-	gboolean res;
 
-	dialog = gtk_message_dialog_new(GTK_WINDOW(terminal->window),
-			GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-			GTK_MESSAGE_QUESTION, GTK_BUTTONS_NONE,
-#if GTK_CHECK_VERSION(2, 6, 0)
-			"%s", _("Question"));
-	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
-#endif
-			"%s", _("There are multiple tabs opened.\n"
-				"Do you really want to close every tab"
-				" opened in this window?"));
-	gtk_dialog_add_buttons(GTK_DIALOG(dialog),
-			GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
-			GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, NULL);
-	gtk_window_set_title(GTK_WINDOW(dialog), _("Question"));
-	res = gtk_dialog_run(GTK_DIALOG(dialog));
-	gtk_widget_destroy(dialog);
-	return (res == GTK_RESPONSE_CLOSE) ? TRUE : FALSE;
+/* terminal_config_watchdog */
+static void _terminal_config_watchdog(Terminal * terminal)
+{
+	if(!_terminal_get_config_uint(terminal, "watchdog", "enabled", 0))
+		return;
+	terminal->watchdog_interval = _terminal_get_config_uint(terminal,
+			"watchdog", "interval", TERMINAL_WATCHDOG_INTERVAL);
+	if(terminal->watchdog_interval == 0)
+		terminal->watchdog_interval = TERMINAL_WATCHDOG_INTERVAL;
+	terminal->watchdog_timeout = _terminal_get_config_uint(terminal,
+			"watchdog", "timeout", TERMINAL_WATCHDOG_TIMEOUT);
+	terminal->watchdog_source = g_timeout_add(terminal->watchdog_interval,
+			_terminal_on_watchdog, terminal);
 }
 
 
-/* terminal_on_fullscreen */
-static void _terminal_on_fullscreen(gpointer data)
+/* terminal_open_tab */
+static TerminalTab * _terminal_open_tab(Terminal * terminal,
+		TerminalBackendDefinition const * definition,
+		TerminalPrefs const * prefs, TerminalSession * session)
 {
-	Terminal * terminal = data;
-
-	terminal_set_fullscreen(terminal, terminal->fullscreen ? FALSE : TRUE);
+	TerminalTab * tab = NULL;
+	gint64 opened;
+	char buf[64];
+
+	opened = g_get_monotonic_time();
+	trace_begin("open_tab");
+	/* the pool only holds the default backend, with new shells and the
+	 * settings of the window */
+	if(definition == terminal->backend && prefs == NULL && session == NULL)
+		tab = _terminal_pool_get(terminal);
+	if(tab == NULL && (tab = _terminal_tab_new(terminal, definition,
+					prefs, session)) == NULL)
+	{
+		trace_end("open_tab");
+		return NULL;
+	}
+	tab->id = ++_terminal_tabs_id;
+	/* the pool always comes after the visible tabs */
+	if(terminal->reorder_handler > 0)
+		g_signal_handler_block(terminal->notebook,
+				terminal->reorder_handler);
+	gtk_notebook_reorder_child(GTK_NOTEBOOK(terminal->notebook),
+			tab->page, terminal->tabs_cnt++);
+	if(terminal->reorder_handler > 0)
+		g_signal_handler_unblock(terminal->notebook,
+				terminal->reorder_handler);
+	gtk_widget_show(tab->page);
+	_terminal_journal_tab(tab);
+	snprintf(buf, sizeof(buf), ",\"backend\":\"%s\",\"pid\":%ld",
+			tab->definition->name, (long)tab->pid);
+	_terminal_control_event(tab, "opened", buf);
+	_terminal_metrics_event(tab, TMET_OPENED, tab->pid, 0);
+	/* the tab is traced until usable */
+	trace_async_begin("tab", tab->handle, opened);
+	if(tab->ready)
+	{
+		trace_async_end("tab", tab->handle);
+		_terminal_control_event(tab, "plugged", "");
+	}
+	else
+		tab->opening = TRUE;
+	trace_end("open_tab");
+	return tab;
 }
 
 
-/* terminal_on_new_tab */
-static void _terminal_on_new_tab(gpointer data)
+/* terminal_open_window */
+static int _terminal_open_window(Terminal * terminal)
 {
-	Terminal * terminal = data;
+	(void) terminal;
 
-	_terminal_open_tab(terminal);
+	/* the new window lives in the current process */
+	if(terminal_new(NULL) == NULL)
+		return -error_print(PROGNAME_TERMINAL);
+	return 0;
 }
 
 
-/* terminal_on_new_window */
-static void _terminal_on_new_window(gpointer data)
+/* terminal_close */
+static void _terminal_close(Terminal * terminal)
 {
-	Terminal * terminal = data;
-
-	_terminal_open_window(terminal);
-}
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+
+	gtk_widget_hide(terminal->window);
+	if(terminal->pool_source > 0)
+	{
+		g_source_remove(terminal->pool_source);
+		terminal->pool_source = 0;
+	}
+	if(terminal->closing)
+		return;
+	terminal->closing = TRUE;
+	/* the terminal emulators stopped have to terminate as well */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+		_terminal_tab_thaw(tab);
+	/* the window is deleted once every process is gone */
+	if(terminalreaper_shutdown(terminal->reaper,
+				terminal->shutdown_timeout,
+				terminal->shutdown_tree,
+				_terminal_on_shutdown, terminal) != 0)
+	{
+		error_print(PROGNAME_TERMINAL);
+		terminal->source = g_idle_add(_terminal_on_delete, terminal);
+	}
+}
+
+
+/* terminal_close_all */
+static void _terminal_close_all(Terminal * terminal)
+{
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s()\n", __func__);
+#endif
+	gtk_widget_hide(terminal->window);
+	/* the remaining tabs are terminated when closing */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		if(tab->pooled || tab->pid < 0)
+			continue;
+		/* the process is terminated but otherwise ignored */
+		_terminal_tab_thaw(tab);
+		terminalstore_set_key(terminal->tabs, tab->handle, TTI_PID, 0);
+		tab->pid = -1;
+	}
+	_terminal_close(terminal);
+}
+
+
+/* terminal_close_tab */
+static void _terminal_close_tab(Terminal * terminal, TerminalTab * tab)
+{
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(%d)\n", __func__, tab->pid);
+#endif
+	trace_begin("close_tab");
+	_terminal_tab_delete(terminal, tab);
+	if(--terminal->tabs_cnt == 0)
+		_terminal_close(terminal);
+	trace_end("close_tab");
+}
+
+
+/* terminal_pool_get */
+static TerminalTab * _terminal_pool_get(Terminal * terminal)
+{
+	TerminalTab * tab;
+
+	if(terminal->pool_size == 0)
+		return NULL;
+	_terminal_pool_refill(terminal);
+	while(terminal->pool_cnt > 0)
+	{
+		/* the oldest xterm is the most likely to be ready */
+		tab = terminal->pool[0];
+		memmove(&terminal->pool[0], &terminal->pool[1],
+				(--terminal->pool_cnt)
+				* sizeof(*terminal->pool));
+		if(_terminal_tab_matches(terminal, tab))
+		{
+			tab->pooled = FALSE;
+			terminal->pool_hits++;
+			return tab;
+		}
+		/* the settings have changed since */
+		_terminal_tab_delete(terminal, tab);
+	}
+	terminal->pool_misses++;
+	return NULL;
+}
+
+
+/* terminal_pool_refill */
+static void _terminal_pool_refill(Terminal * terminal)
+{
+	/* once idle */
+	if(terminal->pool_source == 0 && !terminal->closing)
+		terminal->pool_source = g_idle_add_full(G_PRIORITY_LOW,
+				_terminal_on_pool_fill, terminal, NULL);
+}
+
+
+/* terminal_pool_remove */
+static void _terminal_pool_remove(Terminal * terminal, size_t i)
+{
+	_terminal_tab_delete(terminal, terminal->pool[i]);
+	memmove(&terminal->pool[i], &terminal->pool[i + 1],
+			(terminal->pool_cnt - (i + 1))
+			* sizeof(*terminal->pool));
+	terminal->pool_cnt--;
+}
+
+
+#ifndef EMBEDDED
+/* activity */
+/* terminal_activity_update */
+static void _terminal_activity_update(Terminal * terminal)
+{
+	GtkTreeModel * model = GTK_TREE_MODEL(terminal->activity_store);
+	GtkTreeIter iter;
+	gboolean valid;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+	guint u;
+
+	/* the rows are kept, along with the selection */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+		tab->listed = FALSE;
+	for(valid = gtk_tree_model_get_iter_first(model, &iter); valid;)
+	{
+		gtk_tree_model_get(model, &iter, TAC_HANDLE, &u, -1);
+		if((tab = terminalstore_get(terminal->tabs, u)) == NULL
+				|| tab->pooled)
+		{
+			valid = gtk_list_store_remove(terminal->activity_store,
+					&iter);
+			continue;
+		}
+		tab->listed = TRUE;
+		gtk_list_store_set(terminal->activity_store, &iter,
+				TAC_LABEL, gtk_label_get_text(
+					GTK_LABEL(tab->label)),
+				TAC_LOAD, tab->usage.load,
+				TAC_MEMORY, tab->usage.pss / 1024,
+				TAC_PROCESSES, (gulong)tab->usage.processes,
+				TAC_STATE, tab->finished ? _("done")
+				: ((tab->usage.jobs > 0) ? _("running") : ""),
+				-1);
+		valid = gtk_tree_model_iter_next(model, &iter);
+	}
+	handle = TERMINALSTORE_HANDLE_NONE;
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		if(tab->pooled || tab->listed)
+			continue;
+		gtk_list_store_append(terminal->activity_store, &iter);
+		gtk_list_store_set(terminal->activity_store, &iter,
+				TAC_HANDLE, tab->handle,
+				TAC_LABEL, gtk_label_get_text(
+					GTK_LABEL(tab->label)),
+				TAC_LOAD, tab->usage.load,
+				TAC_MEMORY, tab->usage.pss / 1024,
+				TAC_PROCESSES, (gulong)tab->usage.processes,
+				TAC_STATE, tab->finished ? _("done")
+				: ((tab->usage.jobs > 0) ? _("running") : ""),
+				-1);
+	}
+}
+
+
+#endif
+/* control */
+/* terminal_control_append_tab */
+static void _terminal_control_append_tab(GString * reply, TerminalTab * tab)
+{
+	Terminal * terminal = tab->terminal;
+	GtkNotebook * notebook = GTK_NOTEBOOK(terminal->notebook);
+	gint page;
+	char const * state;
+	TerminalHistory * history;
+	size_t size;
+	size_t stored;
+
+	page = gtk_notebook_page_num(notebook, tab->page);
+	if(tab->finished)
+		state = "done";
+	else if(tab->usage.jobs > 0)
+		state = "running";
+	else if(tab->deferred)
+		state = "deferred";
+	else
+		state = tab->ready ? "ready" : "opening";
+	if(tab->hung != 0)
+		state = "hung";
+	g_string_append_printf(reply, "{\"tab\":%u,\"window\":%u,"
+			"\"index\":%d,\"current\":%s,\"backend\":\"%s\","
+			"\"pid\":%ld", tab->id, terminal->id, page,
+			(page == gtk_notebook_get_current_page(notebook))
+			? "true" : "false", tab->definition->name,
+			(long)tab->pid);
+	if(tab->session != NULL)
+		g_string_append_printf(reply, ",\"session\":%ld",
+				(long)terminalsession_get_pid(tab->session));
+	/* the scrollback kept outside of the terminal emulator */
+	if(tab->session != NULL && (history = terminalsession_get_history(
+					tab->session)) != NULL)
+	{
+		size = terminalhistory_get_size(history, &stored);
+		g_string_append_printf(reply, ",\"history\":%lu,"
+				"\"stored\":%lu,\"dropped\":%lu",
+				(unsigned long)size, (unsigned long)stored,
+				terminalhistory_get_dropped(history));
+	}
+	g_string_append(reply, ",\"label\":");
+	terminalcontrol_append_string(reply, gtk_label_get_text(
+				GTK_LABEL(tab->label)));
+	if(tab->shell != NULL)
+	{
+		g_string_append(reply, ",\"shell\":");
+		terminalcontrol_append_string(reply, tab->shell);
+	}
+	if(tab->directory != NULL)
+	{
+		g_string_append(reply, ",\"directory\":");
+		terminalcontrol_append_string(reply, tab->directory);
+	}
+	g_string_append_printf(reply, ",\"login\":%s,\"state\":\"%s\","
+			"\"background\":%s", tab->login ? "true" : "false",
+			state, tab->background ? "true" : "false");
+	/* only known while the tabs are sampled */
+	if(terminal->monitor_source > 0)
+		g_string_append_printf(reply, ",\"load\":%u,\"memory\":%lu,"
+				"\"processes\":%lu,\"jobs\":%lu",
+				tab->usage.load, tab->usage.pss,
+				(unsigned long)tab->usage.processes,
+				(unsigned long)tab->usage.jobs);
+	g_string_append_c(reply, '}');
+}
+
+
+/* terminal_control_event */
+static void _terminal_control_event(TerminalTab * tab, char const * event,
+		char const * members)
+{
+	char buf[160];
+
+	/* the tabs in the pool were never opened */
+	if(_terminal_control == NULL || tab->id == 0)
+		return;
+	snprintf(buf, sizeof(buf), ",\"tab\":%u,\"window\":%u%s", tab->id,
+			tab->terminal->id, members);
+	terminalcontrol_event(_terminal_control, event, buf);
+}
+
+
+/* terminal_control_exited */
+static void _terminal_control_exited(TerminalTab * tab, char const * process,
+		GPid pid, int status)
+{
+	char buf[96];
+
+	if(WIFEXITED(status))
+		snprintf(buf, sizeof(buf), ",\"process\":\"%s\",\"pid\":%ld,"
+				"\"status\":%d", process, (long)pid,
+				WEXITSTATUS(status));
+	else if(WIFSIGNALED(status))
+		snprintf(buf, sizeof(buf), ",\"process\":\"%s\",\"pid\":%ld,"
+				"\"signal\":%d", process, (long)pid,
+				WTERMSIG(status));
+	else
+		return;
+	_terminal_control_event(tab, "exited", buf);
+}
+
+
+/* terminal_control_get_tab */
+static TerminalTab * _terminal_control_get_tab(
+		TerminalControlRequest const * request)
+{
+	unsigned int id = 0;
+	size_t i;
+	TerminalStoreHandle handle;
+	TerminalTab * tab;
+
+	if(terminalcontrol_request_get_uint(request, "tab", &id) != 0)
+		return NULL;
+	for(i = 0; id > 0 && i < _terminal_windows_cnt; i++)
+	{
+		if(_terminal_windows[i]->closing)
+			continue;
+		handle = TERMINALSTORE_HANDLE_NONE;
+		while((tab = terminalstore_get_next(_terminal_windows[i]->tabs,
+						&handle)) != NULL)
+			if(tab->id == id)
+				return tab;
+	}
+	error_set_code(1, "%s: %s", "tab", _("No such tab"));
+	return NULL;
+}
+
+
+/* terminal_control_get_window */
+static Terminal * _terminal_control_get_window(
+		TerminalControlRequest const * request)
+{
+	unsigned int id = 0;
+	size_t i;
+
+	if(terminalcontrol_request_get_uint(request, "window", &id) != 0)
+		return NULL;
+	/* the first window by default */
+	for(i = 0; i < _terminal_windows_cnt; i++)
+		if(!_terminal_windows[i]->closing
+				&& (id == 0 || _terminal_windows[i]->id == id))
+			return _terminal_windows[i];
+	error_set_code(1, "%s: %s", "window", _("No such window"));
+	return NULL;
+}
+
+
+/* journal */
+/* terminal_journal_remove */
+static void _terminal_journal_remove(Terminal * terminal, TerminalTab * tab)
+{
+	/* kept along with the last window, or if the tab crashed */
+	if(_terminal_journal == NULL || tab->id == 0 || tab->crashed
+			|| (terminal->closing && _terminal_windows_cnt == 1))
+		return;
+	if(terminaljournal_remove(_terminal_journal, tab->id) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+}
+
+
+/* terminal_journal_restore */
+static void _journal_restore_tab(void * data, TerminalJournalTab const * tab);
+
+static int _terminal_journal_restore(Terminal * terminal)
+{
+	TerminalJournalRestore restore;
+	Terminal * t;
+	size_t i;
+	int ret = 0;
+
+	trace_begin("restore");
+	restore.terminal = terminal;
+	restore.window = 0;
+	_terminal_journal_restoring = TRUE;
+	if(terminaljournal_restore(_terminal_journal, _journal_restore_tab,
+				&restore) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+	_terminal_journal_restoring = FALSE;
+	for(i = 0; i < _terminal_windows_cnt; i++)
+	{
+		t = _terminal_windows[i];
+		if(t->id < terminal->id || t->closing)
+			continue;
+		/* the current tabs first, the others in turn */
+		if(t->tabs_cnt > 0)
+		{
+			if(t->journal_source == 0)
+				t->journal_source = g_idle_add(
+						_terminal_on_journal_spawn, t);
+			continue;
+		}
+		/* nothing could be restored in this window */
+		if(_terminal_open_tab(t, t->backend, NULL, NULL) != NULL)
+			continue;
+		if(t == terminal)
+			ret = -1;
+		else
+			_terminal_close(t);
+	}
+	trace_end("restore");
+	return ret;
+}
+
+static void _journal_restore_tab(void * data, TerminalJournalTab const * tab)
+{
+	TerminalJournalRestore * restore = data;
+	TerminalPrefs prefs;
+	TerminalTab * t;
+
+	/* every other window is restored in a new one */
+	if(restore->window != tab->window)
+	{
+		if(restore->window != 0 && (restore->terminal = terminal_new(
+						NULL)) == NULL)
+			error_print(PROGNAME_TERMINAL);
+		restore->window = tab->window;
+	}
+	if(restore->terminal == NULL)
+		return;
+	memset(&prefs, 0, sizeof(prefs));
+	prefs.shell = tab->shell;
+	prefs.login = tab->login;
+	/* the directory may be gone since */
+	if(!tab->login && tab->directory != NULL
+			&& access(tab->directory, X_OK) == 0)
+		prefs.directory = tab->directory;
+	if((t = _terminal_open_tab(restore->terminal,
+					restore->terminal->backend, &prefs,
+					NULL)) != NULL && tab->label != NULL)
+		_terminal_tab_set_label(t, tab->label);
+}
+
+
+/* terminal_journal_tab */
+static void _terminal_journal_tab(TerminalTab * tab)
+{
+	Terminal * terminal = tab->terminal;
+	TerminalJournalTab entry;
+
+	if(_terminal_journal == NULL || tab->id == 0)
+		return;
+	entry.id = tab->id;
+	entry.window = terminal->id;
+	entry.position = gtk_notebook_page_num(GTK_NOTEBOOK(
+				terminal->notebook), tab->page);
+	entry.login = tab->login;
+	entry.shell = tab->shell;
+	/* the directory polled last, as started otherwise */
+	entry.directory = (tab->journaled != NULL) ? tab->journaled
+		: tab->directory;
+	/* the titles set by the terminal emulators change all the time */
+	entry.label = tab->renamed ? gtk_label_get_text(GTK_LABEL(tab->label))
+		: NULL;
+	if(terminaljournal_set(_terminal_journal, &entry) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+}
+
+
+/* metrics */
+/* terminal_metrics_event */
+static void _terminal_metrics_event(TerminalTab * tab,
+		TerminalMetricsEventType type, GPid pid, long value)
+{
+	if(_terminal_metrics != NULL)
+		terminalmetrics_event(_terminal_metrics, type,
+				(tab != NULL) ? tab->id : 0, pid, value);
+}
+
+
+/* terminal_metrics_exited */
+static void _terminal_metrics_exited(TerminalTab * tab, GPid pid,
+		int status)
+{
+	if(WIFEXITED(status))
+		_terminal_metrics_event(tab, TMET_EXITED, pid,
+				WEXITSTATUS(status));
+	else if(WIFSIGNALED(status))
+		_terminal_metrics_event(tab, TMET_SIGNALED, pid,
+				WTERMSIG(status));
+}
+
+
+/* terminal_metrics_export */
+static int _terminal_metrics_export(char const * filename, int events)
+{
+	unsigned long tabs = 0;
+	unsigned long processes = 0;
+	size_t i;
+
+	/* the gauges are only up to date when exported */
+	for(i = 0; i < _terminal_windows_cnt; i++)
+	{
+		tabs += _terminal_windows[i]->tabs_cnt;
+		processes += terminalreaper_get_count(
+				_terminal_windows[i]->reaper);
+	}
+	terminalmetrics_set_gauge(_terminal_metrics, TMG_TABS, tabs);
+	terminalmetrics_set_gauge(_terminal_metrics, TMG_PROCESSES, processes);
+	if(filename == NULL)
+		return terminalmetrics_serve(_terminal_metrics);
+	return terminalmetrics_write(_terminal_metrics, filename, events);
+}
+
+
+/* terminal_metrics_reaped */
+static void _terminal_metrics_reaped(Terminal * terminal, GPid pid)
+{
+	size_t i;
+	TerminalReaping * reaping;
+
+	if(_terminal_metrics == NULL)
+		return;
+	for(i = 0; i < TERMINAL_METRICS_REAPING; i++)
+	{
+		reaping = &terminal->reaping[i];
+		if(reaping->pid != pid || reaping->closed == 0)
+			continue;
+		terminalmetrics_event(_terminal_metrics, TMET_REAPED,
+				reaping->id, pid,
+				g_get_monotonic_time() - reaping->closed);
+		reaping->closed = 0;
+		return;
+	}
+}
+
+
+/* tabs */
+/* terminal_tab_new */
+static TerminalTab * _terminal_tab_new(Terminal * terminal,
+		TerminalBackendDefinition const * definition,
+		TerminalPrefs const * prefs, TerminalSession * session)
+{
+	TerminalTab * tab;
+	TerminalStoreHandle handle;
+	char const * shell = terminal->shell;
+	char const * directory = terminal->directory;
+	GtkWidget * widget;
+
+	if((tab = terminalstore_alloc(terminal->tabs, &handle)) == NULL)
+		return NULL;
+	if(prefs != NULL)
+	{
+		shell = prefs->shell;
+		directory = prefs->directory;
+	}
+	tab->terminal = terminal;
+	tab->handle = handle;
+	tab->id = 0;
+	tab->pooled = FALSE;
+	tab->renamed = FALSE;
+	tab->pid = -1;
+	tab->ready = FALSE;
+	tab->opening = FALSE;
+	tab->spawned = 0;
+	tab->definition = definition;
+	tab->helper.data = tab;
+	tab->helper.config_get = _terminal_on_tab_config_get;
+	tab->helper.set_title = _terminal_on_tab_title;
+	tab->helper.ready = _terminal_on_tab_ready;
+	/* reaped along with the other processes of the window */
+	tab->helper.exited = NULL;
+	tab->shell = (shell != NULL) ? string_new(shell) : NULL;
+	tab->directory = (directory != NULL) ? string_new(directory) : NULL;
+	tab->login = (prefs != NULL) ? prefs->login : terminal->login;
+	tab->session = session;
+	tab->attached = 0;
+	tab->resize_handler = 0;
+	tab->resize_source = 0;
+	tab->resize_cnt = 0;
+	tab->width = 0;
+	tab->height = 0;
+	tab->size_pending = FALSE;
+	tab->sized = 0;
+	tab->size_source = 0;
+	tab->background = FALSE;
+	tab->frozen = FALSE;
+	memset(&tab->usage, 0, sizeof(tab->usage));
+	tab->tree = NULL;
+	tab->exceeded = FALSE;
+	tab->finished = FALSE;
+	tab->listed = FALSE;
+	tab->watched = 0;
+	tab->cpu = 0;
+	tab->suspected = 0;
+	tab->hung = 0;
+	tab->deferred = FALSE;
+	tab->crashed = FALSE;
+	tab->journal_pid = -1;
+	tab->journaled = NULL;
+	if((shell != NULL && tab->shell == NULL)
+			|| (directory != NULL && tab->directory == NULL)
+			|| (tab->backend = terminalwidget_new(definition->name,
+					&tab->helper)) == NULL)
+	{
+		string_delete(tab->directory);
+		string_delete(tab->shell);
+		terminalstore_free(terminal->tabs, handle);
+		return NULL;
+	}
+	/* create the tab, only sized when visible */
+	tab->view = terminalwidget_get_widget(tab->backend);
+	tab->page = gtk_layout_new(NULL, NULL);
+	gtk_layout_put(GTK_LAYOUT(tab->page), tab->view, 0, 0);
+	gtk_widget_show(tab->view);
+	g_signal_connect(tab->page, "size-allocate", G_CALLBACK(
+				_terminal_on_tab_page_allocate), tab);
+	terminalstore_set_key(terminal->tabs, handle, TTI_PAGE,
+			(uintptr_t)tab->page);
+	tab->widget = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+	/* only shown while over budget */
+	tab->warning = gtk_image_new_from_icon_name("dialog-warning",
+			GTK_ICON_SIZE_MENU);
+	gtk_widget_set_no_show_all(tab->warning, TRUE);
+	gtk_box_pack_start(GTK_BOX(tab->widget), tab->warning, FALSE, TRUE, 0);
+	tab->label = gtk_label_new(_(definition->label));
+	gtk_box_pack_start(GTK_BOX(tab->widget), tab->label, TRUE, TRUE, 0);
+	tab->activity = gtk_label_new(NULL);
+	gtk_box_pack_start(GTK_BOX(tab->widget), tab->activity, FALSE, TRUE,
+			4);
+	/* only shown while not responding */
+	tab->kill = gtk_button_new();
+	g_signal_connect_swapped(tab->kill, "clicked", G_CALLBACK(
+				_terminal_on_tab_kill), tab);
+	gtk_container_add(GTK_CONTAINER(tab->kill),
+			gtk_image_new_from_icon_name("process-stop",
+				GTK_ICON_SIZE_MENU));
+	gtk_button_set_relief(GTK_BUTTON(tab->kill), GTK_RELIEF_NONE);
+	gtk_widget_set_tooltip_text(tab->kill,
+			_("Not responding, click to kill"));
+	gtk_widget_set_no_show_all(tab->kill, TRUE);
+	gtk_box_pack_start(GTK_BOX(tab->widget), tab->kill, FALSE, TRUE, 0);
+	widget = gtk_button_new();
+	g_signal_connect_swapped(widget, "clicked", G_CALLBACK(
+				_terminal_on_tab_rename), tab);
+	gtk_container_add(GTK_CONTAINER(widget), gtk_image_new_from_icon_name(
+				"gtk-edit", GTK_ICON_SIZE_MENU));
+	gtk_button_set_relief(GTK_BUTTON(widget), GTK_RELIEF_NONE);
+	gtk_box_pack_start(GTK_BOX(tab->widget), widget, FALSE, TRUE, 0);
+	widget = gtk_button_new();
+	g_signal_connect_swapped(widget, "clicked", G_CALLBACK(
+				_terminal_on_tab_close), tab);
+	gtk_container_add(GTK_CONTAINER(widget), gtk_image_new_from_icon_name(
+				"gtk-close", GTK_ICON_SIZE_MENU));
+	gtk_button_set_relief(GTK_BUTTON(widget), GTK_RELIEF_NONE);
+	gtk_box_pack_start(GTK_BOX(tab->widget), widget, FALSE, TRUE, 0);
+	gtk_widget_show_all(tab->widget);
+	/* the page remains hidden until its widget is shown */
+	gtk_notebook_append_page(GTK_NOTEBOOK(terminal->notebook), tab->page,
+			tab->widget);
+#if GTK_CHECK_VERSION(2, 10, 0)
+	gtk_notebook_set_tab_reorderable(GTK_NOTEBOOK(terminal->notebook),
+			tab->page, TRUE);
+#endif
+	/* the tabs restored are only spawned once needed */
+	if(_terminal_journal_restoring && _terminal_journal_lazy)
+	{
+		tab->deferred = TRUE;
+		return tab;
+	}
+	if(_terminal_tab_spawn(terminal, tab) != 0)
+	{
+		/* the session was detached before */
+		if(session != NULL)
+		{
+			terminalsession_detach(session, NULL);
+			tab->session = NULL;
+		}
+		_terminal_tab_delete(terminal, tab);
+		return NULL;
+	}
+	return tab;
+}
+
+
+/* terminal_tab_delete */
+static void _terminal_tab_delete(Terminal * terminal, TerminalTab * tab)
+{
+	gint page;
+	TerminalReaping * reaping;
+
+	_terminal_control_event(tab, "closed", "");
+	if(_terminal_metrics != NULL && tab->id != 0)
+	{
+		_terminal_metrics_event(tab, TMET_CLOSED, tab->pid, 0);
+		/* timed until the process is reaped */
+		if(tab->pid >= 0)
+		{
+			reaping = &terminal->reaping[terminal->reaping_pos++
+				% TERMINAL_METRICS_REAPING];
+			reaping->pid = tab->pid;
+			reaping->id = tab->id;
+			reaping->closed = g_get_monotonic_time();
+		}
+	}
+	if(tab->opening)
+		trace_async_end("tab", tab->handle);
+	/* the reaper keeps watching the process until it exits, unless it
+	 * is not responding already */
+	if(tab->pid >= 0 && terminalreaper_kill(terminal->reaper, tab->pid,
+				(tab->hung != 0) ? SIGKILL : SIGTERM) != 0)
+		error_print(PROGNAME_TERMINAL);
+	_terminal_tab_set_hung(tab, FALSE, g_get_monotonic_time());
+	_terminal_tab_thaw(tab);
+	if(terminal->foreground == tab)
+		terminal->foreground = NULL;
+	if(tab->resize_source > 0)
+		g_source_remove(tab->resize_source);
+	if(tab->resize_handler > 0)
+		g_signal_handler_disconnect(tab->view, tab->resize_handler);
+	if(tab->size_source > 0)
+		g_source_remove(tab->size_source);
+	if(tab->tree != NULL)
+		terminalmonitor_tree_delete(tab->tree);
+	_terminal_journal_remove(terminal, tab);
+	/* this hangs the shell up */
+	if(tab->session != NULL)
+		terminalsession_delete(tab->session);
+	if((page = gtk_notebook_page_num(GTK_NOTEBOOK(terminal->notebook),
+					tab->page)) >= 0)
+		gtk_notebook_remove_page(GTK_NOTEBOOK(terminal->notebook),
+				page);
+	terminalwidget_delete(tab->backend);
+	string_delete(tab->journaled);
+	string_delete(tab->directory);
+	string_delete(tab->shell);
+	terminalstore_free(terminal->tabs, tab->handle);
+}
+
+
+/* terminal_tab_attach */
+static int _terminal_tab_attach(Terminal * terminal, TerminalTab * tab)
+{
+	int fd;
+	int res;
+	(void) terminal;
+
+	if((fd = terminalsession_attach(tab->session, _terminal_on_tab_session,
+					tab)) < 0)
+		return -1;
+	tab->spawned = g_get_monotonic_time();
+	/* the terminal emulator keeps its own copy */
+	res = terminalwidget_attach(tab->backend, fd);
+	tab->pid = terminalwidget_get_pid(tab->backend);
+	close(fd);
+	if(res != 0)
+		return res;
+	tab->attached = g_get_monotonic_time();
+	_terminal_tab_resize(tab);
+	return 0;
+}
+
+
+/* terminal_tab_detach */
+static void _terminal_tab_detach(Terminal * terminal, TerminalTab * tab)
+{
+	TerminalSession * session = tab->session;
+
+	/* the window and the process have to remain if possible */
+	if(terminal->tabs_cnt == 1 && _terminal_open_tab(terminal,
+				terminal->backend, NULL, NULL) == NULL)
+		error_print(PROGNAME_TERMINAL);
+	tab->session = NULL;
+	terminalsession_detach(session, gtk_label_get_text(
+				GTK_LABEL(tab->label)));
+	_terminal_close_tab(terminal, tab);
+}
+
+
+/* terminal_tab_get_directory */
+static int _terminal_tab_get_directory(TerminalTab * tab, char * buf,
+		size_t size)
+{
+	GPid pid;
+	GPid foreground;
+	ProcEntry * entries;
+	size_t entries_cnt;
+	size_t i;
+
+	if(tab->session != NULL)
+		pid = terminalsession_get_pid(tab->session);
+	else if(tab->pid <= 0)
+		return -1;
+	else if(tab->definition != &backend_xterm)
+		pid = tab->pid;
+	else
+	{
+		/* the shell is started by the xterm, looked up once */
+		if(tab->journal_pid <= 0)
+		{
+			if(proc_get_descendants(&tab->pid, 1, &entries,
+						&entries_cnt) != 0)
+				return -1;
+			for(i = 0; i < entries_cnt; i++)
+				if(entries[i].ppid == tab->pid)
+				{
+					tab->journal_pid = entries[i].pid;
+					break;
+				}
+			free(entries);
+		}
+		if((pid = tab->journal_pid) <= 0)
+			return -1;
+	}
+	/* where the job in the foreground runs, or the shell otherwise */
+	if(proc_get_foreground(pid, &foreground) == 0
+			&& proc_get_cwd(foreground, buf, size) == 0)
+		return 0;
+	return proc_get_cwd(pid, buf, size);
+}
+
+
+/* terminal_tab_history */
+static int _terminal_tab_history(Terminal * terminal, TerminalTab * tab)
+{
+	int ret;
+	char const * directory;
+	char const * homedir;
+	String * d = NULL;
+
+	if((directory = config_get(terminal->config, "history", "directory"))
+			== NULL || directory[0] == '\0')
+	{
+		if((homedir = getenv("HOME")) == NULL)
+			homedir = g_get_home_dir();
+		if((d = string_new_append(homedir, "/",
+						TERMINAL_HISTORY_DIRECTORY,
+						NULL)) == NULL)
+			return -1;
+		directory = d;
+	}
+	/* the history is private, and never kept once the tab is closed */
+	if(mkdir(directory, 0700) != 0 && errno != EEXIST)
+		ret = -error_set_code(1, "%s: %s", directory, strerror(errno));
+	else
+		ret = terminalsession_set_history(tab->session, directory,
+				terminal->history_size);
+	string_delete(d);
+	return ret;
+}
+
+
+/* terminal_tab_matches */
+static gboolean _terminal_tab_matches(Terminal * terminal, TerminalTab * tab)
+{
+	if(tab->definition != terminal->backend
+			|| tab->login != terminal->login)
+		return FALSE;
+	if((tab->shell == NULL) != (terminal->shell == NULL)
+			|| (tab->shell != NULL
+				&& strcmp(tab->shell, terminal->shell) != 0))
+		return FALSE;
+	if((tab->directory == NULL) != (terminal->directory == NULL)
+			|| (tab->directory != NULL
+				&& strcmp(tab->directory, terminal->directory)
+				!= 0))
+		return FALSE;
+	return TRUE;
+}
+
+
+/* terminal_tab_monitor */
+static void _terminal_tab_monitor(Terminal * terminal, TerminalTab * tab,
+		int memory)
+{
+	GtkNotebook * notebook = GTK_NOTEBOOK(terminal->notebook);
+	pid_t pids[2];
+	size_t pids_cnt = 0;
+	size_t jobs = tab->usage.jobs;
+	unsigned int depth;
+#if GTK_CHECK_VERSION(2, 12, 0)
+	char buf[160];
+#endif
+
+	if(tab->tree == NULL && (tab->tree = terminalmonitor_tree_new())
+			== NULL)
+	{
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+		return;
+	}
+	if(tab->pid > 0)
+		pids[pids_cnt++] = tab->pid;
+	if(tab->session != NULL)
+		pids[pids_cnt++] = terminalsession_get_pid(tab->session);
+	/* the jobs run below the shell, itself below xterm unless in a
+	 * session */
+	depth = (tab->session == NULL && tab->definition == &backend_xterm)
+		? 2 : 1;
+	if(terminalmonitor_sample(_terminal_monitor, tab->tree, pids,
+				pids_cnt, depth, memory, &tab->usage) != 0)
+	{
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", _("Monitor"),
+				strerror(errno));
+		return;
+	}
+	/* the last job of a tab in the background is done */
+	if(tab->usage.jobs > 0)
+		_terminal_tab_set_finished(tab, FALSE);
+	else if(jobs > 0 && gtk_notebook_page_num(notebook, tab->page)
+			!= gtk_notebook_get_current_page(notebook))
+		_terminal_tab_set_finished(tab, TRUE);
+	else
+		_terminal_tab_set_finished(tab, tab->finished);
+#if GTK_CHECK_VERSION(2, 12, 0)
+	snprintf(buf, sizeof(buf), _("CPU: %u%%, %lu job(s)\n"
+				"Memory: %lu MiB (PSS), %lu MiB (RSS)\n"
+				"Processes: %lu"), tab->usage.load,
+			(unsigned long)tab->usage.jobs, tab->usage.pss / 1024,
+			tab->usage.rss / 1024,
+			(unsigned long)tab->usage.processes);
+	gtk_widget_set_tooltip_text(tab->widget, buf);
+#endif
+}
+
+
+/* terminal_tab_record */
+static int _terminal_tab_record(Terminal * terminal, TerminalTab * tab)
+{
+	int ret;
+	char const * directory;
+	char const * homedir;
+	String * d = NULL;
+	String * filename;
+	time_t t;
+	struct tm tm;
+	char buf[32];
+
+	if((directory = config_get(terminal->config, "recording",
+					"directory")) == NULL
+			|| directory[0] == '\0')
+	{
+		if((homedir = getenv("HOME")) == NULL)
+			homedir = g_get_home_dir();
+		if((d = string_new_append(homedir, "/",
+						TERMINAL_RECORDING_DIRECTORY,
+						NULL)) == NULL)
+			return -1;
+		directory = d;
+	}
+	/* the recordings are private */
+	if(mkdir(directory, 0700) != 0 && errno != EEXIST)
+	{
+		ret = -error_set_code(1, "%s: %s", directory, strerror(errno));
+		string_delete(d);
+		return ret;
+	}
+	t = time(NULL);
+	strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", localtime_r(&t, &tm));
+	snprintf(&buf[strlen(buf)], sizeof(buf) - strlen(buf), "-%ld",
+			(long)terminalsession_get_pid(tab->session));
+	filename = string_new_append(directory, "/", buf, ".cast.gz", NULL);
+	string_delete(d);
+	if(filename == NULL)
+		return -1;
+	ret = terminalsession_record(tab->session, filename,
+			terminal->recording_size);
+	string_delete(filename);
+	return ret;
+}
+
+
+/* terminal_tab_resize */
+static void _terminal_tab_resize(TerminalTab * tab)
+{
+	/* the terminal emulator resizes its pty once it has noticed */
+	tab->resize_cnt = 0;
+	if(tab->resize_source == 0)
+		tab->resize_source = g_timeout_add(TERMINAL_RESIZE_DELAY,
+				_terminal_on_tab_resize, tab);
+}
+
+
+/* terminal_tab_set_background */
+static void _terminal_tab_set_background(Terminal * terminal,
+		TerminalTab * tab, gboolean background)
+{
+	GPid pids[2];
+	size_t pids_cnt = 0;
+	ProcEntry * entries;
+	size_t entries_cnt;
+	pid_t * p;
+	size_t i;
+	int res;
+
+	tab->background = background;
+	if(tab->pid > 0)
+		pids[pids_cnt++] = tab->pid;
+	if(tab->session != NULL)
+		pids[pids_cnt++] = terminalsession_get_pid(tab->session);
+	/* only the terminal emulator stops, never the shell */
+	if(terminal->freeze && tab->definition == &backend_xterm
+			&& tab->pid > 0 && tab->frozen != background
+			&& kill(tab->pid, background ? SIGSTOP : SIGCONT)
+			== 0)
+		tab->frozen = background;
+	if(!terminal->priority || _terminal_priority == NULL
+			|| pids_cnt == 0)
+		return;
+	/* along with every job started from the tab */
+	if(proc_get_descendants(pids, pids_cnt, &entries, &entries_cnt) != 0)
+	{
+		error_print(PROGNAME_TERMINAL);
+		return;
+	}
+	if((p = malloc(sizeof(*p) * (pids_cnt + entries_cnt))) == NULL)
+	{
+		free(entries);
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+		return;
+	}
+	for(i = 0; i < pids_cnt; i++)
+		p[i] = pids[i];
+	for(i = 0; i < entries_cnt; i++)
+		p[pids_cnt + i] = entries[i].pid;
+	res = background ? terminalpriority_background(_terminal_priority, p,
+			pids_cnt + entries_cnt)
+		: terminalpriority_foreground(_terminal_priority, p,
+				pids_cnt + entries_cnt);
+	if(res != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", _("Priority"),
+				strerror(errno));
+	free(p);
+	free(entries);
+}
+
+
+/* terminal_tab_set_budget */
+static void _terminal_tab_set_budget(Terminal * terminal, TerminalTab * tab,
+		gboolean exceeded)
+{
+	if(tab->exceeded == exceeded)
+		return;
+	tab->exceeded = exceeded;
+	if(!exceeded)
+	{
+		gtk_widget_hide(tab->warning);
+		if(tab->background && tab == terminal->foreground)
+			_terminal_tab_set_background(terminal, tab, FALSE);
+		return;
+	}
+	gtk_widget_show(tab->warning);
+	fprintf(stderr, _("%s: %s: Over the memory budget (%lu kB)\n"),
+			PROGNAME_TERMINAL, gtk_label_get_text(
+				GTK_LABEL(tab->label)), tab->usage.pss);
+	/* until selected again */
+	if(terminal->monitor_background && terminal->priority
+			&& !tab->background)
+		_terminal_tab_set_background(terminal, tab, TRUE);
+	/* the job using the most memory, never the shell itself */
+	if(terminal->monitor_signal > 0 && tab->usage.largest > 0
+			&& kill(tab->usage.largest, terminal->monitor_signal)
+			!= 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", _("Monitor"),
+				strerror(errno));
+}
+
+
+/* terminal_tab_set_finished */
+static void _terminal_tab_set_finished(TerminalTab * tab, gboolean finished)
+{
+	char buf[16] = "";
+
+	tab->finished = finished;
+	if(finished)
+		snprintf(buf, sizeof(buf), "%s", _("done"));
+	else if(tab->usage.load > 0)
+		snprintf(buf, sizeof(buf), "%u%%", tab->usage.load);
+	if(strcmp(gtk_label_get_text(GTK_LABEL(tab->activity)), buf) != 0)
+		gtk_label_set_text(GTK_LABEL(tab->activity), buf);
+}
+
+
+/* terminal_tab_set_hung */
+static void _terminal_tab_set_hung(TerminalTab * tab, gboolean hung,
+		gint64 now)
+{
+	char buf[64];
+
+	tab->suspected = 0;
+	if((tab->hung != 0) == hung)
+		return;
+	if(hung)
+	{
+		tab->hung = now;
+		gtk_widget_show(tab->kill);
+		fprintf(stderr, _("%s: %s: Not responding\n"),
+				PROGNAME_TERMINAL, gtk_label_get_text(
+					GTK_LABEL(tab->label)));
+		snprintf(buf, sizeof(buf), ",\"pid\":%ld", (long)tab->pid);
+		_terminal_control_event(tab, "hung", buf);
+		_terminal_metrics_event(tab, TMET_HUNG, tab->pid, 0);
+		return;
+	}
+	gtk_widget_hide(tab->kill);
+	/* until responding again, killed or closed */
+	_terminal_metrics_event(tab, TMET_HANG_ENDED, tab->pid,
+			now - tab->hung);
+	tab->hung = 0;
+}
+
+
+/* terminal_tab_set_label */
+static void _terminal_tab_set_label(TerminalTab * tab, char const * label)
+{
+	/* the title of the terminal is ignored from now on */
+	gtk_label_set_text(GTK_LABEL(tab->label), label);
+	tab->renamed = TRUE;
+	_terminal_journal_tab(tab);
+}
+
+
+/* terminal_tab_set_size */
+static void _terminal_tab_set_size(TerminalTab * tab)
+{
+	/* the terminal emulator reflows and notifies the shell */
+	tab->size_pending = FALSE;
+	tab->sized = g_get_monotonic_time();
+	gtk_widget_set_size_request(tab->view, tab->width, tab->height);
+}
+
+
+/* terminal_tab_spawn */
+static int _terminal_tab_spawn(Terminal * terminal, TerminalTab * tab)
+{
+	int res;
+
+	tab->deferred = FALSE;
+	trace_begin("spawn");
+	/* the shell may be kept running regardless of the backend */
+	if(tab->session == NULL && (terminal->sessions || terminal->recording
+				|| terminal->history || terminal->flood)
+			&& terminalwidget_can_attach(tab->backend))
+	{
+		if((tab->session = terminalsession_new(tab->directory,
+						tab->shell, tab->login,
+						terminal->sessions_replay))
+				== NULL)
+			error_print(PROGNAME_TERMINAL);
+		else
+		{
+			/* the shell is started anyway */
+			if(terminal->recording
+					&& _terminal_tab_record(terminal, tab)
+					!= 0)
+				error_print(PROGNAME_TERMINAL);
+			if(terminal->history
+					&& _terminal_tab_history(terminal, tab)
+					!= 0)
+				error_print(PROGNAME_TERMINAL);
+			if(terminal->flood && terminalsession_set_flood(
+						tab->session,
+						terminal->flood_rate) != 0)
+				error_print(PROGNAME_TERMINAL);
+		}
+	}
+	if(tab->session != NULL)
+		res = _terminal_tab_attach(terminal, tab);
+	else
+	{
+		tab->spawned = g_get_monotonic_time();
+		res = terminalwidget_start(tab->backend, tab->directory,
+				tab->shell, tab->login);
+		tab->pid = terminalwidget_get_pid(tab->backend);
+	}
+	trace_end("spawn");
+	if(res != 0)
+	{
+		error_print(PROGNAME_TERMINAL);
+		_terminal_metrics_event(NULL, TMET_SPAWN_FAILED, -1, 0);
+		tab->pid = -1;
+		return -1;
+	}
+	if(tab->session != NULL)
+		tab->resize_handler = g_signal_connect_swapped(tab->view,
+				"size-allocate", G_CALLBACK(
+					_terminal_on_tab_size_allocate), tab);
+	terminalstore_set_key(terminal->tabs, tab->handle, TTI_PID, tab->pid);
+	if(terminalreaper_add(terminal->reaper, tab->pid) != 0)
+	{
+		error_print(PROGNAME_TERMINAL);
+		terminalreaper_abandon(tab->pid, SIGTERM);
+		tab->pid = -1;
+		return -1;
+	}
+	return 0;
+}
+
+
+/* terminal_tab_thaw */
+static void _terminal_tab_thaw(TerminalTab * tab)
+{
+	/* the signals sent meanwhile are delivered */
+	if(tab->frozen && tab->pid > 0)
+		kill(tab->pid, SIGCONT);
+	tab->frozen = FALSE;
+}
+
+
+/* terminal_tab_watch */
+static void _terminal_tab_watch(Terminal * terminal, TerminalTab * tab,
+		gint64 now)
+{
+	char state;
+	unsigned long cpu;
+	gint64 elapsed = now - tab->watched;
+	gboolean busy;
+	char buf[64];
+
+	/* the process may be reaped already */
+	if(proc_get_state(tab->pid, &state, &cpu) != 0)
+		return;
+	/* running on a whole processor since the last check */
+	busy = (tab->watched > 0 && cpu >= tab->cpu
+			&& (gint64)(cpu - tab->cpu) * 1000 >= elapsed * 9 / 10);
+	tab->watched = now;
+	tab->cpu = cpu;
+	/* stopped, blocked within the kernel or busy */
+	if(state != 'T' && state != 't' && state != 'D' && !busy)
+	{
+		if(tab->hung != 0)
+		{
+			snprintf(buf, sizeof(buf), ",\"pid\":%ld,"
+					"\"duration\":%ld", (long)tab->pid,
+					(long)((now - tab->hung) / 1000));
+			_terminal_control_event(tab, "responding", buf);
+		}
+		_terminal_tab_set_hung(tab, FALSE, now);
+	}
+	else if(tab->suspected == 0)
+		tab->suspected = now;
+	else if(tab->hung == 0 && now - tab->suspected
+			>= (gint64)terminal->watchdog_timeout * 1000)
+		_terminal_tab_set_hung(tab, TRUE, now);
+}
+
+
+/* callbacks */
+/* terminal_on_child_watch */
+static void _terminal_on_child_watch(void * data, GPid pid, int status)
+{
+	Terminal * terminal = data;
+	TerminalTab * tab;
+	size_t i;
+
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(%d, %d)\n", __func__, pid, status);
+#endif
+	if((tab = terminalstore_lookup(terminal->tabs, TTI_PID, pid, NULL))
+			== NULL)
+	{
+		/* the tab may have been closed already */
+		_terminal_metrics_reaped(terminal, pid);
+		return;
+	}
+	_terminal_metrics_exited(tab, pid, status);
+	if(tab->pooled)
+	{
+		/* this xterm was in the pool */
+		for(i = 0; i < terminal->pool_cnt; i++)
+			if(terminal->pool[i] == tab)
+			{
+				tab->pid = -1;
+				_terminal_pool_remove(terminal, i);
+				break;
+			}
+		_terminal_pool_refill(terminal);
+		return;
+	}
+	if(WIFEXITED(status))
+	{
+		if(WEXITSTATUS(status) != 0)
+			fprintf(stderr, "%s: %s: %s%u\n", PROGNAME_TERMINAL,
+					tab->definition->name,
+					_("exited with status "),
+					WEXITSTATUS(status));
+	}
+	else if(WIFSIGNALED(status))
+	{
+		fprintf(stderr, "%s: %s: %s%u\n", PROGNAME_TERMINAL,
+				tab->definition->name,
+				_("exited with signal "), WTERMSIG(status));
+		/* restored along with the next session */
+		tab->crashed = TRUE;
+	}
+	else
+		return;
+	_terminal_control_exited(tab, tab->definition->name, pid, status);
+	_terminal_tab_set_hung(tab, FALSE, g_get_monotonic_time());
+	tab->pid = -1;
+	tab->frozen = FALSE;
+	if(tab->session == NULL || terminal->closing)
+	{
+		_terminal_close_tab(terminal, tab);
+		return;
+	}
+	/* the shell survives its terminal emulator */
+	terminalstore_set_key(terminal->tabs, tab->handle, TTI_PID, 0);
+	if(g_get_monotonic_time() - tab->attached >= TERMINAL_SESSION_DELAY
+			&& _terminal_tab_attach(terminal, tab) == 0)
+	{
+		terminalstore_set_key(terminal->tabs, tab->handle, TTI_PID,
+				tab->pid);
+		if(terminalreaper_add(terminal->reaper, tab->pid) == 0)
+		{
+			if(tab->background)
+				_terminal_tab_set_background(terminal, tab,
+						TRUE);
+			return;
+		}
+		terminalreaper_abandon(tab->pid, SIGTERM);
+		tab->pid = -1;
+		terminalstore_set_key(terminal->tabs, tab->handle, TTI_PID, 0);
+	}
+	/* do not insist if it keeps failing */
+	fprintf(stderr, "%s: %s: %s\n", PROGNAME_TERMINAL,
+			tab->definition->name, _("Session detached"));
+	_terminal_tab_detach(terminal, tab);
+}
+
+
+/* terminal_on_close */
+static void _terminal_on_close(gpointer data)
+{
+	Terminal * terminal = data;
+	GtkNotebook * notebook = GTK_NOTEBOOK(terminal->notebook);
+	GtkWidget * page;
+	TerminalTab * tab;
+	int i;
+
+	/* the tabs may have been reordered */
+	if((i = gtk_notebook_get_current_page(notebook)) < 0
+			|| (page = gtk_notebook_get_nth_page(notebook, i))
+			== NULL
+			|| (tab = terminalstore_lookup(terminal->tabs,
+					TTI_PAGE, (uintptr_t)page, NULL))
+			== NULL)
+		return;
+	_terminal_close_tab(terminal, tab);
+}
+
+
+/* terminal_on_closex */
+static gboolean _on_closex_confirm(Terminal * terminal);
+
+static gboolean _terminal_on_closex(gpointer data)
+{
+	Terminal * terminal = data;
+
+	if(terminal->tabs_cnt > 1 && _on_closex_confirm(terminal) != TRUE)
+		return TRUE;
+	_terminal_close_all(terminal);
+	return TRUE;
+}
+
+static gboolean _on_closex_confirm(Terminal * terminal)
+{
+	GtkWidget * dialog;
+	gboolean res;
+
+	dialog = gtk_message_dialog_new(GTK_WINDOW(terminal->window),
+			GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+			GTK_MESSAGE_QUESTION, GTK_BUTTONS_NONE,
+#if GTK_CHECK_VERSION(2, 6, 0)
+			"%s", _("Question"));
+	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+#endif
+			"%s", _("There are multiple tabs opened.\n"
+				"Do you really want to close every tab"
+				" opened in this window?"));
+	gtk_dialog_add_buttons(GTK_DIALOG(dialog),
+			GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+			GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, NULL);
+	gtk_window_set_title(GTK_WINDOW(dialog), _("Question"));
+	res = gtk_dialog_run(GTK_DIALOG(dialog));
+	gtk_widget_destroy(dialog);
+	return (res == GTK_RESPONSE_CLOSE) ? TRUE : FALSE;
+}
+
+
+/* terminal_on_control */
+static int _on_control_close(TerminalControlRequest const * request);
+static int _on_control_focus(TerminalControlRequest const * request);
+static int _on_control_list(TerminalControlRequest const * request,
+		GString * reply);
+static int _on_control_objects(GString * reply);
+static int _on_control_open(TerminalControlRequest const * request,
+		GString * reply);
+static int _on_control_prefs(Terminal * terminal,
+		TerminalControlRequest const * request, TerminalPrefs * prefs);
+static int _on_control_rename(TerminalControlRequest const * request);
+static int _on_control_search(TerminalControlRequest const * request,
+		GString * reply);
+static int _on_control_window(TerminalControlRequest const * request,
+		GString * reply);
+
+static int _terminal_on_control(void * data, char const * command,
+		TerminalControlRequest const * request, GString * reply)
+{
+	(void) data;
+
+	if(strcmp(command, "close") == 0)
+		return _on_control_close(request);
+	if(strcmp(command, "focus") == 0)
+		return _on_control_focus(request);
+	if(strcmp(command, "list") == 0)
+		return _on_control_list(request, reply);
+	if(strcmp(command, "objects") == 0)
+		return _on_control_objects(reply);
+	if(strcmp(command, "open") == 0)
+		return _on_control_open(request, reply);
+	if(strcmp(command, "rename") == 0)
+		return _on_control_rename(request);
+	if(strcmp(command, "search") == 0)
+		return _on_control_search(request, reply);
+	if(strcmp(command, "window") == 0)
+		return _on_control_window(request, reply);
+	return -error_set_code(1, "%s: %s", command, _("Unknown command"));
+}
+
+static int _on_control_close(TerminalControlRequest const * request)
+{
+	TerminalTab * tab;
+
+	if((tab = _terminal_control_get_tab(request)) == NULL)
+		return -1;
+	_terminal_close_tab(tab->terminal, tab);
+	return 0;
+}
+
+static int _on_control_focus(TerminalControlRequest const * request)
+{
+	TerminalTab * tab;
+	GtkNotebook * notebook;
+
+	if((tab = _terminal_control_get_tab(request)) == NULL)
+		return -1;
+	notebook = GTK_NOTEBOOK(tab->terminal->notebook);
+	gtk_notebook_set_current_page(notebook, gtk_notebook_page_num(
+				notebook, tab->page));
+	gtk_window_present(GTK_WINDOW(tab->terminal->window));
+	return 0;
+}
+
+static int _on_control_list(TerminalControlRequest const * request,
+		GString * reply)
+{
+	unsigned int id = 0;
+	size_t i;
+	TerminalStoreHandle handle;
+	TerminalTab * tab;
+	size_t cnt = 0;
+
+	/* every window by default */
+	if(terminalcontrol_request_get_uint(request, "window", &id) != 0)
+		return -1;
+	g_string_append(reply, ",\"tabs\":[");
+	for(i = 0; i < _terminal_windows_cnt; i++)
+	{
+		if(_terminal_windows[i]->closing
+				|| (id != 0 && _terminal_windows[i]->id != id))
+			continue;
+		handle = TERMINALSTORE_HANDLE_NONE;
+		while((tab = terminalstore_get_next(_terminal_windows[i]->tabs,
+						&handle)) != NULL)
+		{
+			if(tab->id == 0)
+				continue;
+			if(cnt++ > 0)
+				g_string_append_c(reply, ',');
+			_terminal_control_append_tab(reply, tab);
+		}
+	}
+	g_string_append_c(reply, ']');
+	return 0;
+}
+
+#if GLIB_CHECK_VERSION(2, 44, 0)
+static unsigned long _objects_count(GType type);
+#endif
+
+static int _on_control_objects(GString * reply)
+{
+#if GLIB_CHECK_VERSION(2, 44, 0)
+	gchar const * debug;
+
+	/* the instances are only counted if requested to GObject */
+	if((debug = g_getenv("GOBJECT_DEBUG")) == NULL
+			|| strstr(debug, "instance-count") == NULL)
+		return -error_set_code(1, "%s", _("Set GOBJECT_DEBUG to"
+					" instance-count to count the objects"));
+	g_string_append_printf(reply, ",\"objects\":%lu,\"widgets\":%lu",
+			_objects_count(G_TYPE_OBJECT),
+			_objects_count(GTK_TYPE_WIDGET));
+	return 0;
+#else
+	(void) reply;
+
+	return -error_set_code(1, "%s", strerror(ENOSYS));
+#endif
+}
+
+#if GLIB_CHECK_VERSION(2, 44, 0)
+static unsigned long _objects_count(GType type)
+{
+	unsigned long ret;
+	GType * children;
+	guint cnt;
+	guint i;
+
+	/* including the instances of every derived type */
+	ret = g_type_get_instance_count(type);
+	children = g_type_children(type, &cnt);
+	for(i = 0; i < cnt; i++)
+		ret += _objects_count(children[i]);
+	g_free(children);
+	return ret;
+}
+#endif
+
+static int _on_control_open(TerminalControlRequest const * request,
+		GString * reply)
+{
+	Terminal * terminal;
+	TerminalBackendDefinition const * definition;
+	TerminalPrefs prefs;
+	TerminalPrefs const * p = NULL;
+	char const * backend;
+	char const * title;
+	unsigned int count = 1;
+	unsigned int i;
+	TerminalTab * tab;
+	int ret = 0;
+
+	if((terminal = _terminal_control_get_window(request)) == NULL
+			|| _on_control_prefs(terminal, request, &prefs) != 0)
+		return -1;
+	definition = terminal->backend;
+	if((backend = terminalcontrol_request_get_string(request, "backend"))
+			!= NULL
+			&& (definition = backend_lookup(backend)) == NULL)
+		return -error_set_code(1, "%s: %s", backend,
+				_("Unknown backend"));
+	if(terminalcontrol_request_get_uint(request, "count", &count) != 0)
+		return -1;
+	if(count == 0 || count > TERMINAL_CONTROL_COUNT)
+		return -error_set_code(1, "%s: %s", "count",
+				_("Invalid value"));
+	title = terminalcontrol_request_get_string(request, "title");
+	/* the pool can be used with the settings of the window */
+	if(prefs.shell != terminal->shell
+			|| prefs.directory != terminal->directory
+			|| prefs.login != terminal->login)
+		p = &prefs;
+	g_string_append(reply, ",\"tabs\":[");
+	for(i = 0; i < count; i++)
+	{
+		if((tab = _terminal_open_tab(terminal, definition, p, NULL))
+				== NULL)
+		{
+			ret = -1;
+			break;
+		}
+		if(title != NULL)
+			_terminal_tab_set_label(tab, title);
+		g_string_append_printf(reply, "%s%u", (i > 0) ? "," : "",
+				tab->id);
+	}
+	g_string_append_c(reply, ']');
+	return ret;
+}
+
+static int _on_control_prefs(Terminal * terminal,
+		TerminalControlRequest const * request, TerminalPrefs * prefs)
+{
+	/* the settings of the window otherwise */
+	prefs->shell = terminalcontrol_request_get_string(request, "shell");
+	if(prefs->shell == NULL && terminal != NULL)
+		prefs->shell = terminal->shell;
+	prefs->directory = terminalcontrol_request_get_string(request,
+			"directory");
+	if(prefs->directory == NULL && terminal != NULL)
+		prefs->directory = terminal->directory;
+	prefs->login = (terminal != NULL) ? terminal->login : 0;
+	if(terminalcontrol_request_get_boolean(request, "login",
+				&prefs->login) != 0)
+		return -1;
+	prefs->restore = 0;
+	/* the client runs in a different directory */
+	if(prefs->directory != NULL && prefs->directory[0] != '/')
+		return -error_set_code(1, "%s: %s", prefs->directory,
+				_("The directory must be absolute"));
+	/* consistency check */
+	if(prefs->shell != NULL)
+		prefs->login = 0;
+	else if(prefs->login != 0)
+		prefs->directory = NULL;
+	return 0;
+}
+
+static int _on_control_rename(TerminalControlRequest const * request)
+{
+	TerminalTab * tab;
+	char const * title;
+
+	if((tab = _terminal_control_get_tab(request)) == NULL)
+		return -1;
+	if((title = terminalcontrol_request_get_string(request, "title"))
+			== NULL)
+		return -error_set_code(1, "%s: %s", "title",
+				_("Invalid value"));
+	_terminal_tab_set_label(tab, title);
+	return 0;
+}
+
+static int _search_on_match(void * data, size_t offset, char const * line,
+		size_t len);
+
+static int _on_control_search(TerminalControlRequest const * request,
+		GString * reply)
+{
+	TerminalSearch search;
+	char const * string;
+	unsigned int focus = 0;
+	gint64 start;
+	size_t i;
+	TerminalStoreHandle handle;
+	TerminalTab * tab;
+	TerminalTab * first = NULL;
+	TerminalHistory * history;
+	GtkNotebook * notebook;
+
+	if((string = terminalcontrol_request_get_string(request, "string"))
+			== NULL || string[0] == '\0')
+		return -error_set_code(1, "%s: %s", "string",
+				_("Invalid value"));
+	search.count = TERMINAL_SEARCH_COUNT;
+	if(terminalcontrol_request_get_uint(request, "count", &search.count)
+			!= 0
+			|| terminalcontrol_request_get_boolean(request, "focus",
+				&focus) != 0)
+		return -1;
+	if(search.count == 0)
+		return -error_set_code(1, "%s: %s", "count",
+				_("Invalid value"));
+	search.reply = reply;
+	search.cnt = 0;
+	start = g_get_monotonic_time();
+	g_string_append(reply, ",\"matches\":[");
+	for(i = 0; i < _terminal_windows_cnt && search.cnt < search.count;
+			i++)
+	{
+		if(_terminal_windows[i]->closing)
+			continue;
+		handle = TERMINALSTORE_HANDLE_NONE;
+		while(search.cnt < search.count
+				&& (tab = terminalstore_get_next(
+						_terminal_windows[i]->tabs,
+						&handle)) != NULL)
+		{
+			if(tab->id == 0 || tab->session == NULL)
+				continue;
+			history = terminalsession_get_history(tab->session);
+			if(history == NULL)
+				continue;
+			search.tab = tab;
+			if(terminalhistory_search(history, string,
+						_search_on_match, &search) < 0)
+				return -error_set_code(1, "%s",
+						strerror(errno));
+			if(first == NULL && search.cnt > 0)
+				first = tab;
+		}
+	}
+	g_string_append_printf(reply, "],\"search_us\":%ld",
+			(long)(g_get_monotonic_time() - start));
+	/* jumps to the first match */
+	if(focus && first != NULL)
+	{
+		notebook = GTK_NOTEBOOK(first->terminal->notebook);
+		gtk_notebook_set_current_page(notebook, gtk_notebook_page_num(
+					notebook, first->page));
+		gtk_window_present(GTK_WINDOW(first->terminal->window));
+	}
+	return 0;
+}
+
+static int _search_on_match(void * data, size_t offset, char const * line,
+		size_t len)
+{
+	TerminalSearch * search = data;
+	char buf[TERMINAL_SEARCH_LINE];
+
+	/* the lines are truncated, between two characters */
+	if(len >= sizeof(buf))
+		for(len = sizeof(buf) - 1; len > 0
+				&& ((unsigned char)line[len] & 0xc0) == 0x80;
+				len--);
+	memcpy(buf, line, len);
+	buf[len] = '\0';
+	g_string_append_printf(search->reply, "%s{\"tab\":%u,\"window\":%u,"
+			"\"offset\":%lu,\"line\":", (search->cnt > 0) ? ","
+			: "", search->tab->id, search->tab->terminal->id,
+			(unsigned long)offset);
+	terminalcontrol_append_string(search->reply, buf);
+	g_string_append_c(search->reply, '}');
+	return (++search->cnt >= search->count) ? 1 : 0;
+}
+
+static int _on_control_window(TerminalControlRequest const * request,
+		GString * reply)
+{
+	TerminalPrefs prefs;
+	Terminal * terminal;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+	size_t cnt = 0;
+
+	if(_on_control_prefs(NULL, request, &prefs) != 0
+			|| (terminal = terminal_new(&prefs)) == NULL)
+		return -1;
+	g_string_append_printf(reply, ",\"window\":%u,\"tabs\":[",
+			terminal->id);
+	/* along with its first tab */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+		if(tab->id != 0)
+			g_string_append_printf(reply, "%s%u", (cnt++ > 0)
+					? "," : "", tab->id);
+	g_string_append_c(reply, ']');
+	return 0;
+}
+
+
+/* terminal_on_delete */
+static gboolean _terminal_on_delete(gpointer data)
+{
+	Terminal * terminal = data;
+
+	terminal->source = 0;
+	terminal_delete(terminal);
+	return FALSE;
+}
+
+
+/* terminal_on_fullscreen */
+static void _terminal_on_fullscreen(gpointer data)
+{
+	Terminal * terminal = data;
+
+	terminal_set_fullscreen(terminal, terminal->fullscreen ? FALSE : TRUE);
+}
+
+
+/* terminal_on_journal */
+static gboolean _terminal_on_journal(gpointer data)
+{
+	TerminalStoreHandle handle;
+	TerminalTab * tab;
+	size_t i;
+	char buf[PATH_MAX];
+	(void) data;
+
+	for(i = 0; i < _terminal_windows_cnt; i++)
+	{
+		if(_terminal_windows[i]->closing)
+			continue;
+		handle = TERMINALSTORE_HANDLE_NONE;
+		while((tab = terminalstore_get_next(_terminal_windows[i]->tabs,
+						&handle)) != NULL)
+		{
+			/* only journaled again when changed */
+			if(tab->id == 0 || _terminal_tab_get_directory(tab,
+						buf, sizeof(buf)) != 0
+					|| (tab->journaled != NULL
+						&& strcmp(tab->journaled, buf)
+						== 0))
+				continue;
+			string_delete(tab->journaled);
+			tab->journaled = string_new(buf);
+			_terminal_journal_tab(tab);
+		}
+	}
+	return TRUE;
+}
+
+
+/* terminal_on_journal_spawn */
+static gboolean _terminal_on_journal_spawn(gpointer data)
+{
+	Terminal * terminal = data;
+	GtkNotebook * notebook = GTK_NOTEBOOK(terminal->notebook);
+	GtkWidget * page;
+	TerminalTab * tab = NULL;
+	gint i;
+	gint cnt;
+
+	terminal->journal_source = 0;
+	if(terminal->closing)
+		return FALSE;
+	/* the current tab first, then the others in order */
+	cnt = gtk_notebook_get_n_pages(notebook);
+	for(i = -1; i < cnt; i++)
+	{
+		page = gtk_notebook_get_nth_page(notebook, (i < 0)
+				? gtk_notebook_get_current_page(notebook) : i);
+		if(page != NULL && (tab = terminalstore_lookup(terminal->tabs,
+						TTI_PAGE, (uintptr_t)page,
+						NULL)) != NULL && tab->deferred)
+			break;
+		tab = NULL;
+	}
+	if(tab == NULL)
+		return FALSE;
+	if(_terminal_tab_spawn(terminal, tab) != 0)
+		_terminal_close_tab(terminal, tab);
+	if(!terminal->closing && _terminal_journal_stagger > 0)
+		terminal->journal_source = g_timeout_add_full(G_PRIORITY_LOW,
+				_terminal_journal_stagger,
+				_terminal_on_journal_spawn, terminal, NULL);
+	return FALSE;
+}
+
+
+/* terminal_on_metrics */
+static gboolean _terminal_on_metrics(GIOChannel * channel,
+		GIOCondition condition, gpointer data)
+{
+	(void) channel;
+	(void) condition;
+	(void) data;
+
+	/* the clients not reading fast enough only get a part */
+	if(_terminal_metrics_export(NULL, 0) != 0 && errno != EAGAIN)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s", _("Metrics"),
+				strerror(errno));
+	return TRUE;
+}
+
+
+/* terminal_on_metrics_signal */
+static gboolean _terminal_on_metrics_signal(gpointer data)
+{
+	(void) data;
+
+	if(_terminal_metrics_file != NULL && _terminal_metrics_export(
+				_terminal_metrics_file, 0) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s",
+				_terminal_metrics_file, strerror(errno));
+	if(_terminal_metrics_events != NULL && _terminal_metrics_export(
+				_terminal_metrics_events, 1) != 0)
+		error_set_print(PROGNAME_TERMINAL, 1, "%s: %s",
+				_terminal_metrics_events, strerror(errno));
+	return TRUE;
+}
+
+
+/* terminal_on_monitor */
+static gboolean _terminal_on_monitor(gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+	TerminalTab * largest = NULL;
+	unsigned long total = 0;
+	gboolean exceeded;
+	gint64 start;
+	int memory;
+	guint period;
+
+	start = g_get_monotonic_time();
+	if((memory = (start - terminal->monitor_sampled
+					>= terminal->monitor_memory * 1000)))
+		terminal->monitor_sampled = start;
+	/* every tab is sampled at once, then checked against the budgets */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		if(tab->pooled)
+			continue;
+		_terminal_tab_monitor(terminal, tab, memory);
+		total += tab->usage.pss;
+		if(largest == NULL || tab->usage.pss > largest->usage.pss)
+			largest = tab;
+	}
+	handle = TERMINALSTORE_HANDLE_NONE;
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		if(tab->pooled)
+			continue;
+		exceeded = (terminal->monitor_tab > 0
+				&& tab->usage.pss > terminal->monitor_tab)
+			|| (terminal->monitor_window > 0 && tab == largest
+					&& total > terminal->monitor_window);
+		_terminal_tab_set_budget(terminal, tab, exceeded);
+	}
+#ifndef EMBEDDED
+	if(terminal->activity != NULL)
+		_terminal_activity_update(terminal);
+#endif
+	/* sampling never takes more than 0.5% of the time */
+	period = MAX(terminal->monitor_interval,
+			(g_get_monotonic_time() - start) / 5);
+	if(period <= terminal->monitor_period
+			&& period > terminal->monitor_period / 2)
+		return TRUE;
+	terminal->monitor_period = period;
+	terminal->monitor_source = g_timeout_add(period, _terminal_on_monitor,
+			terminal);
+	return FALSE;
+}
+
+
+/* terminal_on_new_tab */
+static void _terminal_on_new_tab(gpointer data)
+{
+	Terminal * terminal = data;
+
+	_terminal_open_tab(terminal, terminal->backend, NULL, NULL);
+}
+
+
+/* terminal_on_new_window */
+static void _terminal_on_new_window(gpointer data)
+{
+	Terminal * terminal = data;
+
+	_terminal_open_window(terminal);
+}
+
+
+/* terminal_on_page_reordered */
+static void _terminal_on_page_reordered(GtkWidget * widget, GtkWidget * page,
+		guint num, gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+	(void) widget;
+	(void) page;
+	(void) num;
+
+	/* the positions of the other tabs may have changed as well */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+		_terminal_journal_tab(tab);
+}
+
+
+/* terminal_on_pool_fill */
+static gboolean _terminal_on_pool_fill(gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalTab * tab;
+
+	/* start one xterm at a time, and do not insist on errors */
+	if(terminal->pool_cnt >= terminal->pool_size
+			|| (tab = _terminal_tab_new(terminal,
+					terminal->backend, NULL, NULL))
+			== NULL)
+	{
+		terminal->pool_source = 0;
+		return FALSE;
+	}
+	tab->pooled = TRUE;
+	terminal->pool[terminal->pool_cnt++] = tab;
+	if(terminal->pool_cnt < terminal->pool_size)
+		return TRUE;
+	terminal->pool_source = 0;
+	return FALSE;
+}
+
+
+/* terminal_on_shutdown */
+static void _terminal_on_shutdown(void * data,
+		TerminalReaperReport const * report)
+{
+	Terminal * terminal = data;
+	size_t i;
+
+	if(report->terminated > 0)
+		fprintf(stderr, _("%s: Shutdown: %lu ms, %lu process(es)"
+					" terminated, %lu killed\n"),
+				PROGNAME_TERMINAL, report->duration,
+				(unsigned long)report->terminated,
+				(unsigned long)report->killed_cnt);
+	for(i = 0; i < report->killed_cnt; i++)
+		fprintf(stderr, _("%s: Shutdown: killed %ld (%s)\n"),
+				PROGNAME_TERMINAL, (long)report->killed[i].pid,
+				report->killed[i].name);
+	/* the reaper may still be in use by the current callback */
+	if(terminal->source == 0)
+		terminal->source = g_idle_add(_terminal_on_delete, terminal);
+}
+
+
+/* terminal_on_switch_page */
+static void _terminal_on_switch_page(GtkWidget * widget, gpointer page,
+		guint num, gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalTab * tab;
+	(void) page;
+
+	if(terminal->closing || (tab = terminalstore_lookup(terminal->tabs,
+					TTI_PAGE, (uintptr_t)
+					gtk_notebook_get_nth_page(
+						GTK_NOTEBOOK(widget), num),
+					NULL)) == NULL)
+		return;
+	if(tab->size_pending)
+		_terminal_tab_set_size(tab);
+	if(tab->finished)
+		_terminal_tab_set_finished(tab, FALSE);
+	/* spawned once idle, as the page is being switched */
+	if(tab->deferred)
+	{
+		if(terminal->journal_source > 0)
+			g_source_remove(terminal->journal_source);
+		terminal->journal_source = g_idle_add(
+				_terminal_on_journal_spawn, terminal);
+	}
+	if(tab == terminal->foreground)
+		return;
+	/* the tab in the foreground gets its priority back first */
+	if(tab->background)
+		_terminal_tab_set_background(terminal, tab, FALSE);
+	if(terminal->foreground != NULL)
+		_terminal_tab_set_background(terminal, terminal->foreground,
+				TRUE);
+	terminal->foreground = tab;
+}
 
 
 /* terminal_on_tab_close */
 static void _terminal_on_tab_close(gpointer data)
 {
 	TerminalTab * tab = data;
-	size_t i;
 
-	for(i = 0; i < tab->terminal->tabs_cnt; i++)
-		if(tab->terminal->tabs[i]->widget == tab->widget)
-			break;
-	if(i >= tab->terminal->tabs_cnt)
-		/* should not happen */
+	_terminal_close_tab(tab->terminal, tab);
+}
+
+
+/* terminal_on_tab_kill */
+static void _terminal_on_tab_kill(gpointer data)
+{
+	TerminalTab * tab = data;
+
+	/* the tab closes, or attaches to a new one, once reaped */
+	if(tab->pid > 0 && terminalreaper_kill(tab->terminal->reaper,
+				tab->pid, SIGKILL) != 0)
+		error_print(PROGNAME_TERMINAL);
+}
+
+
+/* terminal_on_tab_config_get */
+static char const * _terminal_on_tab_config_get(void * data,
+		char const * variable)
+{
+	TerminalTab * tab = data;
+	char const * ret;
+
+	ret = config_get(tab->terminal->config, tab->definition->name,
+			variable);
+	/* the scrollback is kept by the history otherwise */
+	if(ret == NULL && strcmp(variable, "savelines") == 0
+			&& tab->session != NULL
+			&& terminalsession_get_history(tab->session) != NULL)
+		ret = TERMINAL_HISTORY_SAVELINES;
+	return ret;
+}
+
+
+/* terminal_on_tab_page_allocate */
+static void _terminal_on_tab_page_allocate(GtkWidget * widget,
+		GtkAllocation * allocation, gpointer data)
+{
+	TerminalTab * tab = data;
+	GtkNotebook * notebook = GTK_NOTEBOOK(tab->terminal->notebook);
+	gint64 delay;
+
+	if(allocation->width == tab->width
+			&& allocation->height == tab->height)
+		return;
+	tab->width = allocation->width;
+	tab->height = allocation->height;
+	/* the tabs hidden only get the last size, once selected */
+	if(tab->sized != 0 && gtk_notebook_page_num(notebook, widget)
+			!= gtk_notebook_get_current_page(notebook))
+	{
+		tab->size_pending = TRUE;
+		return;
+	}
+	/* the tab visible follows at a limited rate */
+	if(tab->size_source > 0)
 		return;
-	_terminal_close_tab(tab->terminal, i);
+	delay = tab->sized + TERMINAL_RESIZE_INTERVAL * 1000
+		- g_get_monotonic_time();
+	if(delay <= 0)
+		_terminal_tab_set_size(tab);
+	else
+		tab->size_source = g_timeout_add(delay / 1000 + 1,
+				_terminal_on_tab_size, tab);
+}
+
+
+/* terminal_on_tab_ready */
+static void _terminal_on_tab_ready(void * data)
+{
+	TerminalTab * tab = data;
+
+	tab->ready = TRUE;
+	if(tab->opening)
+	{
+		trace_async_end("tab", tab->handle);
+		tab->opening = FALSE;
+	}
+	_terminal_control_event(tab, "plugged", "");
+	/* including the tabs in the pool, from the start of the process */
+	if(tab->spawned != 0)
+	{
+		_terminal_metrics_event(tab, TMET_PLUGGED, tab->pid,
+				g_get_monotonic_time() - tab->spawned);
+		tab->spawned = 0;
+	}
 }
 
 
@@ -650,13 +3428,220 @@ static void _terminal_on_tab_rename(gpointer data)
 	if(gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK)
 	{
 		p = gtk_entry_get_text(GTK_ENTRY(entry));
-		gtk_label_set_text(GTK_LABEL(tab->label), p);
+		_terminal_tab_set_label(tab, p);
 	}
 	gtk_widget_destroy(dialog);
 }
 
 
+/* terminal_on_tab_resize */
+static gboolean _terminal_on_tab_resize(gpointer data)
+{
+	TerminalTab * tab = data;
+
+	if(terminalsession_resize(tab->session) == 0
+			&& ++tab->resize_cnt < TERMINAL_RESIZE_COUNT)
+		return TRUE;
+	tab->resize_source = 0;
+	return FALSE;
+}
+
+
+/* terminal_on_tab_session */
+static void _terminal_on_tab_session(void * data, TerminalSession * session,
+		int status)
+{
+	TerminalTab * tab = data;
+	Terminal * terminal = tab->terminal;
+	size_t i;
+
+	_terminal_control_exited(tab, "session", terminalsession_get_pid(
+				session), status);
+	if(WIFEXITED(status) && WEXITSTATUS(status) != 0)
+		fprintf(stderr, "%s: %s: %s%u\n", PROGNAME_TERMINAL,
+				_("Session"), _("exited with status "),
+				WEXITSTATUS(status));
+	else if(WIFSIGNALED(status))
+		fprintf(stderr, "%s: %s: %s%u\n", PROGNAME_TERMINAL,
+				_("Session"), _("exited with signal "),
+				WTERMSIG(status));
+	/* the terminal emulator is terminated along with the tab */
+	terminalsession_delete(session);
+	tab->session = NULL;
+	if(tab->pooled == FALSE)
+	{
+		_terminal_close_tab(terminal, tab);
+		return;
+	}
+	for(i = 0; i < terminal->pool_cnt; i++)
+		if(terminal->pool[i] == tab)
+		{
+			_terminal_pool_remove(terminal, i);
+			break;
+		}
+	_terminal_pool_refill(terminal);
+}
+
+
+/* terminal_on_tab_size */
+static gboolean _terminal_on_tab_size(gpointer data)
+{
+	TerminalTab * tab = data;
+
+	tab->size_source = 0;
+	_terminal_tab_set_size(tab);
+	return FALSE;
+}
+
+
+/* terminal_on_tab_size_allocate */
+static void _terminal_on_tab_size_allocate(gpointer data)
+{
+	TerminalTab * tab = data;
+
+	_terminal_tab_resize(tab);
+}
+
+
+/* terminal_on_tab_title */
+static void _terminal_on_tab_title(void * data, char const * title)
+{
+	TerminalTab * tab = data;
+
+	/* the name chosen by the user prevails */
+	if(tab->renamed == FALSE)
+		gtk_label_set_text(GTK_LABEL(tab->label), title);
+}
+
+
+/* terminal_on_vbox */
+static gboolean _terminal_on_vbox(gpointer data)
+{
+	Terminal * terminal = data;
+	GtkWidget * widget;
+	GtkToolItem * toolitem;
+	gint position = 0;
+
+	terminal->vbox_source = 0;
+#ifndef EMBEDDED
+	/* menubar */
+	trace_begin("menubar");
+	terminal->menubar = desktop_menubar_create(_terminal_menubar, terminal,
+			terminal->group);
+	gtk_box_pack_start(GTK_BOX(terminal->vbox), terminal->menubar, FALSE,
+			TRUE, 0);
+	gtk_box_reorder_child(GTK_BOX(terminal->vbox), terminal->menubar,
+			position++);
+	gtk_widget_show_all(terminal->menubar);
+	if(terminal->fullscreen)
+		gtk_widget_hide(terminal->menubar);
+	/* the menubar handles the accelerators from now on */
+	gtk_window_remove_accel_group(GTK_WINDOW(terminal->window),
+			terminal->accel);
+	terminal->accel = NULL;
+	trace_end("menubar");
+#endif
+	/* toolbar */
+	trace_begin("toolbar");
+	widget = desktop_toolbar_create(_terminal_toolbar, terminal,
+			terminal->group);
+#if GTK_CHECK_VERSION(2, 8, 0)
+	toolitem = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_FULLSCREEN);
+#else
+	toolitem = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_ZOOM_FIT);
+#endif
+	gtk_toggle_tool_button_set_active(GTK_TOGGLE_TOOL_BUTTON(toolitem),
+			terminal->fullscreen);
+	terminal->tb_fullscreen = toolitem;
+	g_signal_connect_swapped(G_OBJECT(toolitem), "toggled", G_CALLBACK(
+				_terminal_on_fullscreen), terminal);
+	gtk_toolbar_insert(GTK_TOOLBAR(widget), toolitem, -1);
+	gtk_box_pack_start(GTK_BOX(terminal->vbox), widget, FALSE, TRUE, 0);
+	gtk_box_reorder_child(GTK_BOX(terminal->vbox), widget, position);
+	gtk_widget_show_all(widget);
+	trace_end("toolbar");
+	return FALSE;
+}
+
+
+/* terminal_on_watchdog */
+static gboolean _terminal_on_watchdog(gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+	gint64 now;
+
+	now = g_get_monotonic_time();
+	/* only the xterms run on their own */
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		if(tab->pooled || tab->definition != &backend_xterm
+				|| tab->pid <= 0)
+			continue;
+		/* stopped on purpose while in the background */
+		if(tab->frozen)
+		{
+			tab->watched = 0;
+			_terminal_tab_set_hung(tab, FALSE, now);
+			continue;
+		}
+		_terminal_tab_watch(terminal, tab, now);
+	}
+	return TRUE;
+}
+
+
 #ifndef EMBEDDED
+/* terminal_on_activity_activated */
+static void _terminal_on_activity_activated(GtkTreeView * view,
+		GtkTreePath * path, GtkTreeViewColumn * column, gpointer data)
+{
+	Terminal * terminal = data;
+	GtkTreeModel * model = gtk_tree_view_get_model(view);
+	GtkTreeIter iter;
+	guint u;
+	TerminalTab * tab;
+	gint page;
+	(void) column;
+
+	if(!gtk_tree_model_get_iter(model, &iter, path))
+		return;
+	gtk_tree_model_get(model, &iter, TAC_HANDLE, &u, -1);
+	if((tab = terminalstore_get(terminal->tabs, u)) == NULL
+			|| (page = gtk_notebook_page_num(
+					GTK_NOTEBOOK(terminal->notebook),
+					tab->page)) < 0)
+		return;
+	gtk_notebook_set_current_page(GTK_NOTEBOOK(terminal->notebook), page);
+	gtk_window_present(GTK_WINDOW(terminal->window));
+}
+
+
+/* terminal_on_activity_closex */
+static gboolean _terminal_on_activity_closex(gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalStoreHandle handle = TERMINALSTORE_HANDLE_NONE;
+	TerminalTab * tab;
+
+	gtk_widget_destroy(terminal->activity);
+	terminal->activity = NULL;
+	terminal->activity_store = NULL;
+	/* unless configured, the tabs were only sampled meanwhile */
+	if(terminal->monitor || terminal->monitor_source == 0)
+		return TRUE;
+	g_source_remove(terminal->monitor_source);
+	terminal->monitor_source = 0;
+	while((tab = terminalstore_get_next(terminal->tabs, &handle)) != NULL)
+	{
+		memset(&tab->usage, 0, sizeof(tab->usage));
+		_terminal_tab_set_finished(tab, FALSE);
+	}
+	return TRUE;
+}
+
+
 /* terminal_on_file_close */
 static void _terminal_on_file_close(gpointer data)
 {
@@ -675,12 +3660,68 @@ static void _terminal_on_file_close_all(gpointer data)
 }
 
 
+/* terminal_on_file_detach */
+static void _terminal_on_file_detach(gpointer data)
+{
+	Terminal * terminal = data;
+	GtkNotebook * notebook = GTK_NOTEBOOK(terminal->notebook);
+	GtkWidget * page;
+	TerminalTab * tab;
+	GtkWidget * dialog;
+	int i;
+
+	if((i = gtk_notebook_get_current_page(notebook)) < 0
+			|| (page = gtk_notebook_get_nth_page(notebook, i))
+			== NULL
+			|| (tab = terminalstore_lookup(terminal->tabs,
+					TTI_PAGE, (uintptr_t)page, NULL))
+			== NULL)
+		return;
+	if(tab->session != NULL)
+	{
+		_terminal_tab_detach(terminal, tab);
+		return;
+	}
+	dialog = gtk_message_dialog_new(GTK_WINDOW(terminal->window),
+			GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+			GTK_MESSAGE_INFO, GTK_BUTTONS_CLOSE,
+#if GTK_CHECK_VERSION(2, 6, 0)
+			"%s", _("Information"));
+	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+#endif
+			"%s", _("The shell of this tab is not running in a"
+				" session.\nSessions can be enabled in the"
+				" configuration file."));
+	gtk_window_set_title(GTK_WINDOW(dialog), _("Information"));
+	gtk_dialog_run(GTK_DIALOG(dialog));
+	gtk_widget_destroy(dialog);
+}
+
+
 /* terminal_on_file_new_tab */
 static void _terminal_on_file_new_tab(gpointer data)
 {
 	Terminal * terminal = data;
 
-	_terminal_open_tab(terminal);
+	_terminal_open_tab(terminal, terminal->backend, NULL, NULL);
+}
+
+
+/* terminal_on_file_new_tab_native */
+static void _terminal_on_file_new_tab_native(gpointer data)
+{
+	Terminal * terminal = data;
+
+	_terminal_open_tab(terminal, &backend_native, NULL, NULL);
+}
+
+
+/* terminal_on_file_new_tab_xterm */
+static void _terminal_on_file_new_tab_xterm(gpointer data)
+{
+	Terminal * terminal = data;
+
+	_terminal_open_tab(terminal, &backend_xterm, NULL, NULL);
 }
 
 
@@ -693,6 +3734,100 @@ static void _terminal_on_file_new_window(gpointer data)
 }
 
 
+/* terminal_on_file_reattach */
+static GtkWidget * _reattach_dialog(Terminal * terminal, GtkWidget ** combo);
+
+static void _terminal_on_file_reattach(gpointer data)
+{
+	Terminal * terminal = data;
+	TerminalBackendDefinition const * definition;
+	GtkWidget * dialog;
+	GtkWidget * combo = NULL;
+	TerminalSession * session = NULL;
+	int i;
+
+	if((dialog = _reattach_dialog(terminal, &combo)) == NULL)
+		return;
+	if(gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK
+			&& combo != NULL)
+		/* the sessions are listed in the same order */
+		for(i = gtk_combo_box_get_active(GTK_COMBO_BOX(combo));
+				i >= 0; i--)
+			session = terminalsession_get_detached(session);
+	gtk_widget_destroy(dialog);
+	if(session == NULL)
+		return;
+	definition = (terminal->backend->attach != NULL)
+		? terminal->backend : &backend_xterm;
+	_terminal_open_tab(terminal, definition, NULL, session);
+}
+
+static GtkWidget * _reattach_dialog(Terminal * terminal, GtkWidget ** combo)
+{
+	GtkWidget * dialog;
+	GtkWidget * content;
+	TerminalSession * session;
+	char const * title;
+	gchar * p;
+
+	if((session = terminalsession_get_detached(NULL)) == NULL)
+	{
+		dialog = gtk_message_dialog_new(GTK_WINDOW(terminal->window),
+				GTK_DIALOG_MODAL
+				| GTK_DIALOG_DESTROY_WITH_PARENT,
+				GTK_MESSAGE_INFO, GTK_BUTTONS_CLOSE,
+#if GTK_CHECK_VERSION(2, 6, 0)
+				"%s", _("Information"));
+		gtk_message_dialog_format_secondary_text(
+				GTK_MESSAGE_DIALOG(dialog),
+#endif
+				"%s", _("There is no session detached."));
+		gtk_window_set_title(GTK_WINDOW(dialog), _("Information"));
+		return dialog;
+	}
+	dialog = gtk_message_dialog_new(GTK_WINDOW(terminal->window),
+			GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+			GTK_MESSAGE_OTHER, GTK_BUTTONS_NONE,
+#if GTK_CHECK_VERSION(2, 6, 0)
+			"%s", _("Reattach session"));
+	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+#endif
+			"%s", _("Reattach this session:"));
+	gtk_dialog_add_buttons(GTK_DIALOG(dialog),
+			GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+			GTK_STOCK_OK, GTK_RESPONSE_OK, NULL);
+	gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
+	gtk_window_set_title(GTK_WINDOW(dialog), _("Reattach session"));
+#if GTK_CHECK_VERSION(2, 14, 0)
+	content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+#else
+	content = GTK_DIALOG(dialog)->vbox;
+#endif
+#if GTK_CHECK_VERSION(2, 24, 0)
+	*combo = gtk_combo_box_text_new();
+#else
+	*combo = gtk_combo_box_new_text();
+#endif
+	for(; session != NULL; session = terminalsession_get_detached(session))
+	{
+		if((title = terminalsession_get_title(session)) == NULL)
+			title = _("Session");
+		p = g_strdup_printf("%s (%ld)", title,
+				(long)terminalsession_get_pid(session));
+#if GTK_CHECK_VERSION(2, 24, 0)
+		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(*combo), p);
+#else
+		gtk_combo_box_append_text(GTK_COMBO_BOX(*combo), p);
+#endif
+		g_free(p);
+	}
+	gtk_combo_box_set_active(GTK_COMBO_BOX(*combo), 0);
+	gtk_box_pack_start(GTK_BOX(content), *combo, FALSE, TRUE, 0);
+	gtk_widget_show_all(content);
+	return dialog;
+}
+
+
 /* terminal_on_help_about */
 static void _terminal_on_help_about(gpointer data)
 {
@@ -725,6 +3860,86 @@ static void _terminal_on_help_contents(gpointer data)
 }
 
 
+/* terminal_on_view_activity */
+static void _terminal_on_view_activity(gpointer data)
+{
+	Terminal * terminal = data;
+	GtkWidget * widget;
+	GtkWidget * view;
+	GtkCellRenderer * renderer;
+	GtkTreeViewColumn * column;
+	size_t i;
+	struct
+	{
+		char const * title;
+		TerminalActivityColumn column;
+	} const columns[] =
+	{
+		{ N_("Tab"), TAC_LABEL },
+		{ N_("CPU (%)"), TAC_LOAD },
+		{ N_("Memory (MiB)"), TAC_MEMORY },
+		{ N_("Processes"), TAC_PROCESSES },
+		{ N_("State"), TAC_STATE }
+	};
+
+	if(terminal->activity != NULL)
+	{
+		gtk_window_present(GTK_WINDOW(terminal->activity));
+		return;
+	}
+	/* the tabs are sampled while the window is open at least */
+	if(_terminal_monitor == NULL
+			&& (_terminal_monitor = terminalmonitor_new()) == NULL)
+	{
+		error_set_print(PROGNAME_TERMINAL, 1, "%s", strerror(errno));
+		return;
+	}
+	if(terminal->monitor_source == 0)
+	{
+		terminal->monitor_period = terminal->monitor_interval;
+		terminal->monitor_source = g_timeout_add(
+				terminal->monitor_period, _terminal_on_monitor,
+				terminal);
+	}
+	terminal->activity = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_default_size(GTK_WINDOW(terminal->activity), 480, 300);
+	gtk_window_set_title(GTK_WINDOW(terminal->activity), _("Activity"));
+	gtk_window_set_transient_for(GTK_WINDOW(terminal->activity),
+			GTK_WINDOW(terminal->window));
+	g_signal_connect_swapped(terminal->activity, "delete-event",
+			G_CALLBACK(_terminal_on_activity_closex), terminal);
+	/* the busiest tabs first */
+	terminal->activity_store = gtk_list_store_new(TAC_COUNT, G_TYPE_UINT,
+			G_TYPE_STRING, G_TYPE_UINT, G_TYPE_ULONG, G_TYPE_ULONG,
+			G_TYPE_STRING);
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(
+				terminal->activity_store), TAC_LOAD,
+			GTK_SORT_DESCENDING);
+	view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(
+				terminal->activity_store));
+	g_object_unref(terminal->activity_store);
+	for(i = 0; i < sizeof(columns) / sizeof(*columns); i++)
+	{
+		renderer = gtk_cell_renderer_text_new();
+		column = gtk_tree_view_column_new_with_attributes(
+				_(columns[i].title), renderer, "text",
+				columns[i].column, NULL);
+		gtk_tree_view_column_set_sort_column_id(column,
+				columns[i].column);
+		gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+	}
+	g_signal_connect(view, "row-activated", G_CALLBACK(
+				_terminal_on_activity_activated), terminal);
+	widget = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(widget),
+			GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_container_add(GTK_CONTAINER(widget), view);
+	gtk_container_add(GTK_CONTAINER(terminal->activity), widget);
+	_terminal_activity_update(terminal);
+	gtk_widget_show_all(terminal->activity);
+}
+
+
 /* terminal_on_view_fullscreen */
 static void _terminal_on_view_fullscreen(gpointer data)
 {
@@ -37,6 +37,8 @@ typedef struct _TerminalPrefs
 	char const * shell;
 	char const * directory;
 	unsigned int login;
+	/* the tabs of the previous session instead */
+	unsigned int restore;
 } TerminalPrefs;
 
 typedef struct _Terminal Terminal;
@@ -0,0 +1,160 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "trace.h"
+
+/* constants */
+#define TRACE_CATEGORY	"terminal"
+
+
+/* trace */
+/* private */
+/* prototypes */
+static void _trace_event(char const * name, char phase, gint64 time,
+		char const * extra);
+
+
+/* variables */
+/* tracing is disabled as long as no file is opened */
+static FILE * _trace_fp = NULL;
+static long _trace_pid = 0;
+static size_t _trace_cnt = 0;
+
+
+/* public */
+/* functions */
+/* essential */
+/* trace_open */
+int trace_open(char const * filename)
+{
+	if(_trace_fp != NULL)
+		trace_close();
+	if((_trace_fp = fopen(filename, "w")) == NULL)
+		return -error_set_code(1, "%s: %s", filename, strerror(errno));
+	_trace_pid = getpid();
+	_trace_cnt = 0;
+	/* every event is written as it happens, one per line */
+	setvbuf(_trace_fp, NULL, _IOLBF, 0);
+	/* the JSON array format remains valid if the array is not closed */
+	fputs("[\n", _trace_fp);
+	return 0;
+}
+
+
+/* trace_close */
+void trace_close(void)
+{
+	if(_trace_fp == NULL)
+		return;
+	fputs("]\n", _trace_fp);
+	fclose(_trace_fp);
+	_trace_fp = NULL;
+}
+
+
+/* useful */
+/* trace_begin */
+void trace_begin(char const * name)
+{
+	if(_trace_fp == NULL)
+		return;
+	_trace_event(name, 'B', g_get_monotonic_time(), "");
+}
+
+
+/* trace_end */
+void trace_end(char const * name)
+{
+	if(_trace_fp == NULL)
+		return;
+	_trace_event(name, 'E', g_get_monotonic_time(), "");
+}
+
+
+/* trace_async_begin */
+void trace_async_begin(char const * name, unsigned long id, gint64 time)
+{
+	char buf[32];
+
+	if(_trace_fp == NULL)
+		return;
+	snprintf(buf, sizeof(buf), ",\"id\":\"0x%lx\"", id);
+	_trace_event(name, 'b', time, buf);
+}
+
+
+/* trace_async_end */
+void trace_async_end(char const * name, unsigned long id)
+{
+	char buf[32];
+
+	if(_trace_fp == NULL)
+		return;
+	snprintf(buf, sizeof(buf), ",\"id\":\"0x%lx\"", id);
+	_trace_event(name, 'e', g_get_monotonic_time(), buf);
+}
+
+
+/* trace_complete */
+void trace_complete(char const * name, gint64 start, gint64 end)
+{
+	char buf[32];
+
+	if(_trace_fp == NULL)
+		return;
+	snprintf(buf, sizeof(buf), ",\"dur\":%lld", (long long)(end - start));
+	_trace_event(name, 'X', start, buf);
+}
+
+
+/* trace_instant */
+void trace_instant(char const * name)
+{
+	if(_trace_fp == NULL)
+		return;
+	_trace_event(name, 'i', g_get_monotonic_time(), ",\"s\":\"p\"");
+}
+
+
+/* private */
+/* functions */
+/* trace_event */
+static void _trace_event(char const * name, char phase, gint64 time,
+		char const * extra)
+{
+	/* the timestamps are in microseconds */
+	fprintf(_trace_fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+			"\"ts\":%lld,\"pid\":%ld,\"tid\":%ld%s}\n",
+			(_trace_cnt++ > 0) ? "," : "", name, TRACE_CATEGORY,
+			phase, (long long)time, _trace_pid, _trace_pid, extra);
+}
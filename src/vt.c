@@ -0,0 +1,1364 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "vt.h"
+
+/* constants */
+#define TERMINALVT_PARAMS	16
+#define TERMINALVT_TITLE	256
+
+
+/* TerminalVT */
+/* private */
+/* types */
+typedef enum _TerminalVTState
+{
+	TVS_GROUND = 0,
+	TVS_ESCAPE,
+	TVS_ESCAPE_CHARSET,
+	TVS_CSI,
+	TVS_OSC,
+	TVS_OSC_ESCAPE,
+	TVS_STRING,
+	TVS_STRING_ESCAPE
+} TerminalVTState;
+
+typedef struct _TerminalVTScreen
+{
+	TerminalVTCell * cells;
+	unsigned int lines;
+	unsigned int first;
+	unsigned int history;
+} TerminalVTScreen;
+
+typedef struct _TerminalVTCursor
+{
+	unsigned int x;
+	unsigned int y;
+	TerminalVTCell pen;
+	unsigned int charsets;
+	unsigned int modes;
+} TerminalVTCursor;
+
+struct _TerminalVT
+{
+	TerminalVTHelper helper;
+	unsigned int columns;
+	unsigned int rows;
+	unsigned int history;
+
+	/* screens */
+	TerminalVTScreen screens[2];
+	TerminalVTScreen * screen;
+	unsigned char * tabs;
+
+	/* cursor */
+	TerminalVTCursor cursor;
+	TerminalVTCursor saved;
+	int wrap;
+	unsigned int top;
+	unsigned int bottom;
+	unsigned int charset;
+	char charset_slot;
+
+	/* parser */
+	TerminalVTState state;
+	unsigned int params[TERMINALVT_PARAMS];
+	unsigned int params_cnt;
+	char prefix;
+	char intermediate;
+	uint32_t utf8;
+	unsigned int utf8_left;
+	char title[TERMINALVT_TITLE];
+	size_t title_len;
+
+	/* redraw */
+	unsigned int dirty_first;
+	unsigned int dirty_last;
+};
+
+
+/* constants */
+/* DEC special graphics, from 0x5f to 0x7e */
+static const uint32_t _terminalvt_graphics[] =
+{
+	0x0020, 0x25c6, 0x2592, 0x2409, 0x240c, 0x240d, 0x240a, 0x00b0,
+	0x00b1, 0x2424, 0x240b, 0x2518, 0x2510, 0x250c, 0x2514, 0x253c,
+	0x23ba, 0x23bb, 0x2500, 0x23bc, 0x23bd, 0x251c, 0x2524, 0x2534,
+	0x252c, 0x2502, 0x2264, 0x2265, 0x03c0, 0x2260, 0x00a3, 0x00b7
+};
+
+
+/* prototypes */
+static TerminalVTCell * _terminalvt_line(TerminalVT * vt, unsigned int y);
+static void _terminalvt_dirty(TerminalVT * vt, unsigned int first,
+		unsigned int last);
+
+static void _terminalvt_clear(TerminalVT * vt, unsigned int y,
+		unsigned int from, unsigned int to);
+static void _terminalvt_linefeed(TerminalVT * vt);
+static void _terminalvt_move(TerminalVT * vt, int x, int y);
+static void _terminalvt_print(TerminalVT * vt, uint32_t c);
+static void _terminalvt_reset(TerminalVT * vt);
+static void _terminalvt_restore(TerminalVT * vt);
+static void _terminalvt_scroll_down(TerminalVT * vt, unsigned int top,
+		unsigned int bottom, unsigned int n);
+static void _terminalvt_scroll_up(TerminalVT * vt, unsigned int top,
+		unsigned int bottom, unsigned int n);
+static void _terminalvt_set_screen(TerminalVT * vt, unsigned int alternate);
+
+static void _terminalvt_control(TerminalVT * vt, unsigned char c);
+static void _terminalvt_csi(TerminalVT * vt, unsigned char c);
+static void _terminalvt_csi_modes(TerminalVT * vt, int set);
+static void _terminalvt_csi_sgr(TerminalVT * vt);
+static void _terminalvt_escape(TerminalVT * vt, unsigned char c);
+static void _terminalvt_osc(TerminalVT * vt);
+
+static int _terminalvt_screen_init(TerminalVTScreen * screen,
+		unsigned int columns, unsigned int lines);
+
+
+/* public */
+/* functions */
+/* terminalvt_new */
+TerminalVT * terminalvt_new(TerminalVTHelper const * helper,
+		unsigned int columns, unsigned int rows, unsigned int history)
+{
+	TerminalVT * vt;
+
+	if(columns == 0 || rows == 0)
+		return NULL;
+	if((vt = malloc(sizeof(*vt))) == NULL)
+		return NULL;
+	memset(vt, 0, sizeof(*vt));
+	if(helper != NULL)
+		vt->helper = *helper;
+	vt->columns = columns;
+	vt->rows = rows;
+	vt->history = history;
+	if(_terminalvt_screen_init(&vt->screens[0], columns, rows + history)
+			!= 0
+			|| _terminalvt_screen_init(&vt->screens[1], columns,
+				rows) != 0
+			|| (vt->tabs = malloc(columns)) == NULL)
+	{
+		terminalvt_delete(vt);
+		return NULL;
+	}
+	_terminalvt_reset(vt);
+	return vt;
+}
+
+
+/* terminalvt_delete */
+void terminalvt_delete(TerminalVT * vt)
+{
+	free(vt->tabs);
+	free(vt->screens[1].cells);
+	free(vt->screens[0].cells);
+	free(vt);
+}
+
+
+/* accessors */
+/* terminalvt_get_columns */
+unsigned int terminalvt_get_columns(TerminalVT * vt)
+{
+	return vt->columns;
+}
+
+
+/* terminalvt_get_cursor */
+void terminalvt_get_cursor(TerminalVT * vt, unsigned int * x,
+		unsigned int * y)
+{
+	*x = vt->cursor.x;
+	*y = vt->cursor.y;
+}
+
+
+/* terminalvt_get_dirty */
+int terminalvt_get_dirty(TerminalVT * vt, unsigned int * first,
+		unsigned int * last)
+{
+	if(vt->dirty_first > vt->dirty_last)
+		return 0;
+	*first = vt->dirty_first;
+	*last = vt->dirty_last;
+	/* reset */
+	vt->dirty_first = vt->rows;
+	vt->dirty_last = 0;
+	return 1;
+}
+
+
+/* terminalvt_get_history */
+unsigned int terminalvt_get_history(TerminalVT * vt)
+{
+	return vt->screen->history;
+}
+
+
+/* terminalvt_get_line */
+TerminalVTCell const * terminalvt_get_line(TerminalVT * vt, int y)
+{
+	TerminalVTScreen * screen = vt->screen;
+	unsigned int i;
+
+	/* negative lines are part of the history */
+	if(y >= (int)vt->rows || (y < 0 && (unsigned int)-y > screen->history))
+		return NULL;
+	i = (screen->first + screen->lines + y) % screen->lines;
+	return &screen->cells[i * vt->columns];
+}
+
+
+/* terminalvt_get_modes */
+unsigned int terminalvt_get_modes(TerminalVT * vt)
+{
+	return vt->cursor.modes;
+}
+
+
+/* terminalvt_get_rows */
+unsigned int terminalvt_get_rows(TerminalVT * vt)
+{
+	return vt->rows;
+}
+
+
+/* terminalvt_set_size */
+static void _set_size_screen(TerminalVT * vt, TerminalVTScreen * screen,
+		TerminalVTScreen * old, unsigned int columns,
+		unsigned int rows, unsigned int shift);
+
+int terminalvt_set_size(TerminalVT * vt, unsigned int columns,
+		unsigned int rows)
+{
+	TerminalVTScreen screens[2];
+	unsigned char * tabs;
+	unsigned int shift;
+	unsigned int i;
+
+	if(columns == 0 || rows == 0)
+		return -1;
+	if(columns == vt->columns && rows == vt->rows)
+		return 0;
+	if(_terminalvt_screen_init(&screens[0], columns, rows + vt->history)
+			!= 0)
+		return -1;
+	if(_terminalvt_screen_init(&screens[1], columns, rows) != 0
+			|| (tabs = realloc(vt->tabs, columns)) == NULL)
+	{
+		free(screens[1].cells);
+		free(screens[0].cells);
+		return -1;
+	}
+	vt->tabs = tabs;
+	for(i = vt->columns; i < columns; i++)
+		vt->tabs[i] = (i % 8 == 0) ? 1 : 0;
+	/* keep the cursor on the screen */
+	shift = (vt->cursor.y >= rows) ? vt->cursor.y - rows + 1 : 0;
+	for(i = 0; i < 2; i++)
+	{
+		_set_size_screen(vt, &screens[i], &vt->screens[i], columns,
+				rows, shift);
+		free(vt->screens[i].cells);
+		vt->screens[i] = screens[i];
+	}
+	vt->columns = columns;
+	vt->rows = rows;
+	vt->cursor.y -= shift;
+	if(vt->cursor.x >= columns)
+		vt->cursor.x = columns - 1;
+	if(vt->saved.y >= rows)
+		vt->saved.y = rows - 1;
+	if(vt->saved.x >= columns)
+		vt->saved.x = columns - 1;
+	vt->wrap = 0;
+	vt->top = 0;
+	vt->bottom = rows - 1;
+	vt->dirty_first = 0;
+	vt->dirty_last = rows - 1;
+	return 0;
+}
+
+static void _set_size_screen(TerminalVT * vt, TerminalVTScreen * screen,
+		TerminalVTScreen * old, unsigned int columns,
+		unsigned int rows, unsigned int shift)
+{
+	int y;
+	int ny;
+	int oldest;
+	unsigned int n;
+	size_t len;
+	unsigned int i;
+
+	len = ((columns < vt->columns) ? columns : vt->columns)
+		* sizeof(*screen->cells);
+	/* lines scrolled off the top go to the history */
+	n = old->history + shift;
+	screen->history = (n < screen->lines - rows) ? n
+		: screen->lines - rows;
+	screen->first = screen->history % screen->lines;
+	oldest = -(int)old->history;
+	for(y = oldest; y < (int)vt->rows; y++)
+	{
+		ny = y - (int)shift;
+		if(ny >= (int)rows || ny < -(int)screen->history)
+			continue;
+		i = (old->first + old->lines + y) % old->lines;
+		memcpy(&screen->cells[((screen->first + screen->lines + ny)
+					% screen->lines) * columns],
+				&old->cells[i * vt->columns], len);
+	}
+}
+
+
+/* useful */
+/* terminalvt_dump */
+static size_t _dump_sgr(TerminalVTCell const * pen, char * buf);
+static size_t _dump_utf8(uint32_t c, char * buf);
+
+char * terminalvt_dump(TerminalVT * vt, size_t * len)
+{
+	char * buf;
+	char * p;
+	TerminalVTCell const * line;
+	TerminalVTCell pen;
+	unsigned int modes = vt->cursor.modes;
+	unsigned int x;
+	unsigned int y;
+	unsigned int end;
+
+	/* every cell may come with its own attributes */
+	if((buf = malloc((size_t)vt->columns * vt->rows * 40 + vt->rows * 16
+					+ 256)) == NULL)
+		return NULL;
+	/* start from a known state, without wrapping while drawing */
+	p = buf + sprintf(buf, "\030\033[?1049%c\033(B\033)B\017\033[r"
+			"\033[?6l\033[?7l\033[0m\033[H\033[2J",
+			(vt->screen == &vt->screens[1]) ? 'h' : 'l');
+	memset(&pen, 0, sizeof(pen));
+	pen.attributes = TVA_DEFAULT_FG | TVA_DEFAULT_BG;
+	for(y = 0; y < vt->rows; y++)
+	{
+		line = _terminalvt_line(vt, y);
+		/* the screen was cleared already */
+		for(end = vt->columns; end > 0 && line[end - 1].c == ' '
+				&& (line[end - 1].attributes & (TVA_DEFAULT_BG
+						| TVA_UNDERLINE | TVA_REVERSE))
+				== TVA_DEFAULT_BG; end--);
+		if(end > 0)
+			p += sprintf(p, "\033[%u;1H", y + 1);
+		for(x = 0; x < end; x++)
+		{
+			if(line[x].attributes != pen.attributes
+					|| line[x].fg != pen.fg
+					|| line[x].bg != pen.bg)
+			{
+				p += _dump_sgr(&line[x], p);
+				pen = line[x];
+			}
+			p += _dump_utf8((line[x].c >= 0x20) ? line[x].c : ' ',
+					p);
+		}
+	}
+	/* then the state of the cursor */
+	p += _dump_sgr(&vt->cursor.pen, p);
+	if(vt->cursor.charsets & 0x1)
+		p += sprintf(p, "\033(0");
+	if(vt->cursor.charsets & 0x2)
+		p += sprintf(p, "\033)0");
+	if(vt->charset != 0)
+		*(p++) = '\016';
+	p += sprintf(p, "\033[%u;%ur\033[?1%c\033[?6%c\033[?7%c\033[?25%c"
+			"\033[4%c\033[?2004%c\033[20%c", vt->top + 1,
+			vt->bottom + 1,
+			(modes & TVM_CURSOR_KEYS) ? 'h' : 'l',
+			(modes & TVM_ORIGIN) ? 'h' : 'l',
+			(modes & TVM_AUTOWRAP) ? 'h' : 'l',
+			(modes & TVM_CURSOR_VISIBLE) ? 'h' : 'l',
+			(modes & TVM_INSERT) ? 'h' : 'l',
+			(modes & TVM_BRACKETED_PASTE) ? 'h' : 'l',
+			(modes & TVM_NEWLINE) ? 'h' : 'l');
+	p += sprintf(p, "\033[%u;%uH", vt->cursor.y + 1
+			- ((modes & TVM_ORIGIN) ? vt->top : 0),
+			vt->cursor.x + 1);
+	*len = p - buf;
+	return buf;
+}
+
+static size_t _dump_sgr(TerminalVTCell const * pen, char * buf)
+{
+	char * p = buf;
+
+	p += sprintf(p, "\033[0");
+	if(pen->attributes & TVA_BOLD)
+		p += sprintf(p, ";1");
+	if(pen->attributes & TVA_UNDERLINE)
+		p += sprintf(p, ";4");
+	if(pen->attributes & TVA_REVERSE)
+		p += sprintf(p, ";7");
+	if((pen->attributes & TVA_DEFAULT_FG) == 0)
+		p += sprintf(p, (pen->fg < 8) ? ";%u" : ((pen->fg < 16)
+					? ";%u" : ";38;5;%u"),
+				(pen->fg < 8) ? 30u + pen->fg : ((pen->fg < 16)
+					? 90u + pen->fg - 8 : pen->fg));
+	if((pen->attributes & TVA_DEFAULT_BG) == 0)
+		p += sprintf(p, (pen->bg < 8) ? ";%u" : ((pen->bg < 16)
+					? ";%u" : ";48;5;%u"),
+				(pen->bg < 8) ? 40u + pen->bg : ((pen->bg < 16)
+					? 100u + pen->bg - 8 : pen->bg));
+	*(p++) = 'm';
+	return p - buf;
+}
+
+static size_t _dump_utf8(uint32_t c, char * buf)
+{
+	if(c < 0x80)
+	{
+		buf[0] = c;
+		return 1;
+	}
+	if(c < 0x800)
+	{
+		buf[0] = 0xc0 | (c >> 6);
+		buf[1] = 0x80 | (c & 0x3f);
+		return 2;
+	}
+	if(c < 0x10000)
+	{
+		buf[0] = 0xe0 | (c >> 12);
+		buf[1] = 0x80 | ((c >> 6) & 0x3f);
+		buf[2] = 0x80 | (c & 0x3f);
+		return 3;
+	}
+	buf[0] = 0xf0 | ((c >> 18) & 0x07);
+	buf[1] = 0x80 | ((c >> 12) & 0x3f);
+	buf[2] = 0x80 | ((c >> 6) & 0x3f);
+	buf[3] = 0x80 | (c & 0x3f);
+	return 4;
+}
+
+
+/* terminalvt_write */
+void terminalvt_write(TerminalVT * vt, char const * buf, size_t len)
+{
+	size_t i;
+	unsigned char c;
+
+	for(i = 0; i < len; i++)
+	{
+		c = buf[i];
+		/* strings are only interrupted by their terminator */
+		if(vt->state == TVS_OSC || vt->state == TVS_OSC_ESCAPE)
+		{
+			if(c == 0x07 || (vt->state == TVS_OSC_ESCAPE
+						&& c == '\\'))
+			{
+				_terminalvt_osc(vt);
+				vt->state = TVS_GROUND;
+			}
+			else if(c == 0x1b)
+			{
+				vt->intermediate = '\0';
+				vt->state = TVS_OSC_ESCAPE;
+			}
+			else if(vt->state == TVS_OSC_ESCAPE)
+				/* the sequence was aborted */
+				_terminalvt_escape(vt, c);
+			else if(vt->title_len + 1 < sizeof(vt->title))
+				vt->title[vt->title_len++] = c;
+			continue;
+		}
+		if(vt->state == TVS_STRING || vt->state == TVS_STRING_ESCAPE)
+		{
+			if(c == 0x07 || (vt->state == TVS_STRING_ESCAPE
+						&& c == '\\'))
+				vt->state = TVS_GROUND;
+			else
+				vt->state = (c == 0x1b) ? TVS_STRING_ESCAPE
+					: TVS_STRING;
+			continue;
+		}
+		if(c < 0x20 || c == 0x7f)
+		{
+			_terminalvt_control(vt, c);
+			continue;
+		}
+		switch(vt->state)
+		{
+			case TVS_ESCAPE:
+				_terminalvt_escape(vt, c);
+				continue;
+			case TVS_ESCAPE_CHARSET:
+				if(c == '0')
+					vt->cursor.charsets |= (vt->charset_slot
+							== '(') ? 0x1 : 0x2;
+				else
+					vt->cursor.charsets &= (vt->charset_slot
+							== '(') ? ~0x1 : ~0x2;
+				vt->state = TVS_GROUND;
+				continue;
+			case TVS_CSI:
+				_terminalvt_csi(vt, c);
+				continue;
+			default:
+				break;
+		}
+		/* decode UTF-8 */
+		if(c < 0x80)
+		{
+			vt->utf8_left = 0;
+			_terminalvt_print(vt, c);
+		}
+		else if((c & 0xc0) == 0x80)
+		{
+			if(vt->utf8_left == 0)
+				continue;
+			vt->utf8 = (vt->utf8 << 6) | (c & 0x3f);
+			if(--vt->utf8_left == 0)
+				_terminalvt_print(vt, vt->utf8);
+		}
+		else if((c & 0xe0) == 0xc0)
+		{
+			vt->utf8 = c & 0x1f;
+			vt->utf8_left = 1;
+		}
+		else if((c & 0xf0) == 0xe0)
+		{
+			vt->utf8 = c & 0x0f;
+			vt->utf8_left = 2;
+		}
+		else if((c & 0xf8) == 0xf0)
+		{
+			vt->utf8 = c & 0x07;
+			vt->utf8_left = 3;
+		}
+		else
+			vt->utf8_left = 0;
+	}
+}
+
+
+/* private */
+/* functions */
+/* terminalvt_line */
+static TerminalVTCell * _terminalvt_line(TerminalVT * vt, unsigned int y)
+{
+	TerminalVTScreen * screen = vt->screen;
+
+	return &screen->cells[((screen->first + y) % screen->lines)
+		* vt->columns];
+}
+
+
+/* terminalvt_dirty */
+static void _terminalvt_dirty(TerminalVT * vt, unsigned int first,
+		unsigned int last)
+{
+	if(first < vt->dirty_first)
+		vt->dirty_first = first;
+	if(last > vt->dirty_last)
+		vt->dirty_last = last;
+}
+
+
+/* terminalvt_clear */
+static void _terminalvt_clear(TerminalVT * vt, unsigned int y,
+		unsigned int from, unsigned int to)
+{
+	TerminalVTCell * line;
+	TerminalVTCell blank;
+	unsigned int x;
+
+	/* erased cells keep the current background */
+	blank.c = ' ';
+	blank.fg = vt->cursor.pen.fg;
+	blank.bg = vt->cursor.pen.bg;
+	blank.attributes = vt->cursor.pen.attributes
+		& (TVA_DEFAULT_FG | TVA_DEFAULT_BG);
+	line = _terminalvt_line(vt, y);
+	if(to > vt->columns)
+		to = vt->columns;
+	for(x = from; x < to; x++)
+		line[x] = blank;
+	_terminalvt_dirty(vt, y, y);
+}
+
+
+/* terminalvt_linefeed */
+static void _terminalvt_linefeed(TerminalVT * vt)
+{
+	_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+	if(vt->cursor.y == vt->bottom)
+		_terminalvt_scroll_up(vt, vt->top, vt->bottom, 1);
+	else if(vt->cursor.y + 1 < vt->rows)
+		vt->cursor.y++;
+	_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+}
+
+
+/* terminalvt_move */
+static void _terminalvt_move(TerminalVT * vt, int x, int y)
+{
+	int top = 0;
+	int bottom = vt->rows - 1;
+
+	if(vt->cursor.modes & TVM_ORIGIN)
+	{
+		top = vt->top;
+		bottom = vt->bottom;
+	}
+	_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+	vt->cursor.x = (x < 0) ? 0 : ((x >= (int)vt->columns)
+			? (int)vt->columns - 1 : x);
+	vt->cursor.y = (y < top) ? top : ((y > bottom) ? bottom : y);
+	vt->wrap = 0;
+	_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+}
+
+
+/* terminalvt_print */
+static void _terminalvt_print(TerminalVT * vt, uint32_t c)
+{
+	TerminalVTCell * line;
+	unsigned int charset;
+
+	/* combining characters are not supported */
+	if((c >= 0x300 && c <= 0x36f) || (c >= 0x200b && c <= 0x200f))
+		return;
+	charset = (vt->charset == 0) ? (vt->cursor.charsets & 0x1)
+		: (vt->cursor.charsets & 0x2);
+	if(charset != 0 && c >= 0x5f && c <= 0x7e)
+		c = _terminalvt_graphics[c - 0x5f];
+	if(vt->wrap)
+	{
+		vt->cursor.x = 0;
+		_terminalvt_linefeed(vt);
+		vt->wrap = 0;
+	}
+	line = _terminalvt_line(vt, vt->cursor.y);
+	if(vt->cursor.modes & TVM_INSERT)
+		memmove(&line[vt->cursor.x + 1], &line[vt->cursor.x],
+				(vt->columns - vt->cursor.x - 1)
+				* sizeof(*line));
+	line[vt->cursor.x] = vt->cursor.pen;
+	line[vt->cursor.x].c = c;
+	_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+	if(vt->cursor.x + 1 < vt->columns)
+		vt->cursor.x++;
+	else if(vt->cursor.modes & TVM_AUTOWRAP)
+		vt->wrap = 1;
+}
+
+
+/* terminalvt_reset */
+static void _terminalvt_reset(TerminalVT * vt)
+{
+	unsigned int i;
+
+	vt->screen = &vt->screens[0];
+	memset(&vt->cursor, 0, sizeof(vt->cursor));
+	vt->cursor.pen.c = ' ';
+	vt->cursor.pen.attributes = TVA_DEFAULT_FG | TVA_DEFAULT_BG;
+	vt->cursor.modes = TVM_AUTOWRAP | TVM_CURSOR_VISIBLE;
+	vt->saved = vt->cursor;
+	vt->wrap = 0;
+	vt->top = 0;
+	vt->bottom = vt->rows - 1;
+	vt->charset = 0;
+	vt->state = TVS_GROUND;
+	vt->utf8_left = 0;
+	for(i = 0; i < vt->columns; i++)
+		vt->tabs[i] = (i % 8 == 0) ? 1 : 0;
+	for(i = 0; i < vt->rows; i++)
+		_terminalvt_clear(vt, i, 0, vt->columns);
+}
+
+
+/* terminalvt_restore */
+static void _terminalvt_restore(TerminalVT * vt)
+{
+	/* only some modes are saved along with the cursor */
+	const unsigned int saved = TVM_ORIGIN | TVM_AUTOWRAP;
+	unsigned int modes = vt->cursor.modes;
+
+	vt->cursor = vt->saved;
+	vt->cursor.modes = (modes & ~saved) | (vt->saved.modes & saved);
+	_terminalvt_move(vt, vt->cursor.x, vt->cursor.y);
+}
+
+
+/* terminalvt_scroll_down */
+static void _terminalvt_scroll_down(TerminalVT * vt, unsigned int top,
+		unsigned int bottom, unsigned int n)
+{
+	unsigned int y;
+	size_t len = vt->columns * sizeof(TerminalVTCell);
+
+	if(n > bottom - top + 1)
+		n = bottom - top + 1;
+	for(y = bottom; y >= top + n; y--)
+		memcpy(_terminalvt_line(vt, y), _terminalvt_line(vt, y - n),
+				len);
+	for(y = top; y < top + n; y++)
+		_terminalvt_clear(vt, y, 0, vt->columns);
+	_terminalvt_dirty(vt, top, bottom);
+}
+
+
+/* terminalvt_scroll_up */
+static void _terminalvt_scroll_up(TerminalVT * vt, unsigned int top,
+		unsigned int bottom, unsigned int n)
+{
+	TerminalVTScreen * screen = vt->screen;
+	unsigned int y;
+	size_t len = vt->columns * sizeof(TerminalVTCell);
+
+	if(n > bottom - top + 1)
+		n = bottom - top + 1;
+	if(top == 0 && bottom == vt->rows - 1)
+	{
+		/* rotate the ring of lines, filling the history */
+		for(y = 0; y < n; y++)
+		{
+			screen->first = (screen->first + 1) % screen->lines;
+			if(screen->history < screen->lines - vt->rows)
+				screen->history++;
+			_terminalvt_clear(vt, bottom, 0, vt->columns);
+		}
+	}
+	else
+	{
+		for(y = top; y + n <= bottom; y++)
+			memcpy(_terminalvt_line(vt, y),
+					_terminalvt_line(vt, y + n), len);
+		for(y = bottom + 1 - n; y <= bottom; y++)
+			_terminalvt_clear(vt, y, 0, vt->columns);
+	}
+	_terminalvt_dirty(vt, top, bottom);
+}
+
+
+/* terminalvt_set_screen */
+static void _terminalvt_set_screen(TerminalVT * vt, unsigned int alternate)
+{
+	unsigned int y;
+
+	if(vt->screen == &vt->screens[alternate ? 1 : 0])
+		return;
+	vt->screen = &vt->screens[alternate ? 1 : 0];
+	if(alternate)
+		for(y = 0; y < vt->rows; y++)
+			_terminalvt_clear(vt, y, 0, vt->columns);
+	_terminalvt_dirty(vt, 0, vt->rows - 1);
+}
+
+
+/* parser */
+/* terminalvt_control */
+static void _terminalvt_control(TerminalVT * vt, unsigned char c)
+{
+	unsigned int x;
+
+	switch(c)
+	{
+		case 0x08:
+			/* backspace */
+			if(vt->cursor.x > 0)
+				_terminalvt_move(vt, vt->cursor.x - 1,
+						vt->cursor.y);
+			break;
+		case 0x09:
+			/* horizontal tabulation */
+			for(x = vt->cursor.x + 1; x < vt->columns - 1; x++)
+				if(vt->tabs[x])
+					break;
+			vt->cursor.x = (x < vt->columns) ? x
+				: vt->columns - 1;
+			_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+			break;
+		case 0x0a:
+		case 0x0b:
+		case 0x0c:
+			/* line feed */
+			vt->wrap = 0;
+			if(vt->cursor.modes & TVM_NEWLINE)
+				vt->cursor.x = 0;
+			_terminalvt_linefeed(vt);
+			break;
+		case 0x0d:
+			/* carriage return */
+			vt->cursor.x = 0;
+			vt->wrap = 0;
+			_terminalvt_dirty(vt, vt->cursor.y, vt->cursor.y);
+			break;
+		case 0x0e:
+			/* shift out */
+			vt->charset = 1;
+			break;
+		case 0x0f:
+			/* shift in */
+			vt->charset = 0;
+			break;
+		case 0x18:
+		case 0x1a:
+			/* cancel */
+			vt->state = TVS_GROUND;
+			break;
+		case 0x1b:
+			vt->state = TVS_ESCAPE;
+			vt->intermediate = '\0';
+			break;
+		default:
+			/* ignore */
+			break;
+	}
+}
+
+
+/* terminalvt_csi */
+static void _terminalvt_csi(TerminalVT * vt, unsigned char c)
+{
+	unsigned int * p = vt->params;
+	unsigned int n;
+	unsigned int y;
+	TerminalVTCell * line;
+	char buf[32];
+
+	/* parameters */
+	if(c >= '0' && c <= '9')
+	{
+		if(vt->params_cnt == 0)
+			vt->params_cnt = 1;
+		if(p[vt->params_cnt - 1] < 10000)
+			p[vt->params_cnt - 1] = p[vt->params_cnt - 1] * 10
+				+ c - '0';
+		return;
+	}
+	if(c == ';' || c == ':')
+	{
+		if(vt->params_cnt == 0)
+			vt->params_cnt = 1;
+		if(vt->params_cnt < TERMINALVT_PARAMS)
+			p[vt->params_cnt++] = 0;
+		return;
+	}
+	if(c >= '<' && c <= '?')
+	{
+		vt->prefix = c;
+		return;
+	}
+	if(c >= 0x20 && c <= 0x2f)
+	{
+		vt->intermediate = c;
+		return;
+	}
+	/* final character */
+	vt->state = TVS_GROUND;
+	n = (p[0] > 0) ? p[0] : 1;
+	if(vt->intermediate != '\0')
+		/* not supported */
+		return;
+	if(vt->prefix == '?' && (c == 'h' || c == 'l'))
+	{
+		_terminalvt_csi_modes(vt, c == 'h');
+		return;
+	}
+	if(vt->prefix != '\0' && c != 'c')
+		return;
+	switch(c)
+	{
+		case '@':
+			/* insert characters */
+			line = _terminalvt_line(vt, vt->cursor.y);
+			if(n > vt->columns - vt->cursor.x)
+				n = vt->columns - vt->cursor.x;
+			memmove(&line[vt->cursor.x + n], &line[vt->cursor.x],
+					(vt->columns - vt->cursor.x - n)
+					* sizeof(*line));
+			_terminalvt_clear(vt, vt->cursor.y, vt->cursor.x,
+					vt->cursor.x + n);
+			break;
+		case 'A':
+			_terminalvt_move(vt, vt->cursor.x, (int)vt->cursor.y
+					- (int)n);
+			break;
+		case 'B':
+		case 'e':
+			_terminalvt_move(vt, vt->cursor.x, vt->cursor.y + n);
+			break;
+		case 'C':
+		case 'a':
+			_terminalvt_move(vt, vt->cursor.x + n, vt->cursor.y);
+			break;
+		case 'D':
+			_terminalvt_move(vt, (int)vt->cursor.x - (int)n,
+					vt->cursor.y);
+			break;
+		case 'E':
+			_terminalvt_move(vt, 0, vt->cursor.y + n);
+			break;
+		case 'F':
+			_terminalvt_move(vt, 0, (int)vt->cursor.y - (int)n);
+			break;
+		case 'G':
+		case '`':
+			_terminalvt_move(vt, n - 1, vt->cursor.y);
+			break;
+		case 'H':
+		case 'f':
+			y = (vt->params_cnt > 0 && p[0] > 0) ? p[0] - 1 : 0;
+			if(vt->cursor.modes & TVM_ORIGIN)
+				y += vt->top;
+			_terminalvt_move(vt, (vt->params_cnt > 1 && p[1] > 0)
+					? p[1] - 1 : 0, y);
+			break;
+		case 'J':
+			/* erase in display */
+			if(p[0] == 0)
+			{
+				_terminalvt_clear(vt, vt->cursor.y,
+						vt->cursor.x, vt->columns);
+				for(y = vt->cursor.y + 1; y < vt->rows; y++)
+					_terminalvt_clear(vt, y, 0,
+							vt->columns);
+			}
+			else if(p[0] == 1)
+			{
+				for(y = 0; y < vt->cursor.y; y++)
+					_terminalvt_clear(vt, y, 0,
+							vt->columns);
+				_terminalvt_clear(vt, vt->cursor.y, 0,
+						vt->cursor.x + 1);
+			}
+			else if(p[0] == 2)
+				for(y = 0; y < vt->rows; y++)
+					_terminalvt_clear(vt, y, 0,
+							vt->columns);
+			else if(p[0] == 3)
+				vt->screen->history = 0;
+			break;
+		case 'K':
+			/* erase in line */
+			if(p[0] == 0)
+				_terminalvt_clear(vt, vt->cursor.y,
+						vt->cursor.x, vt->columns);
+			else if(p[0] == 1)
+				_terminalvt_clear(vt, vt->cursor.y, 0,
+						vt->cursor.x + 1);
+			else if(p[0] == 2)
+				_terminalvt_clear(vt, vt->cursor.y, 0,
+						vt->columns);
+			break;
+		case 'L':
+			/* insert lines */
+			if(vt->cursor.y >= vt->top
+					&& vt->cursor.y <= vt->bottom)
+				_terminalvt_scroll_down(vt, vt->cursor.y,
+						vt->bottom, n);
+			break;
+		case 'M':
+			/* delete lines */
+			if(vt->cursor.y >= vt->top
+					&& vt->cursor.y <= vt->bottom)
+				_terminalvt_scroll_up(vt, vt->cursor.y,
+						vt->bottom, n);
+			break;
+		case 'P':
+			/* delete characters */
+			line = _terminalvt_line(vt, vt->cursor.y);
+			if(n > vt->columns - vt->cursor.x)
+				n = vt->columns - vt->cursor.x;
+			memmove(&line[vt->cursor.x], &line[vt->cursor.x + n],
+					(vt->columns - vt->cursor.x - n)
+					* sizeof(*line));
+			_terminalvt_clear(vt, vt->cursor.y, vt->columns - n,
+					vt->columns);
+			break;
+		case 'S':
+			_terminalvt_scroll_up(vt, vt->top, vt->bottom, n);
+			break;
+		case 'T':
+			_terminalvt_scroll_down(vt, vt->top, vt->bottom, n);
+			break;
+		case 'X':
+			/* erase characters */
+			_terminalvt_clear(vt, vt->cursor.y, vt->cursor.x,
+					vt->cursor.x + n);
+			break;
+		case 'c':
+			/* device attributes */
+			if(p[0] != 0)
+				break;
+			if(vt->prefix == '>')
+				snprintf(buf, sizeof(buf), "\033[>1;10;0c");
+			else if(vt->prefix == '\0')
+				snprintf(buf, sizeof(buf), "\033[?1;2c");
+			else
+				break;
+			if(vt->helper.reply != NULL)
+				vt->helper.reply(vt->helper.data, buf,
+						strlen(buf));
+			break;
+		case 'd':
+			_terminalvt_move(vt, vt->cursor.x, n - 1);
+			break;
+		case 'g':
+			/* tabulation clear */
+			if(p[0] == 0)
+				vt->tabs[vt->cursor.x] = 0;
+			else if(p[0] == 3)
+				memset(vt->tabs, 0, vt->columns);
+			break;
+		case 'h':
+		case 'l':
+			_terminalvt_csi_modes(vt, c == 'h');
+			break;
+		case 'm':
+			_terminalvt_csi_sgr(vt);
+			break;
+		case 'n':
+			/* device status report */
+			if(p[0] == 5)
+				snprintf(buf, sizeof(buf), "\033[0n");
+			else if(p[0] == 6)
+				snprintf(buf, sizeof(buf), "\033[%u;%uR",
+						vt->cursor.y + 1,
+						vt->cursor.x + 1);
+			else
+				break;
+			if(vt->helper.reply != NULL)
+				vt->helper.reply(vt->helper.data, buf,
+						strlen(buf));
+			break;
+		case 'r':
+			/* set the scrolling region */
+			y = (vt->params_cnt > 1 && p[1] > 0
+					&& p[1] <= vt->rows) ? p[1] : vt->rows;
+			n = (p[0] > 0) ? p[0] : 1;
+			if(n >= y)
+				break;
+			vt->top = n - 1;
+			vt->bottom = y - 1;
+			_terminalvt_move(vt, 0, (vt->cursor.modes & TVM_ORIGIN)
+					? vt->top : 0);
+			break;
+		case 's':
+			vt->saved = vt->cursor;
+			break;
+		case 'u':
+			_terminalvt_restore(vt);
+			break;
+		default:
+			/* not supported */
+			break;
+	}
+}
+
+
+/* terminalvt_csi_modes */
+static void _terminalvt_csi_modes(TerminalVT * vt, int set)
+{
+	unsigned int i;
+	unsigned int mode;
+
+	for(i = 0; i < vt->params_cnt || i == 0; i++)
+	{
+		mode = 0;
+		if(vt->prefix == '\0')
+			switch(vt->params[i])
+			{
+				case 4:
+					mode = TVM_INSERT;
+					break;
+				case 20:
+					mode = TVM_NEWLINE;
+					break;
+			}
+		else
+			switch(vt->params[i])
+			{
+				case 1:
+					mode = TVM_CURSOR_KEYS;
+					break;
+				case 6:
+					mode = TVM_ORIGIN;
+					break;
+				case 7:
+					mode = TVM_AUTOWRAP;
+					break;
+				case 25:
+					mode = TVM_CURSOR_VISIBLE;
+					_terminalvt_dirty(vt, vt->cursor.y,
+							vt->cursor.y);
+					break;
+				case 2004:
+					mode = TVM_BRACKETED_PASTE;
+					break;
+				case 1049:
+					/* save the cursor as well */
+					if(set)
+						vt->saved = vt->cursor;
+					/* fallthrough */
+				case 47:
+				case 1047:
+					_terminalvt_set_screen(vt, set);
+					if(vt->params[i] == 1049 && !set)
+						_terminalvt_restore(vt);
+					break;
+				case 1048:
+					if(set)
+						vt->saved = vt->cursor;
+					else
+						_terminalvt_restore(vt);
+					break;
+			}
+		if(set)
+			vt->cursor.modes |= mode;
+		else
+			vt->cursor.modes &= ~mode;
+		if(mode == TVM_ORIGIN)
+			_terminalvt_move(vt, 0, set ? vt->top : 0);
+	}
+}
+
+
+/* terminalvt_csi_sgr */
+static uint8_t _sgr_rgb(unsigned int r, unsigned int g, unsigned int b);
+
+static void _terminalvt_csi_sgr(TerminalVT * vt)
+{
+	TerminalVTCell * pen = &vt->cursor.pen;
+	unsigned int * p = vt->params;
+	unsigned int i;
+	unsigned int c;
+
+	if(vt->params_cnt == 0)
+		vt->params_cnt = 1;
+	for(i = 0; i < vt->params_cnt; i++)
+	{
+		c = p[i];
+		if(c == 0)
+		{
+			pen->attributes = TVA_DEFAULT_FG | TVA_DEFAULT_BG;
+			pen->fg = 0;
+			pen->bg = 0;
+		}
+		else if(c == 1)
+			pen->attributes |= TVA_BOLD;
+		else if(c == 4)
+			pen->attributes |= TVA_UNDERLINE;
+		else if(c == 7)
+			pen->attributes |= TVA_REVERSE;
+		else if(c == 22)
+			pen->attributes &= ~TVA_BOLD;
+		else if(c == 24)
+			pen->attributes &= ~TVA_UNDERLINE;
+		else if(c == 27)
+			pen->attributes &= ~TVA_REVERSE;
+		else if((c >= 30 && c <= 37) || (c >= 90 && c <= 97))
+		{
+			pen->fg = (c >= 90) ? c - 90 + 8 : c - 30;
+			pen->attributes &= ~TVA_DEFAULT_FG;
+		}
+		else if((c >= 40 && c <= 47) || (c >= 100 && c <= 107))
+		{
+			pen->bg = (c >= 100) ? c - 100 + 8 : c - 40;
+			pen->attributes &= ~TVA_DEFAULT_BG;
+		}
+		else if(c == 39)
+			pen->attributes |= TVA_DEFAULT_FG;
+		else if(c == 49)
+			pen->attributes |= TVA_DEFAULT_BG;
+		else if((c == 38 || c == 48) && i + 2 < vt->params_cnt
+				&& p[i + 1] == 5)
+		{
+			/* indexed colors */
+			if(c == 38)
+			{
+				pen->fg = p[i + 2];
+				pen->attributes &= ~TVA_DEFAULT_FG;
+			}
+			else
+			{
+				pen->bg = p[i + 2];
+				pen->attributes &= ~TVA_DEFAULT_BG;
+			}
+			i += 2;
+		}
+		else if((c == 38 || c == 48) && i + 4 < vt->params_cnt
+				&& p[i + 1] == 2)
+		{
+			/* direct colors are approximated */
+			if(c == 38)
+			{
+				pen->fg = _sgr_rgb(p[i + 2], p[i + 3],
+						p[i + 4]);
+				pen->attributes &= ~TVA_DEFAULT_FG;
+			}
+			else
+			{
+				pen->bg = _sgr_rgb(p[i + 2], p[i + 3],
+						p[i + 4]);
+				pen->attributes &= ~TVA_DEFAULT_BG;
+			}
+			i += 4;
+		}
+	}
+}
+
+static uint8_t _sgr_rgb(unsigned int r, unsigned int g, unsigned int b)
+{
+	/* use the 6x6x6 color cube */
+	r = (r > 255) ? 5 : (r * 5 + 127) / 255;
+	g = (g > 255) ? 5 : (g * 5 + 127) / 255;
+	b = (b > 255) ? 5 : (b * 5 + 127) / 255;
+	return 16 + r * 36 + g * 6 + b;
+}
+
+
+/* terminalvt_escape */
+static void _terminalvt_escape(TerminalVT * vt, unsigned char c)
+{
+	vt->state = TVS_GROUND;
+	if(vt->intermediate != '\0')
+	{
+		/* not supported */
+		vt->intermediate = '\0';
+		return;
+	}
+	switch(c)
+	{
+		case '[':
+			memset(vt->params, 0, sizeof(vt->params));
+			vt->params_cnt = 0;
+			vt->prefix = '\0';
+			vt->intermediate = '\0';
+			vt->state = TVS_CSI;
+			break;
+		case ']':
+			vt->title_len = 0;
+			vt->state = TVS_OSC;
+			break;
+		case 'P':
+		case 'X':
+		case '^':
+		case '_':
+			/* strings are ignored */
+			vt->state = TVS_STRING;
+			break;
+		case '(':
+		case ')':
+			vt->charset_slot = c;
+			vt->state = TVS_ESCAPE_CHARSET;
+			break;
+		case '7':
+			vt->saved = vt->cursor;
+			break;
+		case '8':
+			_terminalvt_restore(vt);
+			break;
+		case 'D':
+			/* index */
+			_terminalvt_linefeed(vt);
+			break;
+		case 'E':
+			/* next line */
+			vt->cursor.x = 0;
+			_terminalvt_linefeed(vt);
+			break;
+		case 'H':
+			/* tabulation set */
+			vt->tabs[vt->cursor.x] = 1;
+			break;
+		case 'M':
+			/* reverse index */
+			if(vt->cursor.y == vt->top)
+				_terminalvt_scroll_down(vt, vt->top,
+						vt->bottom, 1);
+			else if(vt->cursor.y > 0)
+				_terminalvt_move(vt, vt->cursor.x,
+						vt->cursor.y - 1);
+			break;
+		case 'c':
+			/* full reset */
+			_terminalvt_reset(vt);
+			break;
+		default:
+			if(c >= 0x20 && c <= 0x2f)
+			{
+				/* skip the next character */
+				vt->intermediate = c;
+				vt->state = TVS_ESCAPE;
+			}
+			/* otherwise not supported */
+			break;
+	}
+}
+
+
+/* terminalvt_osc */
+static void _terminalvt_osc(TerminalVT * vt)
+{
+	vt->title[vt->title_len] = '\0';
+	/* only the window title is supported */
+	if(vt->helper.set_title == NULL || vt->title_len < 2
+			|| (vt->title[0] != '0' && vt->title[0] != '2')
+			|| vt->title[1] != ';')
+		return;
+	vt->helper.set_title(vt->helper.data, &vt->title[2]);
+}
+
+
+/* screens */
+/* terminalvt_screen_init */
+static int _terminalvt_screen_init(TerminalVTScreen * screen,
+		unsigned int columns, unsigned int lines)
+{
+	unsigned int i;
+
+	if((screen->cells = malloc(sizeof(*screen->cells) * columns * lines))
+			== NULL)
+		return -1;
+	for(i = 0; i < columns * lines; i++)
+	{
+		screen->cells[i].c = ' ';
+		screen->cells[i].fg = 0;
+		screen->cells[i].bg = 0;
+		screen->cells[i].attributes = TVA_DEFAULT_FG | TVA_DEFAULT_BG;
+	}
+	screen->lines = lines;
+	screen->first = 0;
+	screen->history = 0;
+	return 0;
+}
@@ -0,0 +1,105 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef TERMINAL_VT_H
+# define TERMINAL_VT_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+
+/* TerminalVT */
+/* public */
+/* types */
+typedef struct _TerminalVT TerminalVT;
+
+typedef enum _TerminalVTAttribute
+{
+	TVA_BOLD	= 0x01,
+	TVA_UNDERLINE	= 0x02,
+	TVA_REVERSE	= 0x04,
+	TVA_DEFAULT_FG	= 0x08,
+	TVA_DEFAULT_BG	= 0x10
+} TerminalVTAttribute;
+
+typedef enum _TerminalVTMode
+{
+	TVM_CURSOR_KEYS		= 0x01,
+	TVM_ORIGIN		= 0x02,
+	TVM_AUTOWRAP		= 0x04,
+	TVM_CURSOR_VISIBLE	= 0x08,
+	TVM_INSERT		= 0x10,
+	TVM_BRACKETED_PASTE	= 0x20,
+	TVM_NEWLINE		= 0x40
+} TerminalVTMode;
+
+/* one cell fits in 8 bytes, and lines are stored contiguously */
+typedef struct _TerminalVTCell
+{
+	uint32_t c;
+	uint8_t fg;
+	uint8_t bg;
+	uint16_t attributes;
+} TerminalVTCell;
+
+typedef struct _TerminalVTHelper
+{
+	void * data;
+	void (*reply)(void * data, char const * buf, size_t len);
+	void (*set_title)(void * data, char const * title);
+} TerminalVTHelper;
+
+
+/* functions */
+/* essential */
+TerminalVT * terminalvt_new(TerminalVTHelper const * helper,
+		unsigned int columns, unsigned int rows, unsigned int history);
+void terminalvt_delete(TerminalVT * vt);
+
+
+/* accessors */
+unsigned int terminalvt_get_columns(TerminalVT * vt);
+void terminalvt_get_cursor(TerminalVT * vt, unsigned int * x,
+		unsigned int * y);
+int terminalvt_get_dirty(TerminalVT * vt, unsigned int * first,
+		unsigned int * last);
+unsigned int terminalvt_get_history(TerminalVT * vt);
+TerminalVTCell const * terminalvt_get_line(TerminalVT * vt, int y);
+unsigned int terminalvt_get_modes(TerminalVT * vt);
+unsigned int terminalvt_get_rows(TerminalVT * vt);
+
+int terminalvt_set_size(TerminalVT * vt, unsigned int columns,
+		unsigned int rows);
+
+
+/* useful */
+/* returns the escape sequences reproducing the screen, to be freed
+ * (cancelling any sequence in progress first) */
+char * terminalvt_dump(TerminalVT * vt, size_t * len);
+void terminalvt_write(TerminalVT * vt, char const * buf, size_t len);
+
+#endif /* !TERMINAL_VT_H */
@@ -0,0 +1,216 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/wait.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "Terminal/widget.h"
+#include "backend.h"
+#include "reaper.h"
+
+
+/* TerminalWidget */
+/* private */
+/* types */
+struct _TerminalWidget
+{
+	TerminalWidgetHelper helper;
+	TerminalBackendDefinition const * definition;
+	TerminalBackend * backend;
+	TerminalBackendHelper backend_helper;
+	GPid pid;
+
+	/* only if reaping the process for the host */
+	TerminalReaper * reaper;
+};
+
+
+/* prototypes */
+static int _terminalwidget_started(TerminalWidget * widget, int res);
+
+/* callbacks */
+static void _terminalwidget_on_child_watch(void * data, GPid pid,
+		int status);
+
+
+/* public */
+/* functions */
+/* essential */
+/* terminalwidget_new */
+TerminalWidget * terminalwidget_new(char const * backend,
+		TerminalWidgetHelper const * helper)
+{
+	TerminalWidget * widget;
+	TerminalBackendDefinition const * definition;
+
+	if((definition = backend_lookup(backend)) == NULL)
+	{
+		error_set_code(1, "%s: %s", backend, "Unknown backend");
+		return NULL;
+	}
+	if((widget = object_new(sizeof(*widget))) == NULL)
+		return NULL;
+	widget->helper = *helper;
+	widget->definition = definition;
+	/* the backend reports to the host directly */
+	widget->backend_helper.data = helper->data;
+	widget->backend_helper.config_get = helper->config_get;
+	widget->backend_helper.set_title = helper->set_title;
+	widget->backend_helper.ready = helper->ready;
+	widget->pid = -1;
+	widget->reaper = NULL;
+	if((widget->backend = definition->init(&widget->backend_helper))
+			== NULL)
+	{
+		object_delete(widget);
+		return NULL;
+	}
+	return widget;
+}
+
+
+/* terminalwidget_delete */
+void terminalwidget_delete(TerminalWidget * widget)
+{
+	/* the process left is still reaped */
+	if(widget->reaper != NULL)
+	{
+		if(widget->pid > 0)
+			terminalreaper_kill(widget->reaper, widget->pid,
+					SIGTERM);
+		terminalreaper_delete(widget->reaper);
+	}
+	widget->definition->destroy(widget->backend);
+	object_delete(widget);
+}
+
+
+/* accessors */
+/* terminalwidget_can_attach */
+int terminalwidget_can_attach(TerminalWidget * widget)
+{
+	return (widget->definition->attach != NULL) ? 1 : 0;
+}
+
+
+/* terminalwidget_get_backend */
+char const * terminalwidget_get_backend(TerminalWidget * widget)
+{
+	return widget->definition->name;
+}
+
+
+/* terminalwidget_get_label */
+char const * terminalwidget_get_label(TerminalWidget * widget)
+{
+	return widget->definition->label;
+}
+
+
+/* terminalwidget_get_pid */
+GPid terminalwidget_get_pid(TerminalWidget * widget)
+{
+	return widget->pid;
+}
+
+
+/* terminalwidget_get_widget */
+GtkWidget * terminalwidget_get_widget(TerminalWidget * widget)
+{
+	return widget->definition->get_widget(widget->backend);
+}
+
+
+/* useful */
+/* terminalwidget_attach */
+int terminalwidget_attach(TerminalWidget * widget, int fd)
+{
+	int res;
+
+	if(widget->definition->attach == NULL)
+		return -error_set_code(1, "%s: %s", widget->definition->name,
+				strerror(ENOTSUP));
+	res = widget->definition->attach(widget->backend, fd, &widget->pid);
+	return _terminalwidget_started(widget, res);
+}
+
+
+/* terminalwidget_start */
+int terminalwidget_start(TerminalWidget * widget, char const * directory,
+		char const * shell, unsigned int login)
+{
+	int res;
+
+	res = widget->definition->start(widget->backend, directory, shell,
+			login, &widget->pid);
+	return _terminalwidget_started(widget, res);
+}
+
+
+/* private */
+/* functions */
+/* terminalwidget_started */
+static int _terminalwidget_started(TerminalWidget * widget, int res)
+{
+	if(res != 0)
+	{
+		widget->pid = -1;
+		return res;
+	}
+	/* otherwise the host reaps the process */
+	if(widget->helper.exited == NULL)
+		return 0;
+	if(widget->reaper == NULL && (widget->reaper = terminalreaper_new(
+					_terminalwidget_on_child_watch,
+					widget)) == NULL)
+		res = -1;
+	else
+		res = terminalreaper_add(widget->reaper, widget->pid);
+	if(res != 0)
+	{
+		terminalreaper_abandon(widget->pid, SIGTERM);
+		widget->pid = -1;
+	}
+	return res;
+}
+
+
+/* callbacks */
+/* terminalwidget_on_child_watch */
+static void _terminalwidget_on_child_watch(void * data, GPid pid,
+		int status)
+{
+	TerminalWidget * widget = data;
+
+	if(pid != widget->pid || (!WIFEXITED(status) && !WIFSIGNALED(status)))
+		return;
+	widget->pid = -1;
+	widget->helper.exited(widget->helper.data, pid, status);
+}
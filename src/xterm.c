@@ -0,0 +1,265 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <libintl.h>
+#include <gtk/gtk.h>
+#if GTK_CHECK_VERSION(3, 0, 0)
+# include <gtk/gtkx.h>
+#endif
+#include <System.h>
+#include "backend.h"
+#include "pty.h"
+#include "spawner.h"
+#include "../config.h"
+#define N_(string) (string)
+
+/* constants */
+#ifndef PREFIX
+# define PREFIX			"/usr/local"
+#endif
+#ifndef BINDIR
+# define BINDIR			PREFIX "/bin"
+#endif
+
+
+/* XTerm */
+/* private */
+/* types */
+struct _TerminalBackend
+{
+	TerminalBackendHelper helper;
+	GtkWidget * socket;
+};
+
+
+/* prototypes */
+static TerminalBackend * _xterm_init(TerminalBackendHelper const * helper);
+static void _xterm_destroy(TerminalBackend * xterm);
+
+static GtkWidget * _xterm_get_widget(TerminalBackend * xterm);
+
+static int _xterm_start(TerminalBackend * xterm, char const * directory,
+		char const * shell, unsigned int login, GPid * pid);
+static int _xterm_attach(TerminalBackend * xterm, int fd, GPid * pid);
+static int _xterm_spawn(TerminalBackend * xterm, char * argv[],
+		char const * directory, int fd, GPid * pid);
+
+/* callbacks */
+static void _xterm_on_child_setup(gpointer data);
+static void _xterm_on_plug_added(gpointer data);
+static gboolean _xterm_on_plug_removed(gpointer data);
+
+
+/* public */
+/* constants */
+TerminalBackendDefinition const backend_xterm =
+{
+	"xterm",
+	N_("xterm"),
+	_xterm_init,
+	_xterm_destroy,
+	_xterm_get_widget,
+	_xterm_start,
+	_xterm_attach
+};
+
+
+/* private */
+/* functions */
+/* xterm_init */
+static TerminalBackend * _xterm_init(TerminalBackendHelper const * helper)
+{
+	TerminalBackend * xterm;
+
+	if((xterm = object_new(sizeof(*xterm))) == NULL)
+		return NULL;
+	xterm->helper = *helper;
+	xterm->socket = gtk_socket_new();
+	g_object_ref_sink(xterm->socket);
+	g_signal_connect_swapped(xterm->socket, "plug-added", G_CALLBACK(
+				_xterm_on_plug_added), xterm);
+	/* another xterm may be embedded later on */
+	g_signal_connect_swapped(xterm->socket, "plug-removed", G_CALLBACK(
+				_xterm_on_plug_removed), xterm);
+	return xterm;
+}
+
+
+/* xterm_destroy */
+static void _xterm_destroy(TerminalBackend * xterm)
+{
+	g_signal_handlers_disconnect_by_data(xterm->socket, xterm);
+	g_object_unref(xterm->socket);
+	object_delete(xterm);
+}
+
+
+/* accessors */
+/* xterm_get_widget */
+static GtkWidget * _xterm_get_widget(TerminalBackend * xterm)
+{
+	return xterm->socket;
+}
+
+
+/* useful */
+/* xterm_start */
+static int _xterm_start(TerminalBackend * xterm, char const * directory,
+		char const * shell, unsigned int login, GPid * pid)
+{
+	char * argv[] = { BINDIR "/xterm", "xterm", "-into", NULL,
+		"-class", "Terminal", NULL, NULL, NULL };
+
+	if(login)
+	{
+		argv[6] = "-ls";
+		argv[7] = (char *)shell;
+	}
+	else
+		argv[6] = (char *)shell;
+	return _xterm_spawn(xterm, argv, directory, -1, pid);
+}
+
+
+/* xterm_attach */
+static int _xterm_attach(TerminalBackend * xterm, int fd, GPid * pid)
+{
+	int ret;
+	char * argv[] = { BINDIR "/xterm", "xterm", "-into", NULL,
+		"-class", "Terminal", NULL, NULL };
+	char * name;
+
+	/* the name of the pty is only informative */
+	if((name = pty_get_name(fd)) == NULL)
+		return -1;
+	argv[6] = g_strdup_printf("-S%s/%d", name, SPAWNER_FD);
+	free(name);
+	ret = _xterm_spawn(xterm, argv, NULL, fd, pid);
+	g_free(argv[6]);
+	return ret;
+}
+
+
+/* xterm_spawn */
+static int _xterm_spawn(TerminalBackend * xterm, char * argv[],
+		char const * directory, int fd, GPid * pid)
+{
+	int ret = 0;
+	int res;
+	char buf[32];
+	char const * path = NULL;
+	char const * savelines = NULL;
+	char * args[12];
+	size_t i;
+	GSpawnFlags flags = G_SPAWN_FILE_AND_ARGV_ZERO
+		| G_SPAWN_DO_NOT_REAP_CHILD;
+	gchar ** envp;
+	GError * error = NULL;
+
+	snprintf(buf, sizeof(buf), "%lu", gtk_socket_get_id(
+				GTK_SOCKET(xterm->socket)));
+	argv[3] = buf;
+	/* another xterm may be configured */
+	if(xterm->helper.config_get != NULL)
+	{
+		path = xterm->helper.config_get(xterm->helper.data, "path");
+		savelines = xterm->helper.config_get(xterm->helper.data,
+				"savelines");
+	}
+	if(path != NULL && path[0] != '\0')
+		argv[0] = (char *)path;
+	/* the scrollback may be kept by Terminal instead */
+	if(savelines != NULL && savelines[0] != '\0')
+	{
+		memcpy(args, argv, sizeof(*args) * 6);
+		args[6] = "-sl";
+		args[7] = (char *)savelines;
+		for(i = 6; argv[i] != NULL; i++)
+			args[i + 2] = argv[i];
+		args[i + 2] = NULL;
+		argv = args;
+	}
+	/* the pty is then duplicated in the child */
+	if(fd >= 0)
+		flags |= G_SPAWN_LEAVE_DESCRIPTORS_OPEN;
+	/* avoid forking the whole process if possible */
+	envp = g_get_environ();
+	if((res = spawner_spawn(argv[0], &argv[1], envp, directory, NULL, fd,
+					SPAWNER_FLAG_SETPGID, pid)) < 0)
+		ret = -error_set_code(1, "%s: %s", argv[1], strerror(errno));
+	else if(res > 0 && g_spawn_async(directory, argv, NULL, flags,
+				_xterm_on_child_setup, &fd, pid, &error)
+			== FALSE)
+	{
+		ret = -error_set_code(1, "%s: %s", argv[1], error->message);
+		g_error_free(error);
+	}
+	g_strfreev(envp);
+	return ret;
+}
+
+
+/* callbacks */
+/* xterm_on_child_setup */
+static void _xterm_on_child_setup(gpointer data)
+{
+	int const * fd = data;
+
+	/* the xterm can then be signalled along with its process group */
+	setpgid(0, 0);
+	if(*fd == SPAWNER_FD)
+		fcntl(*fd, F_SETFD, 0);
+	else if(*fd >= 0 && dup2(*fd, SPAWNER_FD) < 0)
+		_exit(127);
+}
+
+
+/* xterm_on_plug_added */
+static void _xterm_on_plug_added(gpointer data)
+{
+	TerminalBackend * xterm = data;
+
+	/* the xterm is embedded */
+	if(xterm->helper.ready != NULL)
+		xterm->helper.ready(xterm->helper.data);
+}
+
+
+/* xterm_on_plug_removed */
+static gboolean _xterm_on_plug_removed(gpointer data)
+{
+	(void) data;
+
+	/* keep the socket */
+	return TRUE;
+}
@@ -0,0 +1,790 @@
+#!/bin/sh
+#$Id$
+#Copyright (c) 2026 Pierre Pronchery <khorben@defora.org>
+#
+#Redistribution and use in source and binary forms, with or without
+#modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+#THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+#AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+#IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+#DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+#FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+#DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+#SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+#CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+#OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#variables
+BASELINE="${0%/bench.sh}/bench.baseline"
+COMMONSH="${0%/bench.sh}/common.sh"
+CONFIGSH="${0%/bench.sh}/../config.sh"
+CONTROL=
+COUNT=10
+DISPLAYNUM=42
+EMBED=
+HISTORY=
+LATENCY=
+LINES=100000
+METRICS=
+MONITOR=
+PRIORITY=
+PROGNAME="bench.sh"
+RECORDER=
+SPAWNER=
+STORE=
+TERMINAL=
+TIMEOUT=10
+#in percent
+TOLERANCE=20
+#executables
+CHMOD="chmod"
+DATE="date"
+DEBUG="_debug"
+GETCONF="getconf"
+GREP="grep"
+KILL="kill"
+MKDIR="mkdir -p"
+MKTEMP="mktemp"
+PGREP="pgrep"
+RM="rm -f"
+SED="sed"
+SEQ="seq"
+SLEEP="sleep"
+XDOTOOL="xdotool"
+XVFB="Xvfb"
+XTERM="xterm"
+XWININFO="xwininfo"
+
+[ -f "$CONFIGSH" ] && . "$CONFIGSH"
+. "$COMMONSH"
+
+
+#functions
+#bench
+_bench()
+{
+	res=0
+
+	$DATE
+	echo
+	#no display is required here
+	"$STORE"						|| res=2
+	"$RECORDER"						|| res=2
+	"$HISTORY"						|| res=2
+	"$SPAWNER"						|| res=2
+	"$METRICS"						|| res=2
+	"$MONITOR"						|| res=2
+	"$MONITOR" -c 10 -n 500 -p 20 -s 64			|| res=2
+	#like the tabs in the background by default
+	"$PRIORITY" -i						|| res=2
+	_xvfb_start						|| return 2
+	_bench_window "standalone" -n				|| res=2
+	_bench_window "server"					|| res=2
+	_bench_embed "xterm"					|| res=2
+	_bench_embed "native"					|| res=2
+	_bench_backend "xterm"					|| res=2
+	_bench_backend "native"					|| res=2
+	_bench_flood "off"					|| res=2
+	_bench_flood "on"					|| res=2
+	_bench_resize						|| res=2
+	_bench_control						|| res=2
+	_bench_watchdog						|| res=2
+	_bench_latency						|| res=2
+	_bench_restore "eager"					|| res=2
+	_bench_restore "lazy"					|| res=2
+	_bench_history "xterm"					|| res=2
+	_bench_history "history"				|| res=2
+	_bench_tabs						|| res=2
+	_xvfb_stop
+	return $res
+}
+
+
+#bench_backend
+_bench_backend()
+{
+	backend="$1"
+
+	_bench_home						|| return 2
+	echo "backend=$backend" > "$home/.terminal"
+	#throughput: the tab closes once everything was displayed
+	$SEQ -f "%g: the quick brown fox jumps over the lazy dog" $LINES \
+		> "$home/output"
+	printf '#!/bin/sh\nexec cat "%s"\n' "$home/output" > "$home/cat.sh"
+	$CHMOD +x "$home/cat.sh"
+	start=$(_now)
+	HOME="$home" SHELL="$home/cat.sh" DISPLAY=":$DISPLAYNUM" \
+		"$TERMINAL" -n
+	echo "backend.$backend.cat_ms=$(($(_now) - start))"
+	#memory usage, including the terminal emulator itself
+	_bench_start "$backend" "backend=$backend\n"		|| return 2
+	#let the terminal settle down
+	$SLEEP 1
+	echo "backend.$backend.rss_kb=$(_bench_rss $pid $($PGREP -P $pid))"
+	_bench_stop
+	return 0
+}
+
+
+#bench_compare
+_bench_compare()
+{
+	baseline="$1"
+	results="$2"
+	res=0
+
+	#lower is always better
+	while IFS="=" read key value; do
+		case "$key" in
+			""|\#*)
+				continue
+				;;
+		esac
+		current=$($SED -n "s/^$key=//p" "$results")
+		if [ -z "$current" ]; then
+			_error "$key: Missing from the results"
+			res=2
+		elif [ "$current" -gt $((value * (100 + TOLERANCE) / 100)) ]
+		then
+			echo "regression.$key=$current"
+			_error "$key: $current instead of $value (+$TOLERANCE%)"
+			res=2
+		fi
+	done < "$baseline"
+	return $res
+}
+
+
+#bench_control
+_bench_control()
+{
+	tabs=$((COUNT * 5))
+	res=0
+
+	_bench_home						|| return 2
+	_bench_start "control" "[control]\nenabled=1\npath=$home/control\n" \
+								|| return 2
+	#every tab in a single round trip, until usable
+	start=$(_now)
+	if "$CONTROL" -p "$home/control" -e plugged -n $tabs \
+		"{\"command\":\"open\",\"count\":$tabs}" \
+		> "$home/events"; then
+		echo "control.open_ms=$(($(_now) - start))"
+	else
+		_error "control: Could not open $tabs tabs"
+		res=2
+	fi
+	start=$(_now)
+	if "$CONTROL" -p "$home/control" '{"command":"list"}' \
+		> "$home/list"; then
+		echo "control.list_ms=$(($(_now) - start))"
+	else
+		_error "control: Could not list the tabs"
+		res=2
+	fi
+	_bench_stop
+	return $res
+}
+
+
+#bench_cpu
+_bench_cpu()
+{
+	ticks=0
+
+	#in milliseconds, summed over every process given
+	for pid in "$@"; do
+		[ -f "/proc/$pid/stat" ]			|| continue
+		#the name of the process may contain spaces
+		set -- $($SED -n 's/^.*) //p' "/proc/$pid/stat")
+		ticks=$((ticks + ${12} + ${13}))
+	done
+	echo $((ticks * 1000 / $($GETCONF CLK_TCK)))
+}
+
+
+#bench_descendants
+_bench_descendants()
+{
+	for child in $($PGREP -P "$1"); do
+		echo "$child"
+		_bench_descendants "$child"
+	done
+}
+
+
+#bench_embed
+_bench_embed()
+{
+	backend="$1"
+	res=0
+
+	#against window.standalone.rss_kb for a process per window
+	_bench_home						|| return 2
+	if ! HOME="$home" SHELL="$home/sleep.sh" DISPLAY=":$DISPLAYNUM" \
+		"$EMBED" -b "$backend" -c $COUNT; then
+		_error "embed: Could not embed $COUNT $backend tabs"
+		res=2
+	fi
+	$RM -r -- "$home"
+	return $res
+}
+
+
+#bench_flood
+_bench_flood()
+{
+	mode="$1"
+	config=
+	res=0
+
+	[ "$mode" = "on" ] && config='[flood]\nenabled=1\n'
+	_bench_home						|| return 2
+	#the tab closes once interrupted
+	printf '#!/bin/sh\nexec yes "%s"\n' \
+		"the quick brown fox jumps over the lazy dog" \
+		> "$home/yes.sh"
+	$CHMOD +x "$home/yes.sh"
+	_bench_start "flood.$mode" "$config" "$home/yes.sh" || return 2
+	window=$($XDOTOOL search --classname "^terminal\$" | head -n 1)
+	#let the output pile up
+	$SLEEP 1
+	start=$(_now)
+	deadline=$((start + TIMEOUT * 1000))
+	$XDOTOOL windowfocus --sync "$window" key ctrl+c
+	while $KILL -0 $pid 2> "/dev/null"; do
+		if [ $(_now) -ge $deadline ]; then
+			_error "flood.$mode: Could not interrupt the shell"
+			res=2
+			break
+		fi
+		$SLEEP 0.01
+	done
+	echo "flood.$mode.interrupt_ms=$(($(_now) - start))"
+	_bench_stop
+	return $res
+}
+
+
+#bench_history
+_bench_history()
+{
+	mode="$1"
+	tabs=$COUNT
+	res=0
+
+	_bench_home						|| return 2
+	#the same scrollback, kept by xterm or in the history
+	if [ "$mode" = "history" ]; then
+		config='[history]\nenabled=1\n'
+	else
+		config="[xterm]\nsavelines=$LINES\n"
+	fi
+	config="$config[control]\nenabled=1\npath=$home/control\n"
+	$SEQ -f "%g: the quick brown fox jumps over the lazy dog" $LINES \
+		> "$home/output"
+	printf '#!/bin/sh\ncat "%s"\nexec sleep %u\n' "$home/output" \
+		$((TIMEOUT * 10)) > "$home/cat.sh"
+	$CHMOD +x "$home/cat.sh"
+	_bench_start "history.$mode" "$config" "$home/cat.sh" || return 2
+	if "$CONTROL" -p "$home/control" -e plugged -n $((tabs - 1)) \
+		"{\"command\":\"open\",\"count\":$((tabs - 1))}" \
+		> "$home/events"; then
+		#let the output be displayed
+		$SLEEP 2
+		#memory usage, including Terminal and the xterms
+		echo "history.$mode.pss_per_tab_kb=$(($(_bench_pss $pid \
+			$($PGREP -P $pid)) / tabs))"
+	else
+		_error "history.$mode: Could not open $tabs tabs"
+		res=2
+	fi
+	#across every tab, for a single line each
+	if [ "$mode" = "history" ] && "$CONTROL" -p "$home/control" \
+		'{"command":"search","string":"4242: the"}' \
+		> "$home/search"; then
+		echo "history.$mode.search_us=$($SED -n \
+			's/^.*"search_us":\([0-9]*\).*$/\1/p' "$home/search")"
+	fi
+	_bench_stop
+	return $res
+}
+
+
+#bench_home
+_bench_home()
+{
+	#a temporary home directory, with a shell kept running
+	home=$($MKTEMP -d)					|| return 2
+	trace="$home/trace.json"
+	printf '#!/bin/sh\nexec sleep %u\n' $((TIMEOUT * 10)) \
+		> "$home/sleep.sh"
+	$CHMOD +x "$home/sleep.sh"
+}
+
+
+#bench_latency
+_bench_latency()
+{
+	res=0
+
+	_bench_home						|| return 2
+	#the keys typed are echoed by the pty
+	printf '#!/bin/sh\nexec cat\n' > "$home/cat.sh"
+	printf '#!/bin/sh\nexec yes\n' > "$home/yes.sh"
+	$CHMOD +x "$home/cat.sh" "$home/yes.sh"
+	#standalone
+	DISPLAY=":$DISPLAYNUM" $XTERM -name "bench-latency" \
+		-e "$home/cat.sh" &
+	pid=$!
+	deadline=$(($(_now) + TIMEOUT * 1000))
+	while true; do
+		window=$(DISPLAY=":$DISPLAYNUM" $XDOTOOL search \
+			--classname "^bench-latency\$" | head -n 1)
+		[ -z "$window" ]				|| break
+		[ $(_now) -lt $deadline ]			|| break
+		$SLEEP 0.1
+	done
+	if [ -n "$window" ]; then
+		DISPLAY=":$DISPLAYNUM" "$LATENCY" -n "xterm" "$window" \
+									|| res=2
+	else
+		_error "latency: Could not start $XTERM"
+		res=2
+	fi
+	$KILL $pid
+	wait $pid
+	#embedded
+	_bench_start "latency" "[control]\nenabled=1\npath=$home/control\n" \
+		"$home/cat.sh"					|| return 2
+	window=$(DISPLAY=":$DISPLAYNUM" $XDOTOOL search \
+		--classname "^terminal\$" | head -n 1)
+	DISPLAY=":$DISPLAYNUM" "$LATENCY" -n "embedded" "$window" || res=2
+	#embedded, along with tabs under load in the background
+	open="{\"command\":\"open\",\"count\":4,\"shell\":\"$home/yes.sh\"}"
+	if "$CONTROL" -p "$home/control" -e plugged -n 4 "$open" \
+		'{"command":"focus","tab":1}' > "$home/events"; then
+		DISPLAY=":$DISPLAYNUM" "$LATENCY" -n "loaded" "$window" \
+									|| res=2
+	else
+		_error "latency: Could not open the tabs under load"
+		res=2
+	fi
+	_bench_stop
+	return $res
+}
+
+
+#bench_pss
+_bench_pss()
+{
+	pss=0
+
+	#in kilobytes, summed over every process given
+	for pid in "$@"; do
+		[ -f "/proc/$pid/smaps_rollup" ]		|| continue
+		while read key value unit; do
+			[ "$key" = "Pss:" ] && pss=$((pss + value))
+		done < "/proc/$pid/smaps_rollup"
+	done
+	echo "$pss"
+}
+
+
+#bench_resize
+_bench_resize()
+{
+	tabs=$((COUNT * 3))
+	res=0
+
+	_bench_home						|| return 2
+	#every shell reports the SIGWINCHs received once hung up
+	cat > "$home/winch.sh" << EOF
+#!/bin/sh
+count=0
+trap 'count=\$((count + 1))' WINCH
+trap 'echo \$count >> "$home/winch"; exit 0' HUP TERM
+while true; do
+	sleep 1 &
+	wait \$!
+done
+EOF
+	$CHMOD +x "$home/winch.sh"
+	_bench_start "resize" "" "$home/winch.sh"		|| return 2
+	window=$($XDOTOOL search --classname "^terminal\$" | head -n 1)
+	$XDOTOOL windowfocus --sync "$window" \
+		key --repeat $((tabs - 1)) --delay 0 ctrl+t
+	if ! _tabs_wait "$trace" $tabs; then
+		_error "resize: Could not open $tabs tabs"
+		_bench_stop
+		return 2
+	fi
+	#let the tabs settle down
+	$SLEEP 1
+	: > "$home/winch"
+	pids="$pid $(_bench_descendants $pid)"
+	cpu=$(_bench_cpu $pids)
+	#drag the corner of the window for about 2 seconds
+	i=0
+	while [ $i -lt 60 ]; do
+		$XDOTOOL windowsize "$window" $((600 + i * 5)) \
+			$((400 + i * 3))
+		$SLEEP 0.033
+		i=$((i + 1))
+	done
+	$SLEEP 1
+	echo "resize.cpu_ms=$(($(_bench_cpu $pids) - cpu))"
+	#the shells are hung up along with their tabs
+	$KILL $pid
+	wait $pid
+	deadline=$(($(_now) + TIMEOUT * 1000))
+	while [ $($GREP -c . "$home/winch") -lt $tabs ]; do
+		[ $(_now) -lt $deadline ]			|| break
+		$SLEEP 0.1
+	done
+	count=0
+	while read winch; do
+		count=$((count + winch))
+	done < "$home/winch"
+	echo "resize.winch_count=$count"
+	$RM -r -- "$home"
+	return $res
+}
+
+
+#bench_restore
+_bench_restore()
+{
+	mode="$1"
+	tabs=50
+	lazy=0
+	res=0
+
+	[ "$mode" = "lazy" ] && lazy=1
+	_bench_home						|| return 2
+	#the journal of a previous session, with a single window
+	i=1
+	while [ $i -le $tabs ]; do
+		printf 'T\t%u\t1\t%u\t0\t\t%s\ttab %u\n' \
+			$i $i "$home" $i
+		i=$((i + 1))
+	done > "$home/.terminal-journal"
+	#time to interactive, until the tab shown is usable
+	start=$(_now)
+	_bench_start "restore.$mode" \
+		"[journal]\nenabled=1\nlazy=$lazy\nstagger=20\n" "" -r \
+								|| return 2
+	echo "restore.$mode.interactive_ms=$(($(_now) - start))"
+	#until every tab is usable, started in turn if lazy
+	if _tabs_wait "$trace" $tabs; then
+		echo "restore.$mode.all_ms=$(($(_now) - start))"
+	else
+		_error "restore: Could not restore $tabs tabs ($mode)"
+		res=2
+	fi
+	_bench_stop
+	return $res
+}
+
+
+#bench_rss
+_bench_rss()
+{
+	rss=0
+
+	#in kilobytes, summed over every process given
+	for pid in "$@"; do
+		[ -f "/proc/$pid/status" ]			|| continue
+		while read key value unit; do
+			[ "$key" = "VmRSS:" ] && rss=$((rss + value))
+		done < "/proc/$pid/status"
+	done
+	echo "$rss"
+}
+
+
+#bench_start
+_bench_start()
+{
+	name="$1"
+	config="$2"
+	shell="$home/sleep.sh"
+	shift 2
+	if [ $# -gt 0 ]; then
+		[ -z "$1" ] || shell="$1"
+		shift
+	fi
+
+	#in the home directory from _bench_home, until the first tab is usable
+	printf '%b' "$config" > "$home/.terminal"
+	HOME="$home" SHELL="$shell" DISPLAY=":$DISPLAYNUM" \
+		"$TERMINAL" -n -t "$trace" "$@" &
+	pid=$!
+	if ! _tabs_wait "$trace" 1; then
+		_error "$name: Could not open the first tab"
+		_bench_stop
+		return 2
+	fi
+	return 0
+}
+
+
+#bench_stop
+_bench_stop()
+{
+	#the process may be gone already
+	$KILL $pid 2> "/dev/null"
+	wait $pid
+	$RM -r -- "$home"
+}
+
+
+#bench_tabs
+_bench_tabs()
+{
+	tabs=$((COUNT * 2 + 1))
+	res=0
+
+	#the tabs have to remain open
+	_bench_home						|| return 2
+	#cold start, until the first tab is usable
+	start=$(_now)
+	_bench_start "tabs" ""					|| return 2
+	echo "tabs.first_ms=$(($(_now) - start))"
+	window=$($XDOTOOL search --classname "^terminal\$" | head -n 1)
+	#sequential tabs
+	start=$(_now)
+	i=1
+	while [ $i -le $COUNT ]; do
+		$XDOTOOL windowfocus --sync "$window" key ctrl+t
+		_tabs_wait "$trace" $((i + 1))			|| break
+		i=$((i + 1))
+	done
+	echo "tabs.sequential_ms=$(($(_now) - start))"
+	#burst of tabs
+	start=$(_now)
+	$XDOTOOL windowfocus --sync "$window" \
+		key --repeat $COUNT --delay 0 ctrl+t
+	if _tabs_wait "$trace" $tabs; then
+		echo "tabs.burst_ms=$(($(_now) - start))"
+		#memory usage, with the xterms shared across the tabs
+		echo "tabs.rss_kb=$(_bench_rss $pid)"
+		echo "tabs.pss_per_tab_kb=$(($(_bench_pss \
+			$($PGREP -P $pid)) / tabs))"
+	else
+		_error "tabs: Could not open $tabs tabs"
+		res=2
+	fi
+	#close every tab at once, until the process is gone
+	start=$(_now)
+	deadline=$((start + TIMEOUT * 1000))
+	$XDOTOOL windowfocus --sync "$window" key ctrl+shift+w
+	while $KILL -0 $pid 2> "/dev/null"; do
+		if [ $(_now) -ge $deadline ]; then
+			_error "tabs: Could not close every tab"
+			res=2
+			break
+		fi
+		$SLEEP 0.01
+	done
+	echo "tabs.close_all_ms=$(($(_now) - start))"
+	_bench_stop
+	return $res
+}
+
+
+#bench_wait
+_bench_wait()
+{
+	count="$1"
+	deadline=$(($(_now) + TIMEOUT * 1000))
+
+	while [ $(_bench_windows) -lt "$count" ]; do
+		[ $(_now) -lt $deadline ]			|| return 2
+		$SLEEP 0.01
+	done
+	return 0
+}
+
+
+#bench_watchdog
+_bench_watchdog()
+{
+	res=0
+
+	_bench_home						|| return 2
+	config="[control]\nenabled=1\npath=$home/control\n"
+	config="$config[watchdog]\nenabled=1\ninterval=100\ntimeout=500\n"
+	_bench_start "watchdog" "$config"			|| return 2
+	if ! "$CONTROL" -p "$home/control" '{"command":"list"}' \
+		> "$home/list"; then
+		_error "watchdog: Could not list the tabs"
+		_bench_stop
+		return 2
+	fi
+	xterm=$($SED -n 's/^[^}]*"backend":"xterm","pid":\([0-9]*\).*$/\1/p' \
+		"$home/list")
+	#from stopping the xterm until reported, then until continued
+	start=$(_now)
+	if [ -n "$xterm" ] && $KILL -STOP "$xterm" && "$CONTROL" \
+		-p "$home/control" -e hung -n 1 '{"command":"list"}' \
+		> "$home/events"; then
+		echo "watchdog.hung_ms=$(($(_now) - start))"
+	else
+		_error "watchdog: The xterm was not reported as hung"
+		res=2
+	fi
+	start=$(_now)
+	if [ -n "$xterm" ] && $KILL -CONT "$xterm" && "$CONTROL" \
+		-p "$home/control" -e responding -n 1 '{"command":"list"}' \
+		> "$home/events"; then
+		echo "watchdog.responding_ms=$(($(_now) - start))"
+	else
+		_error "watchdog: The xterm was not reported as responding"
+		res=2
+	fi
+	_bench_stop
+	return $res
+}
+
+
+#bench_window
+_bench_window()
+{
+	mode="$1"
+	shift
+	pids=
+	total=0
+
+	#the first window always starts a new process
+	DISPLAY=":$DISPLAYNUM" "$TERMINAL" "$@" &
+	pids="$!"
+	if ! _bench_wait 1; then
+		_error "$mode: Could not open the first window"
+		$KILL $pids
+		return 2
+	fi
+	rss=$(_bench_rss $pids)
+	i=1
+	while [ $i -le $COUNT ]; do
+		start=$(_now)
+		DISPLAY=":$DISPLAYNUM" "$TERMINAL" "$@" &
+		#in server mode the client exits right away
+		[ "$mode" = "server" ] || pids="$pids $!"
+		if ! _bench_wait $((i + 1)); then
+			_error "$mode: Could not open window $i"
+			$KILL $pids
+			return 2
+		fi
+		total=$((total + $(_now) - start))
+		i=$((i + 1))
+	done
+	rss=$(($(_bench_rss $pids) - rss))
+	echo "window.$mode.time_ms=$((total / COUNT))"
+	echo "window.$mode.rss_kb=$((rss / COUNT))"
+	$KILL $pids
+	wait
+	return 0
+}
+
+
+#bench_windows
+_bench_windows()
+{
+	$XWININFO -display ":$DISPLAYNUM" -root -children 2> "/dev/null" \
+		| $GREP -c '"Terminal": ("terminal"'
+}
+
+
+#debug
+_debug()
+{
+	echo "$@" 1>&3
+	"$@"
+}
+
+
+#error
+_error()
+{
+	echo "$PROGNAME: $@" 1>&2
+	return 2
+}
+
+
+#usage
+_usage()
+{
+	echo "Usage: $PROGNAME [-c] target..." 1>&2
+	return 1
+}
+
+
+#main
+clean=0
+while getopts "cO:P:" name; do
+	case "$name" in
+		c)
+			clean=1
+			;;
+		O)
+			export "${OPTARG%%=*}"="${OPTARG#*=}"
+			;;
+		P)
+			#XXX ignored for compatibility
+			;;
+		?)
+			_usage
+			exit $?
+			;;
+	esac
+done
+shift $((OPTIND - 1))
+if [ $# -lt 1 ]; then
+	_usage
+	exit $?
+fi
+
+#clean
+[ $clean -ne 0 ] && exit 0
+
+exec 3>&1
+ret=0
+while [ $# -gt 0 ]; do
+	target="$1"
+	dirname="${target%/*}"
+	shift
+
+	objdir=
+	if [ -n "$dirname" -a "$dirname" != "$target" ]; then
+		$MKDIR -- "$dirname"				|| ret=$?
+		objdir="$dirname/"
+	fi
+	[ -n "$CONTROL" ] || CONTROL="${objdir}control"
+	[ -n "$EMBED" ] || EMBED="${objdir}embed"
+	[ -n "$HISTORY" ] || HISTORY="${objdir}history"
+	[ -n "$LATENCY" ] || LATENCY="${objdir}latency"
+	[ -n "$METRICS" ] || METRICS="${objdir}metrics"
+	[ -n "$MONITOR" ] || MONITOR="${objdir}monitor"
+	[ -n "$PRIORITY" ] || PRIORITY="${objdir}priority"
+	[ -n "$RECORDER" ] || RECORDER="${objdir}recorder"
+	[ -n "$SPAWNER" ] || SPAWNER="${objdir}spawner"
+	[ -n "$STORE" ] || STORE="${objdir}store"
+	[ -n "$TERMINAL" ] || TERMINAL="${objdir}../src/terminal"
+	_bench > "$target"					|| ret=$?
+	#regressions are appended to the results
+	if [ -f "$BASELINE" ]; then
+		_bench_compare "$BASELINE" "$target" >> "$target" || ret=$?
+	fi
+done
+exit $ret
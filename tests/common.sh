@@ -0,0 +1,80 @@
+#!/bin/sh
+#$Id$
+#Copyright (c) 2026 Pierre Pronchery <khorben@defora.org>
+#
+#Redistribution and use in source and binary forms, with or without
+#modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+#THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+#AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+#IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+#DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+#FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+#DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+#SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+#CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+#OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+#functions shared by bench.sh and soak.sh, once their variables are set
+#now
+_now()
+{
+	#in milliseconds
+	echo $(($($DATE +%s%N) / 1000000))
+}
+
+
+#tabs_wait
+_tabs_wait()
+{
+	trace="$1"
+	count="$2"
+	deadline=$(($(_now) + TIMEOUT * 1000))
+
+	#the tabs are traced until usable
+	while true; do
+		cnt=$($GREP -c '"name":"tab","cat":"terminal","ph":"e"' \
+			"$trace" 2> "/dev/null")
+		[ "${cnt:-0}" -lt "$count" ]			|| return 0
+		[ $(_now) -lt $deadline ]			|| return 2
+		$SLEEP 0.01
+	done
+}
+
+
+#xvfb_start
+_xvfb_start()
+{
+	deadline=$(($(_now) + TIMEOUT * 1000))
+
+	$XVFB ":$DISPLAYNUM" -screen 0 1024x768x24 -nolisten tcp \
+		> "/dev/null" 2>&1 &
+	xvfb=$!
+	until $XWININFO -display ":$DISPLAYNUM" -root > "/dev/null" 2>&1; do
+		if [ $(_now) -ge $deadline ]; then
+			_error "Could not start $XVFB"
+			$KILL $xvfb
+			return 2
+		fi
+		$SLEEP 0.1
+	done
+	return 0
+}
+
+
+#xvfb_stop
+_xvfb_stop()
+{
+	$KILL $xvfb
+	wait $xvfb
+}
@@ -0,0 +1,198 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef PROGNAME_CONTROL
+# define PROGNAME_CONTROL	"control"
+#endif
+#define CONTROL_TIMEOUT		10
+
+
+/* control */
+/* private */
+/* prototypes */
+static int _control(char const * path, char const * event, unsigned int count,
+		char * const * commands, int commands_cnt);
+static int _control_send(int fd, char const * command);
+
+static int _error(char const * message, int ret);
+static int _usage(void);
+
+
+/* functions */
+/* control */
+static int _control(char const * path, char const * event, unsigned int count,
+		char * const * commands, int commands_cnt)
+{
+	struct sockaddr_un sa;
+	struct timeval tv;
+	int fd;
+	FILE * fp;
+	char * line = NULL;
+	size_t size = 0;
+	char buf[64];
+	int i;
+	unsigned int n = 0;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -_error("socket", 1);
+	if(connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+	{
+		close(fd);
+		return -_error(path, 1);
+	}
+	/* do not wait forever, unless asked to */
+	tv.tv_sec = (event == NULL || count > 0) ? CONTROL_TIMEOUT : 0;
+	tv.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	if((fp = fdopen(fd, "r")) == NULL)
+	{
+		close(fd);
+		return -_error(path, 1);
+	}
+	/* subscribe first, so that no event is missed */
+	if(event != NULL && (_control_send(fd, "{\"command\":\"subscribe\"}")
+				!= 0 || getline(&line, &size, fp) < 0))
+	{
+		fclose(fp);
+		return -_error(path, 1);
+	}
+	/* one reply per line sent, along with the events meanwhile */
+	snprintf(buf, sizeof(buf), "{\"event\":\"%s\"", (event != NULL)
+			? event : "");
+	for(i = 0; i < commands_cnt; i++)
+	{
+		if(_control_send(fd, commands[i]) != 0)
+			break;
+		while(getline(&line, &size, fp) >= 0
+				&& strncmp(line, "{\"event\":", 9) == 0)
+			if(event != NULL)
+			{
+				fputs(line, stdout);
+				if(strncmp(line, buf, strlen(buf)) == 0)
+					n++;
+			}
+		if(ferror(fp) || feof(fp))
+			break;
+		fputs(line, stdout);
+	}
+	/* until enough events of this kind were received */
+	while(i == commands_cnt && event != NULL && (count == 0 || n < count)
+			&& getline(&line, &size, fp) >= 0)
+	{
+		fputs(line, stdout);
+		fflush(stdout);
+		if(strncmp(line, buf, strlen(buf)) == 0)
+			n++;
+	}
+	free(line);
+	fclose(fp);
+	if(i < commands_cnt || (event != NULL && n < count))
+		return -_error(path, 1);
+	return 0;
+}
+
+
+/* control_send */
+static int _control_send(int fd, char const * command)
+{
+	size_t len = strlen(command);
+
+	if(write(fd, command, len) != (ssize_t)len || write(fd, "\n", 1) != 1)
+		return -1;
+	return 0;
+}
+
+
+/* error */
+static int _error(char const * message, int ret)
+{
+	fputs(PROGNAME_CONTROL ": ", stderr);
+	perror(message);
+	return ret;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_CONTROL " [-e event][-n count][-p path]"
+" command...\n"
+"  -e	Wait for events of this kind\n"
+"  -n	Number of events to wait for, 0 for every event (default: 1)\n"
+"  -p	Path to the control socket (default: $TERMINAL_CONTROL)\n",
+			stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	char const * path;
+	char const * event = NULL;
+	unsigned int count = 1;
+	unsigned long u;
+	char * p;
+
+	path = getenv("TERMINAL_CONTROL");
+	while((o = getopt(argc, argv, "e:n:p:")) != -1)
+		switch(o)
+		{
+			case 'e':
+				event = optarg;
+				break;
+			case 'n':
+				u = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| u > 1000000)
+					return _usage();
+				count = u;
+				break;
+			case 'p':
+				path = optarg;
+				break;
+			default:
+				return _usage();
+		}
+	if(path == NULL || path[0] == '\0' || (optind == argc && event == NULL))
+		return _usage();
+	return (_control(path, event, count, &argv[optind], argc - optind)
+			== 0) ? 0 : 2;
+}
@@ -0,0 +1,275 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <System.h>
+#include "../include/Terminal.h"
+
+#ifndef PROGNAME_EMBED
+# define PROGNAME_EMBED		"embed"
+#endif
+
+/* constants */
+#define EMBED_TIMEOUT		10
+
+
+/* embed */
+/* private */
+/* types */
+typedef struct _Embed
+{
+	TerminalWidget ** widgets;
+	unsigned int count;
+	unsigned int ready;
+	unsigned int exited;
+	gboolean timeout;
+} Embed;
+
+
+/* prototypes */
+static int _embed(char const * backend, unsigned int count);
+
+static long _embed_now(void);
+static unsigned long _embed_rss(GPid pid);
+
+static int _usage(void);
+
+/* callbacks */
+static void _embed_on_exited(void * data, GPid pid, int status);
+static void _embed_on_ready(void * data);
+static gboolean _embed_on_timeout(gpointer data);
+
+
+/* functions */
+/* embed */
+static int _embed(char const * backend, unsigned int count)
+{
+	int ret = 0;
+	Embed embed;
+	TerminalWidgetHelper helper;
+	GtkWidget * window;
+	GtkWidget * notebook;
+	unsigned int i;
+	unsigned long rss;
+	unsigned long children = 0;
+	long start;
+	guint source;
+
+	if((embed.widgets = calloc(count, sizeof(*embed.widgets))) == NULL)
+	{
+		perror(PROGNAME_EMBED);
+		return -1;
+	}
+	embed.count = 0;
+	embed.ready = 0;
+	embed.exited = 0;
+	embed.timeout = FALSE;
+	memset(&helper, 0, sizeof(helper));
+	helper.data = &embed;
+	helper.ready = _embed_on_ready;
+	helper.exited = _embed_on_exited;
+	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_default_size(GTK_WINDOW(window), 640, 480);
+	notebook = gtk_notebook_new();
+	gtk_container_add(GTK_CONTAINER(window), notebook);
+	gtk_widget_show_all(window);
+	while(gtk_events_pending())
+		gtk_main_iteration();
+	/* only the tabs are accounted for */
+	rss = _embed_rss(getpid());
+	start = _embed_now();
+	for(i = 0; i < count; i++)
+	{
+		if((embed.widgets[i] = terminalwidget_new(backend, &helper))
+				== NULL)
+			break;
+		embed.count++;
+		gtk_notebook_append_page(GTK_NOTEBOOK(notebook),
+				terminalwidget_get_widget(embed.widgets[i]),
+				NULL);
+		gtk_widget_show(terminalwidget_get_widget(embed.widgets[i]));
+		/* the shell of the user by default */
+		if(terminalwidget_start(embed.widgets[i], NULL, NULL, 0) != 0)
+			break;
+	}
+	if(i < count)
+	{
+		error_print(PROGNAME_EMBED);
+		ret = -1;
+	}
+	else
+	{
+		/* until every tab is usable */
+		source = g_timeout_add_seconds(EMBED_TIMEOUT,
+				_embed_on_timeout, &embed);
+		while(embed.ready < count && embed.exited == 0
+				&& embed.timeout == FALSE)
+			gtk_main_iteration();
+		if(embed.timeout == FALSE)
+			g_source_remove(source);
+		if(embed.ready < count)
+		{
+			fprintf(stderr, "%s: %s: %u/%u %s\n", PROGNAME_EMBED,
+					backend, embed.ready, count,
+					"tabs usable");
+			ret = -1;
+		}
+	}
+	if(ret == 0)
+	{
+		printf("embed.%s.time_ms=%ld\n", backend,
+				(_embed_now() - start) / count / 1000);
+		rss = _embed_rss(getpid()) - rss;
+		for(i = 0; i < count; i++)
+			children += _embed_rss(terminalwidget_get_pid(
+						embed.widgets[i]));
+		printf("embed.%s.rss_kb=%lu\n", backend, rss / count);
+		printf("embed.%s.children_kb=%lu\n", backend,
+				children / count);
+	}
+	for(i = 0; i < count; i++)
+		if(embed.widgets[i] != NULL)
+			terminalwidget_delete(embed.widgets[i]);
+	free(embed.widgets);
+	gtk_widget_destroy(window);
+	return ret;
+}
+
+
+/* embed_now */
+static long _embed_now(void)
+{
+	struct timeval tv;
+
+	/* in microseconds */
+	if(gettimeofday(&tv, NULL) != 0)
+		return 0;
+	return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/* embed_rss */
+static unsigned long _embed_rss(GPid pid)
+{
+	unsigned long ret = 0;
+	char buf[64];
+	FILE * fp;
+
+	/* in kilobytes */
+	if(pid <= 0)
+		return 0;
+	snprintf(buf, sizeof(buf), "/proc/%ld/status", (long)pid);
+	if((fp = fopen(buf, "r")) == NULL)
+		return 0;
+	while(fgets(buf, sizeof(buf), fp) != NULL)
+		if(sscanf(buf, "VmRSS: %lu kB", &ret) == 1)
+			break;
+	fclose(fp);
+	return ret;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_EMBED " [-b backend][-c count]\n"
+"  -b	Backend of the tabs (default: xterm)\n"
+"  -c	Number of tabs embedded (default: 10)\n", stderr);
+	return 1;
+}
+
+
+/* callbacks */
+/* embed_on_exited */
+static void _embed_on_exited(void * data, GPid pid, int status)
+{
+	Embed * embed = data;
+
+	fprintf(stderr, "%s: %ld: %s %d\n", PROGNAME_EMBED, (long)pid,
+			"exited with status", status);
+	embed->exited++;
+}
+
+
+/* embed_on_ready */
+static void _embed_on_ready(void * data)
+{
+	Embed * embed = data;
+
+	embed->ready++;
+}
+
+
+/* embed_on_timeout */
+static gboolean _embed_on_timeout(gpointer data)
+{
+	Embed * embed = data;
+
+	embed->timeout = TRUE;
+	return FALSE;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	char const * backend = "xterm";
+	unsigned int count = 10;
+	unsigned long u;
+	char * p;
+
+	if(gtk_init_check(&argc, &argv) != TRUE)
+	{
+		fputs(PROGNAME_EMBED ": Could not initialize GTK+\n", stderr);
+		return 2;
+	}
+	while((o = getopt(argc, argv, "b:c:")) != -1)
+		switch(o)
+		{
+			case 'b':
+				backend = optarg;
+				break;
+			case 'c':
+				u = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0' || u == 0
+						|| u > 1000)
+					return _usage();
+				count = u;
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_embed(backend, count) == 0) ? 0 : 2;
+}
@@ -0,0 +1,219 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/history.c"
+
+#ifndef PROGNAME_HISTORY
+# define PROGNAME_HISTORY	"history"
+#endif
+
+
+/* index */
+/* private */
+/* constants */
+#define INDEX_FRAME	4096
+#define INDEX_NEEDLE	10000
+#define INDEX_SIZE	(4 * 1024 * 1024)
+
+
+/* prototypes */
+static int _index(unsigned int size, char const * string);
+static int _index_on_match(void * data, size_t offset, char const * line,
+		size_t len);
+static void _index_wait(TerminalHistory * history);
+
+static long _index_now(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* index */
+static int _index(unsigned int size, char const * string)
+{
+	char const line[] = ": the quick brown fox jumps over the lazy dog"
+		" \342\200\224 \033[1mbold\033[0m\r\n";
+	char * buf;
+	size_t total = (size_t)size * 1024 * 1024;
+	size_t len = 1024 * 1024;
+	size_t i;
+	size_t n;
+	unsigned int l;
+	char tmp[] = "/tmp/" PROGNAME_HISTORY ".XXXXXX";
+	TerminalHistory * history;
+	size_t text;
+	size_t stored;
+	long start;
+	long elapsed;
+	int matches = 0;
+
+	/* like the output of a shell, with a needle from time to time */
+	if((buf = malloc(len + sizeof(line) + 32)) == NULL)
+	{
+		perror(PROGNAME_HISTORY);
+		return -1;
+	}
+	for(i = 0, l = 0; i < len; l++)
+		i += snprintf(&buf[i], sizeof(line) + 32,
+				(l % INDEX_NEEDLE == 0) ? "needle-%u%s"
+				: "%u%s", l, line);
+	if(mkdtemp(tmp) == NULL)
+	{
+		perror(tmp);
+		free(buf);
+		return -1;
+	}
+	if((history = terminalhistory_new(tmp, INDEX_SIZE)) == NULL)
+	{
+		perror(tmp);
+		rmdir(tmp);
+		free(buf);
+		return -1;
+	}
+	/* the file is gone already */
+	rmdir(tmp);
+	start = _index_now();
+	for(i = 0; i < total; i += n)
+	{
+		n = total - i;
+		n = (n < INDEX_FRAME) ? n : INDEX_FRAME;
+		n = (n < len - i % len) ? n : len - i % len;
+		/* nothing is dropped here */
+		while(n > history->size - (atomic_load(&history->head)
+					- atomic_load(&history->tail)))
+			usleep(100);
+		terminalhistory_output(history, &buf[i % len], n);
+	}
+	_index_wait(history);
+	elapsed = _index_now() - start;
+	text = terminalhistory_get_size(history, &stored);
+	printf("history.index_mb_s=%ld\n", (long)((double)total * 1000000
+				/ (1024 * 1024) / ((elapsed > 0) ? elapsed
+					: 1)));
+	printf("history.text_kb=%lu\n", (unsigned long)text / 1024);
+	printf("history.size_kb=%lu\n", (unsigned long)stored / 1024);
+	printf("history.dropped=%lu\n", terminalhistory_get_dropped(history));
+	start = _index_now();
+	if(terminalhistory_search(history, string, _index_on_match, &matches)
+			< 0)
+		perror(string);
+	printf("history.search_us=%ld\n", _index_now() - start);
+	printf("history.matches=%d\n", matches);
+	terminalhistory_delete(history);
+	free(buf);
+	return 0;
+}
+
+
+/* index_on_match */
+static int _index_on_match(void * data, size_t offset, char const * line,
+		size_t len)
+{
+	int * matches = data;
+
+	(void) offset;
+	(void) line;
+	(void) len;
+
+	(*matches)++;
+	return 0;
+}
+
+
+/* index_wait */
+static void _index_wait(TerminalHistory * history)
+{
+	size_t size;
+	size_t s;
+
+	/* until the indexer is done with the output */
+	while(atomic_load(&history->tail) != atomic_load(&history->head))
+		usleep(100);
+	for(size = terminalhistory_get_size(history, NULL);; size = s)
+	{
+		usleep(1000);
+		if((s = terminalhistory_get_size(history, NULL)) == size)
+			break;
+	}
+}
+
+
+/* index_now */
+static long _index_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_HISTORY " [-s size][-n string]\n"
+"  -n	String to search for (default: \"needle-10000\")\n"
+"  -s	Size of the output, in MB (default: 256)\n", stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int size = 256;
+	char const * string = "needle-10000";
+	char * p;
+
+	while((o = getopt(argc, argv, "n:s:")) != -1)
+		switch(o)
+		{
+			case 'n':
+				string = optarg;
+				if(string[0] == '\0')
+					return _usage();
+				break;
+			case 's':
+				size = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| size == 0)
+					return _usage();
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_index(size, string) == 0) ? 0 : 2;
+}
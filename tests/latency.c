@@ -0,0 +1,274 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/XTest.h>
+
+#ifndef PROGNAME_LATENCY
+# define PROGNAME_LATENCY	"latency"
+#endif
+
+/* constants */
+#define LATENCY_RETURN		40
+/* in milliseconds */
+#define LATENCY_TIMEOUT		1000
+
+
+/* latency */
+/* private */
+/* prototypes */
+static int _latency(char const * name, Window window, unsigned int count,
+		unsigned int interval);
+static void _latency_drain(Display * display);
+static long _latency_now(void);
+static Window _latency_target(Display * display, Window window);
+static int _latency_wait(Display * display, int type, long deadline);
+
+static int _latency_compare(void const * a, void const * b);
+
+static int _usage(void);
+
+
+/* functions */
+/* latency */
+static int _latency(char const * name, Window window, unsigned int count,
+		unsigned int interval)
+{
+	Display * display;
+	int event;
+	int error;
+	int major;
+	int minor;
+	Damage damage;
+	XWindowAttributes attributes;
+	KeyCode keys[2];
+	KeyCode key;
+	long * samples;
+	unsigned int cnt = 0;
+	unsigned int i;
+	long start;
+
+	if((display = XOpenDisplay(NULL)) == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", PROGNAME_LATENCY,
+				"Could not open the display");
+		return -1;
+	}
+	if(!XDamageQueryExtension(display, &event, &error)
+			|| !XTestQueryExtension(display, &error, &error,
+				&major, &minor)
+			|| !XGetWindowAttributes(display, window, &attributes))
+	{
+		fprintf(stderr, "%s: %s\n", PROGNAME_LATENCY,
+				"XDamage, XTest or the window are missing");
+		XCloseDisplay(display);
+		return -1;
+	}
+	if((samples = malloc(sizeof(*samples) * count)) == NULL)
+	{
+		perror(PROGNAME_LATENCY);
+		XCloseDisplay(display);
+		return -1;
+	}
+	keys[0] = XKeysymToKeycode(display, XK_a);
+	keys[1] = XKeysymToKeycode(display, XK_Return);
+	/* the keys reach the window under the pointer within the focus, as
+	 * the embedded terminal emulators, and the glyphs the screen */
+	XWarpPointer(display, None, window, 0, 0, 0, 0, attributes.width / 2,
+			attributes.height / 2);
+	XSetInputFocus(display, window, RevertToParent, CurrentTime);
+	/* only the terminal emulator, not the rest of the screen */
+	damage = XDamageCreate(display, _latency_target(display, window),
+			XDamageReportNonEmpty);
+	for(i = 0; i < count; i++)
+	{
+		/* the previous glyph was displayed completely */
+		usleep(interval * 1000);
+		XDamageSubtract(display, damage, None, None);
+		XSync(display, False);
+		_latency_drain(display);
+		key = keys[((i + 1) % LATENCY_RETURN == 0) ? 1 : 0];
+		start = _latency_now();
+		XTestFakeKeyEvent(display, key, True, CurrentTime);
+		XTestFakeKeyEvent(display, key, False, CurrentTime);
+		XFlush(display);
+		if(_latency_wait(display, event + XDamageNotify, start
+					+ LATENCY_TIMEOUT * 1000) == 0)
+			samples[cnt++] = _latency_now() - start;
+	}
+	XDamageDestroy(display, damage);
+	XCloseDisplay(display);
+	if(cnt == 0)
+	{
+		fprintf(stderr, "%s: %s: %s\n", PROGNAME_LATENCY, name,
+				"Nothing was displayed");
+		free(samples);
+		return -1;
+	}
+	qsort(samples, cnt, sizeof(*samples), _latency_compare);
+	printf("latency.%s.p50_us=%ld\n", name, samples[cnt / 2]);
+	printf("latency.%s.p99_us=%ld\n", name, samples[cnt * 99 / 100]);
+	printf("latency.%s.max_us=%ld\n", name, samples[cnt - 1]);
+	if(cnt < count)
+		printf("latency.%s.lost_count=%u\n", name, count - cnt);
+	free(samples);
+	return 0;
+}
+
+
+/* latency_drain */
+static void _latency_drain(Display * display)
+{
+	XEvent xevent;
+
+	while(XPending(display) > 0)
+		XNextEvent(display, &xevent);
+}
+
+
+/* latency_now */
+static long _latency_now(void)
+{
+	struct timeval tv;
+
+	/* in microseconds */
+	if(gettimeofday(&tv, NULL) != 0)
+		return 0;
+	return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/* latency_target */
+static Window _latency_target(Display * display, Window window)
+{
+	Window root;
+	Window child;
+	int x;
+	int y;
+	unsigned int mask;
+
+	/* the deepest window under the pointer, as embedded */
+	XSync(display, False);
+	while(XQueryPointer(display, window, &root, &child, &x, &y, &x, &y,
+				&mask) && child != None)
+		window = child;
+	return window;
+}
+
+
+/* latency_wait */
+static int _latency_wait(Display * display, int type, long deadline)
+{
+	struct pollfd pfd;
+	XEvent xevent;
+	long now;
+
+	pfd.fd = ConnectionNumber(display);
+	pfd.events = POLLIN;
+	for(;;)
+	{
+		while(XPending(display) > 0)
+		{
+			XNextEvent(display, &xevent);
+			if(xevent.type == type)
+				return 0;
+		}
+		if((now = _latency_now()) >= deadline)
+			return -1;
+		poll(&pfd, 1, (deadline - now + 999) / 1000);
+	}
+}
+
+
+/* latency_compare */
+static int _latency_compare(void const * a, void const * b)
+{
+	long const * la = a;
+	long const * lb = b;
+
+	return (*la > *lb) - (*la < *lb);
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_LATENCY " [-c count][-i interval][-n name]"
+" window\n"
+"  -c	Number of keys typed (default: 200)\n"
+"  -i	Interval between the keys, in milliseconds (default: 50)\n"
+"  -n	Name of the measurements (default: \"window\")\n", stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int count = 200;
+	unsigned int interval = 50;
+	char const * name = "window";
+	unsigned long u;
+	char * p;
+
+	while((o = getopt(argc, argv, "c:i:n:")) != -1)
+		switch(o)
+		{
+			case 'c':
+			case 'i':
+				u = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0' || u == 0
+						|| u > 100000)
+					return _usage();
+				if(o == 'c')
+					count = u;
+				else
+					interval = u;
+				break;
+			case 'n':
+				name = optarg;
+				break;
+			default:
+				return _usage();
+		}
+	if(optind + 1 != argc)
+		return _usage();
+	/* as given by xdotool or xwininfo */
+	u = strtoul(argv[optind], &p, 0);
+	if(argv[optind][0] == '\0' || *p != '\0' || u == 0)
+		return _usage();
+	return (_latency(name, u, count, interval) == 0) ? 0 : 2;
+}
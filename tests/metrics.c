@@ -0,0 +1,159 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../src/metrics.c"
+
+#ifndef PROGNAME_METRICS
+# define PROGNAME_METRICS	"metrics"
+#endif
+
+
+/* metrics */
+/* private */
+/* prototypes */
+static int _metrics(unsigned int count, unsigned int exports);
+
+static long _metrics_now(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* metrics */
+static int _metrics(unsigned int count, unsigned int exports)
+{
+	int ret = 0;
+	TerminalMetrics * metrics;
+	int fd;
+	unsigned int i;
+	long start;
+	long event;
+	long export;
+	long events;
+
+	if((metrics = terminalmetrics_new()) == NULL
+			|| (fd = open("/dev/null", O_WRONLY)) < 0)
+	{
+		perror(PROGNAME_METRICS);
+		if(metrics != NULL)
+			terminalmetrics_delete(metrics);
+		return -1;
+	}
+	/* like the lifecycle of as many tabs */
+	start = _metrics_now();
+	for(i = 0; i < count; i++)
+	{
+		terminalmetrics_event(metrics, TMET_OPENED, i + 1, i, 0);
+		terminalmetrics_event(metrics, TMET_PLUGGED, i + 1, i,
+				(i % 1000) * 100);
+		terminalmetrics_event(metrics, (i % 10) ? TMET_EXITED
+				: TMET_SIGNALED, i + 1, i, i % 3);
+		terminalmetrics_event(metrics, TMET_CLOSED, i + 1, i, 0);
+	}
+	event = _metrics_now() - start;
+	start = _metrics_now();
+	for(i = 0; i < exports && ret == 0; i++)
+		ret = terminalmetrics_export(metrics, fd);
+	export = _metrics_now() - start;
+	start = _metrics_now();
+	for(i = 0; i < exports && ret == 0; i++)
+		ret = terminalmetrics_export_events(metrics, fd);
+	events = _metrics_now() - start;
+	if(ret != 0)
+		perror(PROGNAME_METRICS);
+	else
+	{
+		printf("metrics.event_ns=%ld\n", event * 1000 / (count * 4));
+		printf("metrics.export_us=%ld\n", export / exports);
+		printf("metrics.export_events_us=%ld\n", events / exports);
+	}
+	close(fd);
+	terminalmetrics_delete(metrics);
+	return ret;
+}
+
+
+/* metrics_now */
+static long _metrics_now(void)
+{
+	struct timeval tv;
+
+	/* in microseconds */
+	if(gettimeofday(&tv, NULL) != 0)
+		return 0;
+	return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_METRICS " [-c count][-e exports]\n"
+"  -c	Number of tabs opened and closed (default: 1000000)\n"
+"  -e	Number of exports (default: 100)\n", stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int count = 1000000;
+	unsigned int exports = 100;
+	unsigned long u;
+	char * p;
+
+	while((o = getopt(argc, argv, "c:e:")) != -1)
+	{
+		if(o == '?')
+			return _usage();
+		u = strtoul(optarg, &p, 10);
+		if(optarg[0] == '\0' || *p != '\0' || u == 0 || u > 100000000)
+			return _usage();
+		switch(o)
+		{
+			case 'c':
+				count = u;
+				break;
+			case 'e':
+				exports = u;
+				break;
+			default:
+				return _usage();
+		}
+	}
+	if(optind != argc)
+		return _usage();
+	return (_metrics(count, exports) == 0) ? 0 : 2;
+}
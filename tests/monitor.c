@@ -0,0 +1,274 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../src/monitor.c"
+
+#ifndef PROGNAME_MONITOR
+# define PROGNAME_MONITOR	"monitor"
+#endif
+
+
+/* monitor */
+/* private */
+/* prototypes */
+static int _monitor(unsigned int tabs, unsigned int processes,
+		unsigned int count, unsigned int interval, unsigned int memory,
+		unsigned int size);
+static long _monitor_sample(TerminalMonitor * monitor,
+		TerminalMonitorTree ** trees, pid_t const * pids,
+		unsigned int tabs, int memory, size_t * total);
+static pid_t _monitor_tab(int fd, unsigned int processes, unsigned int size);
+
+static long _monitor_cpu(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* monitor */
+static int _monitor(unsigned int tabs, unsigned int processes,
+		unsigned int count, unsigned int interval, unsigned int memory,
+		unsigned int size)
+{
+	int ret = -1;
+	pid_t * pids;
+	TerminalMonitorTree ** trees;
+	int fd[2];
+	unsigned int i;
+	TerminalMonitor * monitor = NULL;
+	size_t total;
+	long first = 0;
+	long cpu = 0;
+	long mem = 0;
+	char c;
+
+	pids = malloc(sizeof(*pids) * tabs);
+	trees = calloc(tabs, sizeof(*trees));
+	if(pids == NULL || trees == NULL || pipe(fd) != 0)
+	{
+		perror(PROGNAME_MONITOR);
+		free(trees);
+		free(pids);
+		return -1;
+	}
+	/* every process reports once its memory is in use */
+	for(i = 0; i < tabs; i++)
+		if((pids[i] = _monitor_tab(fd[1], processes, size)) < 0)
+			break;
+	close(fd[1]);
+	tabs = i;
+	for(i = 0; i < tabs * processes; i++)
+		if(read(fd[0], &c, 1) != 1)
+			break;
+	close(fd[0]);
+	for(i = 0; i < tabs; i++)
+		if((trees[i] = terminalmonitor_tree_new()) == NULL)
+			break;
+	if(i < tabs || (monitor = terminalmonitor_new()) == NULL)
+		perror(PROGNAME_MONITOR);
+	/* the processes are found on the first sample */
+	else if((first = _monitor_sample(monitor, trees, pids, tabs, 0,
+					&total)) >= 0)
+	{
+		for(i = 0; i < count && cpu >= 0 && mem >= 0; i++)
+		{
+			cpu += _monitor_sample(monitor, trees, pids, tabs, 0,
+					&total);
+			mem += _monitor_sample(monitor, trees, pids, tabs, 1,
+					&total);
+		}
+		if(cpu >= 0 && mem >= 0)
+			ret = 0;
+	}
+	if(ret == 0)
+	{
+		cpu /= count;
+		mem /= count;
+		if(total != tabs * processes)
+			fprintf(stderr, "%s: %lu process(es) instead of %u\n",
+					PROGNAME_MONITOR, (unsigned long)total,
+					tabs * processes);
+		printf("monitor.%ux%u.first_us=%ld\n", tabs, processes, first);
+		printf("monitor.%ux%u.sample_us=%ld\n", tabs, processes, cpu);
+		printf("monitor.%ux%u.memory_us=%ld\n", tabs, processes, mem);
+		/* of one processor, at the intervals given */
+		printf("monitor.%ux%u.cpu_ppm=%ld\n", tabs, processes,
+				cpu * 1000 / interval
+				+ (mem - cpu) * 1000 / memory);
+	}
+	if(monitor != NULL)
+		terminalmonitor_delete(monitor);
+	for(i = 0; i < tabs; i++)
+	{
+		if(trees[i] != NULL)
+			terminalmonitor_tree_delete(trees[i]);
+		kill(-pids[i], SIGKILL);
+		waitpid(pids[i], NULL, 0);
+	}
+	free(trees);
+	free(pids);
+	return ret;
+}
+
+
+/* monitor_sample */
+static long _monitor_sample(TerminalMonitor * monitor,
+		TerminalMonitorTree ** trees, pid_t const * pids,
+		unsigned int tabs, int memory, size_t * total)
+{
+	long cpu;
+	unsigned int i;
+	TerminalMonitorUsage usage;
+
+	/* like every tab of a window at once */
+	cpu = _monitor_cpu();
+	for(i = 0, *total = 0; i < tabs; i++)
+	{
+		if(terminalmonitor_sample(monitor, trees[i], &pids[i], 1, 2,
+					memory, &usage) != 0)
+		{
+			perror(PROGNAME_MONITOR);
+			return -1;
+		}
+		*total += usage.processes;
+	}
+	return _monitor_cpu() - cpu;
+}
+
+
+/* monitor_tab */
+static pid_t _monitor_tab(int fd, unsigned int processes, unsigned int size)
+{
+	pid_t pid;
+	unsigned int i;
+	char * p;
+
+	if((pid = fork()) < 0)
+		perror("fork");
+	if(pid != 0)
+		return pid;
+	/* like a terminal emulator, its shell and jobs */
+	setpgid(0, 0);
+	for(i = 1; i < processes; i++)
+		if(fork() == 0)
+			break;
+	if((p = malloc(size * 1024)) != NULL)
+		memset(p, i, size * 1024);
+	if(write(fd, "", 1) != 1)
+		_exit(2);
+	close(fd);
+	for(;;)
+		pause();
+}
+
+
+/* monitor_cpu */
+static long _monitor_cpu(void)
+{
+	struct rusage ru;
+
+	/* in microseconds */
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000
+		+ ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_MONITOR
+" [-c count][-i interval][-m interval][-n tabs][-p processes]"
+" [-s size]\n"
+"  -c	Number of samples (default: 100)\n"
+"  -i	Interval between the samples, in milliseconds (default: 1000)\n"
+"  -m	Interval between the samples of the memory (default: 5000)\n"
+"  -n	Number of tabs (default: 100)\n"
+"  -p	Number of processes per tab (default: 3)\n"
+"  -s	Memory used per process, in kilobytes (default: 4096)\n",
+			stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int count = 100;
+	unsigned int interval = 1000;
+	unsigned int memory = 5000;
+	unsigned int tabs = 100;
+	unsigned int processes = 3;
+	unsigned int size = 4096;
+	unsigned long u;
+	char * p;
+
+	while((o = getopt(argc, argv, "c:i:m:n:p:s:")) != -1)
+	{
+		if(o == '?')
+			return _usage();
+		u = strtoul(optarg, &p, 10);
+		if(optarg[0] == '\0' || *p != '\0' || u == 0 || u > 1000000)
+			return _usage();
+		switch(o)
+		{
+			case 'c':
+				count = u;
+				break;
+			case 'i':
+				interval = u;
+				break;
+			case 'm':
+				memory = u;
+				break;
+			case 'n':
+				tabs = u;
+				break;
+			case 'p':
+				processes = u;
+				break;
+			case 's':
+				size = u;
+				break;
+			default:
+				return _usage();
+		}
+	}
+	if(optind != argc)
+		return _usage();
+	return (_monitor(tabs, processes, count, interval, memory, size)
+			== 0) ? 0 : 2;
+}
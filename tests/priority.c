@@ -0,0 +1,317 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/priority.c"
+
+#ifndef PROGNAME_PRIORITY
+# define PROGNAME_PRIORITY	"priority"
+#endif
+
+
+/* priority */
+/* private */
+/* constants */
+#define PRIORITY_DELAY	2000
+#define PRIORITY_TIMEOUT	1000
+#define PRIORITY_WORK	500
+
+
+/* prototypes */
+static int _priority(unsigned int busy, unsigned int count, int idle,
+		int nice, unsigned int weight);
+static pid_t _priority_busy(void);
+static int _priority_echo(int fd, unsigned int count, char const * mode);
+static pid_t _priority_shell(int * fd);
+
+static int _priority_compare(void const * a, void const * b);
+static long _priority_now(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* priority */
+static int _priority(unsigned int busy, unsigned int count, int idle,
+		int nice, unsigned int weight)
+{
+	int ret = 0;
+	pid_t * pids;
+	pid_t shell;
+	int fd;
+	unsigned int i;
+	TerminalPriority * priority;
+
+	if((pids = malloc(sizeof(*pids) * busy)) == NULL)
+	{
+		perror(PROGNAME_PRIORITY);
+		return -1;
+	}
+	if((shell = _priority_shell(&fd)) < 0)
+	{
+		free(pids);
+		return -1;
+	}
+	/* the jobs of the tabs in the background */
+	for(i = 0; i < busy; i++)
+		if((pids[i] = _priority_busy()) < 0)
+			break;
+	busy = i;
+	if(_priority_echo(fd, count, "off") != 0)
+		ret = -1;
+	if((priority = terminalpriority_new()) == NULL)
+	{
+		perror(PROGNAME_PRIORITY);
+		ret = -1;
+	}
+	else
+	{
+		if(terminalpriority_set_nice(priority, nice) != 0)
+			perror("nice");
+		if(idle && terminalpriority_set_idle(priority, 1) != 0)
+			perror("idle");
+		if(terminalpriority_set_io(priority, 1) != 0)
+			perror("ioprio");
+		if(weight > 0 && terminalpriority_set_weight(priority, weight)
+				!= 0)
+			perror("cgroup");
+		if(terminalpriority_background(priority, pids, busy) != 0)
+			perror(PROGNAME_PRIORITY);
+		if(_priority_echo(fd, count, "on") != 0)
+			ret = -1;
+	}
+	for(i = 0; i < busy; i++)
+	{
+		kill(pids[i], SIGKILL);
+		waitpid(pids[i], NULL, 0);
+	}
+	if(priority != NULL)
+		terminalpriority_delete(priority);
+	close(fd);
+	kill(shell, SIGKILL);
+	waitpid(shell, NULL, 0);
+	free(pids);
+	return ret;
+}
+
+
+/* priority_busy */
+static pid_t _priority_busy(void)
+{
+	pid_t pid;
+	volatile unsigned long u = 0;
+
+	if((pid = fork()) < 0)
+		perror("fork");
+	else if(pid == 0)
+		for(;;)
+			u++;
+	return pid;
+}
+
+
+/* priority_echo */
+static int _priority_echo(int fd, unsigned int count, char const * mode)
+{
+	long * latencies;
+	struct pollfd pfd;
+	unsigned int i;
+	long start;
+	char c;
+
+	if((latencies = malloc(sizeof(*latencies) * count)) == NULL)
+	{
+		perror(PROGNAME_PRIORITY);
+		return -1;
+	}
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	/* like typing in the tab in the foreground */
+	for(i = 0; i < count; i++)
+	{
+		start = _priority_now();
+		if(write(fd, "x", 1) != 1
+				|| poll(&pfd, 1, PRIORITY_TIMEOUT) != 1
+				|| read(fd, &c, 1) != 1)
+		{
+			fprintf(stderr, "%s: %s: %s\n", PROGNAME_PRIORITY,
+					mode, "No echo");
+			free(latencies);
+			return -1;
+		}
+		latencies[i] = _priority_now() - start;
+		usleep(PRIORITY_DELAY);
+	}
+	qsort(latencies, count, sizeof(*latencies), _priority_compare);
+	printf("priority.%s.echo_p50_us=%ld\n", mode, latencies[count / 2]);
+	printf("priority.%s.echo_p99_us=%ld\n", mode,
+			latencies[count * 99 / 100]);
+	printf("priority.%s.echo_max_us=%ld\n", mode, latencies[count - 1]);
+	free(latencies);
+	return 0;
+}
+
+
+/* priority_shell */
+static pid_t _priority_shell(int * fd)
+{
+	pid_t pid;
+	int slave;
+	struct termios term;
+	char c;
+	long start;
+
+	if((*fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0
+			|| grantpt(*fd) != 0 || unlockpt(*fd) != 0)
+	{
+		perror("pty");
+		return -1;
+	}
+	if((pid = fork()) < 0)
+	{
+		perror("fork");
+		close(*fd);
+		return -1;
+	}
+	if(pid > 0)
+		return pid;
+	/* echoes every character read, after some work like a redraw */
+	setsid();
+	if((slave = open(ptsname(*fd), O_RDWR)) < 0)
+		_exit(2);
+	close(*fd);
+	if(tcgetattr(slave, &term) == 0)
+	{
+		cfmakeraw(&term);
+		tcsetattr(slave, TCSANOW, &term);
+	}
+	while(read(slave, &c, 1) == 1)
+	{
+		for(start = _priority_now(); _priority_now() - start
+				< PRIORITY_WORK;);
+		if(write(slave, &c, 1) != 1)
+			break;
+	}
+	_exit(0);
+}
+
+
+/* priority_compare */
+static int _priority_compare(void const * a, void const * b)
+{
+	long const * la = a;
+	long const * lb = b;
+
+	return (*la < *lb) ? -1 : ((*la > *lb) ? 1 : 0);
+}
+
+
+/* priority_now */
+static long _priority_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_PRIORITY
+" [-i][-b busy][-c count][-n nice][-w weight]\n"
+"  -i	Use the idle scheduling policy in the background\n"
+"  -b	Number of busy processes (default: twice the processors)\n"
+"  -c	Number of characters echoed (default: 1000)\n"
+"  -n	Niceness in the background (default: 10)\n"
+"  -w	CPU weight in the background, within a cgroup (default: 0)\n",
+			stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	int idle = 0;
+	long busy;
+	unsigned int count = 1000;
+	unsigned int nice = 10;
+	unsigned int weight = 0;
+	char * p;
+
+	if((busy = sysconf(_SC_NPROCESSORS_ONLN) * 2) <= 0)
+		busy = 2;
+	while((o = getopt(argc, argv, "ib:c:n:w:")) != -1)
+		switch(o)
+		{
+			case 'i':
+				idle = 1;
+				break;
+			case 'b':
+				busy = strtol(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0' || busy < 0)
+					return _usage();
+				break;
+			case 'c':
+				count = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| count == 0)
+					return _usage();
+				break;
+			case 'n':
+				nice = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0' || nice > 19)
+					return _usage();
+				break;
+			case 'w':
+				weight = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| weight > 10000)
+					return _usage();
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_priority(busy, count, idle, nice, weight) == 0) ? 0 : 2;
+}
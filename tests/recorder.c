@@ -0,0 +1,253 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/recorder.c"
+
+#ifndef PROGNAME_RECORDER
+# define PROGNAME_RECORDER	"recorder"
+#endif
+
+
+/* record */
+/* private */
+/* constants */
+#define RECORD_FRAME	4096
+#define RECORD_SIZE	(4 * 1024 * 1024)
+#define RECORD_TICK	1000000
+
+
+/* prototypes */
+static int _record(char const * filename, unsigned int rate,
+		unsigned int duration);
+static long _record_loop(TerminalRecorder * recorder, char const * buf,
+		size_t size, unsigned int rate, unsigned int duration,
+		unsigned long * calls);
+
+static long _record_cpu(void);
+static long _record_now(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* record */
+static int _record(char const * filename, unsigned int rate,
+		unsigned int duration)
+{
+	char const line[] = ": the quick brown fox jumps over the lazy dog"
+		" \342\200\224 \033[1mbold\033[0m\r\n";
+	char * buf;
+	size_t size = 1024 * 1024;
+	size_t i;
+	int n;
+	char tmp[] = "/tmp/" PROGNAME_RECORDER ".XXXXXX";
+	char * path = NULL;
+	TerminalRecorder * recorder;
+	long reference;
+	long cpu;
+	long elapsed;
+	unsigned long calls;
+	struct stat st;
+
+	/* like the output of a shell */
+	if((buf = malloc(size + sizeof(line) + 16)) == NULL)
+	{
+		perror(PROGNAME_RECORDER);
+		return -1;
+	}
+	for(i = 0, n = 0; i < size; n++)
+		i += snprintf(&buf[i], sizeof(line) + 16, "%d%s", n, line);
+	if(filename == NULL)
+	{
+		if(mkdtemp(tmp) == NULL || (path = malloc(sizeof(tmp)
+						+ sizeof("/output.cast.gz")))
+				== NULL)
+		{
+			perror(tmp);
+			free(buf);
+			return -1;
+		}
+		sprintf(path, "%s/output.cast.gz", tmp);
+		filename = path;
+	}
+	/* without recording first, for reference */
+	reference = _record_cpu();
+	_record_loop(NULL, buf, size, rate, duration, &calls);
+	reference = _record_cpu() - reference;
+	cpu = _record_cpu();
+	if((recorder = terminalrecorder_new(filename, 80, 24,
+					RECORD_SIZE)) == NULL)
+	{
+		perror(filename);
+		free(buf);
+		free(path);
+		return -1;
+	}
+	elapsed = _record_loop(recorder, buf, size, rate, duration, &calls);
+	printf("recorder.output_ns=%ld\n", elapsed * 1000 / calls);
+	printf("recorder.dropped=%lu\n", terminalrecorder_get_dropped(
+				recorder));
+	if(terminalrecorder_delete(recorder) != 0)
+		perror(filename);
+	/* including the writer, in percent of one processor */
+	printf("recorder.cpu_pct=%ld\n", (_record_cpu() - cpu - reference)
+			* 100 / ((long)duration * 1000000));
+	if(stat(filename, &st) == 0)
+		printf("recorder.size_kb=%ld\n", (long)st.st_size / 1024);
+	if(path != NULL)
+	{
+		unlink(path);
+		rmdir(tmp);
+	}
+	free(buf);
+	free(path);
+	return 0;
+}
+
+
+/* record_loop */
+static long _record_loop(TerminalRecorder * recorder, char const * buf,
+		size_t size, unsigned int rate, unsigned int duration,
+		unsigned long * calls)
+{
+	struct timespec ts;
+	size_t tick = (size_t)rate * 1024 * 1024 / (1000000000 / RECORD_TICK);
+	unsigned long t;
+	size_t pos = 0;
+	size_t i;
+	size_t n;
+	long start;
+	long elapsed = 0;
+
+	/* like the output of a shell read every millisecond */
+	*calls = 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	for(t = 0; t < (unsigned long)duration * (1000000000 / RECORD_TICK);
+			t++)
+	{
+		for(i = 0; i < tick; i += n, pos = (pos + n) % size)
+		{
+			n = tick - i;
+			n = (n < RECORD_FRAME) ? n : RECORD_FRAME;
+			n = (n < size - pos) ? n : size - pos;
+			if(recorder == NULL)
+				continue;
+			start = _record_now();
+			terminalrecorder_output(recorder, &buf[pos], n);
+			elapsed += _record_now() - start;
+			(*calls)++;
+		}
+		if((ts.tv_nsec += RECORD_TICK) >= 1000000000)
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+	/* in microseconds */
+	return elapsed;
+}
+
+
+/* record_cpu */
+static long _record_cpu(void)
+{
+	struct rusage ru;
+
+	/* in microseconds, for every thread */
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000
+		+ ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+
+/* record_now */
+static long _record_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_RECORDER
+" [-o filename][-r rate][-t duration]\n"
+"  -o	Keep the recording in this file\n"
+"  -r	Rate of the output, in MB/s (default: 100)\n"
+"  -t	Duration, in seconds (default: 5)\n", stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	char const * filename = NULL;
+	unsigned int rate = 100;
+	unsigned int duration = 5;
+	char * p;
+
+	while((o = getopt(argc, argv, "o:r:t:")) != -1)
+		switch(o)
+		{
+			case 'o':
+				filename = optarg;
+				break;
+			case 'r':
+				rate = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| rate == 0)
+					return _usage();
+				break;
+			case 't':
+				duration = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| duration == 0)
+					return _usage();
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_record(filename, rate, duration) == 0) ? 0 : 2;
+}
@@ -0,0 +1,377 @@
+#!/bin/sh
+#$Id$
+#Copyright (c) 2026 Pierre Pronchery <khorben@defora.org>
+#
+#Redistribution and use in source and binary forms, with or without
+#modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+#THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+#AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+#IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+#DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+#FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+#DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+#SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+#CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+#OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+#variables
+BACKEND="xterm"
+BATCH=50
+COMMONSH="${0%/soak.sh}/common.sh"
+CONFIGSH="${0%/soak.sh}/../config.sh"
+CONTROL=
+CYCLES=10000
+DISPLAYNUM=43
+#growth tolerated after every phase
+FDS=0
+OBJECTS=0
+PROGNAME="soak.sh"
+#in kilobytes per 1000 cycles
+RSS_SLOPE=100
+SANITIZE=0
+SETTLE=1
+SUPPRESSIONS="${0%/soak.sh}/soak.supp"
+TERMINAL=
+TIMEOUT=10
+WIDGETS=0
+ZOMBIES=0
+#executables
+CAT="cat"
+CHMOD="chmod"
+DATE="date"
+DEBUG="_debug"
+GREP="grep"
+KILL="kill"
+MKDIR="mkdir -p"
+MKTEMP="mktemp"
+PGREP="pgrep"
+RM="rm -f"
+SED="sed"
+SLEEP="sleep"
+XVFB="Xvfb"
+XWININFO="xwininfo"
+
+[ -f "$CONFIGSH" ] && . "$CONFIGSH"
+. "$COMMONSH"
+
+
+#functions
+#soak
+_soak()
+{
+	res=0
+
+	$DATE
+	echo
+	if [ "$SANITIZE" -ne 0 ]; then
+		#for a build with -fsanitize=address
+		export ASAN_OPTIONS="detect_leaks=1:abort_on_error=0"
+		export LSAN_OPTIONS="suppressions=$SUPPRESSIONS"
+	fi
+	_xvfb_start						|| return 2
+	_soak_phase "tabs" _soak_cycle_tabs			|| res=2
+	_soak_phase "exits" _soak_cycle_exits			|| res=2
+	_soak_phase "failures" _soak_cycle_failures		|| res=2
+	_xvfb_stop
+	return $res
+}
+
+
+#soak_check
+_soak_check()
+{
+	phase="$1"
+	key="$2"
+	before="$3"
+	after="$4"
+	tolerance="$5"
+
+	echo "soak.$phase.$key=$((after - before))"
+	[ $((after - before)) -le "$tolerance" ]		&& return 0
+	_error "$phase: $key from $before to $after (+$tolerance)"
+}
+
+
+#soak_close
+_soak_close()
+{
+	ids=$($SED -n 's/^.*"tabs":\[\([0-9,]*\)\].*$/\1/p' "$1")
+	commands=
+
+	[ -n "$ids" ]						|| return 2
+	#in a single round trip
+	for id in $(echo "$ids" | $SED 's/,/ /g'); do
+		commands="$commands${commands:+,}"
+		commands="$commands{\"command\":\"close\",\"tab\":$id}"
+	done
+	"$CONTROL" -p "$home/control" "[$commands]" > "$home/close" \
+								|| return 2
+	! $GREP -q '"ok":false' "$home/close"
+}
+
+
+#soak_cycle_exits
+_soak_cycle_exits()
+{
+	command="{\"command\":\"open\",\"count\":$BATCH"
+	command="$command,\"backend\":\"$BACKEND\""
+	command="$command,\"shell\":\"$home/exit.sh\"}"
+
+	#the tabs close on their own
+	"$CONTROL" -p "$home/control" -e closed -n $BATCH "$command" \
+		> "$home/open"
+}
+
+
+#soak_cycle_failures
+_soak_cycle_failures()
+{
+	commands=
+	n=0
+
+	#every tab fails to spawn, one command each
+	while [ $n -lt $BATCH ]; do
+		commands="$commands${commands:+,}"
+		commands="$commands{\"command\":\"open\",\"backend\":\"xterm\"}"
+		n=$((n + 1))
+	done
+	"$CONTROL" -p "$home/control" "[$commands]" > "$home/open" \
+								|| return 2
+	if $GREP -q '"ok":true' "$home/open"; then
+		_error "failures: Could spawn $home/missing"
+		_soak_close "$home/open"
+		return 2
+	fi
+	return 0
+}
+
+
+#soak_cycle_tabs
+_soak_cycle_tabs()
+{
+	command="{\"command\":\"open\",\"count\":$BATCH"
+	command="$command,\"backend\":\"$BACKEND\"}"
+
+	#until usable, then closed at once
+	"$CONTROL" -p "$home/control" -e plugged -n $BATCH "$command" \
+		> "$home/open"					|| return 2
+	_soak_close "$home/open"
+}
+
+
+#soak_phase
+_soak_phase()
+{
+	phase="$1"
+	cycle="$2"
+	home=$($MKTEMP -d)					|| return 2
+	trace="$home/trace.json"
+	leaks=0
+
+	printf 'backend=native\n[control]\nenabled=1\npath=%s\n' \
+		"$home/control" > "$home/.terminal"
+	#the xterms cannot be spawned in this phase
+	[ "$phase" = "failures" ] && printf '[xterm]\npath=%s\n' \
+		"$home/missing" >> "$home/.terminal"
+	printf '#!/bin/sh\nexec sleep %u\n' 86400 > "$home/sleep.sh"
+	printf '#!/bin/sh\nexit 0\n' > "$home/exit.sh"
+	$CHMOD +x "$home/sleep.sh" "$home/exit.sh"
+	#the objects are only counted if requested
+	HOME="$home" SHELL="$home/sleep.sh" DISPLAY=":$DISPLAYNUM" \
+		GOBJECT_DEBUG="instance-count" \
+		"$TERMINAL" -n -t "$trace" 2> "$home/stderr" &
+	pid=$!
+	if ! _tabs_wait "$trace" 1; then
+		_error "$phase: Could not open the first tab"
+		_soak_stop
+		return 2
+	fi
+	#a first batch to warm up the caches
+	if ! $cycle || ! $SLEEP $SETTLE || ! before=$(_soak_sample); then
+		_error "$phase: Could not warm up"
+		_soak_stop
+		return 2
+	fi
+	start=$(_now)
+	i=0
+	while [ $i -lt $CYCLES ]; do
+		if ! $cycle; then
+			_error "$phase: Failed after $i cycles"
+			_soak_stop
+			return 2
+		fi
+		i=$((i + BATCH))
+	done
+	echo "soak.$phase.cycles=$i"
+	echo "soak.$phase.time_ms=$(($(_now) - start))"
+	#let the processes closed be reaped
+	$SLEEP $SETTLE
+	if ! after=$(_soak_sample); then
+		_error "$phase: Could not sample the process"
+		_soak_stop
+		return 2
+	fi
+	set -- $before $after
+	_soak_check "$phase" "fds" $1 $6 $FDS			|| leaks=2
+	echo "soak.$phase.rss_slope_kb=$((($7 - $2) * 1000 / i))"
+	if [ $((($7 - $2) * 1000 / i)) -gt $RSS_SLOPE ]; then
+		_error "$phase: RSS from $2 to $7 kB after $i cycles"
+		leaks=2
+	fi
+	_soak_check "$phase" "objects" $3 $8 $OBJECTS		|| leaks=2
+	_soak_check "$phase" "widgets" $4 $9 $WIDGETS		|| leaks=2
+	_soak_check "$phase" "zombies" 0 ${10} $ZOMBIES	|| leaks=2
+	_soak_stop						|| leaks=2
+	return $leaks
+}
+
+
+#soak_sample
+_soak_sample()
+{
+	fds=$(set -- /proc/$pid/fd/*; echo $#)
+	rss=0
+	members='"objects":\([0-9]*\),"widgets":\([0-9]*\)'
+	objects=$("$CONTROL" -p "$home/control" '{"command":"objects"}' \
+		| $SED -n "s/^.*$members.*\$/\\1 \\2/p")
+
+	[ -n "$objects" ]					|| return 2
+	while read key value unit; do
+		[ "$key" = "VmRSS:" ] && rss=$value
+	done < "/proc/$pid/status"
+	echo "$fds $rss $objects $(_soak_zombies)"
+}
+
+
+#soak_stop
+_soak_stop()
+{
+	deadline=$(($(_now) + TIMEOUT * 1000))
+
+	#closing the last tab lets Terminal exit on its own
+	tab=$("$CONTROL" -p "$home/control" '{"command":"list"}' \
+		| $SED -n 's/^.*"tabs":\[{"tab":\([0-9]*\),.*$/\1/p')
+	[ -n "$tab" ] && "$CONTROL" -p "$home/control" \
+		"{\"command\":\"close\",\"tab\":$tab}" > "/dev/null" 2>&1
+	while $KILL -0 $pid 2> "/dev/null"; do
+		if [ $(_now) -ge $deadline ]; then
+			_error "$phase: Terminal did not exit"
+			$KILL $pid
+			break
+		fi
+		$SLEEP 0.1
+	done
+	wait $pid
+	status=$?
+	#including the leaks reported when sanitized
+	if [ $status -ne 0 ]; then
+		_error "$phase: Terminal exited with status $status"
+		$CAT "$home/stderr" 1>&2
+	fi
+	$RM -r -- "$home"
+	[ $status -eq 0 ]
+}
+
+
+#soak_zombies
+_soak_zombies()
+{
+	parents=" $pid "
+	cnt=0
+
+	for child in $($PGREP -P $pid); do
+		parents="$parents$child "
+	done
+	#the children of Terminal or of its helpers, not reaped
+	for ppid in $($SED -n 's/^.*) Z \([0-9]*\) .*$/\1/p' \
+		/proc/[0-9]*/stat 2> "/dev/null"); do
+		case "$parents" in
+			*" $ppid "*)
+				cnt=$((cnt + 1))
+				;;
+		esac
+	done
+	echo "$cnt"
+}
+
+
+#debug
+_debug()
+{
+	echo "$@" 1>&3
+	"$@"
+}
+
+
+#error
+_error()
+{
+	echo "$PROGNAME: $@" 1>&2
+	return 2
+}
+
+
+#usage
+_usage()
+{
+	echo "Usage: $PROGNAME [-c] target..." 1>&2
+	return 1
+}
+
+
+#main
+clean=0
+while getopts "cO:P:" name; do
+	case "$name" in
+		c)
+			clean=1
+			;;
+		O)
+			export "${OPTARG%%=*}"="${OPTARG#*=}"
+			;;
+		P)
+			#XXX ignored for compatibility
+			;;
+		?)
+			_usage
+			exit $?
+			;;
+	esac
+done
+shift $((OPTIND - 1))
+if [ $# -lt 1 ]; then
+	_usage
+	exit $?
+fi
+
+#clean
+[ $clean -ne 0 ] && exit 0
+
+exec 3>&1
+ret=0
+while [ $# -gt 0 ]; do
+	target="$1"
+	dirname="${target%/*}"
+	shift
+
+	objdir=
+	if [ -n "$dirname" -a "$dirname" != "$target" ]; then
+		$MKDIR -- "$dirname"				|| ret=$?
+		objdir="$dirname/"
+	fi
+	[ -n "$CONTROL" ] || CONTROL="${objdir}control"
+	[ -n "$TERMINAL" ] || TERMINAL="${objdir}../src/terminal"
+	_soak > "$target"					|| ret=$?
+done
+exit $ret
@@ -0,0 +1,229 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/store.c"
+#include "../src/spawner.c"
+
+#ifndef PROGNAME_SPAWNER
+# define PROGNAME_SPAWNER	"spawner"
+#endif
+
+
+/* spawn */
+/* private */
+/* prototypes */
+static int _spawn(unsigned int count, unsigned int size);
+static int _spawn_fork(unsigned int count, char * argv[]);
+static int _spawn_helper(unsigned int count, char * argv[]);
+
+static long _spawn_now(void);
+
+static int _usage(void);
+
+/* callbacks */
+static void _spawn_on_exit(void * data, pid_t pid, int status);
+
+
+/* variables */
+static int _spawn_exited;
+
+
+/* functions */
+/* spawn */
+static int _spawn(unsigned int count, unsigned int size)
+{
+	char * argv[] = { "/bin/true", NULL };
+	unsigned int sizes[] = { 0, 256, 1024 };
+	unsigned int i;
+	char * p = NULL;
+	char * q;
+	long start;
+
+	/* like the terminal, the helper is started while still small */
+	if(spawner_start() != 0)
+	{
+		perror(PROGNAME_SPAWNER);
+		return -1;
+	}
+	spawner_set_callback(_spawn_on_exit, &_spawn_exited);
+	for(i = 0; i < sizeof(sizes) / sizeof(*sizes) && sizes[i] <= size;
+			i++)
+	{
+		/* grow the resident set of the parent */
+		if((q = realloc(p, (size_t)sizes[i] * 1024 * 1024 + 1))
+				== NULL)
+		{
+			perror(PROGNAME_SPAWNER);
+			break;
+		}
+		p = q;
+		memset(p, 0x5a, (size_t)sizes[i] * 1024 * 1024 + 1);
+		start = _spawn_now();
+		if(_spawn_fork(count, argv) != 0)
+			break;
+		printf("spawner.fork_%umb_us=%ld\n", sizes[i],
+				(_spawn_now() - start) / count);
+		start = _spawn_now();
+		if(_spawn_helper(count, argv) != 0)
+			break;
+		printf("spawner.helper_%umb_us=%ld\n", sizes[i],
+				(_spawn_now() - start) / count);
+	}
+	free(p);
+	spawner_stop();
+	return (i == sizeof(sizes) / sizeof(*sizes) || sizes[i] > size)
+		? 0 : -1;
+}
+
+
+/* spawn_fork */
+/* the former implementation, for reference */
+static int _spawn_fork(unsigned int count, char * argv[])
+{
+	unsigned int i;
+	pid_t pid;
+	int status;
+
+	for(i = 0; i < count; i++)
+	{
+		if((pid = fork()) == 0)
+		{
+			execv(argv[0], argv);
+			_exit(127);
+		}
+		else if(pid < 0 || waitpid(pid, &status, 0) != pid)
+		{
+			perror("fork");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+/* spawn_helper */
+static int _spawn_helper(unsigned int count, char * argv[])
+{
+	unsigned int i;
+	pid_t pid;
+	struct pollfd pfd;
+
+	pfd.fd = spawner_get_fd();
+	pfd.events = POLLIN;
+	for(i = 0; i < count; i++)
+	{
+		if(spawner_spawn(argv[0], argv, NULL, NULL, NULL, -1, 0, &pid)
+				!= 0)
+		{
+			perror("spawner_spawn");
+			return -1;
+		}
+		/* the exits are waited for as well */
+		for(_spawn_exited = 0; _spawn_exited == 0;)
+			if((spawner_get_pending() == 0 && poll(&pfd, 1, -1) < 0)
+					|| spawner_dispatch() != 0)
+			{
+				perror("spawner_dispatch");
+				return -1;
+			}
+	}
+	return 0;
+}
+
+
+/* spawn_now */
+static long _spawn_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_SPAWNER " [-m size][-n count]\n"
+"  -m	Largest resident set of the parent, in MB (default: 1024)\n"
+"  -n	Number of processes to spawn (default: 100)\n", stderr);
+	return 1;
+}
+
+
+/* callbacks */
+/* spawn_on_exit */
+static void _spawn_on_exit(void * data, pid_t pid, int status)
+{
+	int * exited = data;
+	(void) pid;
+	(void) status;
+
+	*exited = 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int count = 100;
+	unsigned int size = 1024;
+	char * p;
+
+	while((o = getopt(argc, argv, "m:n:")) != -1)
+		switch(o)
+		{
+			case 'm':
+				size = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0')
+					return _usage();
+				break;
+			case 'n':
+				count = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| count == 0)
+					return _usage();
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_spawn(count, size) == 0) ? 0 : 2;
+}
@@ -0,0 +1,286 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Terminal */
+/* Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ITS AUTHORS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/store.c"
+
+#ifndef PROGNAME_STORE
+# define PROGNAME_STORE	"store"
+#endif
+
+
+/* store */
+/* private */
+/* types */
+typedef enum _StoreIndex
+{
+	SI_PID = 0,
+	SI_PAGE,
+	SI_COUNT
+} StoreIndex;
+
+/* roughly the size of a tab */
+typedef struct _StoreTab
+{
+	void * data[16];
+	long pid;
+	uintptr_t page;
+} StoreTab;
+
+
+/* prototypes */
+static int _store(unsigned int count, int children);
+static int _store_array(unsigned int count, long * pids, uintptr_t * pages,
+		unsigned int * order);
+static int _store_store(unsigned int count, int children, long * pids,
+		uintptr_t * pages, unsigned int * order);
+
+static long _store_now(void);
+
+static int _usage(void);
+
+
+/* functions */
+/* store */
+static int _store(unsigned int count, int children)
+{
+	int ret;
+	long * pids;
+	uintptr_t * pages;
+	unsigned int * order;
+	unsigned int i;
+	unsigned int j;
+	unsigned int t;
+
+	pids = malloc(sizeof(*pids) * count);
+	pages = malloc(sizeof(*pages) * count);
+	order = malloc(sizeof(*order) * count);
+	if(pids == NULL || pages == NULL || order == NULL)
+	{
+		free(pids);
+		free(pages);
+		free(order);
+		return -1;
+	}
+	for(i = 0; i < count; i++)
+	{
+		/* the children are reaped in an arbitrary order */
+		pids[i] = 1000 + i;
+		pages[i] = (uintptr_t)&pages[i];
+		order[i] = i;
+	}
+	srand(count);
+	for(i = count; i > 1; i--)
+	{
+		j = rand() % i;
+		t = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = t;
+	}
+	/* use real processes */
+	for(i = 0; children && i < count; i++)
+		if((pids[i] = fork()) == 0)
+			_exit(0);
+		else if(pids[i] < 0)
+		{
+			perror("fork");
+			children = 0;
+		}
+	ret = _store_array(count, pids, pages, order);
+	if(ret == 0)
+		ret = _store_store(count, children, pids, pages, order);
+	free(order);
+	free(pages);
+	free(pids);
+	return ret;
+}
+
+
+/* store_array */
+/* the former implementation, for reference */
+static int _store_array(unsigned int count, long * pids, uintptr_t * pages,
+		unsigned int * order)
+{
+	StoreTab ** tabs = NULL;
+	StoreTab ** p;
+	size_t tabs_cnt = 0;
+	unsigned int i;
+	size_t j;
+	long start;
+
+	start = _store_now();
+	for(i = 0; i < count; i++)
+	{
+		if((p = realloc(tabs, sizeof(*p) * (tabs_cnt + 1))) == NULL)
+			return -1;
+		tabs = p;
+		if((tabs[tabs_cnt] = malloc(sizeof(**tabs))) == NULL)
+			return -1;
+		tabs[tabs_cnt]->pid = pids[i];
+		tabs[tabs_cnt++]->page = pages[i];
+	}
+	printf("array.open_us=%ld\n", _store_now() - start);
+	start = _store_now();
+	for(i = 0; i < count; i++)
+	{
+		/* close every other tab, reap the others */
+		if(i % 2 == 0)
+		{
+			for(j = 0; j < tabs_cnt; j++)
+				if(tabs[j]->page == pages[order[i]])
+					break;
+		}
+		else
+			for(j = 0; j < tabs_cnt; j++)
+				if(tabs[j]->pid == pids[order[i]])
+					break;
+		if(j == tabs_cnt)
+			return -1;
+		free(tabs[j]);
+		memmove(&tabs[j], &tabs[j + 1], (--tabs_cnt - j)
+				* sizeof(*tabs));
+	}
+	printf("array.close_us=%ld\n", _store_now() - start);
+	free(tabs);
+	return 0;
+}
+
+
+/* store_store */
+static int _store_store(unsigned int count, int children, long * pids,
+		uintptr_t * pages, unsigned int * order)
+{
+	TerminalStore * store;
+	StoreTab * tab;
+	TerminalStoreHandle handle;
+	unsigned int i;
+	long start;
+	int status;
+
+	if((store = terminalstore_new(sizeof(*tab), SI_COUNT)) == NULL)
+		return -1;
+	start = _store_now();
+	for(i = 0; i < count; i++)
+	{
+		if((tab = terminalstore_alloc(store, &handle)) == NULL
+				|| terminalstore_set_key(store, handle, SI_PID,
+					pids[i]) != 0
+				|| terminalstore_set_key(store, handle, SI_PAGE,
+					pages[i]) != 0)
+		{
+			terminalstore_delete(store);
+			return -1;
+		}
+		tab->pid = pids[i];
+		tab->page = pages[i];
+	}
+	printf("store.open_us=%ld\n", _store_now() - start);
+	start = _store_now();
+	for(i = 0; i < count; i++)
+	{
+		/* close every other tab, reap the others */
+		if(i % 2 == 0)
+			tab = terminalstore_lookup(store, SI_PAGE,
+					pages[order[i]], &handle);
+		else if(children)
+			tab = terminalstore_lookup(store, SI_PID,
+					waitpid(pids[order[i]], &status, 0),
+					&handle);
+		else
+			tab = terminalstore_lookup(store, SI_PID,
+					pids[order[i]], &handle);
+		if(tab == NULL)
+			break;
+		if(children && i % 2 == 0)
+			waitpid(tab->pid, &status, 0);
+		terminalstore_free(store, handle);
+	}
+	printf("store.close_us=%ld\n", _store_now() - start);
+	i = terminalstore_get_count(store);
+	terminalstore_delete(store);
+	if(i != 0)
+	{
+		fprintf(stderr, "%s: %u tab(s) left\n", PROGNAME_STORE, i);
+		return -1;
+	}
+	return 0;
+}
+
+
+/* store_now */
+static long _store_now(void)
+{
+	struct timespec ts;
+
+	/* in microseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fputs("Usage: " PROGNAME_STORE " [-f][-n count]\n"
+"  -f	Reap real child processes\n"
+"  -n	Number of tabs to open and close (default: 10000)\n", stderr);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	unsigned int count = 10000;
+	int children = 0;
+	char * p;
+
+	while((o = getopt(argc, argv, "fn:")) != -1)
+		switch(o)
+		{
+			case 'f':
+				children = 1;
+				break;
+			case 'n':
+				count = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0'
+						|| count == 0)
+					return _usage();
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	return (_store(count, children) == 0) ? 0 : 2;
+}